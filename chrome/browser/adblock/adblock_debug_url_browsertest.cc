@@ -257,6 +257,38 @@ IN_PROC_BROWSER_TEST_F(AdblockDebugUrlTest, TestEnableAACommands) {
             ExecuteScriptAndExtractString(kReadPageBodyScript));
 }
 
+IN_PROC_BROWSER_TEST_F(AdblockDebugUrlTest, TestProfilerCommands) {
+  GURL enable_profiler_url(kAdblockDebugUrl + "/profiler/enable");
+  GURL disable_profiler_url(kAdblockDebugUrl + "/profiler/disable");
+  GURL profiler_state_url(kAdblockDebugUrl + "/profiler/state");
+  GURL list_profiler_url(kAdblockDebugUrl + "/profiler/list");
+  GURL clear_profiler_url(kAdblockDebugUrl + "/profiler/clear");
+
+  ASSERT_TRUE(ui_test_utils::NavigateToURL(browser(), profiler_state_url));
+  ASSERT_EQ("OK\n\ndisabled",
+            ExecuteScriptAndExtractString(kReadPageBodyScript));
+
+  ASSERT_TRUE(ui_test_utils::NavigateToURL(browser(), enable_profiler_url));
+  ASSERT_EQ("OK", ExecuteScriptAndExtractString(kReadPageBodyScript));
+  ASSERT_TRUE(ui_test_utils::NavigateToURL(browser(), profiler_state_url));
+  ASSERT_EQ("OK\n\nenabled",
+            ExecuteScriptAndExtractString(kReadPageBodyScript));
+
+  ASSERT_TRUE(ui_test_utils::NavigateToURL(browser(), list_profiler_url));
+  auto response = ExecuteScriptAndExtractString(kReadPageBodyScript);
+  ASSERT_THAT(response, StartsWith("OK\n\n"));
+  ASSERT_THAT(response, HasSubstr("\"buckets\""));
+
+  ASSERT_TRUE(ui_test_utils::NavigateToURL(browser(), clear_profiler_url));
+  ASSERT_EQ("OK", ExecuteScriptAndExtractString(kReadPageBodyScript));
+
+  ASSERT_TRUE(ui_test_utils::NavigateToURL(browser(), disable_profiler_url));
+  ASSERT_EQ("OK", ExecuteScriptAndExtractString(kReadPageBodyScript));
+  ASSERT_TRUE(ui_test_utils::NavigateToURL(browser(), profiler_state_url));
+  ASSERT_EQ("OK\n\ndisabled",
+            ExecuteScriptAndExtractString(kReadPageBodyScript));
+}
+
 IN_PROC_BROWSER_TEST_F(AdblockDebugUrlTest, TestFilterCommandsInOldFormat) {
   GURL clear_filters_url(kAdblockDebugUrl + "/filters/clear");
   ASSERT_TRUE(ui_test_utils::NavigateToURL(browser(), clear_filters_url));
@@ -15,9 +15,13 @@
  * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <map>
+#include <string>
 #include <vector>
 
 #include "base/ranges/algorithm.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/trace_event_analyzer.h"
 #include "chrome/browser/adblock/adblock_controller_factory.h"
 #include "chrome/browser/adblock/resource_classification_runner_factory.h"
 #include "chrome/browser/profiles/profile.h"
@@ -25,11 +29,13 @@
 #include "chrome/test/base/in_process_browser_test.h"
 #include "chrome/test/base/ui_test_utils.h"
 #include "components/adblock/content/browser/adblock_filter_match.h"
+#include "components/adblock/content/browser/document_frame_context.h"
 #include "components/adblock/content/browser/frame_hierarchy_builder.h"
 #include "components/adblock/content/browser/resource_classification_runner.h"
 #include "components/adblock/core/adblock_controller.h"
 #include "components/adblock/core/common/adblock_constants.h"
 #include "components/blocked_content/popup_blocker_tab_helper.h"
+#include "content/public/browser/render_frame_host.h"
 #include "content/public/test/browser_test.h"
 #include "content/public/test/browser_test_utils.h"
 #include "net/dns/mock_host_resolver.h"
@@ -219,6 +225,58 @@ IN_PROC_BROWSER_TEST_F(AdblockFrameHierarchyBrowserTest,
                                   observer.blocked_ads_notifications);
 }
 
+IN_PROC_BROWSER_TEST_F(AdblockFrameHierarchyBrowserTest,
+                       FrameHierarchyBuiltOncePerFrame) {
+  SetFilters({"/resource.png"});
+  // Every frame context is built by DocumentFrameContext, whichever of the
+  // navigation, request, response, rewrite or popup paths needs it first.
+  trace_analyzer::Start("eyeo");
+  NavigateToOutermostFrame();
+  VerifyTargetResourceShown(false);
+  observer.VerifyNotificationSent("resource.png",
+                                  observer.blocked_ads_notifications);
+
+  content::RenderFrameHost* inner_frame = content::ChildFrameAt(
+      content::ChildFrameAt(browser()
+                                ->tab_strip_model()
+                                ->GetActiveWebContents()
+                                ->GetPrimaryMainFrame(),
+                            0),
+      0);
+  ASSERT_TRUE(inner_frame);
+  const auto frame_context = DocumentFrameContext::Get(inner_frame);
+  ASSERT_TRUE(frame_context);
+  EXPECT_EQ(3u, frame_context->frame_hierarchy().size());
+  EXPECT_EQ("inner.com", frame_context->document_domain());
+
+  // Further requests of the frame are classified with the same frame context
+  // instead of building the hierarchy again.
+  for (const char* query : {"?second", "?third", "?fourth"}) {
+    EXPECT_EQ(false, content::EvalJs(
+                         inner_frame, base::StringPrintf(
+                                          "fetch('resource.png%s')"
+                                          ".then(() => true, () => false)",
+                                          query)));
+    observer.VerifyNotificationSent("resource.png",
+                                    observer.blocked_ads_notifications);
+  }
+  EXPECT_EQ(frame_context, DocumentFrameContext::Get(inner_frame));
+
+  auto analyzer = trace_analyzer::Stop();
+  trace_analyzer::TraceEventVector builds;
+  analyzer->FindEvents(trace_analyzer::Query::EventNameIs(
+                           "DocumentFrameContext::BuildFrameContext"),
+                       &builds);
+  std::map<std::string, int> builds_per_frame;
+  for (const auto* build : builds) {
+    ++builds_per_frame[GURL(build->GetKnownArgAsString("url")).host()];
+  }
+  // Documents of the tab before the navigation aren't part of the page.
+  for (const char* frame_host : {"outer.com", "middle.com", "inner.com"}) {
+    EXPECT_EQ(1, builds_per_frame[frame_host]) << frame_host;
+  }
+}
+
 IN_PROC_BROWSER_TEST_F(AdblockFrameHierarchyBrowserTest,
                        PopupHandledByChromiumWithoutFilters) {
   // Without any popup-specific filters, blocking popups is handed over to
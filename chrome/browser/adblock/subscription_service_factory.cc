@@ -112,8 +112,9 @@ std::unique_ptr<FilteringConfigurationMaintainer>
 MakeFilterConfigurationMaintainer(
     content::BrowserContext* context,
     FilteringConfiguration* configuration,
-    FilteringConfigurationMaintainerImpl::SubscriptionUpdatedCallback
-        observer) {
+    FilteringConfigurationMaintainerImpl::SubscriptionUpdatedCallback observer,
+    FilteringConfigurationMaintainerImpl::CollectionChangedCallback
+        collection_changed_callback) {
   auto* prefs = Profile::FromBrowserContext(context)->GetPrefs();
   auto main_thread_task_runner = base::SequencedTaskRunner::GetCurrentDefault();
   auto* persistent_metadata =
@@ -142,7 +143,7 @@ MakeFilterConfigurationMaintainer(
       configuration, std::move(storage), std::move(downloader),
       std::make_unique<PreloadedSubscriptionProviderImpl>(),
       MakeSubscriptionUpdater(), conversion_executors, persistent_metadata,
-      observer);
+      observer, collection_changed_callback);
   maintainer->InitializeStorage();
   return maintainer;
 }
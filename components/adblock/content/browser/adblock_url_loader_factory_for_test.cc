@@ -20,6 +20,7 @@
 #include "base/strings/string_split.h"
 #include "base/strings/string_util.h"
 #include "base/strings/utf_string_conversions.h"
+#include "components/adblock/core/subscription/filter_match_profiler.h"
 #include "net/http/http_status_code.h"
 #include "net/http/http_util.h"
 #include "services/network/public/cpp/resource_request.h"
@@ -40,6 +41,7 @@ constexpr char kTopicDomains[] = "domains";
 constexpr char kTopicSubscriptions[] = "subscriptions";
 constexpr char kTopicAdblock[] = "adblock";
 constexpr char kTopicAcceptableAds[] = "aa";
+constexpr char kTopicProfiler[] = "profiler";
 constexpr char kTopicHelp[] = "help";
 
 constexpr char kActionAdd[] = "add";
@@ -53,11 +55,13 @@ constexpr char kActionState[] = "state";
 constexpr char kHelp[] = R"(
   Command syntax `adblock.test.data/[topic]/[action]/[payload]` where:
   - `topic` is either `domains` (allowed domains), `filters`, `subscriptions`,
-    `adblock`, `aa` (Acceptable Ads)
+    `adblock`, `aa` (Acceptable Ads), `profiler` (filter match profiler)
   - `action` is either:
       - `add`, `clear` (remove all), `list`, `remove` valid for `domains`,
         `filters` and `subscriptions`
-      - `enable`, `disable` or `state` valid for `aa` and `adblock`
+      - `enable`, `disable` or `state` valid for `aa`, `adblock` and
+        `profiler`
+      - `list` (statistics as JSON) and `clear` valid for `profiler`
   - `payload` is url encoded string required for action `add` and `remove`.
   When adding or removing filter/domain/subscription one can encode several
   entries splitting them by a new line character.
@@ -340,6 +344,25 @@ std::string AdblockURLLoaderFactoryForTest::HandleCommand(
           return response;
         }
       }
+    } else if (topic == kTopicProfiler) {
+      auto* profiler = FilterMatchProfiler::GetInstance();
+      if (action == kActionState) {
+        std::string response = kResponseOk;
+        response += "\n\n";
+        response += profiler->IsEnabled() ? "enabled" : "disabled";
+        return response;
+      } else if (action == kActionEnable || action == kActionDisable) {
+        profiler->SetEnabled(action == kActionEnable);
+        return kResponseOk;
+      } else if (action == kActionList) {
+        std::string response = kResponseOk;
+        response += "\n\n";
+        response += profiler->ToJson();
+        return response;
+      } else if (action == kActionClear) {
+        profiler->Reset();
+        return kResponseOk;
+      }
     } else if (topic == kTopicAdblock || topic == kTopicAcceptableAds) {
       if (action == kActionState) {
         std::string response = kResponseOk;
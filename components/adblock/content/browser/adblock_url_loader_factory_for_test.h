@@ -26,11 +26,13 @@ namespace adblock {
 // A simple class which handles following commands passed via intercepted url
 // in a format `adblock.test.data/[topic]/[action]/[payload]` where:
 // - `topic` is either `domains` (allowed domains), `filters`, `subscriptions`,
-//   `adblock`, `aa` (Acceptable Ads)
+//   `adblock`, `aa` (Acceptable Ads), `profiler` (filter match profiler)
 // - `action` is either:
 //    - `add`, `clear` (remove all), `list`, `remove` valid for `domains`,
 //      `filters` and `subscriptions`
-//    - `enable`, `disable` or `state` valid for `aa` and `adblock`
+//    - `enable`, `disable` or `state` valid for `aa`, `adblock` and
+//      `profiler`
+//    - `list` (statistics as JSON) and `clear` valid for `profiler`
 // - `payload` is url encoded string required for action `add` and `remove`.
 // When adding or removing filter/domain/subscription one can encode several
 // entries splitting them by a new line character.
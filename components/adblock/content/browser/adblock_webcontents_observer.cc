@@ -18,7 +18,8 @@
 #include "components/adblock/content/browser/adblock_webcontents_observer.h"
 
 #include "base/trace_event/trace_event.h"
-#include "components/adblock/core/common/sitekey.h"
+#include "components/adblock/content/browser/document_frame_context.h"
+#include "components/adblock/content/browser/document_special_filters.h"
 #include "components/adblock/core/subscription/subscription_service.h"
 #include "content/public/browser/navigation_handle.h"
 #include "net/base/url_util.h"
@@ -99,22 +100,18 @@ void AdblockWebContentObserver::HandleOnLoad(
                                     "AdblockWebContentObserver::HandleOnLoad",
                                     trace_id, "url", url.spec());
 
-  auto referrers_chain =
-      frame_hierarchy_builder_->BuildFrameHierarchy(frame_host);
-  DVLOG(1) << "[eyeo] Got " << referrers_chain.size() << " referrers for "
-           << url.spec();
-
-  adblock::SiteKey site_key;
-  auto url_key_pair = sitekey_storage_->FindSiteKeyForAnyUrl(referrers_chain);
-  if (url_key_pair.has_value()) {
-    site_key = url_key_pair->second;
-    DVLOG(2) << "[eyeo] Element hiding found siteKey: " << url_key_pair->second
-             << " for url: " << url_key_pair->first;
-  }
+  // Built once for the document, subresource requests it makes share it.
+  auto frame_context = adblock::DocumentFrameContext::Rebuild(
+      frame_host, *frame_hierarchy_builder_, *sitekey_storage_);
+  // Subresource requests of the document reuse the special filters found for
+  // it instead of looking them up every time.
+  adblock::DocumentSpecialFilters::Update(
+      frame_host, frame_context, subscription_service_->GetCurrentSnapshot());
 
   element_hider_->ApplyElementHidingEmulationOnPage(
-      std::move(url), std::move(referrers_chain), frame_host,
-      std::move(site_key), base::BindOnce(&TraceHandleLoadComplete, trace_id));
+      std::move(url), frame_context->frame_hierarchy(), frame_host,
+      frame_context->sitekey(),
+      base::BindOnce(&TraceHandleLoadComplete, trace_id));
 }
 
 WEB_CONTENTS_USER_DATA_KEY_IMPL(AdblockWebContentObserver);
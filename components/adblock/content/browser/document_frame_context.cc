@@ -0,0 +1,109 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/content/browser/document_frame_context.h"
+
+#include <vector>
+
+#include "base/trace_event/trace_event.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/browser/render_frame_host.h"
+#include "url/gurl.h"
+
+namespace adblock {
+namespace {
+
+scoped_refptr<const FrameContext> BuildFrameContext(
+    content::RenderFrameHost* host,
+    const FrameHierarchyBuilder& frame_hierarchy_builder,
+    const SitekeyStorage& sitekey_storage) {
+  TRACE_EVENT1("eyeo", "DocumentFrameContext::BuildFrameContext", "url",
+               host->GetLastCommittedURL().spec());
+  std::vector<GURL> frame_hierarchy =
+      frame_hierarchy_builder.BuildFrameHierarchy(host);
+  DVLOG(1) << "[eyeo] Got " << frame_hierarchy.size()
+           << " frame_hierarchy for " << host->GetLastCommittedURL();
+  SiteKey sitekey;
+  const auto url_key_pair =
+      sitekey_storage.FindSiteKeyForAnyUrl(frame_hierarchy);
+  if (url_key_pair.has_value()) {
+    sitekey = url_key_pair->second;
+    DVLOG(1) << "[eyeo] Found site key: " << sitekey.value()
+             << " for url: " << url_key_pair->first;
+  }
+  return base::MakeRefCounted<FrameContext>(std::move(frame_hierarchy),
+                                            std::move(sitekey));
+}
+
+}  // namespace
+
+DocumentFrameContext::DocumentFrameContext(content::RenderFrameHost* host)
+    : content::DocumentUserData<DocumentFrameContext>(host) {}
+
+DocumentFrameContext::~DocumentFrameContext() = default;
+
+// static
+scoped_refptr<const FrameContext> DocumentFrameContext::Get(
+    content::RenderFrameHost* host) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  DCHECK(host);
+  const auto* data = GetForCurrentDocument(host);
+  return data ? data->frame_context_ : nullptr;
+}
+
+// static
+scoped_refptr<const FrameContext> DocumentFrameContext::GetOrCreate(
+    content::RenderFrameHost* host,
+    const FrameHierarchyBuilder& frame_hierarchy_builder,
+    const SitekeyStorage& sitekey_storage) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  DCHECK(host);
+  auto* data = GetOrCreateForCurrentDocument(host);
+  if (!data->frame_context_) {
+    data->frame_context_ =
+        BuildFrameContext(host, frame_hierarchy_builder, sitekey_storage);
+  }
+  return data->frame_context_;
+}
+
+// static
+scoped_refptr<const FrameContext> DocumentFrameContext::Rebuild(
+    content::RenderFrameHost* host,
+    const FrameHierarchyBuilder& frame_hierarchy_builder,
+    const SitekeyStorage& sitekey_storage) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  DCHECK(host);
+  auto* data = GetOrCreateForCurrentDocument(host);
+  data->frame_context_ =
+      BuildFrameContext(host, frame_hierarchy_builder, sitekey_storage);
+  host->ForEachRenderFrameHost([&](content::RenderFrameHost* frame) {
+    if (frame == host) {
+      return;
+    }
+    // Contexts not built yet will be built from the new hierarchy.
+    auto* descendant_data = GetForCurrentDocument(frame);
+    if (descendant_data && descendant_data->frame_context_) {
+      descendant_data->frame_context_ =
+          BuildFrameContext(frame, frame_hierarchy_builder, sitekey_storage);
+    }
+  });
+  return data->frame_context_;
+}
+
+DOCUMENT_USER_DATA_KEY_IMPL(DocumentFrameContext);
+
+}  // namespace adblock
@@ -0,0 +1,75 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CONTENT_BROWSER_DOCUMENT_FRAME_CONTEXT_H_
+#define COMPONENTS_ADBLOCK_CONTENT_BROWSER_DOCUMENT_FRAME_CONTEXT_H_
+
+#include "base/memory/scoped_refptr.h"
+#include "components/adblock/content/browser/frame_hierarchy_builder.h"
+#include "components/adblock/core/sitekey_storage.h"
+#include "components/adblock/core/subscription/request_context.h"
+#include "content/public/browser/document_user_data.h"
+
+namespace content {
+class RenderFrameHost;
+}  // namespace content
+
+namespace adblock {
+
+// The FrameContext of a document: its frame hierarchy and sitekey, along with
+// the normalized forms of the frames' URLs. Built when the document's
+// navigation commits and shared by the classifications of every request the
+// document makes, instead of walking the frame tree and looking up the
+// sitekey for each of them.
+// Lives on the UI thread.
+class DocumentFrameContext
+    : public content::DocumentUserData<DocumentFrameContext> {
+ public:
+  ~DocumentFrameContext() override;
+  DocumentFrameContext(const DocumentFrameContext&) = delete;
+  DocumentFrameContext& operator=(const DocumentFrameContext&) = delete;
+
+  // Returns the frame context of the current document of |host|, null if it
+  // wasn't built yet.
+  static scoped_refptr<const FrameContext> Get(content::RenderFrameHost* host);
+  // Returns the frame context of the current document of |host|, building it
+  // first if needed, ex. for error pages or requests made before the
+  // navigation of the document finished.
+  static scoped_refptr<const FrameContext> GetOrCreate(
+      content::RenderFrameHost* host,
+      const FrameHierarchyBuilder& frame_hierarchy_builder,
+      const SitekeyStorage& sitekey_storage);
+  // Builds the frame context of the current document of |host| anew, called
+  // when a navigation commits in its frame. The contexts already built for
+  // the documents of descendant frames are rebuilt as well, as a
+  // same-document navigation changes their hierarchy.
+  static scoped_refptr<const FrameContext> Rebuild(
+      content::RenderFrameHost* host,
+      const FrameHierarchyBuilder& frame_hierarchy_builder,
+      const SitekeyStorage& sitekey_storage);
+
+ private:
+  friend class content::DocumentUserData<DocumentFrameContext>;
+  explicit DocumentFrameContext(content::RenderFrameHost* host);
+  DOCUMENT_USER_DATA_KEY_DECL();
+
+  scoped_refptr<const FrameContext> frame_context_;
+};
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CONTENT_BROWSER_DOCUMENT_FRAME_CONTEXT_H_
@@ -0,0 +1,117 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/content/browser/document_special_filters.h"
+
+#include "base/functional/bind.h"
+#include "base/task/thread_pool.h"
+#include "base/trace_event/trace_event.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/browser/render_frame_host.h"
+
+namespace adblock {
+
+DocumentSpecialFilters::DocumentSpecialFilters(content::RenderFrameHost* host)
+    : content::DocumentUserData<DocumentSpecialFilters>(host) {}
+
+DocumentSpecialFilters::~DocumentSpecialFilters() = default;
+
+// static
+void DocumentSpecialFilters::Update(
+    content::RenderFrameHost* host,
+    scoped_refptr<const FrameContext> frame_context,
+    SubscriptionService::Snapshot snapshot) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  DCHECK(host);
+  DCHECK(frame_context);
+  auto find = base::BindOnce(
+      [](const SubscriptionService::Snapshot& snapshot,
+         const scoped_refptr<const FrameContext>& frame_context) {
+        return Find(snapshot, *frame_context);
+      },
+      std::move(snapshot), frame_context);
+  base::ThreadPool::PostTaskAndReplyWithResult(
+      FROM_HERE, {}, std::move(find),
+      base::BindOnce(&DocumentSpecialFilters::Store,
+                     host->GetWeakDocumentPtr(), std::move(frame_context)));
+}
+
+// static
+FrameSpecialFiltersList DocumentSpecialFilters::Get(
+    content::RenderFrameHost* host,
+    const FrameContext& frame_context) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  DCHECK(host);
+  const auto* data = GetForCurrentDocument(host);
+  // Frame contexts are immutable, another one means another hierarchy or
+  // sitekey may have been looked up.
+  if (!data || data->frame_context_.get() != &frame_context) {
+    return {};
+  }
+  return data->filters_;
+}
+
+// static
+void DocumentSpecialFilters::Store(
+    content::WeakDocumentPtr document,
+    scoped_refptr<const FrameContext> frame_context,
+    FrameSpecialFiltersList filters) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  content::RenderFrameHost* host = document.AsRenderFrameHostIfValid();
+  if (!host) {
+    // The document was replaced or its frame destroyed in the meantime.
+    return;
+  }
+  auto* data = GetOrCreateForCurrentDocument(host);
+  data->frame_context_ = std::move(frame_context);
+  data->filters_ = std::move(filters);
+}
+
+// static
+FrameSpecialFiltersList DocumentSpecialFilters::Find(
+    const SubscriptionService::Snapshot& snapshot,
+    const FrameContext& frame_context) {
+  TRACE_EVENT0("eyeo", "DocumentSpecialFilters::Find");
+  FrameSpecialFiltersList filters;
+  filters.reserve(snapshot.size());
+  for (const auto& collection : snapshot) {
+    filters.push_back(collection->FindFrameSpecialFilters(frame_context));
+  }
+  return filters;
+}
+
+// static
+bool DocumentSpecialFilters::IsCurrent(
+    const FrameSpecialFiltersList& filters,
+    const SubscriptionService::Snapshot& snapshot) {
+  if (filters.size() != snapshot.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < snapshot.size(); ++i) {
+    // Collections that don't track their state have no filters to reuse.
+    const uint64_t generation =
+        filters[i] ? filters[i]->generation() : uint64_t{0};
+    if (generation != snapshot[i]->GetGeneration()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+DOCUMENT_USER_DATA_KEY_IMPL(DocumentSpecialFilters);
+
+}  // namespace adblock
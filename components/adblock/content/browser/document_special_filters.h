@@ -0,0 +1,85 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CONTENT_BROWSER_DOCUMENT_SPECIAL_FILTERS_H_
+#define COMPONENTS_ADBLOCK_CONTENT_BROWSER_DOCUMENT_SPECIAL_FILTERS_H_
+
+#include "base/memory/scoped_refptr.h"
+#include "components/adblock/core/subscription/frame_special_filters.h"
+#include "components/adblock/core/subscription/request_context.h"
+#include "components/adblock/core/subscription/subscription_service.h"
+#include "content/public/browser/document_user_data.h"
+#include "content/public/browser/weak_document_ptr.h"
+
+namespace content {
+class RenderFrameHost;
+}  // namespace content
+
+namespace adblock {
+
+// Document-level special filters ($document, $elemhide, $genericblock and
+// $generichide) that apply to a document through its frame or the frame's
+// ancestors. Looked up once when the document commits and handed to the
+// ResourceClassifier with every subresource request the document makes, so
+// the requests don't look them up again. Filters found with an older snapshot
+// are looked up again by the first request that notices, see IsCurrent().
+// Lives on the UI thread, static methods that take no RenderFrameHost or
+// WeakDocumentPtr are thread-safe.
+class DocumentSpecialFilters
+    : public content::DocumentUserData<DocumentSpecialFilters> {
+ public:
+  ~DocumentSpecialFilters() override;
+  DocumentSpecialFilters(const DocumentSpecialFilters&) = delete;
+  DocumentSpecialFilters& operator=(const DocumentSpecialFilters&) = delete;
+
+  // Looks up the filters for |frame_context| with |snapshot| in the background
+  // and stores them on the current document of |host| once found.
+  static void Update(content::RenderFrameHost* host,
+                     scoped_refptr<const FrameContext> frame_context,
+                     SubscriptionService::Snapshot snapshot);
+  // Returns the filters stored on the current document of |host| if they were
+  // found for |frame_context|, an empty list otherwise, ex. when a
+  // same-document navigation replaced the frame context since.
+  static FrameSpecialFiltersList Get(content::RenderFrameHost* host,
+                                     const FrameContext& frame_context);
+  // Stores |filters| found for |frame_context| on |document|, replacing the
+  // ones stored before. Does nothing if |document| is gone.
+  static void Store(content::WeakDocumentPtr document,
+                    scoped_refptr<const FrameContext> frame_context,
+                    FrameSpecialFiltersList filters);
+
+  // Looks up the filters in every collection of |snapshot|.
+  static FrameSpecialFiltersList Find(
+      const SubscriptionService::Snapshot& snapshot,
+      const FrameContext& frame_context);
+  // Whether |filters| were found with the state of every collection of
+  // |snapshot|, so that looking them up again would find the same.
+  static bool IsCurrent(const FrameSpecialFiltersList& filters,
+                        const SubscriptionService::Snapshot& snapshot);
+
+ private:
+  friend class content::DocumentUserData<DocumentSpecialFilters>;
+  explicit DocumentSpecialFilters(content::RenderFrameHost* host);
+  DOCUMENT_USER_DATA_KEY_DECL();
+
+  scoped_refptr<const FrameContext> frame_context_;
+  FrameSpecialFiltersList filters_;
+};
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CONTENT_BROWSER_DOCUMENT_SPECIAL_FILTERS_H_
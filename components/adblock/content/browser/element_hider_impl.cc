@@ -27,6 +27,7 @@
 #include "base/strings/utf_string_conversions.h"
 #include "base/task/thread_pool.h"
 #include "base/trace_event/trace_event.h"
+#include "components/adblock/core/subscription/generic_elemhide_stylesheet.h"
 #include "components/adblock/core/subscription/subscription_service.h"
 #include "components/grit/components_resources.h"
 #include "content/public/browser/browser_thread.h"
@@ -68,27 +69,19 @@ std::string GenerateBlockedElemhideJavaScript(
   return result;
 }
 
-void GenerateStylesheet(const GURL& url,
-                        std::vector<base::StringPiece>& input,
-                        std::string& output) {
+void GenerateStylesheet(
+    const GURL& url,
+    const std::vector<scoped_refptr<const GenericElemhideStylesheet>>&
+        generic_stylesheets,
+    const std::vector<base::StringPiece>& input,
+    std::string& output) {
   TRACE_EVENT1("eyeo", "GenerateStylesheet", "url", url.spec());
-  // Chromium's Blink engine supports only up to 8,192 simple selectors, and
-  // even fewer compound selectors, in a rule. The exact number of selectors
-  // that would work depends on their sizes (e.g. "#foo .bar" has a size of 2).
-  // Since we don't know the sizes of the selectors here, we simply split them
-  // into groups of 1,024, based on the reasonable assumption that the average
-  // selector won't have a size greater than 8. The alternative would be to
-  // calculate the sizes of the selectors and divide them up accordingly, but
-  // this approach is more efficient and has worked well in practice. In theory
-  // this could still lead to some selectors not working on Chromium, but it is
-  // highly unlikely.
-  const size_t max_selector_count = 1024u;
-  for (size_t i = 0; i < input.size(); i += max_selector_count) {
-    const size_t batch_size = std::min(max_selector_count, input.size() - i);
-    const base::span<base::StringPiece> selectors_batch(&input[i], batch_size);
-    output += base::JoinString(selectors_batch, ", ") +
-              " {display: none !important;}\n";
+  // Shared stylesheets come pre-rendered, only the frame's own selectors are
+  // rendered here.
+  for (const auto& generic_stylesheet : generic_stylesheets) {
+    output += generic_stylesheet->stylesheet();
   }
+  AppendElemhideRules(input, output);
 }
 
 void GenerateElemHidingEmuJavaScript(
@@ -137,6 +130,8 @@ ElementHider::ElemhideInjectionData PrepareElemhideEmulationData(
     const SiteKey sitekey) {
   TRACE_EVENT1("eyeo", "PrepareElemhideEmulationData", "url", url.spec());
 
+  std::vector<scoped_refptr<const GenericElemhideStylesheet>>
+      generic_stylesheets;
   std::vector<base::StringPiece> stylesheet;
   std::vector<base::StringPiece> elemhide_js;
   base::Value::List snippet_js;
@@ -148,9 +143,14 @@ ElementHider::ElemhideInjectionData PrepareElemhideEmulationData(
         collection->FindBySpecialFilter(SpecialFilterType::Elemhide, url,
                                         frame_hierarchy, sitekey);
     if (!ehe_allowlisted) {
-      base::ranges::copy(
-          collection->GetElementHideSelectors(url, frame_hierarchy, sitekey),
-          std::back_inserter(stylesheet));
+      auto element_hide_data =
+          collection->GetElementHideData(url, frame_hierarchy, sitekey);
+      if (element_hide_data.generic_stylesheet) {
+        generic_stylesheets.push_back(
+            std::move(element_hide_data.generic_stylesheet));
+      }
+      base::ranges::copy(element_hide_data.selectors,
+                         std::back_inserter(stylesheet));
       base::ranges::copy(collection->GetElementHideEmulationSelectors(url),
                          std::back_inserter(elemhide_js));
     }
@@ -161,10 +161,12 @@ ElementHider::ElemhideInjectionData PrepareElemhideEmulationData(
     }
   }
   ElementHider::ElemhideInjectionData result;
-  if (!stylesheet.empty()) {
-    DVLOG(2) << "[eyeo] Got " << stylesheet.size() << " EH selectors for url "
+  if (!stylesheet.empty() || !generic_stylesheets.empty()) {
+    DVLOG(2) << "[eyeo] Got " << stylesheet.size() << " EH selectors and "
+             << generic_stylesheets.size() << " shared stylesheets for url "
              << url;
-    GenerateStylesheet(url, stylesheet, result.stylesheet);
+    GenerateStylesheet(url, generic_stylesheets, stylesheet,
+                       result.stylesheet);
   }
   if (!elemhide_js.empty()) {
     DVLOG(2) << "[eyeo] Got " << elemhide_js.size()
@@ -21,8 +21,11 @@
 #include "base/task/task_traits.h"
 #include "base/task/thread_pool.h"
 #include "base/trace_event/trace_event.h"
+#include "components/adblock/content/browser/document_frame_context.h"
+#include "components/adblock/content/browser/document_special_filters.h"
 #include "components/adblock/core/common/adblock_utils.h"
 #include "components/adblock/core/common/sitekey.h"
+#include "content/public/browser/browser_task_traits.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/render_frame_host.h"
 #include "services/network/public/mojom/url_response_head.mojom.h"
@@ -37,10 +40,11 @@ namespace {
 absl::optional<GURL> HasRewriteHelper(
     const SubscriptionService::Snapshot subscription_collections,
     const GURL& request_url,
-    const std::vector<GURL>& frame_hierarchy) {
+    const scoped_refptr<const FrameContext>& frame_context) {
   absl::optional<GURL> rewrite_url = absl::nullopt;
   for (const auto& collection : subscription_collections) {
-    rewrite_url = collection->GetRewriteUrl(request_url, frame_hierarchy);
+    rewrite_url = collection->GetRewriteUrl(request_url,
+                                            frame_context->frame_hierarchy());
     if (rewrite_url) {
       break;
     }
@@ -115,13 +119,13 @@ FilterMatchResult ResourceClassificationRunnerImpl::ShouldBlockPopup(
   TRACE_EVENT1("eyeo", "ResourceClassificationRunnerImpl::ShouldBlockPopup",
                "popup_url", popup_url.spec());
 
-  const auto frame_hierarchy =
-      frame_hierarchy_builder_->BuildFrameHierarchy(frame_host);
-  const auto sitekey = sitekey_storage_->FindSiteKeyForAnyUrl(frame_hierarchy);
+  const auto frame_context = DocumentFrameContext::GetOrCreate(
+      frame_host, *frame_hierarchy_builder_, *sitekey_storage_);
+  const auto& frame_hierarchy = frame_context->frame_hierarchy();
 
   auto classification_result = resource_classifier_->ClassifyPopup(
       subscription_collections, popup_url, frame_hierarchy,
-      sitekey ? sitekey->second : SiteKey());
+      frame_context->sitekey());
   if (classification_result.decision == ClassificationDecision::Ignored) {
     return FilterMatchResult::kNoRule;
   }
@@ -232,31 +236,22 @@ void ResourceClassificationRunnerImpl::CheckRequestFilterMatchImpl(
     std::move(callback).Run(FilterMatchResult::kNoRule);
     return;
   }
-  const std::vector<GURL> frame_hierarchy_chain =
-      frame_hierarchy_builder_->BuildFrameHierarchy(host);
-
-  DVLOG(1) << "[eyeo] Got " << frame_hierarchy_chain.size()
-           << " frame_hierarchy for " << request_url.spec();
-
-  auto site_key_pair =
-      sitekey_storage_->FindSiteKeyForAnyUrl(frame_hierarchy_chain);
-  SiteKey site_key;
-  if (site_key_pair.has_value()) {
-    site_key = site_key_pair->second;
-    DVLOG(1) << "[eyeo] Found site key: " << site_key.value()
-             << " for url: " << site_key_pair->first;
-  }
+  // Built once per document, normally when its navigation committed.
+  auto frame_context = DocumentFrameContext::GetOrCreate(
+      host, *frame_hierarchy_builder_, *sitekey_storage_);
+  auto frame_special_filters =
+      DocumentSpecialFilters::Get(host, *frame_context);
 
   base::ThreadPool::PostTaskAndReplyWithResult(
       FROM_HERE, {},
       base::BindOnce(
           &ResourceClassificationRunnerImpl::CheckRequestFilterMatchInternal,
           resource_classifier_, std::move(subscription_collections),
-          request_url, frame_hierarchy_chain, adblock_resource_type,
-          std::move(site_key)),
+          request_url, frame_context, adblock_resource_type,
+          std::move(frame_special_filters), host->GetWeakDocumentPtr()),
       base::BindOnce(
           &ResourceClassificationRunnerImpl::OnCheckResourceFilterMatchComplete,
-          weak_ptr_factory_.GetWeakPtr(), request_url, frame_hierarchy_chain,
+          weak_ptr_factory_.GetWeakPtr(), request_url, frame_context,
           adblock_resource_type, frame_host_id, std::move(callback)));
 }
 
@@ -266,9 +261,10 @@ ResourceClassificationRunnerImpl::CheckRequestFilterMatchInternal(
     const scoped_refptr<ResourceClassifier>& resource_classifier,
     SubscriptionService::Snapshot subscription_collections,
     const GURL request_url,
-    const std::vector<GURL> frame_hierarchy,
+    const scoped_refptr<const FrameContext> frame_context,
     ContentType adblock_resource_type,
-    const SiteKey sitekey) {
+    FrameSpecialFiltersList frame_special_filters,
+    content::WeakDocumentPtr document) {
   TRACE_EVENT1("eyeo",
                "ResourceClassificationRunnerImpl::"
                "CheckRequestFilterMatchInternal",
@@ -276,9 +272,22 @@ ResourceClassificationRunnerImpl::CheckRequestFilterMatchInternal(
 
   DVLOG(1) << "[eyeo] CheckRequestFilterMatchInternal start";
 
+  if (!DocumentSpecialFilters::IsCurrent(frame_special_filters,
+                                         subscription_collections)) {
+    // The lookup made when the document committed isn't done yet, or a new
+    // snapshot was published since. Look them up once more for this request
+    // and the following ones.
+    frame_special_filters =
+        DocumentSpecialFilters::Find(subscription_collections, *frame_context);
+    content::GetUIThreadTaskRunner({})->PostTask(
+        FROM_HERE,
+        base::BindOnce(&DocumentSpecialFilters::Store, std::move(document),
+                       frame_context, frame_special_filters));
+  }
+
   auto classification_result = resource_classifier->ClassifyRequest(
-      std::move(subscription_collections), request_url, frame_hierarchy,
-      adblock_resource_type, sitekey);
+      std::move(subscription_collections), request_url, *frame_context,
+      adblock_resource_type, frame_special_filters);
 
   if (classification_result.decision == ClassificationDecision::Allowed) {
     VLOG(1) << "[eyeo] Document allowed due to allowing filter " << request_url;
@@ -299,7 +308,7 @@ ResourceClassificationRunnerImpl::CheckRequestFilterMatchInternal(
 
 void ResourceClassificationRunnerImpl::OnCheckResourceFilterMatchComplete(
     const GURL request_url,
-    const std::vector<GURL> frame_hierarchy,
+    const scoped_refptr<const FrameContext> frame_context,
     ContentType adblock_resource_type,
     content::GlobalRenderFrameHostId render_frame_host_id,
     CheckFilterMatchCallback callback,
@@ -314,9 +323,9 @@ void ResourceClassificationRunnerImpl::OnCheckResourceFilterMatchComplete(
     // when there was NO_RULE.
     if (result.status == FilterMatchResult::kAllowRule ||
         result.status == FilterMatchResult::kBlockRule) {
-      NotifyAdMatched(request_url, result.status, frame_hierarchy,
-                      adblock_resource_type, render_frame_host,
-                      result.subscription);
+      NotifyAdMatched(request_url, result.status,
+                      frame_context->frame_hierarchy(), adblock_resource_type,
+                      render_frame_host, result.subscription);
     }
   }
 }
@@ -356,18 +365,19 @@ void ResourceClassificationRunnerImpl::CheckResponseFilterMatch(
     return;
   }
 
-  auto frame_hierarchy = frame_hierarchy_builder_->BuildFrameHierarchy(host);
+  auto frame_context = DocumentFrameContext::GetOrCreate(
+      host, *frame_hierarchy_builder_, *sitekey_storage_);
   // ResponseFilterMatch might take a while, let it run in the background.
   base::ThreadPool::PostTaskAndReplyWithResult(
       FROM_HERE, {},
       base::BindOnce(
           &ResourceClassificationRunnerImpl::CheckResponseFilterMatchInternal,
           resource_classifier_, std::move(subscription_collections),
-          response_url, frame_hierarchy, adblock_resource_type,
+          response_url, frame_context, adblock_resource_type,
           std::move(headers)),
       base::BindOnce(
           &ResourceClassificationRunnerImpl::OnCheckResourceFilterMatchComplete,
-          weak_ptr_factory_.GetWeakPtr(), response_url, frame_hierarchy,
+          weak_ptr_factory_.GetWeakPtr(), response_url, frame_context,
           adblock_resource_type, host->GetGlobalId(), std::move(callback)));
 }
 
@@ -377,12 +387,13 @@ ResourceClassificationRunnerImpl::CheckResponseFilterMatchInternal(
     const scoped_refptr<ResourceClassifier> resource_classifier,
     SubscriptionService::Snapshot subscription_collections,
     const GURL response_url,
-    const std::vector<GURL> frame_hierarchy,
+    const scoped_refptr<const FrameContext> frame_context,
     ContentType adblock_resource_type,
     const scoped_refptr<net::HttpResponseHeaders> response_headers) {
   auto classification_result = resource_classifier->ClassifyResponse(
-      std::move(subscription_collections), response_url, frame_hierarchy,
-      adblock_resource_type, response_headers);
+      std::move(subscription_collections), response_url,
+      frame_context->frame_hierarchy(), adblock_resource_type,
+      response_headers);
 
   if (classification_result.decision == ClassificationDecision::Allowed) {
     VLOG(1) << "[eyeo] Document allowed due to allowing filter "
@@ -417,12 +428,12 @@ void ResourceClassificationRunnerImpl::CheckRewriteFilterMatch(
     return;
   }
 
-  const std::vector<GURL> frame_hierarchy =
-      frame_hierarchy_builder_->BuildFrameHierarchy(host);
+  auto frame_context = DocumentFrameContext::GetOrCreate(
+      host, *frame_hierarchy_builder_, *sitekey_storage_);
   base::ThreadPool::PostTaskAndReplyWithResult(
       FROM_HERE, {},
       base::BindOnce(&HasRewriteHelper, std::move(subscription_collections),
-                     request_url, frame_hierarchy),
+                     request_url, std::move(frame_context)),
       std::move(callback));
 }
 
@@ -25,7 +25,10 @@
 #include "components/adblock/core/classifier/resource_classifier.h"
 #include "components/adblock/core/common/sitekey.h"
 #include "components/adblock/core/sitekey_storage.h"
+#include "components/adblock/core/subscription/frame_special_filters.h"
+#include "components/adblock/core/subscription/request_context.h"
 #include "content/public/browser/global_routing_id.h"
+#include "content/public/browser/weak_document_ptr.h"
 
 namespace adblock {
 
@@ -101,13 +104,14 @@ class ResourceClassificationRunnerImpl final
       const scoped_refptr<ResourceClassifier>& resource_classifier,
       SubscriptionService::Snapshot subscription_collections,
       const GURL request_url,
-      const std::vector<GURL> frame_hierarchy,
+      const scoped_refptr<const FrameContext> frame_context,
       ContentType adblock_resource_type,
-      const SiteKey sitekey);
+      FrameSpecialFiltersList frame_special_filters,
+      content::WeakDocumentPtr document);
 
   void OnCheckResourceFilterMatchComplete(
       const GURL request_url,
-      const std::vector<GURL> frame_hierarchy,
+      const scoped_refptr<const FrameContext> frame_context,
       ContentType adblock_resource_type,
       content::GlobalRenderFrameHostId render_frame_host_id,
       CheckFilterMatchCallback callback,
@@ -117,7 +121,7 @@ class ResourceClassificationRunnerImpl final
       const scoped_refptr<ResourceClassifier> resource_classifier,
       SubscriptionService::Snapshot subscription_collections,
       const GURL response_url,
-      const std::vector<GURL> frame_hierarchy,
+      const scoped_refptr<const FrameContext> frame_context,
       ContentType adblock_resource_type,
       const scoped_refptr<net::HttpResponseHeaders> response_headers);
 
@@ -0,0 +1,100 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/content/browser/document_frame_context.h"
+
+#include <vector>
+
+#include "components/adblock/content/browser/test/mock_frame_hierarchy_builder.h"
+#include "components/adblock/core/test/mock_sitekey_storage.h"
+#include "content/public/test/test_renderer_host.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace adblock {
+
+using testing::_;
+using testing::Return;
+
+class AdblockDocumentFrameContextTest
+    : public content::RenderViewHostTestHarness {
+ public:
+  void SetUp() override {
+    content::RenderViewHostTestHarness::SetUp();
+    NavigateAndCommit(kPageUrl);
+    ON_CALL(sitekey_storage_, FindSiteKeyForAnyUrl(_))
+        .WillByDefault(Return(absl::nullopt));
+  }
+
+  const GURL kPageUrl{"https://page.com/"};
+  const GURL kFrameUrl{"https://frame.com/"};
+  MockFrameHierarchyBuilder frame_hierarchy_builder_;
+  testing::NiceMock<MockSitekeyStorage> sitekey_storage_;
+};
+
+TEST_F(AdblockDocumentFrameContextTest, BuiltOncePerDocument) {
+  EXPECT_CALL(frame_hierarchy_builder_, BuildFrameHierarchy(main_rfh()))
+      .WillOnce(Return(std::vector<GURL>{kPageUrl}));
+  EXPECT_CALL(sitekey_storage_,
+              FindSiteKeyForAnyUrl(std::vector<GURL>{kPageUrl}))
+      .WillOnce(Return(std::make_pair(kPageUrl, SiteKey("abc"))));
+
+  EXPECT_FALSE(DocumentFrameContext::Get(main_rfh()));
+  const auto frame_context = DocumentFrameContext::GetOrCreate(
+      main_rfh(), frame_hierarchy_builder_, sitekey_storage_);
+  ASSERT_TRUE(frame_context);
+  EXPECT_EQ(frame_context->frame_hierarchy(), std::vector<GURL>{kPageUrl});
+  EXPECT_EQ(frame_context->sitekey(), SiteKey("abc"));
+  EXPECT_EQ(frame_context->document_domain(), "page.com");
+  EXPECT_EQ(DocumentFrameContext::GetOrCreate(
+                main_rfh(), frame_hierarchy_builder_, sitekey_storage_),
+            frame_context);
+  EXPECT_EQ(DocumentFrameContext::Get(main_rfh()), frame_context);
+
+  // A new document starts without one.
+  NavigateAndCommit(GURL("https://other.com/"));
+  EXPECT_FALSE(DocumentFrameContext::Get(main_rfh()));
+}
+
+TEST_F(AdblockDocumentFrameContextTest, RebuildReplacesContextsOfDescendants) {
+  auto* tester = content::RenderFrameHostTester::For(main_rfh());
+  content::RenderFrameHost* built_child = tester->AppendChild("built");
+  content::RenderFrameHost* unbuilt_child = tester->AppendChild("unbuilt");
+  ON_CALL(frame_hierarchy_builder_, BuildFrameHierarchy(_))
+      .WillByDefault(Return(std::vector<GURL>{kFrameUrl, kPageUrl}));
+  ON_CALL(frame_hierarchy_builder_, BuildFrameHierarchy(main_rfh()))
+      .WillByDefault(Return(std::vector<GURL>{kPageUrl}));
+
+  const auto old_child_context = DocumentFrameContext::GetOrCreate(
+      built_child, frame_hierarchy_builder_, sitekey_storage_);
+
+  // A same-document navigation of the main frame changes the hierarchy of
+  // its children.
+  EXPECT_CALL(frame_hierarchy_builder_, BuildFrameHierarchy(main_rfh()));
+  EXPECT_CALL(frame_hierarchy_builder_, BuildFrameHierarchy(built_child));
+  EXPECT_CALL(frame_hierarchy_builder_, BuildFrameHierarchy(unbuilt_child))
+      .Times(0);
+  const auto main_context = DocumentFrameContext::Rebuild(
+      main_rfh(), frame_hierarchy_builder_, sitekey_storage_);
+  EXPECT_EQ(DocumentFrameContext::Get(main_rfh()), main_context);
+  const auto new_child_context = DocumentFrameContext::Get(built_child);
+  ASSERT_TRUE(new_child_context);
+  EXPECT_NE(new_child_context, old_child_context);
+  EXPECT_FALSE(DocumentFrameContext::Get(unbuilt_child));
+}
+
+}  // namespace adblock
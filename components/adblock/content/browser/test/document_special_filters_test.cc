@@ -0,0 +1,117 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/content/browser/document_special_filters.h"
+
+#include <memory>
+#include <vector>
+
+#include "base/memory/scoped_refptr.h"
+#include "components/adblock/core/subscription/subscription_collection_impl.h"
+#include "components/adblock/core/subscription/test/mock_subscription_collection.h"
+#include "content/public/test/test_renderer_host.h"
+#include "gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace adblock {
+
+using testing::Return;
+
+class AdblockDocumentSpecialFiltersTest
+    : public content::RenderViewHostTestHarness {
+ public:
+  void SetUp() override {
+    content::RenderViewHostTestHarness::SetUp();
+    NavigateAndCommit(kPageUrl);
+  }
+
+  static scoped_refptr<const FrameSpecialFilters> MakeFilters(
+      uint64_t generation) {
+    FrameSpecialFilters::Positions positions;
+    positions[static_cast<size_t>(SpecialFilterType::Genericblock)] = 0u;
+    return base::MakeRefCounted<FrameSpecialFilters>(generation, positions);
+  }
+
+  const GURL kPageUrl{"https://page.com/"};
+  const scoped_refptr<const FrameContext> kFrameContext =
+      base::MakeRefCounted<FrameContext>(std::vector<GURL>{kPageUrl},
+                                         SiteKey("abc"));
+};
+
+TEST_F(AdblockDocumentSpecialFiltersTest, StoredFiltersReturnedForSameFrame) {
+  const FrameSpecialFiltersList filters{MakeFilters(1u)};
+  DocumentSpecialFilters::Store(main_rfh()->GetWeakDocumentPtr(),
+                                kFrameContext, filters);
+
+  EXPECT_EQ(DocumentSpecialFilters::Get(main_rfh(), *kFrameContext), filters);
+  // Filters found for another frame context don't apply, even if it's equal.
+  const auto other_context = base::MakeRefCounted<FrameContext>(
+      kFrameContext->frame_hierarchy(), kFrameContext->sitekey());
+  EXPECT_TRUE(DocumentSpecialFilters::Get(main_rfh(), *other_context).empty());
+}
+
+TEST_F(AdblockDocumentSpecialFiltersTest, FiltersDroppedWithDocument) {
+  auto document = main_rfh()->GetWeakDocumentPtr();
+  DocumentSpecialFilters::Store(document, kFrameContext, {MakeFilters(1u)});
+
+  NavigateAndCommit(GURL("https://other.com/"));
+  EXPECT_TRUE(DocumentSpecialFilters::Get(main_rfh(), *kFrameContext).empty());
+
+  // Lookups that finish after the document is gone are discarded.
+  DocumentSpecialFilters::Store(document, kFrameContext, {MakeFilters(1u)});
+  EXPECT_TRUE(DocumentSpecialFilters::Get(main_rfh(), *kFrameContext).empty());
+}
+
+TEST_F(AdblockDocumentSpecialFiltersTest, CurrentWhileGenerationsMatch) {
+  auto tracked = std::make_unique<MockSubscriptionCollection>();
+  EXPECT_CALL(*tracked, GetGeneration()).WillRepeatedly(Return(7u));
+  auto untracked = std::make_unique<MockSubscriptionCollection>();
+  EXPECT_CALL(*untracked, GetGeneration()).WillRepeatedly(Return(0u));
+  SubscriptionService::Snapshot snapshot;
+  snapshot.push_back(std::move(tracked));
+  snapshot.push_back(std::move(untracked));
+
+  EXPECT_TRUE(
+      DocumentSpecialFilters::IsCurrent({MakeFilters(7u), nullptr}, snapshot));
+  // Found with an older state of the first collection.
+  EXPECT_FALSE(
+      DocumentSpecialFilters::IsCurrent({MakeFilters(6u), nullptr}, snapshot));
+  // Not found yet.
+  EXPECT_FALSE(DocumentSpecialFilters::IsCurrent({}, snapshot));
+  // Found for a snapshot with other collections.
+  EXPECT_FALSE(DocumentSpecialFilters::IsCurrent({MakeFilters(7u)}, snapshot));
+}
+
+TEST_F(AdblockDocumentSpecialFiltersTest, UpdateStoresFiltersOfSnapshot) {
+  const uint64_t generation = SubscriptionCollection::NextGeneration();
+  SubscriptionService::Snapshot snapshot;
+  snapshot.push_back(std::make_unique<SubscriptionCollectionImpl>(
+      std::vector<scoped_refptr<InstalledSubscription>>{}, nullptr,
+      generation));
+
+  DocumentSpecialFilters::Update(main_rfh(), kFrameContext,
+                                 std::move(snapshot));
+  task_environment()->RunUntilIdle();
+
+  const auto filters = DocumentSpecialFilters::Get(main_rfh(), *kFrameContext);
+  ASSERT_EQ(filters.size(), 1u);
+  ASSERT_TRUE(filters[0]);
+  EXPECT_EQ(filters[0]->generation(), generation);
+  EXPECT_EQ(filters[0]->Find(SpecialFilterType::Document), absl::nullopt);
+}
+
+}  // namespace adblock
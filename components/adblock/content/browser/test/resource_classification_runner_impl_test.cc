@@ -106,12 +106,17 @@ class AdblockResourceClassificationRunnerImplTest
         .WillOnce(Return(kFrameHierarchy));
   }
 
+  // Matches the FrameContext built for kFrameHierarchy and kSitekey.
+  auto IsFrameContext() const {
+    return AllOf(Property(&FrameContext::frame_hierarchy, kFrameHierarchy),
+                 Property(&FrameContext::sitekey, kSitekey));
+  }
+
   void ClassifierReturnsRequestClassification(GURL url,
                                               ContentType content_type,
                                               Decision decision) {
-    EXPECT_CALL(
-        *mock_resource_classifier_,
-        ClassifyRequest(_, url, kFrameHierarchy, content_type, kSitekey))
+    EXPECT_CALL(*mock_resource_classifier_,
+                ClassifyRequest(_, url, IsFrameContext(), content_type, _))
         .WillOnce(testing::Return(ResourceClassifier::ClassificationResult{
             decision, kSubscriptionUrl}));
   }
@@ -202,6 +207,36 @@ TEST_F(AdblockResourceClassificationRunnerImplTest,
   task_environment()->RunUntilIdle();
 }
 
+TEST_F(AdblockResourceClassificationRunnerImplTest,
+       FrameHierarchyBuiltOncePerFrame) {
+  EXPECT_CALL(*mock_frame_hierarchy_builder_,
+              FindRenderFrameHost(main_rfh()->GetGlobalId()))
+      .Times(2)
+      .WillRepeatedly(Return(main_rfh()));
+  // Requests made by the same document share its frame context.
+  EXPECT_CALL(*mock_frame_hierarchy_builder_, BuildFrameHierarchy(main_rfh()))
+      .WillOnce(Return(kFrameHierarchy));
+  EXPECT_CALL(mock_sitekey_storage_, FindSiteKeyForAnyUrl(kFrameHierarchy))
+      .WillOnce(Return(std::make_pair(kFrameHierarchy.front(), kSitekey)));
+  EXPECT_CALL(*mock_resource_classifier_,
+              ClassifyRequest(_, _, IsFrameContext(), ContentType::Image, _))
+      .Times(2)
+      .WillRepeatedly(Return(ResourceClassifier::ClassificationResult{
+          Decision::Ignored, {}}));
+
+  base::MockCallback<CheckFilterMatchCallback> callback;
+  EXPECT_CALL(callback, Run(FilterMatchResult::kNoRule)).Times(2);
+
+  classification_runner_->CheckRequestFilterMatch(
+      SubscriptionService::Snapshot(), kUrl, ContentType::Image,
+      main_rfh()->GetGlobalId(), callback.Get());
+  task_environment()->RunUntilIdle();
+  classification_runner_->CheckRequestFilterMatch(
+      SubscriptionService::Snapshot(), GURL("https://test.com/other.x"),
+      ContentType::Image, main_rfh()->GetGlobalId(), callback.Get());
+  task_environment()->RunUntilIdle();
+}
+
 TEST_F(AdblockResourceClassificationRunnerImplTest,
        CheckRequestFilterMatch_RenderFrameHostNotFound) {
   // FrameHierarchyBuilder will be unable to find a RFH for the provided IDs.
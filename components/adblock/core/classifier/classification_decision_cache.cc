@@ -0,0 +1,140 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/classifier/classification_decision_cache.h"
+
+#include <algorithm>
+#include <tuple>
+
+#include "base/hash/hash.h"
+
+namespace adblock {
+namespace {
+
+// Whether |generation| was taken from a snapshot published after the one
+// |current| was taken from. Collections only ever move to higher generations.
+// When configurations were added or removed, the snapshots can't be compared
+// per collection, the one with the most recently created collection is newer.
+bool IsNewer(const ClassificationDecisionCache::SnapshotGeneration& generation,
+             const ClassificationDecisionCache::SnapshotGeneration& current) {
+  if (generation.size() != current.size()) {
+    const auto latest =
+        [](const ClassificationDecisionCache::SnapshotGeneration& snapshot) {
+          return snapshot.empty()
+                     ? uint64_t{0}
+                     : *std::max_element(snapshot.begin(), snapshot.end());
+        };
+    return latest(generation) > latest(current);
+  }
+  bool newer = false;
+  for (size_t i = 0; i < generation.size(); ++i) {
+    if (generation[i] < current[i]) {
+      return false;
+    }
+    newer |= generation[i] > current[i];
+  }
+  return newer;
+}
+
+}  // namespace
+
+bool ClassificationDecisionCache::Key::operator<(const Key& other) const {
+  return std::tie(url, frame_hierarchy_hash, content_type, sitekey) <
+         std::tie(other.url, other.frame_hierarchy_hash, other.content_type,
+                  other.sitekey);
+}
+
+ClassificationDecisionCache::ClassificationDecisionCache(size_t capacity)
+    : entries_(capacity) {}
+
+ClassificationDecisionCache::~ClassificationDecisionCache() = default;
+
+// static
+absl::optional<ClassificationDecisionCache::SnapshotGeneration>
+ClassificationDecisionCache::GetSnapshotGeneration(
+    const SubscriptionService::Snapshot& snapshot) {
+  SnapshotGeneration generation;
+  generation.reserve(snapshot.size());
+  for (const auto& collection : snapshot) {
+    const uint64_t collection_generation = collection->GetGeneration();
+    if (collection_generation == 0u) {
+      return absl::nullopt;
+    }
+    generation.push_back(collection_generation);
+  }
+  return generation;
+}
+
+// static
+ClassificationDecisionCache::Key ClassificationDecisionCache::MakeKey(
+    const GURL& request_url,
+    const std::vector<GURL>& frame_hierarchy,
+    ContentType content_type,
+    const SiteKey& sitekey) {
+  size_t frame_hierarchy_hash = frame_hierarchy.size();
+  for (const auto& frame : frame_hierarchy) {
+    frame_hierarchy_hash =
+        base::HashInts(frame_hierarchy_hash, base::FastHash(frame.spec()));
+  }
+  return {request_url.spec(), frame_hierarchy_hash, content_type,
+          sitekey.value()};
+}
+
+absl::optional<ResourceClassifier::ClassificationResult>
+ClassificationDecisionCache::Lookup(const SnapshotGeneration& generation,
+                                    const Key& key) {
+  base::AutoLock lock(lock_);
+  if (generation == generation_) {
+    const auto it = entries_.Get(key);
+    if (it != entries_.end()) {
+      ++hits_;
+      return it->second;
+    }
+  }
+  ++misses_;
+  return absl::nullopt;
+}
+
+void ClassificationDecisionCache::Store(
+    const SnapshotGeneration& generation,
+    const Key& key,
+    const ResourceClassifier::ClassificationResult& result) {
+  base::AutoLock lock(lock_);
+  if (generation != generation_) {
+    if (!IsNewer(generation, generation_)) {
+      // The decision was made with a snapshot that has been replaced since,
+      // while the request was classified.
+      return;
+    }
+    // A new snapshot was published, all entries are outdated.
+    entries_.Clear();
+    generation_ = generation;
+  }
+  entries_.Put(key, result);
+}
+
+size_t ClassificationDecisionCache::GetHitCount() const {
+  base::AutoLock lock(lock_);
+  return hits_;
+}
+
+size_t ClassificationDecisionCache::GetMissCount() const {
+  base::AutoLock lock(lock_);
+  return misses_;
+}
+
+}  // namespace adblock
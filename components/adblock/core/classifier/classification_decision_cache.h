@@ -0,0 +1,98 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CORE_CLASSIFIER_CLASSIFICATION_DECISION_CACHE_H_
+#define COMPONENTS_ADBLOCK_CORE_CLASSIFIER_CLASSIFICATION_DECISION_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/types/optional.h"
+#include "base/containers/lru_cache.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "components/adblock/core/classifier/resource_classifier.h"
+#include "components/adblock/core/common/content_type.h"
+#include "components/adblock/core/common/sitekey.h"
+#include "components/adblock/core/subscription/subscription_service.h"
+#include "url/gurl.h"
+
+namespace adblock {
+
+// Remembers recent request classification decisions. Pages request the same
+// trackers and CDN resources over and over, and a decision only depends on the
+// request and on the SubscriptionService::Snapshot it was made with.
+// Entries are tagged with the generation of that snapshot. Storing a decision
+// made with a newer snapshot drops all entries at once, so a decision is never
+// served for a snapshot it wasn't made with. Decisions made with an older
+// snapshot, by requests that started before it was replaced, are not stored.
+// Bounded, the least recently used entry is evicted first. Thread-safe.
+class ClassificationDecisionCache {
+ public:
+  struct Key {
+    bool operator<(const Key& other) const;
+
+    std::string url;
+    // Hash of all frame URLs, from the innermost frame up.
+    size_t frame_hierarchy_hash;
+    ContentType content_type;
+    std::string sitekey;
+  };
+  // Generations of all collections of a snapshot, in snapshot order.
+  using SnapshotGeneration = std::vector<uint64_t>;
+
+  static constexpr size_t kDefaultCapacity = 1024u;
+
+  explicit ClassificationDecisionCache(size_t capacity = kDefaultCapacity);
+  ~ClassificationDecisionCache();
+  ClassificationDecisionCache(const ClassificationDecisionCache&) = delete;
+  ClassificationDecisionCache& operator=(const ClassificationDecisionCache&) =
+      delete;
+
+  // Returns nullopt if any collection of |snapshot| does not track its state,
+  // decisions made with such a snapshot cannot be cached.
+  static absl::optional<SnapshotGeneration> GetSnapshotGeneration(
+      const SubscriptionService::Snapshot& snapshot);
+  static Key MakeKey(const GURL& request_url,
+                     const std::vector<GURL>& frame_hierarchy,
+                     ContentType content_type,
+                     const SiteKey& sitekey);
+
+  absl::optional<ResourceClassifier::ClassificationResult> Lookup(
+      const SnapshotGeneration& generation,
+      const Key& key);
+  void Store(const SnapshotGeneration& generation,
+             const Key& key,
+             const ResourceClassifier::ClassificationResult& result);
+
+  size_t GetHitCount() const;
+  size_t GetMissCount() const;
+
+ private:
+  mutable base::Lock lock_;
+  SnapshotGeneration generation_ GUARDED_BY(lock_);
+  base::LRUCache<Key, ResourceClassifier::ClassificationResult> entries_
+      GUARDED_BY(lock_);
+  size_t hits_ GUARDED_BY(lock_) = 0u;
+  size_t misses_ GUARDED_BY(lock_) = 0u;
+};
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CORE_CLASSIFIER_CLASSIFICATION_DECISION_CACHE_H_
@@ -24,6 +24,8 @@
 #include "base/memory/scoped_refptr.h"
 #include "components/adblock/core/common/content_type.h"
 #include "components/adblock/core/common/sitekey.h"
+#include "components/adblock/core/subscription/frame_special_filters.h"
+#include "components/adblock/core/subscription/request_context.h"
 #include "components/adblock/core/subscription/subscription_service.h"
 #include "net/http/http_response_headers.h"
 #include "url/gurl.h"
@@ -51,12 +53,17 @@ class ResourceClassifier
     GURL decisive_subscription;
   };
 
+  // |frame_context| describes the document that made the request.
+  // |frame_special_filters| may hold filters found for |frame_context| with
+  // SubscriptionCollection::FindFrameSpecialFilters(), they are used for
+  // collections of |subscription_collections| whose generation they match and
+  // spare looking up the frames' filters again.
   virtual ClassificationResult ClassifyRequest(
       const SubscriptionService::Snapshot subscription_collections,
       const GURL& request_url,
-      const std::vector<GURL>& frame_hierarchy,
+      const FrameContext& frame_context,
       ContentType content_type,
-      const SiteKey& sitekey) const = 0;
+      const FrameSpecialFiltersList& frame_special_filters) const = 0;
 
   virtual ClassificationResult ClassifyPopup(
       const SubscriptionService::Snapshot& subscription_collections,
@@ -19,7 +19,9 @@
 
 #include "base/strings/string_split.h"
 #include "components/adblock/core/common/adblock_utils.h"
+#include "components/adblock/core/subscription/fused_url_filter_index.h"
 #include "components/adblock/core/subscription/installed_subscription.h"
+#include "components/adblock/core/subscription/request_context.h"
 
 namespace adblock {
 namespace {
@@ -58,47 +60,28 @@ bool ContainsHeaderValue(const scoped_refptr<net::HttpResponseHeaders>& headers,
 
 ClassificationResult ClassifyRequestWithSingleCollection(
     const SubscriptionCollection& subscription_collection,
-    const GURL& request_url,
-    const std::vector<GURL>& frame_hierarchy,
-    ContentType content_type,
-    const SiteKey& sitekey) {
-  // Search all subscriptions for any blocking filters (generic or
-  // domain-specific).
-  const auto subscription_with_blocking_filter_it =
-      subscription_collection.FindBySubresourceFilter(
-          request_url, frame_hierarchy, content_type, sitekey,
-          FilterCategory::Blocking);
-  if (!subscription_with_blocking_filter_it) {
+    const RequestContext& context,
+    ContentType content_type) {
+  // All searches the decision may depend on, done in one go.
+  const auto match =
+      subscription_collection.FindSubresourceMatch(context, content_type);
+  if (!match.blocking) {
     // Found no blocking filters in any of the subscriptions.
     return ClassificationResult{ClassificationResult::Decision::Ignored, {}};
   }
-  // Found a blocking filter but perhaps one of the subscriptions has an
-  // allowing filter to override it?
-  const auto subscription_with_allowing_filter_it =
-      subscription_collection.FindByAllowFilter(request_url, frame_hierarchy,
-                                                content_type, sitekey);
-  if (subscription_with_allowing_filter_it) {
+  if (match.allowing) {
     // Found an overriding allowing filter:
     return ClassificationResult{ClassificationResult::Decision::Allowed,
-                                *subscription_with_allowing_filter_it};
+                                *match.allowing};
   }
-  // Last chance to avoid blocking: maybe there is a GENERICBLOCK filter and we
-  // should re-search for domain-specific filters only?
-  if (subscription_collection.FindBySpecialFilter(
-          SpecialFilterType::Genericblock, request_url, frame_hierarchy,
-          sitekey)) {
-    // This is a relatively rare case - we should have searched for
-    // domain-specific filters only.
-    const auto subscription_with_domain_specific_blocking_filter_it =
-        subscription_collection.FindBySubresourceFilter(
-            request_url, frame_hierarchy, content_type, sitekey,
-            FilterCategory::DomainSpecificBlocking);
-    if (subscription_with_domain_specific_blocking_filter_it) {
+  // Last chance to avoid blocking: maybe there is a GENERICBLOCK filter and
+  // only domain-specific filters count?
+  if (match.genericblock) {
+    if (match.domain_specific_blocking) {
       // There was a domain-specific blocking filter, the resource is blocked by
       // it.
-      return ClassificationResult{
-          ClassificationResult::Decision::Blocked,
-          *subscription_with_domain_specific_blocking_filter_it};
+      return ClassificationResult{ClassificationResult::Decision::Blocked,
+                                  *match.domain_specific_blocking};
     } else {
       // There were no domain-specific blocking filters, our first match must
       // have been a generic filter.
@@ -108,19 +91,55 @@ ClassificationResult ClassifyRequestWithSingleCollection(
   // There was no GENERICBLOCK filter available, so the original blocking result
   // is valid.
   return ClassificationResult{ClassificationResult::Decision::Blocked,
-                              *subscription_with_blocking_filter_it};
+                              *match.blocking};
+}
+
+ClassificationResult ClassifyRequestWithAllCollections(
+    const SubscriptionService::Snapshot& subscription_collections,
+    const GURL& request_url,
+    const FrameContext& frame_context,
+    ContentType content_type,
+    const FrameSpecialFiltersList& frame_special_filters) {
+  auto classification =
+      ClassificationResult{ClassificationResult::Decision::Ignored, {}};
+  // Normalize and tokenize the request once for all collections, the frames
+  // were when |frame_context| was built.
+  const RequestContext context(request_url, frame_context,
+                               frame_special_filters);
+  // When the collections can be searched together, one walk over the keyword
+  // buckets of all of them tells which ones have a blocking filter at all. The
+  // others would ignore the request and need no further searches.
+  const FusedUrlFilterIndex* fused_index =
+      subscription_collections.fused_index();
+  FusedUrlFilterIndex::CollectionMask blocking_collections;
+  if (fused_index) {
+    blocking_collections =
+        fused_index->FindBlockingCollections(context.request(), content_type);
+  }
+  for (size_t i = 0; i < subscription_collections.size(); ++i) {
+    if (fused_index && !blocking_collections[i]) {
+      continue;
+    }
+    auto result = ClassifyRequestWithSingleCollection(
+        *subscription_collections[i], context, content_type);
+    if (result.decision == ClassificationResult::Decision::Blocked) {
+      return result;
+    }
+    if (result.decision == ClassificationResult::Decision::Allowed) {
+      classification = result;
+    }
+  }
+  return classification;
 }
 
 ClassificationResult ClassifyPopupWithSingleCollection(
     const SubscriptionCollection& subscription_collection,
-    const GURL& popup_url,
-    const std::vector<GURL>& opener_frame_hierarchy,
-    const SiteKey& sitekey) {
+    const RequestContext& context) {
   // Search all subscriptions for popup blocking filters (generic or
   // domain-specific).
   const auto subscription_with_blocking_filter_it =
-      subscription_collection.FindByPopupFilter(
-          popup_url, opener_frame_hierarchy, sitekey, FilterCategory::Blocking);
+      subscription_collection.FindByPopupFilter(context,
+                                                FilterCategory::Blocking);
   if (!subscription_with_blocking_filter_it) {
     // Found no blocking filters in any of the subscriptions.
     return ClassificationResult{ClassificationResult::Decision::Ignored, {}};
@@ -128,17 +147,16 @@ ClassificationResult ClassifyPopupWithSingleCollection(
   // Found a blocking filter but perhaps one of the subscriptions has an
   // allowing filter to override it?
   const auto subscription_with_allowing_filter_it =
-      subscription_collection.FindByPopupFilter(
-          popup_url, opener_frame_hierarchy, sitekey, FilterCategory::Allowing);
+      subscription_collection.FindByPopupFilter(context,
+                                                FilterCategory::Allowing);
   if (subscription_with_allowing_filter_it) {
     // Found an overriding allowing filter:
     return ClassificationResult{ClassificationResult::Decision::Allowed,
                                 *subscription_with_allowing_filter_it};
   }
   const auto subscription_with_document_allowing_filter_it =
-      subscription_collection.FindBySpecialFilter(
-          SpecialFilterType::Document, popup_url, opener_frame_hierarchy,
-          sitekey);
+      subscription_collection.FindBySpecialFilter(SpecialFilterType::Document,
+                                                  context);
   if (subscription_with_document_allowing_filter_it) {
     // Found an overriding document allowing filter for the frame hierarchy:
     return ClassificationResult{ClassificationResult::Decision::Allowed,
@@ -242,21 +260,26 @@ ResourceClassifierImpl::~ResourceClassifierImpl() = default;
 ClassificationResult ResourceClassifierImpl::ClassifyRequest(
     const SubscriptionService::Snapshot subscription_collections,
     const GURL& request_url,
-    const std::vector<GURL>& frame_hierarchy,
+    const FrameContext& frame_context,
     ContentType content_type,
-    const SiteKey& sitekey) const {
-  auto classification =
-      ClassificationResult{ClassificationResult::Decision::Ignored, {}};
-  for (const auto& collection : subscription_collections) {
-    auto result = ClassifyRequestWithSingleCollection(
-        *collection, request_url, frame_hierarchy, content_type, sitekey);
-    if (result.decision == ClassificationResult::Decision::Blocked) {
-      return result;
-    }
-    if (result.decision == ClassificationResult::Decision::Allowed) {
-      classification = result;
-    }
+    const FrameSpecialFiltersList& frame_special_filters) const {
+  const auto generation = ClassificationDecisionCache::GetSnapshotGeneration(
+      subscription_collections);
+  if (!generation) {
+    return ClassifyRequestWithAllCollections(
+        subscription_collections, request_url, frame_context, content_type,
+        frame_special_filters);
+  }
+  const auto key = ClassificationDecisionCache::MakeKey(
+      request_url, frame_context.frame_hierarchy(), content_type,
+      frame_context.sitekey());
+  if (auto cached = decision_cache_.Lookup(*generation, key)) {
+    return *cached;
   }
+  auto classification = ClassifyRequestWithAllCollections(
+      subscription_collections, request_url, frame_context, content_type,
+      frame_special_filters);
+  decision_cache_.Store(*generation, key, classification);
   return classification;
 }
 
@@ -267,9 +290,9 @@ ClassificationResult ResourceClassifierImpl::ClassifyPopup(
     const SiteKey& sitekey) const {
   auto classification =
       ClassificationResult{ClassificationResult::Decision::Ignored, {}};
+  const RequestContext context(popup_url, opener_frame_hierarchy, sitekey);
   for (const auto& collection : subscription_collections) {
-    auto result = ClassifyPopupWithSingleCollection(
-        *collection, popup_url, opener_frame_hierarchy, sitekey);
+    auto result = ClassifyPopupWithSingleCollection(*collection, context);
     if (result.decision == ClassificationResult::Decision::Blocked) {
       return result;
     }
@@ -20,6 +20,7 @@
 
 #include <set>
 
+#include "components/adblock/core/classifier/classification_decision_cache.h"
 #include "components/adblock/core/classifier/resource_classifier.h"
 
 namespace adblock {
@@ -31,9 +32,9 @@ class ResourceClassifierImpl final : public ResourceClassifier {
   ClassificationResult ClassifyRequest(
       const SubscriptionService::Snapshot subscription_collections,
       const GURL& request_url,
-      const std::vector<GURL>& frame_hierarchy,
+      const FrameContext& frame_context,
       ContentType content_type,
-      const SiteKey& sitekey) const final;
+      const FrameSpecialFiltersList& frame_special_filters) const final;
 
   ClassificationResult ClassifyPopup(
       const SubscriptionService::Snapshot& subscription_collections,
@@ -49,9 +50,18 @@ class ResourceClassifierImpl final : public ResourceClassifier {
       const scoped_refptr<net::HttpResponseHeaders>& response_headers)
       const final;
 
+  // Decisions of ClassifyRequest() are cached for snapshots whose collections
+  // track their state.
+  const ClassificationDecisionCache& decision_cache() const {
+    return decision_cache_;
+  }
+
  protected:
   friend class base::RefCountedThreadSafe<ResourceClassifierImpl>;
   ~ResourceClassifierImpl() override;
+
+ private:
+  mutable ClassificationDecisionCache decision_cache_;
 };
 
 }  // namespace adblock
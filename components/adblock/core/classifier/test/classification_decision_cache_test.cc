@@ -0,0 +1,158 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/classifier/classification_decision_cache.h"
+
+#include "base/memory/ptr_util.h"
+#include "components/adblock/core/subscription/test/mock_subscription_collection.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace adblock {
+
+using testing::Return;
+
+using ClassificationResult = ResourceClassifier::ClassificationResult;
+
+class AdblockClassificationDecisionCacheTest : public testing::Test {
+ public:
+  ClassificationDecisionCache::Key MakeKey(base::StringPiece url) {
+    return ClassificationDecisionCache::MakeKey(GURL(url), kFrameHierarchy,
+                                                ContentType::Image, SiteKey());
+  }
+
+  const std::vector<GURL> kFrameHierarchy{GURL("https://frame.com/"),
+                                          GURL("https://top.com/")};
+  const ClassificationDecisionCache::SnapshotGeneration kGeneration{1u, 2u};
+  const ClassificationResult kBlocked{
+      ClassificationResult::Decision::Blocked,
+      GURL("https://subscription.com/easylist.txt")};
+};
+
+TEST_F(AdblockClassificationDecisionCacheTest, StoredDecisionIsFound) {
+  ClassificationDecisionCache cache;
+  const auto key = MakeKey("https://ads.com/ad.png");
+  EXPECT_FALSE(cache.Lookup(kGeneration, key));
+  cache.Store(kGeneration, key, kBlocked);
+  const auto cached = cache.Lookup(kGeneration, key);
+  ASSERT_TRUE(cached);
+  EXPECT_EQ(cached->decision, kBlocked.decision);
+  EXPECT_EQ(cached->decisive_subscription, kBlocked.decisive_subscription);
+  EXPECT_EQ(cache.GetHitCount(), 1u);
+  EXPECT_EQ(cache.GetMissCount(), 1u);
+}
+
+TEST_F(AdblockClassificationDecisionCacheTest, KeyCoversAllRequestData) {
+  ClassificationDecisionCache cache;
+  const GURL url("https://ads.com/ad.png");
+  cache.Store(kGeneration,
+              ClassificationDecisionCache::MakeKey(
+                  url, kFrameHierarchy, ContentType::Image, SiteKey()),
+              kBlocked);
+  EXPECT_FALSE(cache.Lookup(kGeneration, MakeKey("https://ads.com/AD.png")));
+  EXPECT_FALSE(cache.Lookup(
+      kGeneration, ClassificationDecisionCache::MakeKey(
+                       url, {GURL("https://other.com/")}, ContentType::Image,
+                       SiteKey())));
+  EXPECT_FALSE(cache.Lookup(
+      kGeneration, ClassificationDecisionCache::MakeKey(
+                       url, kFrameHierarchy, ContentType::Script, SiteKey())));
+  EXPECT_FALSE(cache.Lookup(
+      kGeneration, ClassificationDecisionCache::MakeKey(url, kFrameHierarchy,
+                                                        ContentType::Image,
+                                                        SiteKey("abc"))));
+  EXPECT_EQ(cache.GetHitCount(), 0u);
+  EXPECT_EQ(cache.GetMissCount(), 4u);
+}
+
+TEST_F(AdblockClassificationDecisionCacheTest, NewGenerationDropsEntries) {
+  ClassificationDecisionCache cache;
+  const auto first_key = MakeKey("https://ads.com/first.png");
+  const auto second_key = MakeKey("https://ads.com/second.png");
+  cache.Store(kGeneration, first_key, kBlocked);
+  const ClassificationDecisionCache::SnapshotGeneration new_generation{1u, 3u};
+  // Not found for another snapshot, but not dropped by a lookup either.
+  EXPECT_FALSE(cache.Lookup(new_generation, first_key));
+  EXPECT_TRUE(cache.Lookup(kGeneration, first_key));
+  // Storing a decision made with another snapshot drops all entries.
+  cache.Store(new_generation, second_key, kBlocked);
+  EXPECT_TRUE(cache.Lookup(new_generation, second_key));
+  EXPECT_FALSE(cache.Lookup(new_generation, first_key));
+  EXPECT_FALSE(cache.Lookup(kGeneration, second_key));
+}
+
+TEST_F(AdblockClassificationDecisionCacheTest, OldGenerationNotStored) {
+  ClassificationDecisionCache cache;
+  const auto first_key = MakeKey("https://ads.com/first.png");
+  const auto second_key = MakeKey("https://ads.com/second.png");
+  const auto third_key = MakeKey("https://ads.com/third.png");
+  const ClassificationDecisionCache::SnapshotGeneration new_generation{1u, 3u};
+  cache.Store(kGeneration, first_key, kBlocked);
+  cache.Store(new_generation, second_key, kBlocked);
+  // A classification that started before |new_generation| was published
+  // finishes late. Its decision is dropped, the newer entries survive.
+  cache.Store(kGeneration, third_key, kBlocked);
+  EXPECT_TRUE(cache.Lookup(new_generation, second_key));
+  EXPECT_FALSE(cache.Lookup(kGeneration, third_key));
+  EXPECT_FALSE(cache.Lookup(new_generation, third_key));
+  EXPECT_FALSE(cache.Lookup(kGeneration, first_key));
+}
+
+TEST_F(AdblockClassificationDecisionCacheTest, ConfigurationAdded) {
+  ClassificationDecisionCache cache;
+  const auto first_key = MakeKey("https://ads.com/first.png");
+  const auto second_key = MakeKey("https://ads.com/second.png");
+  // A configuration was added, with a newly created collection.
+  const ClassificationDecisionCache::SnapshotGeneration added{1u, 2u, 4u};
+  cache.Store(kGeneration, first_key, kBlocked);
+  cache.Store(added, second_key, kBlocked);
+  EXPECT_TRUE(cache.Lookup(added, second_key));
+  // Late decision made before the configuration was added.
+  cache.Store(kGeneration, first_key, kBlocked);
+  EXPECT_FALSE(cache.Lookup(kGeneration, first_key));
+  EXPECT_TRUE(cache.Lookup(added, second_key));
+}
+
+TEST_F(AdblockClassificationDecisionCacheTest, LeastRecentlyUsedEvicted) {
+  ClassificationDecisionCache cache(2u);
+  const auto first_key = MakeKey("https://ads.com/first.png");
+  const auto second_key = MakeKey("https://ads.com/second.png");
+  const auto third_key = MakeKey("https://ads.com/third.png");
+  cache.Store(kGeneration, first_key, kBlocked);
+  cache.Store(kGeneration, second_key, kBlocked);
+  // Makes |second_key| the least recently used entry.
+  EXPECT_TRUE(cache.Lookup(kGeneration, first_key));
+  cache.Store(kGeneration, third_key, kBlocked);
+  EXPECT_TRUE(cache.Lookup(kGeneration, first_key));
+  EXPECT_FALSE(cache.Lookup(kGeneration, second_key));
+  EXPECT_TRUE(cache.Lookup(kGeneration, third_key));
+}
+
+TEST_F(AdblockClassificationDecisionCacheTest, SnapshotGeneration) {
+  SubscriptionService::Snapshot snapshot;
+  auto* tracked = new MockSubscriptionCollection();
+  ON_CALL(*tracked, GetGeneration()).WillByDefault(Return(5u));
+  snapshot.push_back(base::WrapUnique(tracked));
+  EXPECT_EQ(ClassificationDecisionCache::GetSnapshotGeneration(snapshot),
+            ClassificationDecisionCache::SnapshotGeneration{5u});
+
+  // Decisions made with collections that don't track their state are not
+  // cacheable.
+  snapshot.push_back(std::make_unique<MockSubscriptionCollection>());
+  EXPECT_FALSE(ClassificationDecisionCache::GetSnapshotGeneration(snapshot));
+}
+
+}  // namespace adblock
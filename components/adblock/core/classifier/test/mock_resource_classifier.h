@@ -31,9 +31,9 @@ class MockResourceClassifier : public ResourceClassifier {
               ClassifyRequest,
               (const SubscriptionService::Snapshot,
                const GURL&,
-               const std::vector<GURL>&,
+               const FrameContext&,
                ContentType,
-               const SiteKey&),
+               const FrameSpecialFiltersList&),
               (override, const));
   MOCK_METHOD(ClassificationResult,
               ClassifyPopup,
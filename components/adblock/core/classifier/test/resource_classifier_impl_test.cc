@@ -17,6 +17,7 @@
 
 #include "components/adblock/core/classifier/resource_classifier_impl.h"
 #include "absl/types/optional.h"
+#include "base/memory/ptr_util.h"
 #include "base/strings/string_piece_forward.h"
 #include "components/adblock/core/subscription/test/mock_subscription_collection.h"
 #include "gmock/gmock-actions.h"
@@ -38,7 +39,7 @@ class AdblockResourceClassifierImplTest : public ::testing::Test {
     classifier_ = base::MakeRefCounted<ResourceClassifierImpl>();
     mock_subscription_collection_ = new MockSubscriptionCollection();
     mock_snapshot_ = std::make_unique<SubscriptionService::Snapshot>();
-    mock_snapshot_->emplace_back(mock_subscription_collection_);
+    mock_snapshot_->push_back(base::WrapUnique(mock_subscription_collection_));
   }
 
   void FindBySubresourceFilterReturns(const absl::optional<GURL>& return_value,
@@ -115,6 +116,9 @@ class AdblockResourceClassifierImplTest : public ::testing::Test {
   const GURL kParentAddress{"https://parent.com/"};
   const ContentType kContentType = ContentType::Image;
   const SiteKey kSitekey{"abc"};
+  const scoped_refptr<const FrameContext> kFrameContext =
+      base::MakeRefCounted<FrameContext>(std::vector<GURL>{kParentAddress},
+                                         kSitekey);
   const GURL kSourceUrl{"https://subscription.com/easylist.txt"};
   const std::set<HeaderFilterData> kAllowingHeaderFilters = {
       {"allowing_filter", kSourceUrl}};
@@ -139,7 +143,7 @@ TEST_F(AdblockResourceClassifierImplTest, BlockingFilterNotFound) {
 
   EXPECT_EQ(classifier_
                 ->ClassifyRequest(std::move(*mock_snapshot_), kResourceAddress,
-                                  {kParentAddress}, kContentType, kSitekey)
+                                  *kFrameContext, kContentType, {})
                 .decision,
             Decision::Ignored);
 }
@@ -161,11 +165,53 @@ TEST_F(AdblockResourceClassifierImplTest, BlockingFilterFound) {
 
   EXPECT_EQ(classifier_
                 ->ClassifyRequest(std::move(*mock_snapshot_), kResourceAddress,
-                                  {kParentAddress}, kContentType, kSitekey)
+                                  *kFrameContext, kContentType, {})
                 .decision,
             Decision::Blocked);
 }
 
+TEST_F(AdblockResourceClassifierImplTest, DecisionCachedPerGeneration) {
+  ON_CALL(*mock_subscription_collection_, GetGeneration())
+      .WillByDefault(Return(7u));
+  FindBySubresourceFilterReturns(absl::optional<GURL>(kSourceUrl),
+                                 FilterCategory::Blocking);
+  FindByAllowFilterReturns(absl::nullopt);
+  FindBySpecialFilterReturns(absl::nullopt, SpecialFilterType::Genericblock);
+  EXPECT_EQ(classifier_
+                ->ClassifyRequest(std::move(*mock_snapshot_), kResourceAddress,
+                                  *kFrameContext, kContentType, {})
+                .decision,
+            Decision::Blocked);
+
+  // Another snapshot of the same state is answered from the cache.
+  auto* same_state = new MockSubscriptionCollection();
+  ON_CALL(*same_state, GetGeneration()).WillByDefault(Return(7u));
+  EXPECT_CALL(*same_state, FindBySubresourceFilter(_, _, _, _, _)).Times(0);
+  SubscriptionService::Snapshot same_state_snapshot;
+  same_state_snapshot.push_back(base::WrapUnique(same_state));
+  EXPECT_EQ(classifier_
+                ->ClassifyRequest(std::move(same_state_snapshot),
+                                  kResourceAddress, *kFrameContext,
+                                  kContentType, {})
+                .decision,
+            Decision::Blocked);
+
+  // A snapshot of a newer state is searched again.
+  auto* new_state = new MockSubscriptionCollection();
+  ON_CALL(*new_state, GetGeneration()).WillByDefault(Return(8u));
+  EXPECT_CALL(*new_state,
+              FindBySubresourceFilter(_, _, _, _, FilterCategory::Blocking))
+      .WillOnce(Return(absl::nullopt));
+  SubscriptionService::Snapshot new_state_snapshot;
+  new_state_snapshot.push_back(base::WrapUnique(new_state));
+  EXPECT_EQ(classifier_
+                ->ClassifyRequest(std::move(new_state_snapshot),
+                                  kResourceAddress, *kFrameContext,
+                                  kContentType, {})
+                .decision,
+            Decision::Ignored);
+}
+
 TEST_F(AdblockResourceClassifierImplTest, BlockingAndAllowingFilterFound) {
   // Subscriptions get queried for url filters, one reports a blocking filter
   FindBySubresourceFilterReturns(absl::optional<GURL>(kSourceUrl),
@@ -182,7 +228,7 @@ TEST_F(AdblockResourceClassifierImplTest, BlockingAndAllowingFilterFound) {
 
   EXPECT_EQ(classifier_
                 ->ClassifyRequest(std::move(*mock_snapshot_), kResourceAddress,
-                                  {kParentAddress}, kContentType, kSitekey)
+                                  *kFrameContext, kContentType, {})
                 .decision,
             Decision::Allowed);
 }
@@ -203,7 +249,7 @@ TEST_F(AdblockResourceClassifierImplTest, GenericBlockSearch) {
 
   EXPECT_EQ(classifier_
                 ->ClassifyRequest(std::move(*mock_snapshot_), kResourceAddress,
-                                  {kParentAddress}, kContentType, kSitekey)
+                                  *kFrameContext, kContentType, {})
                 .decision,
             Decision::Blocked);
 }
@@ -227,7 +273,7 @@ TEST_F(AdblockResourceClassifierImplTest, DomainSpecificNotFound) {
 
   EXPECT_EQ(classifier_
                 ->ClassifyRequest(std::move(*mock_snapshot_), kResourceAddress,
-                                  {kParentAddress}, kContentType, kSitekey)
+                                  *kFrameContext, kContentType, {})
                 .decision,
             Decision::Ignored);
 }
@@ -251,7 +297,7 @@ TEST_F(AdblockResourceClassifierImplTest, DomainSpecificFound) {
 
   EXPECT_EQ(classifier_
                 ->ClassifyRequest(std::move(*mock_snapshot_), kResourceAddress,
-                                  {kParentAddress}, kContentType, kSitekey)
+                                  *kFrameContext, kContentType, {})
                 .decision,
             Decision::Blocked);
 }
@@ -449,7 +495,7 @@ TEST_F(AdblockResourceClassifierImplTest,
   mock_snapshot_->push_back(std::move(mock_subscription_collection));
   EXPECT_EQ(classifier_
                 ->ClassifyRequest(std::move(*mock_snapshot_), kResourceAddress,
-                                  {kParentAddress}, kContentType, kSitekey)
+                                  *kFrameContext, kContentType, {})
                 .decision,
             Decision::Blocked);
 }
@@ -472,7 +518,7 @@ TEST_F(AdblockResourceClassifierImplTest,
   mock_snapshot_->push_back(std::move(mock_subscription_collection));
   EXPECT_EQ(classifier_
                 ->ClassifyRequest(std::move(*mock_snapshot_), kResourceAddress,
-                                  {kParentAddress}, kContentType, kSitekey)
+                                  *kFrameContext, kContentType, {})
                 .decision,
             Decision::Blocked);
 }
@@ -493,10 +539,10 @@ TEST_F(AdblockResourceClassifierImplTest,
   EXPECT_CALL(*mock_subscription_collection, FindByAllowFilter(_, _, _, _))
       .WillOnce(Return(absl::optional<GURL>(kSourceUrl)));
 
-  mock_snapshot_->emplace_back(mock_subscription_collection);
+  mock_snapshot_->push_back(base::WrapUnique(mock_subscription_collection));
   EXPECT_EQ(classifier_
                 ->ClassifyRequest(std::move(*mock_snapshot_), kResourceAddress,
-                                  {kParentAddress}, kContentType, kSitekey)
+                                  *kFrameContext, kContentType, {})
                 .decision,
             Decision::Allowed);
 }
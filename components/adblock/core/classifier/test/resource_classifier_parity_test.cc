@@ -0,0 +1,246 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/string_split.h"
+#include "components/adblock/core/classifier/resource_classifier_impl.h"
+#include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/subscription/fused_url_filter_index.h"
+#include "components/adblock/core/subscription/installed_subscription_impl.h"
+#include "components/adblock/core/subscription/merged_url_filter_index.h"
+#include "components/adblock/core/subscription/request_context.h"
+#include "components/adblock/core/subscription/subscription_collection_impl.h"
+#include "components/adblock/core/subscription/test/load_gzipped_test_file.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace adblock {
+namespace {
+
+using ClassificationResult = ResourceClassifier::ClassificationResult;
+
+scoped_refptr<InstalledSubscription> MakeSubscription(
+    std::unique_ptr<FlatbufferData> data) {
+  return base::MakeRefCounted<InstalledSubscriptionImpl>(
+      std::move(data), Subscription::InstallationState::Installed,
+      base::Time());
+}
+
+scoped_refptr<InstalledSubscription> LoadSubscription(
+    base::StringPiece filename,
+    const GURL& url) {
+  std::stringstream input(LoadGzippedTestFile(filename));
+  auto result = FlatbufferConverter::Convert(input, url, false);
+  CHECK(absl::holds_alternative<std::unique_ptr<FlatbufferData>>(result));
+  return MakeSubscription(
+      std::move(absl::get<std::unique_ptr<FlatbufferData>>(result)));
+}
+
+}  // namespace
+
+// Checks that classifying requests with SubscriptionCollection's fused
+// FindSubresourceMatch() gives the same decisions as searching each filter
+// category separately.
+class AdblockFusedClassificationParityTest : public testing::Test {
+ public:
+  static void SetUpTestSuite() {
+    subscriptions_ = new std::vector<scoped_refptr<InstalledSubscription>>{
+        LoadSubscription(
+            "easylist.txt.gz",
+            GURL("https://easylist-downloads.adblockplus.org/easylist.txt")),
+        LoadSubscription("exceptionrules.txt.gz",
+                         GURL("https://easylist-downloads.adblockplus.org/"
+                              "exceptionrules.txt"))};
+  }
+
+  static void TearDownTestSuite() {
+    delete subscriptions_;
+    subscriptions_ = nullptr;
+  }
+
+ protected:
+  void ExpectParity(
+      const std::vector<scoped_refptr<InstalledSubscription>>& subscriptions,
+      const std::vector<GURL>& request_urls,
+      const std::vector<std::vector<GURL>>& frame_hierarchies) {
+    // Without a merged index, every category is searched separately in each
+    // subscription.
+    const SubscriptionCollectionImpl multi_pass(subscriptions);
+    const SubscriptionCollectionImpl fused(
+        subscriptions, MergedUrlFilterIndex::Build(subscriptions));
+    auto classifier = base::MakeRefCounted<ResourceClassifierImpl>();
+    for (const auto& frame_hierarchy : frame_hierarchies) {
+      for (const auto& url : request_urls) {
+        for (const auto content_type :
+             {ContentType::Image, ContentType::Script,
+              ContentType::Subdocument, ContentType::Xmlhttprequest}) {
+          const RequestContext context(url, frame_hierarchy, SiteKey());
+          // The fused search must agree with the sequential searches over
+          // the same merged index...
+          const auto expected =
+              fused.SubscriptionCollection::FindSubresourceMatch(
+                  context, content_type);
+          const auto actual = fused.FindSubresourceMatch(context, content_type);
+          EXPECT_EQ(expected.blocking, actual.blocking) << url;
+          EXPECT_EQ(expected.allowing, actual.allowing) << url;
+          EXPECT_EQ(expected.genericblock, actual.genericblock) << url;
+          EXPECT_EQ(expected.domain_specific_blocking,
+                    actual.domain_specific_blocking)
+              << url;
+          // ...and the classifier must decide as it does without one.
+          const auto multi_pass_result =
+              Classify(*classifier, multi_pass, url, frame_hierarchy,
+                       content_type);
+          const auto fused_result =
+              Classify(*classifier, fused, url, frame_hierarchy, content_type);
+          EXPECT_EQ(multi_pass_result.decision, fused_result.decision) << url;
+          EXPECT_EQ(multi_pass_result.decisive_subscription,
+                    fused_result.decisive_subscription)
+              << url;
+        }
+      }
+    }
+  }
+
+  static ClassificationResult Classify(
+      const ResourceClassifierImpl& classifier,
+      const SubscriptionCollectionImpl& collection,
+      const GURL& url,
+      const std::vector<GURL>& frame_hierarchy,
+      ContentType content_type) {
+    SubscriptionService::Snapshot snapshot;
+    snapshot.push_back(
+        std::make_unique<SubscriptionCollectionImpl>(collection));
+    const auto frame_context =
+        base::MakeRefCounted<FrameContext>(frame_hierarchy, SiteKey());
+    return classifier.ClassifyRequest(std::move(snapshot), url, *frame_context,
+                                      content_type, {});
+  }
+
+  // Classifies with a Snapshot of one collection per entry of |states|,
+  // searched one by one and together through a FusedUrlFilterIndex.
+  void ExpectMultiConfigurationParity(
+      const FusedUrlFilterIndex::CollectionStates& states,
+      const std::vector<GURL>& request_urls,
+      const std::vector<std::vector<GURL>>& frame_hierarchies) {
+    SubscriptionService::Snapshot snapshot;
+    for (const auto& state : states) {
+      snapshot.push_back(std::make_unique<SubscriptionCollectionImpl>(
+          state, MergedUrlFilterIndex::Build(state)));
+    }
+    auto fused_index = FusedUrlFilterIndex::Build(states);
+    ASSERT_TRUE(fused_index);
+    const auto fused_snapshot = snapshot.WithFusedIndex(fused_index);
+    auto classifier = base::MakeRefCounted<ResourceClassifierImpl>();
+    for (const auto& frame_hierarchy : frame_hierarchies) {
+      const auto frame_context =
+          base::MakeRefCounted<FrameContext>(frame_hierarchy, SiteKey());
+      for (const auto& url : request_urls) {
+        for (const auto content_type :
+             {ContentType::Image, ContentType::Script,
+              ContentType::Subdocument, ContentType::Xmlhttprequest}) {
+          const auto expected = classifier->ClassifyRequest(
+              snapshot, url, *frame_context, content_type, {});
+          const auto actual = classifier->ClassifyRequest(
+              fused_snapshot, url, *frame_context, content_type, {});
+          EXPECT_EQ(expected.decision, actual.decision) << url;
+          EXPECT_EQ(expected.decisive_subscription,
+                    actual.decisive_subscription)
+              << url;
+        }
+      }
+    }
+  }
+
+  static std::vector<scoped_refptr<InstalledSubscription>>* subscriptions_;
+};
+
+std::vector<scoped_refptr<InstalledSubscription>>*
+    AdblockFusedClassificationParityTest::subscriptions_ = nullptr;
+
+TEST_F(AdblockFusedClassificationParityTest, EasylistAndExceptionrules) {
+  std::vector<GURL> urls;
+  for (const auto line : base::SplitStringPiece(
+           LoadGzippedTestFile("5000_urls.txt.gz"), "\n",
+           base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+    urls.emplace_back(line);
+  }
+  ExpectParity(*subscriptions_, urls,
+               {{},
+                {GURL("https://www.example.com/")},
+                {GURL("https://news.example.org/article.html"),
+                 GURL("https://www.example.com/")}});
+}
+
+TEST_F(AdblockFusedClassificationParityTest, AllDecisionPaths) {
+  // Custom filters reaching every branch of the decision: allowed by a
+  // filter or by document allowlisting of a frame, and genericblock with and
+  // without a domain-specific blocking filter.
+  auto custom = MakeSubscription(FlatbufferConverter::Convert(
+      {"/generic-ad.", "/specific-ad.$domain=example.com",
+       "@@/allowed-ad.", "/allowed-ad.", "@@||allowlisted.org^$document",
+       "@@||example.com^$genericblock", "@@||example.net^$genericblock"},
+      GURL("https://custom.filters/list.txt"), false));
+  std::vector<scoped_refptr<InstalledSubscription>> subscriptions =
+      *subscriptions_;
+  subscriptions.insert(subscriptions.begin(), custom);
+  ExpectParity(subscriptions,
+               {GURL("https://ads.com/generic-ad.png"),
+                GURL("https://ads.com/specific-ad.png"),
+                GURL("https://ads.com/allowed-ad.png"),
+                GURL("https://ads.com/nothing-to-see.png")},
+               {{},
+                {GURL("https://www.example.com/")},
+                {GURL("https://www.example.net/")},
+                {GURL("https://www.example.com/"),
+                 GURL("https://allowlisted.org/")}});
+}
+
+TEST_F(AdblockFusedClassificationParityTest, MultipleConfigurations) {
+  // One configuration blocks what another allows, a third one shares a
+  // subscription with the first.
+  auto custom = MakeSubscription(FlatbufferConverter::Convert(
+      {"/generic-ad.", "@@/allowed-ad.", "/allowed-ad.",
+       "@@||allowlisted.org^$document", "@@||example.net^$genericblock"},
+      GURL("https://custom.filters/list.txt"), false));
+  auto enterprise = MakeSubscription(FlatbufferConverter::Convert(
+      {"/allowed-ad.", "/specific-ad.$domain=example.net", "@@/generic-ad."},
+      GURL("https://enterprise.filters/list.txt"), false));
+  std::vector<GURL> urls = {GURL("https://ads.com/generic-ad.png"),
+                            GURL("https://ads.com/specific-ad.png"),
+                            GURL("https://ads.com/allowed-ad.png"),
+                            GURL("https://ads.com/nothing-to-see.png")};
+  for (const auto line : base::SplitStringPiece(
+           LoadGzippedTestFile("5000_urls.txt.gz"), "\n",
+           base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+    urls.emplace_back(line);
+  }
+  ExpectMultiConfigurationParity({*subscriptions_,
+                                  {enterprise},
+                                  {custom, (*subscriptions_)[0]}},
+                                 urls,
+                                 {{},
+                                  {GURL("https://www.example.net/")},
+                                  {GURL("https://www.example.com/"),
+                                   GURL("https://allowlisted.org/")}});
+}
+
+}  // namespace adblock
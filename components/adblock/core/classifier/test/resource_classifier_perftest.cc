@@ -24,11 +24,15 @@
 #include "base/path_service.h"
 #include "base/strings/string_piece.h"
 #include "base/strings/string_piece_forward.h"
+#include "base/strings/stringprintf.h"
 #include "base/timer/elapsed_timer.h"
 #include "components/adblock/core/classifier/resource_classifier_impl.h"
 #include "components/adblock/core/common/adblock_constants.h"
 #include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/subscription/fused_url_filter_index.h"
 #include "components/adblock/core/subscription/installed_subscription_impl.h"
+#include "components/adblock/core/subscription/merged_url_filter_index.h"
+#include "components/adblock/core/subscription/request_context.h"
 #include "components/adblock/core/subscription/subscription_collection_impl.h"
 #include "components/adblock/core/subscription/subscription_service.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -43,6 +47,12 @@ class ResourceClassifierPerfTest : public testing::Test {
   }
   std::unique_ptr<SubscriptionCollectionImpl> CreateSubscriptionCollection(
       std::initializer_list<std::string> filenames) {
+    return std::make_unique<SubscriptionCollectionImpl>(
+        CreateSubscriptions(filenames));
+  }
+
+  std::vector<scoped_refptr<InstalledSubscription>> CreateSubscriptions(
+      std::initializer_list<std::string> filenames) {
     std::vector<scoped_refptr<InstalledSubscription>> state;
     for (const auto& cur : filenames) {
       const std::string content = ReadFromTestData(cur);
@@ -56,7 +66,7 @@ class ResourceClassifierPerfTest : public testing::Test {
               absl::get<std::unique_ptr<FlatbufferData>>(converter_result)),
           Subscription::InstallationState::Installed, base::Time()));
     }
-    return std::make_unique<SubscriptionCollectionImpl>(state);
+    return state;
   }
 
   static std::string ReadFromTestData(const std::string& file_name) {
@@ -92,12 +102,13 @@ class ResourceClassifierPerfTest : public testing::Test {
     SubscriptionService::Snapshot snapshot;
     snapshot.push_back(std::move(sub_collection));
     ResourceClassifier::ClassificationResult classification_result;
+    const auto frame_context = base::MakeRefCounted<FrameContext>(
+        DefautFrameHeirarchy(), DefaultSitekey());
     base::ElapsedTimer timer;
     // Call matching many times to make sure perf woke up for measurement.
     for (int i = 0; i < cycles; ++i) {
       classification_result = classifier_->ClassifyRequest(
-          std::move(snapshot), url, DefautFrameHeirarchy(), content_type,
-          DefaultSitekey());
+          std::move(snapshot), url, *frame_context, content_type, {});
     }
     LOG(INFO) << "URL matching time: " << timer.Elapsed() / cycles;
     LOG(INFO) << "Classification result: "
@@ -219,6 +230,256 @@ TEST_F(ResourceClassifierPerfTest, LongUrlMatch) {
                          std::move(sub_collection), kRepCount);
 }
 
+// Compares running the queries ResourceClassifierImpl makes for a blocked
+// request with a RequestContext created per query (as done by the GURL-based
+// SubscriptionCollection methods) versus one shared RequestContext.
+TEST_F(ResourceClassifierPerfTest, SharedRequestContext) {
+  auto sub_collection = CreateSubscriptionCollection(
+      {"easylist.txt.gz", "exceptionrules.txt.gz"});
+  const std::vector<GURL> urls = {UnknownAddress(), BlockedAddress()};
+  const int cycles = BenchmarkRepetitions();
+
+  base::ElapsedTimer context_per_query_timer;
+  for (int i = 0; i < cycles; ++i) {
+    for (const auto& url : urls) {
+      sub_collection->FindBySubresourceFilter(
+          url, DefautFrameHeirarchy(), ContentType::Image, DefaultSitekey(),
+          FilterCategory::Blocking);
+      sub_collection->FindByAllowFilter(url, DefautFrameHeirarchy(),
+                                        ContentType::Image, DefaultSitekey());
+      sub_collection->FindBySpecialFilter(SpecialFilterType::Genericblock, url,
+                                          DefautFrameHeirarchy(),
+                                          DefaultSitekey());
+    }
+  }
+  const auto context_per_query_time = context_per_query_timer.Elapsed();
+
+  base::ElapsedTimer shared_context_timer;
+  for (int i = 0; i < cycles; ++i) {
+    for (const auto& url : urls) {
+      const RequestContext context(url, DefautFrameHeirarchy(),
+                                   DefaultSitekey());
+      sub_collection->FindBySubresourceFilter(context, ContentType::Image,
+                                              FilterCategory::Blocking);
+      sub_collection->FindByAllowFilter(context, ContentType::Image);
+      sub_collection->FindBySpecialFilter(SpecialFilterType::Genericblock,
+                                          context);
+    }
+  }
+  const auto shared_context_time = shared_context_timer.Elapsed();
+
+  const int requests = cycles * static_cast<int>(urls.size());
+  LOG(INFO) << "Time per request, context per query: "
+            << context_per_query_time / requests;
+  LOG(INFO) << "Time per request, shared context: "
+            << shared_context_time / requests;
+}
+
+// Replays page loads that request the same trackers, CDN resources and
+// first-party assets over and over, as real browsing does, with and without
+// the decision cache of ResourceClassifierImpl.
+TEST_F(ResourceClassifierPerfTest, RepeatedRequestsDecisionCache) {
+  const auto state =
+      CreateSubscriptions({"easylist.txt.gz", "exceptionrules.txt.gz"});
+  // Collections that don't track their state bypass the cache.
+  const SubscriptionCollectionImpl uncached_collection(state);
+  const SubscriptionCollectionImpl cached_collection(
+      state, nullptr, SubscriptionCollection::NextGeneration());
+
+  const std::vector<GURL> shared_resources = {
+      BlockedAddress(),
+      UnknownAddress(),
+      GURL("https://www.google-analytics.com/analytics.js"),
+      GURL("https://cdn.jsdelivr.net/npm/jquery@3.6.0/dist/jquery.min.js"),
+      GURL("https://fonts.gstatic.com/s/roboto/v30/font.woff2"),
+      GURL("https://securepubads.g.doubleclick.net/tag/js/gpt.js"),
+  };
+  std::vector<GURL> requests;
+  for (int page = 0; page < 20; ++page) {
+    // Assets of the page itself are only requested once.
+    for (int asset = 0; asset < 5; ++asset) {
+      requests.emplace_back(base::StringPrintf(
+          "https://frame.com/page%d/asset%d.png", page, asset));
+    }
+    requests.insert(requests.end(), shared_resources.begin(),
+                    shared_resources.end());
+  }
+
+  auto classifier = base::MakeRefCounted<ResourceClassifierImpl>();
+  const int cycles = BenchmarkRepetitions() / 10 + 1;
+  const auto frame_context = base::MakeRefCounted<FrameContext>(
+      DefautFrameHeirarchy(), DefaultSitekey());
+  const auto replay = [&](const ResourceClassifierImpl& classifier,
+                          const SubscriptionCollectionImpl& collection) {
+    base::ElapsedTimer timer;
+    for (int i = 0; i < cycles; ++i) {
+      for (const auto& url : requests) {
+        SubscriptionService::Snapshot snapshot;
+        snapshot.push_back(
+            std::make_unique<SubscriptionCollectionImpl>(collection));
+        classifier.ClassifyRequest(std::move(snapshot), url, *frame_context,
+                                   ContentType::Image, {});
+      }
+    }
+    return timer.Elapsed() / (cycles * requests.size());
+  };
+
+  const auto uncached_time = replay(*classifier, uncached_collection);
+  const auto cached_time = replay(*classifier, cached_collection);
+  LOG(INFO) << "Time per request, no cache: " << uncached_time
+            << ", decision cache: " << cached_time;
+  LOG(INFO) << "Decision cache hits: "
+            << classifier->decision_cache().GetHitCount()
+            << ", misses: " << classifier->decision_cache().GetMissCount();
+}
+
+// Classifies the same requests on a page without and with a $genericblock
+// filter. The latter searches the domain-specific blocking filters a second
+// time whenever a generic blocking filter matched.
+TEST_F(ResourceClassifierPerfTest, GenericblockPage) {
+  const auto state =
+      CreateSubscriptions({"easylist.txt.gz", "exceptionrules.txt.gz"});
+  auto genericblock_state = state;
+  genericblock_state.push_back(base::MakeRefCounted<InstalledSubscriptionImpl>(
+      FlatbufferConverter::Convert({"@@||frame.com^$genericblock"},
+                                   CustomFiltersUrl(), false),
+      Subscription::InstallationState::Installed, base::Time()));
+
+  const std::vector<GURL> requests = {
+      BlockedAddress(),
+      UnknownAddress(),
+      GURL("https://www.google-analytics.com/analytics.js"),
+      GURL("https://securepubads.g.doubleclick.net/tag/js/gpt.js"),
+      GURL("https://frame.com/ads/banner.png"),
+      GURL("https://cdn.frame.com/static/advertisement.js"),
+  };
+  const int cycles = BenchmarkRepetitions();
+  const auto classify = [&](const SubscriptionCollectionImpl& collection) {
+    int blocked = 0;
+    base::ElapsedTimer timer;
+    for (int i = 0; i < cycles; ++i) {
+      for (const auto& url : requests) {
+        const RequestContext context(url, DefautFrameHeirarchy(),
+                                     DefaultSitekey());
+        const auto match =
+            collection.FindSubresourceMatch(context, ContentType::Script);
+        blocked += match.blocking && !match.allowing &&
+                   (!match.genericblock || match.domain_specific_blocking);
+      }
+    }
+    LOG(INFO) << "Blocked per cycle: " << blocked / cycles;
+    return timer.Elapsed() / (cycles * requests.size());
+  };
+
+  const auto default_time = classify(SubscriptionCollectionImpl(state));
+  const auto genericblock_time =
+      classify(SubscriptionCollectionImpl(genericblock_state));
+  LOG(INFO) << "Time per request, default page: " << default_time
+            << ", $genericblock page: " << genericblock_time;
+}
+
+// Classifies the same requests from a frame nested three levels deep, looking
+// up the frames and their document-level filters for every request, then
+// once for all of them through a shared FrameContext.
+TEST_F(ResourceClassifierPerfTest, FrameSpecialFiltersReused) {
+  const auto state =
+      CreateSubscriptions({"easylist.txt.gz", "exceptionrules.txt.gz"});
+  const SubscriptionCollectionImpl collection(
+      state, MergedUrlFilterIndex::Build(state),
+      SubscriptionCollection::NextGeneration());
+  const std::vector<GURL> frame_hierarchy = {
+      GURL("https://ads.example.com/frame.html"),
+      GURL("https://widget.example.org/embed"),
+      GURL("https://frame.com/article"),
+      GURL("https://frame.com/"),
+  };
+  const std::vector<GURL> requests = {
+      BlockedAddress(),
+      UnknownAddress(),
+      GURL("https://www.google-analytics.com/analytics.js"),
+      GURL("https://securepubads.g.doubleclick.net/tag/js/gpt.js"),
+      GURL("https://frame.com/ads/banner.png"),
+      GURL("https://cdn.frame.com/static/advertisement.js"),
+  };
+  const int cycles = BenchmarkRepetitions();
+  base::ElapsedTimer per_request_timer;
+  for (int i = 0; i < cycles; ++i) {
+    for (const auto& url : requests) {
+      const RequestContext context(url, frame_hierarchy, DefaultSitekey());
+      collection.FindSubresourceMatch(context, ContentType::Script);
+    }
+  }
+  const auto per_request_time =
+      per_request_timer.Elapsed() / (cycles * requests.size());
+
+  base::ElapsedTimer lookup_timer;
+  const auto frame_context =
+      base::MakeRefCounted<FrameContext>(frame_hierarchy, DefaultSitekey());
+  const FrameSpecialFiltersList frame_filters = {
+      collection.FindFrameSpecialFilters(*frame_context)};
+  const auto lookup_time = lookup_timer.Elapsed();
+  base::ElapsedTimer reused_timer;
+  for (int i = 0; i < cycles; ++i) {
+    for (const auto& url : requests) {
+      const RequestContext context(url, *frame_context, frame_filters);
+      collection.FindSubresourceMatch(context, ContentType::Script);
+    }
+  }
+  const auto reused_time = reused_timer.Elapsed() / (cycles * requests.size());
+  LOG(INFO) << "Time per request, frames looked up per request: "
+            << per_request_time << ", once per frame: " << reused_time
+            << " after a lookup of " << lookup_time;
+}
+
+// Classifies the same requests with 1, 2 and 4 FilteringConfigurations, each
+// with its own copy of the same filter lists, searching their collections one
+// by one and together through a FusedUrlFilterIndex.
+TEST_F(ResourceClassifierPerfTest, MultipleConfigurations) {
+  FusedUrlFilterIndex::CollectionStates all_states;
+  for (int i = 0; i < 4; ++i) {
+    all_states.push_back(
+        CreateSubscriptions({"easylist.txt.gz", "exceptionrules.txt.gz"}));
+  }
+  const std::vector<GURL> requests = {
+      BlockedAddress(),
+      UnknownAddress(),
+      GURL("https://www.google-analytics.com/analytics.js"),
+      GURL("https://cdn.jsdelivr.net/npm/jquery@3.6.0/dist/jquery.min.js"),
+      GURL("https://fonts.gstatic.com/s/roboto/v30/font.woff2"),
+      GURL("https://frame.com/page/asset.png"),
+  };
+  const auto frame_context = base::MakeRefCounted<FrameContext>(
+      DefautFrameHeirarchy(), DefaultSitekey());
+  const int cycles = BenchmarkRepetitions();
+  const auto classify = [&](const SubscriptionService::Snapshot& snapshot) {
+    base::ElapsedTimer timer;
+    for (int i = 0; i < cycles; ++i) {
+      for (const auto& url : requests) {
+        classifier_->ClassifyRequest(snapshot, url, *frame_context,
+                                     ContentType::Script, {});
+      }
+    }
+    return timer.Elapsed() / (cycles * requests.size());
+  };
+
+  for (const size_t configurations : {1u, 2u, 4u}) {
+    const FusedUrlFilterIndex::CollectionStates states(
+        all_states.begin(), all_states.begin() + configurations);
+    SubscriptionService::Snapshot snapshot;
+    for (const auto& state : states) {
+      snapshot.push_back(std::make_unique<SubscriptionCollectionImpl>(
+          state, MergedUrlFilterIndex::Build(state)));
+    }
+    const auto fused_snapshot =
+        snapshot.WithFusedIndex(FusedUrlFilterIndex::Build(states));
+    const auto one_by_one_time = classify(snapshot);
+    const auto fused_time = classify(fused_snapshot);
+    LOG(INFO) << "Time per request with " << configurations
+              << " configurations, one by one: " << one_by_one_time
+              << ", fused: " << fused_time;
+  }
+}
+
 TEST_F(ResourceClassifierPerfTest, LongUrlFindCsp) {
   auto sub_collection = CreateSubscriptionCollection(
       {"easylist.txt.gz", "exceptionrules.txt.gz"});
@@ -28,11 +28,10 @@
 #include "base/strings/string_util.h"
 #include "base/strings/utf_string_conversions.h"
 #include "components/adblock/core/common/adblock_constants.h"
+#include "components/adblock/core/common/regex_cache.h"
 #include "components/grit/components_resources.h"
 #include "components/version_info/version_info.h"
 #include "net/http/http_response_headers.h"
-#include "third_party/icu/source/i18n/unicode/regex.h"
-#include "third_party/re2/src/re2/re2.h"
 #include "ui/base/resource/resource_bundle.h"
 #include "url/gurl.h"
 
@@ -131,37 +130,8 @@ std::unique_ptr<FlatbufferData> MakeFlatbufferDataFromResourceBundle(
 bool RegexMatches(base::StringPiece pattern,
                   base::StringPiece input,
                   bool case_sensitive) {
-  re2::RE2::Options options;
-  options.set_case_sensitive(case_sensitive);
-  options.set_never_capture(true);
-  options.set_log_errors(false);
-  options.set_encoding(re2::RE2::Options::EncodingLatin1);
-  const re2::RE2 re2_pattern(pattern.data(), options);
-  if (re2_pattern.ok())
-    return re2::RE2::PartialMatch(input.data(), re2_pattern);
-  VLOG(2) << "[eyeo] RE2 does not support filter pattern " << pattern
-          << " and return with error message: " << re2_pattern.error();
-
-  // Maximum length of the string to match to avoid causing an icu::RegexMatcher
-  // stack overflow. (crbug.com/1198219)
-  if (input.size() > url::kMaxURLChars)
-    return false;
-  const icu::UnicodeString icu_pattern(pattern.data(), pattern.length());
-  const icu::UnicodeString icu_input(input.data(), input.length());
-  UErrorCode status = U_ZERO_ERROR;
-  const auto icu_case_sensetive = case_sensitive ? 0u : UREGEX_CASE_INSENSITIVE;
-  icu::RegexMatcher matcher(icu_pattern, icu_case_sensetive, status);
-
-  // is pattern supported by icu regex
-  if (U_FAILURE(status)) {
-    // should not happen as validation should take place before reaching
-    // this point
-    DLOG(ERROR) << "[eyeo] None of the regex engines can use pattern: "
-                << pattern;
-    return false;
-  }
-  matcher.reset(icu_input);
-  return matcher.find(0, status);
+  const auto regex = RegexCache::GetInstance()->Get(pattern, case_sensitive);
+  return regex && regex->Matches(input);
 }
 
 }  // namespace utils
@@ -0,0 +1,185 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/common/literal_automaton.h"
+
+#include <algorithm>
+
+#include "base/check_op.h"
+#include "base/containers/queue.h"
+#include "base/ranges/algorithm.h"
+#include "base/strings/string_piece.h"
+
+namespace adblock {
+namespace {
+
+constexpr uint32_t kRoot = 0u;
+
+// Returns the state reached from |state| on |label|, or kRoot if there is no
+// such transition. No transition leads back to the root, so kRoot is
+// unambiguous.
+uint32_t FindTransition(const flat::LiteralAutomaton& automaton,
+                        uint32_t state,
+                        uint8_t label) {
+  const auto* labels = automaton.transition_labels();
+  const auto* transitions_begin = automaton.transitions_begin();
+  const auto* begin = labels->data() + transitions_begin->Get(state);
+  const auto* end = labels->data() + transitions_begin->Get(state + 1u);
+  const auto* it = std::lower_bound(begin, end, label);
+  if (it == end || *it != label) {
+    return kRoot;
+  }
+  return automaton.transition_targets()->Get(it - labels->data());
+}
+
+}  // namespace
+
+LiteralAutomatonBuilder::State::State() = default;
+LiteralAutomatonBuilder::State::~State() = default;
+LiteralAutomatonBuilder::State::State(State&&) = default;
+
+LiteralAutomatonBuilder::LiteralAutomatonBuilder() : states_(1u) {}
+
+LiteralAutomatonBuilder::~LiteralAutomatonBuilder() = default;
+
+void LiteralAutomatonBuilder::Add(base::StringPiece literal, uint32_t value) {
+  if (literal.empty()) {
+    unconditional_.push_back(value);
+    return;
+  }
+  uint32_t state = kRoot;
+  for (const char c : literal) {
+    const uint8_t label = static_cast<uint8_t>(c);
+    const auto it = states_[state].next.find(label);
+    if (it != states_[state].next.end()) {
+      state = it->second;
+      continue;
+    }
+    const uint32_t next = states_.size();
+    states_[state].next.emplace(label, next);
+    states_.emplace_back();
+    state = next;
+  }
+  states_[state].outputs.push_back(value);
+}
+
+bool LiteralAutomatonBuilder::HasLiterals() const {
+  return states_.size() > 1u;
+}
+
+flatbuffers::Offset<flat::LiteralAutomaton> LiteralAutomatonBuilder::Build(
+    flatbuffers::FlatBufferBuilder& builder) const {
+  const size_t state_count = states_.size();
+  std::vector<uint32_t> failure(state_count, kRoot);
+  std::vector<uint32_t> output_link(state_count, kRoot);
+
+  // Breadth-first, so the failure state of every state is final before the
+  // state's children are visited.
+  base::queue<uint32_t> queue;
+  for (const auto& [label, child] : states_[kRoot].next) {
+    queue.push(child);
+  }
+  while (!queue.empty()) {
+    const uint32_t state = queue.front();
+    queue.pop();
+    for (const auto& [label, child] : states_[state].next) {
+      uint32_t fallback = failure[state];
+      while (true) {
+        const auto it = states_[fallback].next.find(label);
+        if (it != states_[fallback].next.end()) {
+          failure[child] = it->second;
+          break;
+        }
+        if (fallback == kRoot) {
+          break;
+        }
+        fallback = failure[fallback];
+      }
+      output_link[child] = states_[failure[child]].outputs.empty()
+                               ? output_link[failure[child]]
+                               : failure[child];
+      queue.push(child);
+    }
+  }
+
+  std::vector<uint32_t> transitions_begin;
+  std::vector<uint8_t> transition_labels;
+  std::vector<uint32_t> transition_targets;
+  std::vector<uint32_t> outputs_begin;
+  std::vector<uint32_t> outputs;
+  transitions_begin.reserve(state_count + 1u);
+  outputs_begin.reserve(state_count + 1u);
+  for (const auto& state : states_) {
+    transitions_begin.push_back(transition_labels.size());
+    for (const auto& [label, child] : state.next) {
+      transition_labels.push_back(label);
+      transition_targets.push_back(child);
+    }
+    outputs_begin.push_back(outputs.size());
+    outputs.insert(outputs.end(), state.outputs.begin(), state.outputs.end());
+  }
+  transitions_begin.push_back(transition_labels.size());
+  outputs_begin.push_back(outputs.size());
+
+  return flat::CreateLiteralAutomaton(
+      builder, builder.CreateVector(transitions_begin),
+      builder.CreateVector(transition_labels),
+      builder.CreateVector(transition_targets), builder.CreateVector(failure),
+      builder.CreateVector(output_link), builder.CreateVector(outputs_begin),
+      builder.CreateVector(outputs), builder.CreateVector(unconditional_));
+}
+
+std::vector<uint32_t> FindLiteralAutomatonCandidates(
+    const flat::LiteralAutomaton& automaton,
+    base::StringPiece text) {
+  std::vector<uint32_t> result;
+  if (const auto* unconditional = automaton.unconditional()) {
+    result.assign(unconditional->begin(), unconditional->end());
+  }
+  const auto* failure = automaton.failure();
+  const auto* output_link = automaton.output_link();
+  const auto* outputs_begin = automaton.outputs_begin();
+  const auto* outputs = automaton.outputs();
+  if (!failure || failure->size() <= 1u) {
+    return result;
+  }
+
+  uint32_t state = kRoot;
+  for (const char c : text) {
+    const uint8_t label = static_cast<uint8_t>(c);
+    uint32_t next = FindTransition(automaton, state, label);
+    while (next == kRoot && state != kRoot) {
+      state = failure->Get(state);
+      next = FindTransition(automaton, state, label);
+    }
+    state = next;
+    // Report the literals ending here: the state's own, then those of the
+    // shorter suffixes along the output links.
+    for (uint32_t output_state = state; output_state != kRoot;
+         output_state = output_link->Get(output_state)) {
+      for (uint32_t i = outputs_begin->Get(output_state);
+           i < outputs_begin->Get(output_state + 1u); ++i) {
+        result.push_back(outputs->Get(i));
+      }
+    }
+  }
+  base::ranges::sort(result);
+  result.erase(base::ranges::unique(result), result.end());
+  return result;
+}
+
+}  // namespace adblock
@@ -0,0 +1,71 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CORE_COMMON_LITERAL_AUTOMATON_H_
+#define COMPONENTS_ADBLOCK_CORE_COMMON_LITERAL_AUTOMATON_H_
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "base/strings/string_piece_forward.h"
+#include "components/adblock/core/schema/filter_list_schema_generated.h"
+
+namespace adblock {
+
+// Builds a flat::LiteralAutomaton during conversion.
+class LiteralAutomatonBuilder {
+ public:
+  LiteralAutomatonBuilder();
+  ~LiteralAutomatonBuilder();
+  LiteralAutomatonBuilder(const LiteralAutomatonBuilder&) = delete;
+  LiteralAutomatonBuilder& operator=(const LiteralAutomatonBuilder&) = delete;
+
+  // |value| will be reported by FindLiteralAutomatonCandidates() for every
+  // text that contains |literal|. An empty |literal| is contained in every
+  // text.
+  void Add(base::StringPiece literal, uint32_t value);
+
+  // Whether any non-empty literal was added. Without one, the automaton would
+  // report every value for every text.
+  bool HasLiterals() const;
+
+  flatbuffers::Offset<flat::LiteralAutomaton> Build(
+      flatbuffers::FlatBufferBuilder& builder) const;
+
+ private:
+  struct State {
+    State();
+    ~State();
+    State(State&&);
+    std::map<uint8_t, uint32_t> next;
+    std::vector<uint32_t> outputs;
+  };
+
+  std::vector<State> states_;
+  std::vector<uint32_t> unconditional_;
+};
+
+// Returns the values, sorted and unique, of all literals of |automaton| that
+// occur in |text|, and of all literals that were empty. Scans |text| once.
+std::vector<uint32_t> FindLiteralAutomatonCandidates(
+    const flat::LiteralAutomaton& automaton,
+    base::StringPiece text);
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CORE_COMMON_LITERAL_AUTOMATON_H_
@@ -0,0 +1,78 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/common/pattern_program.h"
+
+#include "base/check.h"
+#include "base/strings/string_piece.h"
+#include "base/strings/string_util.h"
+#include "components/adblock/core/common/regex_filter_pattern.h"
+
+namespace adblock {
+
+std::vector<flat::PatternInstruction> CompilePatternProgram(
+    base::StringPiece filter_pattern) {
+  DCHECK(!ExtractRegexFilterFromPattern(filter_pattern))
+      << "Regular expression filters cannot be compiled";
+  std::vector<flat::PatternInstruction> program;
+  size_t begin = 0u;
+  size_t end = filter_pattern.size();
+  if (base::StartsWith(filter_pattern, "||")) {
+    begin = 2u;
+    // "||*" is equivalent to "*", which is equivalent to no anchor at all.
+    if (begin == end || filter_pattern[begin] != '*') {
+      program.emplace_back(flat::PatternOpcode_HostAnchor, 0u, 0u);
+    }
+  } else if (base::StartsWith(filter_pattern, "|")) {
+    begin = 1u;
+    program.emplace_back(flat::PatternOpcode_StartAnchor, 0u, 0u);
+  }
+  const bool end_anchored = end > begin && filter_pattern[end - 1] == '|';
+  if (end_anchored) {
+    --end;
+  }
+
+  size_t literal_begin = begin;
+  auto flush_literal = [&](size_t literal_end) {
+    if (literal_end > literal_begin) {
+      program.emplace_back(flat::PatternOpcode_Literal, literal_begin,
+                           literal_end - literal_begin);
+    }
+  };
+  for (size_t i = begin; i < end; ++i) {
+    const char c = filter_pattern[i];
+    if (c != '*' && c != '^') {
+      continue;
+    }
+    flush_literal(i);
+    literal_begin = i + 1;
+    if (c == '^') {
+      program.emplace_back(flat::PatternOpcode_Separator, 0u, 0u);
+    } else if (program.empty() ||
+               program.back().opcode() != flat::PatternOpcode_Wildcard) {
+      program.emplace_back(flat::PatternOpcode_Wildcard, 0u, 0u);
+    }
+  }
+  flush_literal(end);
+
+  if (end_anchored) {
+    program.emplace_back(flat::PatternOpcode_EndAnchor, 0u, 0u);
+  }
+  return program;
+}
+
+}  // namespace adblock
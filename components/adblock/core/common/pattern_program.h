@@ -0,0 +1,40 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CORE_COMMON_PATTERN_PROGRAM_H_
+#define COMPONENTS_ADBLOCK_CORE_COMMON_PATTERN_PROGRAM_H_
+
+#include <vector>
+
+#include "base/strings/string_piece_forward.h"
+#include "components/adblock/core/schema/filter_list_schema_generated.h"
+
+namespace adblock {
+
+// Compiles a non-regex filter pattern, like "||example.com^*/ad.js|", into
+// the instructions executed by DoesPatternProgramMatchUrl(). Consecutive
+// wildcards are collapsed and a host anchor immediately followed by a wildcard
+// is dropped, as it matches like an unanchored pattern. A "|" that is neither
+// the first nor the last character is part of a literal.
+// Literal instructions refer to ranges of |filter_pattern|, the program is
+// only meaningful together with it.
+std::vector<flat::PatternInstruction> CompilePatternProgram(
+    base::StringPiece filter_pattern);
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CORE_COMMON_PATTERN_PROGRAM_H_
@@ -0,0 +1,182 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/common/regex_cache.h"
+
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "base/no_destructor.h"
+#include "third_party/icu/source/i18n/unicode/regex.h"
+#include "third_party/re2/src/re2/re2.h"
+#include "url/url_constants.h"
+
+namespace adblock {
+namespace {
+
+// RE2 does not expose the size of a compiled program in bytes, only its
+// number of instructions.
+constexpr size_t kEstimatedBytesPerRe2Instruction = 16u;
+// ICU does not expose the size of a compiled pattern at all.
+constexpr size_t kEstimatedIcuBytesPerPatternCharacter = 64u;
+
+}  // namespace
+
+// static
+scoped_refptr<CompiledRegex> CompiledRegex::Compile(base::StringPiece pattern,
+                                                    bool case_sensitive) {
+  re2::RE2::Options options;
+  options.set_case_sensitive(case_sensitive);
+  options.set_never_capture(true);
+  options.set_log_errors(false);
+  options.set_encoding(re2::RE2::Options::EncodingLatin1);
+  auto re2_pattern = std::make_unique<re2::RE2>(
+      re2::StringPiece(pattern.data(), pattern.size()), options);
+  if (re2_pattern->ok()) {
+    return base::WrapRefCounted(
+        new CompiledRegex(std::move(re2_pattern), nullptr, pattern.size()));
+  }
+  VLOG(2) << "[eyeo] RE2 does not support filter pattern " << pattern
+          << " and return with error message: " << re2_pattern->error();
+
+  const icu::UnicodeString icu_pattern(pattern.data(), pattern.length());
+  UErrorCode status = U_ZERO_ERROR;
+  const auto icu_case_sensitive = case_sensitive ? 0u : UREGEX_CASE_INSENSITIVE;
+  auto compiled_icu_pattern = base::WrapUnique(
+      icu::RegexPattern::compile(icu_pattern, icu_case_sensitive, status));
+  if (U_FAILURE(status) || !compiled_icu_pattern) {
+    // Should not happen as validation should take place before reaching this
+    // point.
+    DLOG(ERROR) << "[eyeo] None of the regex engines can use pattern: "
+                << pattern;
+    return nullptr;
+  }
+  return base::WrapRefCounted(new CompiledRegex(
+      nullptr, std::move(compiled_icu_pattern), pattern.size()));
+}
+
+CompiledRegex::CompiledRegex(std::unique_ptr<re2::RE2> re2_pattern,
+                             std::unique_ptr<icu::RegexPattern> icu_pattern,
+                             size_t pattern_size)
+    : re2_pattern_(std::move(re2_pattern)),
+      icu_pattern_(std::move(icu_pattern)),
+      pattern_size_(pattern_size) {
+  DCHECK(!!re2_pattern_ != !!icu_pattern_);
+}
+
+CompiledRegex::~CompiledRegex() = default;
+
+bool CompiledRegex::Matches(base::StringPiece input) const {
+  if (re2_pattern_) {
+    return re2::RE2::PartialMatch(re2::StringPiece(input.data(), input.size()),
+                                  *re2_pattern_);
+  }
+  // Maximum length of the string to match to avoid causing an
+  // icu::RegexMatcher stack overflow. (crbug.com/1198219)
+  if (input.size() > url::kMaxURLChars) {
+    return false;
+  }
+  const icu::UnicodeString icu_input(input.data(), input.length());
+  UErrorCode status = U_ZERO_ERROR;
+  std::unique_ptr<icu::RegexMatcher> matcher =
+      base::WrapUnique(icu_pattern_->matcher(icu_input, status));
+  if (U_FAILURE(status) || !matcher) {
+    return false;
+  }
+  return matcher->find(0, status);
+}
+
+size_t CompiledRegex::EstimateMemoryUsage() const {
+  if (re2_pattern_) {
+    return sizeof(*this) + sizeof(re2::RE2) + pattern_size_ +
+           static_cast<size_t>(re2_pattern_->ProgramSize()) *
+               kEstimatedBytesPerRe2Instruction;
+  }
+  return sizeof(*this) + pattern_size_ * kEstimatedIcuBytesPerPatternCharacter;
+}
+
+// static
+RegexCache* RegexCache::GetInstance() {
+  static base::NoDestructor<RegexCache> instance;
+  return instance.get();
+}
+
+RegexCache::RegexCache(size_t memory_limit)
+    : memory_limit_(memory_limit),
+      entries_(base::LRUCache<Key, scoped_refptr<CompiledRegex>>::
+                   NO_AUTO_EVICT) {}
+
+RegexCache::~RegexCache() = default;
+
+scoped_refptr<CompiledRegex> RegexCache::Get(base::StringPiece pattern,
+                                             bool case_sensitive) {
+  Key key(std::string(pattern), case_sensitive);
+  {
+    base::AutoLock lock(lock_);
+    const auto it = entries_.Get(key);
+    if (it != entries_.end()) {
+      ++hits_;
+      return it->second;
+    }
+    ++misses_;
+  }
+
+  // Compiling may take a while, other expressions can be served meanwhile.
+  // Should two sequences compile the same expression, the last one is kept.
+  auto compiled = CompiledRegex::Compile(pattern, case_sensitive);
+  if (!compiled) {
+    return nullptr;
+  }
+  const size_t memory_usage = compiled->EstimateMemoryUsage();
+
+  base::AutoLock lock(lock_);
+  const auto existing = entries_.Peek(key);
+  if (existing != entries_.end()) {
+    memory_usage_ -= existing->second->EstimateMemoryUsage();
+    entries_.Erase(existing);
+  }
+  entries_.Put(std::move(key), compiled);
+  memory_usage_ += memory_usage;
+  // The newest entry is kept even if it exceeds the limit on its own.
+  while (memory_usage_ > memory_limit_ && entries_.size() > 1u) {
+    const auto oldest = entries_.rbegin();
+    memory_usage_ -= oldest->second->EstimateMemoryUsage();
+    entries_.Erase(oldest);
+  }
+  return compiled;
+}
+
+size_t RegexCache::GetEntryCount() const {
+  base::AutoLock lock(lock_);
+  return entries_.size();
+}
+
+size_t RegexCache::GetMemoryUsage() const {
+  base::AutoLock lock(lock_);
+  return memory_usage_;
+}
+
+size_t RegexCache::GetHitCount() const {
+  base::AutoLock lock(lock_);
+  return hits_;
+}
+
+size_t RegexCache::GetMissCount() const {
+  base::AutoLock lock(lock_);
+  return misses_;
+}
+
+}  // namespace adblock
@@ -0,0 +1,108 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CORE_COMMON_REGEX_CACHE_H_
+#define COMPONENTS_ADBLOCK_CORE_COMMON_REGEX_CACHE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "base/containers/lru_cache.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/string_piece.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+
+namespace icu {
+class RegexPattern;
+}  // namespace icu
+
+namespace re2 {
+class RE2;
+}  // namespace re2
+
+namespace adblock {
+
+// A regular expression compiled by RE2 or, for expressions RE2 does not
+// support, by ICU. Immutable, may be matched from any thread.
+class CompiledRegex final : public base::RefCountedThreadSafe<CompiledRegex> {
+ public:
+  // Returns nullptr if neither RE2 nor ICU can compile |pattern|.
+  static scoped_refptr<CompiledRegex> Compile(base::StringPiece pattern,
+                                              bool case_sensitive);
+
+  bool Matches(base::StringPiece input) const;
+
+  // Estimate of the memory held by the compiled expression. Does not include
+  // the DFA states RE2 caches while matching, which RE2 bounds by itself.
+  size_t EstimateMemoryUsage() const;
+
+ private:
+  friend class base::RefCountedThreadSafe<CompiledRegex>;
+  CompiledRegex(std::unique_ptr<re2::RE2> re2_pattern,
+                std::unique_ptr<icu::RegexPattern> icu_pattern,
+                size_t pattern_size);
+  ~CompiledRegex();
+
+  const std::unique_ptr<re2::RE2> re2_pattern_;
+  const std::unique_ptr<icu::RegexPattern> icu_pattern_;
+  const size_t pattern_size_;
+};
+
+// Compiled regular expressions shared by all subscriptions and sequences of
+// the process, so that a regex filter is compiled once rather than on every
+// evaluation. Bounded by the estimated memory usage of its entries, the least
+// recently used entry is evicted first. Evicted expressions stay valid for
+// callers still holding them. Thread-safe.
+class RegexCache final {
+ public:
+  static constexpr size_t kDefaultMemoryLimit = 4u * 1024u * 1024u;
+
+  static RegexCache* GetInstance();
+
+  explicit RegexCache(size_t memory_limit = kDefaultMemoryLimit);
+  ~RegexCache();
+  RegexCache(const RegexCache&) = delete;
+  RegexCache& operator=(const RegexCache&) = delete;
+
+  // Returns the compiled |pattern|, compiling it on a cache miss. Returns
+  // nullptr if |pattern| cannot be compiled, such patterns are not cached.
+  scoped_refptr<CompiledRegex> Get(base::StringPiece pattern,
+                                   bool case_sensitive);
+
+  size_t GetEntryCount() const;
+  size_t GetMemoryUsage() const;
+  size_t GetHitCount() const;
+  size_t GetMissCount() const;
+
+ private:
+  using Key = std::pair<std::string, bool>;
+
+  const size_t memory_limit_;
+  mutable base::Lock lock_;
+  base::LRUCache<Key, scoped_refptr<CompiledRegex>> entries_ GUARDED_BY(lock_);
+  size_t memory_usage_ GUARDED_BY(lock_) = 0u;
+  size_t hits_ GUARDED_BY(lock_) = 0u;
+  size_t misses_ GUARDED_BY(lock_) = 0u;
+};
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CORE_COMMON_REGEX_CACHE_H_
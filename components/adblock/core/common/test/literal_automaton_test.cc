@@ -0,0 +1,81 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/common/literal_automaton.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace adblock {
+
+class AdblockLiteralAutomatonTest : public testing::Test {
+ public:
+  const flat::LiteralAutomaton* Build(
+      const std::vector<std::pair<std::string, uint32_t>>& literals) {
+    LiteralAutomatonBuilder automaton_builder;
+    for (const auto& [literal, value] : literals) {
+      automaton_builder.Add(literal, value);
+    }
+    builder_.Finish(automaton_builder.Build(builder_));
+    return flatbuffers::GetRoot<flat::LiteralAutomaton>(
+        builder_.GetBufferPointer());
+  }
+
+  flatbuffers::FlatBufferBuilder builder_;
+};
+
+TEST_F(AdblockLiteralAutomatonTest, NoLiterals) {
+  const auto* automaton = Build({});
+  EXPECT_THAT(FindLiteralAutomatonCandidates(*automaton, "https://ads.com/"),
+              testing::IsEmpty());
+}
+
+TEST_F(AdblockLiteralAutomatonTest, EmptyLiteralAlwaysReported) {
+  const auto* automaton = Build({{"", 3u}, {"banner", 1u}});
+  EXPECT_THAT(FindLiteralAutomatonCandidates(*automaton, "https://ads.com/"),
+              testing::ElementsAre(3u));
+  EXPECT_THAT(
+      FindLiteralAutomatonCandidates(*automaton, "https://ads.com/banner"),
+      testing::ElementsAre(1u, 3u));
+}
+
+TEST_F(AdblockLiteralAutomatonTest, OverlappingLiteralsFound) {
+  const auto* automaton = Build({{"he", 0u},
+                                 {"she", 1u},
+                                 {"his", 2u},
+                                 {"hers", 3u},
+                                 {"/ad/", 4u},
+                                 {"ad", 5u}});
+  EXPECT_THAT(FindLiteralAutomatonCandidates(*automaton, "ushers"),
+              testing::ElementsAre(0u, 1u, 3u));
+  EXPECT_THAT(FindLiteralAutomatonCandidates(*automaton, "https://x.com/ad/"),
+              testing::ElementsAre(4u, 5u));
+  EXPECT_THAT(FindLiteralAutomatonCandidates(*automaton, "https://x.com/a/d"),
+              testing::IsEmpty());
+}
+
+TEST_F(AdblockLiteralAutomatonTest, ValuesReportedOnceAndSorted) {
+  const auto* automaton = Build({{"ad", 7u}, {"ad", 2u}, {"x", 5u}});
+  EXPECT_THAT(FindLiteralAutomatonCandidates(*automaton, "adxadxad"),
+              testing::ElementsAre(2u, 5u, 7u));
+}
+
+}  // namespace adblock
@@ -0,0 +1,96 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/common/pattern_program.h"
+
+#include <string>
+#include <vector>
+
+#include "base/strings/string_piece.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace adblock {
+namespace {
+
+// Renders |program| back into pattern syntax, with literals in brackets.
+std::string Describe(base::StringPiece pattern,
+                     const std::vector<flat::PatternInstruction>& program) {
+  std::string result;
+  for (const auto& instruction : program) {
+    switch (instruction.opcode()) {
+      case flat::PatternOpcode_Literal:
+        result += "[";
+        result += std::string(
+            pattern.substr(instruction.begin(), instruction.length()));
+        result += "]";
+        break;
+      case flat::PatternOpcode_Separator:
+        result += "^";
+        break;
+      case flat::PatternOpcode_Wildcard:
+        result += "*";
+        break;
+      case flat::PatternOpcode_StartAnchor:
+        result += "|<";
+        break;
+      case flat::PatternOpcode_HostAnchor:
+        result += "||";
+        break;
+      case flat::PatternOpcode_EndAnchor:
+        result += ">|";
+        break;
+    }
+  }
+  return result;
+}
+
+std::string Compile(base::StringPiece pattern) {
+  return Describe(pattern, CompilePatternProgram(pattern));
+}
+
+}  // namespace
+
+TEST(AdblockPatternProgramTest, EmptyPattern) {
+  EXPECT_EQ(Compile(""), "");
+}
+
+TEST(AdblockPatternProgramTest, LiteralsSeparatorsAndWildcards) {
+  EXPECT_EQ(Compile("/ads/*banner^"), "[/ads/]*[banner]^");
+  EXPECT_EQ(Compile("^foo.bar^"), "^[foo.bar]^");
+}
+
+TEST(AdblockPatternProgramTest, ConsecutiveWildcardsAreCollapsed) {
+  EXPECT_EQ(Compile("start***foobar"), "[start]*[foobar]");
+}
+
+TEST(AdblockPatternProgramTest, Anchors) {
+  EXPECT_EQ(Compile("|https"), "|<[https]");
+  EXPECT_EQ(Compile("||example.com^"), "||[example.com]^");
+  EXPECT_EQ(Compile("/popup/log|"), "[/popup/log]>|");
+  EXPECT_EQ(Compile("|https://ads.com/|"), "|<[https://ads.com/]>|");
+  EXPECT_EQ(Compile("|"), "|<");
+}
+
+TEST(AdblockPatternProgramTest, HostAnchorFollowedByWildcardIsDropped) {
+  EXPECT_EQ(Compile("||*/banner.gif"), "*[/banner.gif]");
+}
+
+TEST(AdblockPatternProgramTest, PipeInsidePatternIsLiteral) {
+  EXPECT_EQ(Compile("a|b"), "[a|b]");
+}
+
+}  // namespace adblock
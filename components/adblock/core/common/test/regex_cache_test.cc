@@ -0,0 +1,109 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/common/regex_cache.h"
+
+#include "base/strings/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace adblock {
+
+TEST(AdblockRegexCacheTest, CompilesRe2AndIcuExpressions) {
+  RegexCache cache;
+  const auto re2_regex = cache.Get("\\/banner[0-9]+\\.", false);
+  ASSERT_TRUE(re2_regex);
+  EXPECT_TRUE(re2_regex->Matches("https://ads.com/banner12.png"));
+  EXPECT_FALSE(re2_regex->Matches("https://ads.com/banner.png"));
+
+  // Lookahead is only supported by ICU.
+  const auto icu_regex = cache.Get("\\/track(?=er)", false);
+  ASSERT_TRUE(icu_regex);
+  EXPECT_TRUE(icu_regex->Matches("https://ads.com/tracker.js"));
+  EXPECT_FALSE(icu_regex->Matches("https://ads.com/tracking.js"));
+
+  EXPECT_EQ(cache.GetEntryCount(), 2u);
+}
+
+TEST(AdblockRegexCacheTest, CaseSensitivityIsPartOfKey) {
+  RegexCache cache;
+  const auto case_insensitive = cache.Get("banner", false);
+  const auto case_sensitive = cache.Get("banner", true);
+  ASSERT_TRUE(case_insensitive && case_sensitive);
+  EXPECT_NE(case_insensitive, case_sensitive);
+  EXPECT_TRUE(case_insensitive->Matches("https://ads.com/BANNER"));
+  EXPECT_FALSE(case_sensitive->Matches("https://ads.com/BANNER"));
+  EXPECT_EQ(cache.GetEntryCount(), 2u);
+}
+
+TEST(AdblockRegexCacheTest, ExpressionCompiledOnce) {
+  RegexCache cache;
+  const auto first = cache.Get("\\/ads?\\/", false);
+  const auto second = cache.Get("\\/ads?\\/", false);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(cache.GetMissCount(), 1u);
+  EXPECT_EQ(cache.GetHitCount(), 1u);
+}
+
+TEST(AdblockRegexCacheTest, InvalidExpressionNotCached) {
+  RegexCache cache;
+  EXPECT_FALSE(cache.Get("(unbalanced", false));
+  EXPECT_EQ(cache.GetEntryCount(), 0u);
+  EXPECT_EQ(cache.GetMemoryUsage(), 0u);
+}
+
+TEST(AdblockRegexCacheTest, LeastRecentlyUsedEvictedOverMemoryLimit) {
+  const auto expression = [](int i) {
+    return base::StringPrintf("\\/ad%d[_-]banner\\.", i);
+  };
+  const size_t entry_size =
+      CompiledRegex::Compile(expression(0), false)->EstimateMemoryUsage();
+  // Room for about three entries.
+  RegexCache cache(entry_size * 3u + entry_size / 2u);
+  const auto oldest = cache.Get(expression(0), false);
+  cache.Get(expression(1), false);
+  cache.Get(expression(2), false);
+  EXPECT_EQ(cache.GetEntryCount(), 3u);
+  // Makes expression(1) the least recently used.
+  cache.Get(expression(0), false);
+  cache.Get(expression(3), false);
+  EXPECT_EQ(cache.GetEntryCount(), 3u);
+  EXPECT_LE(cache.GetMemoryUsage(), entry_size * 3u + entry_size / 2u);
+
+  const size_t misses = cache.GetMissCount();
+  cache.Get(expression(0), false);
+  cache.Get(expression(2), false);
+  cache.Get(expression(3), false);
+  EXPECT_EQ(cache.GetMissCount(), misses);
+  cache.Get(expression(1), false);
+  EXPECT_EQ(cache.GetMissCount(), misses + 1u);
+
+  // Evicted expressions stay usable by their holders.
+  EXPECT_TRUE(oldest->Matches("https://ads.com/ad0_banner.png"));
+}
+
+TEST(AdblockRegexCacheTest, EntryLargerThanLimitKept) {
+  RegexCache cache(1u);
+  const auto regex = cache.Get("banner", false);
+  ASSERT_TRUE(regex);
+  EXPECT_EQ(cache.GetEntryCount(), 1u);
+  const auto newer_regex = cache.Get("popup", false);
+  ASSERT_TRUE(newer_regex);
+  EXPECT_EQ(cache.GetEntryCount(), 1u);
+  EXPECT_EQ(cache.GetMemoryUsage(), newer_regex->EstimateMemoryUsage());
+}
+
+}  // namespace adblock
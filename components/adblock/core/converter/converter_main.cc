@@ -25,6 +25,8 @@
 #include "base/logging.h"
 #include "components/adblock/core/common/flatbuffer_data.h"
 #include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/converter/serializer/filter_hit_table.h"
+#include "components/adblock/core/converter/serializer/keyword_frequency_table.h"
 #include "third_party/zlib/google/compression_utils.h"
 
 #if BUILDFLAG(IS_WIN)
@@ -33,7 +35,16 @@
 
 namespace {
 
-bool Convert(base::FilePath input_path, GURL url, base::FilePath output_path) {
+// Optional path to a table produced by adblock_keyword_frequency_generator.
+constexpr char kKeywordFrequenciesSwitch[] = "keyword-frequencies";
+// Optional path to a table produced by adblock_filter_hit_generator.
+constexpr char kFilterHitsSwitch[] = "filter-hits";
+
+bool Convert(base::FilePath input_path,
+             GURL url,
+             base::FilePath output_path,
+             const adblock::KeywordFrequencyTable* keyword_frequencies,
+             const adblock::FilterHitTable* filter_hits) {
   if (!url.is_valid()) {
     LOG(ERROR) << "[eyeo] Filter list URL not valid: " << url;
     return false;
@@ -51,7 +62,8 @@ bool Convert(base::FilePath input_path, GURL url, base::FilePath output_path) {
   }
   std::stringstream input(content);
   auto converter_result =
-      adblock::FlatbufferConverter::Convert(input, url, true);
+      adblock::FlatbufferConverter::Convert(input, url, true,
+                                            keyword_frequencies, filter_hits);
 
   if (absl::holds_alternative<adblock::ConversionError>(converter_result)) {
     LOG(ERROR) << "[eyeo] "
@@ -92,6 +104,8 @@ int main(int argc, char* argv[]) {
   const auto positional_arguments = command_line->GetArgs();
   if (positional_arguments.size() != 3u) {
     LOG(ERROR) << "[eyeo] Usage: " << command_line->GetProgram()
+               << " [--" << kKeywordFrequenciesSwitch << "=TABLE_FILE]"
+               << " [--" << kFilterHitsSwitch << "=TABLE_FILE]"
                << " [INPUT_FILE] [FILTER_LIST_URL] [OUTPUT_FILE]";
     return 1;
   }
@@ -108,7 +122,34 @@ int main(int argc, char* argv[]) {
 #endif
   const auto output_path = base::FilePath(positional_arguments[2]);
 
-  if (!Convert(input_path, url, output_path)) {
+  absl::optional<adblock::KeywordFrequencyTable> keyword_frequencies;
+  if (command_line->HasSwitch(kKeywordFrequenciesSwitch)) {
+    const auto table_path = base::MakeAbsoluteFilePath(
+        command_line->GetSwitchValuePath(kKeywordFrequenciesSwitch));
+    std::string table;
+    if (!base::ReadFileToString(table_path, &table) ||
+        !(keyword_frequencies = adblock::KeywordFrequencyTable::Parse(table))) {
+      LOG(ERROR) << "[eyeo] Could not read keyword frequency table "
+                 << table_path;
+      return 1;
+    }
+  }
+
+  absl::optional<adblock::FilterHitTable> filter_hits;
+  if (command_line->HasSwitch(kFilterHitsSwitch)) {
+    const auto table_path = base::MakeAbsoluteFilePath(
+        command_line->GetSwitchValuePath(kFilterHitsSwitch));
+    std::string table;
+    if (!base::ReadFileToString(table_path, &table) ||
+        !(filter_hits = adblock::FilterHitTable::Parse(table))) {
+      LOG(ERROR) << "[eyeo] Could not read filter hit table " << table_path;
+      return 1;
+    }
+  }
+
+  if (!Convert(input_path, url, output_path,
+               keyword_frequencies ? &*keyword_frequencies : nullptr,
+               filter_hits ? &*filter_hits : nullptr)) {
     return 1;
   }
   return 0;
@@ -0,0 +1,157 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "base/at_exit.h"
+#include "base/command_line.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "base/time/time.h"
+#include "components/adblock/core/common/content_type.h"
+#include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/converter/serializer/filter_hit_table.h"
+#include "components/adblock/core/subscription/filter_match_profiler.h"
+#include "components/adblock/core/subscription/installed_subscription_impl.h"
+#include "third_party/zlib/google/compression_utils.h"
+#include "url/gurl.h"
+
+// Builds a filter hit table for adblock_flatbuffer_converter's --filter-hits
+// switch by classifying a corpus of request URLs, one per line, against a
+// filter list. Filter evaluations are counted by FilterMatchProfiler.
+
+namespace {
+
+bool ReadFile(const base::FilePath& path, std::string& content) {
+  if (!base::ReadFileToString(path, &content)) {
+    LOG(ERROR) << "[eyeo] Could not open input file " << path;
+    return false;
+  }
+  if (path.MatchesFinalExtension(".gz") &&
+      !compression::GzipUncompress(content, &content)) {
+    LOG(ERROR) << "[eyeo] Could not decompress input file " << path;
+    return false;
+  }
+  return true;
+}
+
+// The corpus has no request types, guess them from the file extension.
+adblock::ContentType GuessContentType(const GURL& url) {
+  const base::StringPiece path = url.path_piece();
+  if (base::EndsWith(path, ".js")) {
+    return adblock::ContentType::Script;
+  }
+  if (base::EndsWith(path, ".css")) {
+    return adblock::ContentType::Stylesheet;
+  }
+  for (const char* extension : {".gif", ".jpg", ".jpeg", ".png", ".svg",
+                                ".webp"}) {
+    if (base::EndsWith(path, extension)) {
+      return adblock::ContentType::Image;
+    }
+  }
+  return adblock::ContentType::Other;
+}
+
+bool Generate(base::FilePath list_path,
+              base::FilePath urls_path,
+              base::FilePath output_path) {
+  std::string list;
+  std::string urls;
+  if (!ReadFile(list_path, list) || !ReadFile(urls_path, urls)) {
+    return false;
+  }
+  std::stringstream input(std::move(list));
+  auto converter_result =
+      adblock::FlatbufferConverter::Convert(input, GURL(), true);
+  if (!absl::holds_alternative<std::unique_ptr<adblock::FlatbufferData>>(
+          converter_result)) {
+    LOG(ERROR) << "[eyeo] Could not convert filter list " << list_path;
+    return false;
+  }
+  auto subscription = base::MakeRefCounted<adblock::InstalledSubscriptionImpl>(
+      std::move(absl::get<std::unique_ptr<adblock::FlatbufferData>>(
+          converter_result)),
+      adblock::Subscription::InstallationState::Installed, base::Time());
+
+  auto* profiler = adblock::FilterMatchProfiler::GetInstance();
+  profiler->SetEnabled(true);
+  for (const auto line : base::SplitStringPiece(
+           urls, "\n", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+    const GURL url(line);
+    if (!url.is_valid()) {
+      VLOG(1) << "[eyeo] Skipping invalid URL " << line;
+      continue;
+    }
+    for (const auto category : {adblock::FilterCategory::Blocking,
+                                adblock::FilterCategory::Allowing}) {
+      subscription->HasUrlFilter(url, url.host(), GuessContentType(url),
+                                 adblock::SiteKey(), category);
+    }
+  }
+  profiler->SetEnabled(false);
+
+  adblock::FilterHitTable table;
+  for (const auto& [pattern, stats] :
+       profiler->GetFilterStats(subscription->GetSourceUrl().spec())) {
+    table.AddEvaluations(pattern, stats.evaluations, stats.matches);
+  }
+  if (!base::WriteFile(output_path, table.Serialize())) {
+    LOG(ERROR) << "[eyeo] Could not write output file " << output_path;
+    return false;
+  }
+  LOG(INFO) << "[eyeo] Profiled " << table.size() << " filter patterns";
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  base::AtExitManager exit_manager;
+  base::CommandLine::Init(argc, argv);
+  auto* command_line = base::CommandLine::ForCurrentProcess();
+
+  logging::LoggingSettings logging_settings;
+  logging_settings.logging_dest = logging::LOG_TO_STDERR;
+  logging::InitLogging(logging_settings);
+
+  const auto positional_arguments = command_line->GetArgs();
+  if (positional_arguments.size() != 3u) {
+    LOG(ERROR) << "[eyeo] Usage: " << command_line->GetProgram()
+               << " [FILTER_LIST_FILE] [URL_LIST_FILE] [OUTPUT_FILE]";
+    return 1;
+  }
+
+  // We need to make the paths absolute because base::ReadFileToString() fails
+  // for paths with `..` components.
+  const auto list_path =
+      base::MakeAbsoluteFilePath(base::FilePath(positional_arguments[0]));
+  const auto urls_path =
+      base::MakeAbsoluteFilePath(base::FilePath(positional_arguments[1]));
+  const auto output_path = base::FilePath(positional_arguments[2]);
+
+  if (!Generate(list_path, urls_path, output_path)) {
+    return 1;
+  }
+  return 0;
+}
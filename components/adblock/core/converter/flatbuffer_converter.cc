@@ -37,9 +37,12 @@ static constexpr char kCommentPrefix[] = "!";
 static constexpr size_t kMaxSeparatorLength = 3u;
 
 // static
-ConversionResult FlatbufferConverter::Convert(std::istream& filter_stream,
-                                              GURL subscription_url,
-                                              bool allow_privileged) {
+ConversionResult FlatbufferConverter::Convert(
+    std::istream& filter_stream,
+    GURL subscription_url,
+    bool allow_privileged,
+    const KeywordFrequencyTable* keyword_frequencies,
+    const FilterHitTable* filter_hits) {
   if (!filter_stream) {
     return ConversionError("Invalid filter stream");
   }
@@ -53,8 +56,8 @@ ConversionResult FlatbufferConverter::Convert(std::istream& filter_stream,
     return metadata->redirect_url.value();
   }
 
-  FlatbufferSerializer flatbuffer_serializer(subscription_url,
-                                             allow_privileged);
+  FlatbufferSerializer flatbuffer_serializer(subscription_url, allow_privileged,
+                                             keyword_frequencies, filter_hits);
   flatbuffer_serializer.SerializeMetadata(std::move(metadata.value()));
   std::string line;
   while (std::getline(filter_stream, line)) {
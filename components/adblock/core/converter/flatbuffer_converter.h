@@ -34,12 +34,20 @@ using ConversionError =
 using ConversionResult =
     absl::variant<std::unique_ptr<FlatbufferData>, GURL, ConversionError>;
 
+class FilterHitTable;
 class FlatbufferSerializer;
+class KeywordFrequencyTable;
 class FlatbufferConverter {
  public:
-  static ConversionResult Convert(std::istream& filter_stream,
-                                  GURL subscription_url,
-                                  bool allow_privileged);
+  // |keyword_frequencies| optionally guides the choice of the keyword each
+  // URL filter is indexed under, and |filter_hits| the order of filters
+  // within a keyword bucket, see FlatbufferSerializer.
+  static ConversionResult Convert(
+      std::istream& filter_stream,
+      GURL subscription_url,
+      bool allow_privileged,
+      const KeywordFrequencyTable* keyword_frequencies = nullptr,
+      const FilterHitTable* filter_hits = nullptr);
   static std::unique_ptr<FlatbufferData> Convert(
       const std::vector<std::string>& filters,
       GURL subscription_url,
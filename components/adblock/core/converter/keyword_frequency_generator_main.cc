@@ -0,0 +1,108 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <set>
+#include <string>
+
+#include "base/at_exit.h"
+#include "base/command_line.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "components/adblock/core/common/keyword_extractor_utils.h"
+#include "components/adblock/core/converter/serializer/keyword_frequency_table.h"
+#include "components/adblock/core/subscription/url_keyword_extractor.h"
+#include "third_party/zlib/google/compression_utils.h"
+#include "url/gurl.h"
+
+// Builds a keyword frequency table for adblock_flatbuffer_converter's
+// --keyword-frequencies switch from a corpus of request URLs, one per line.
+// Keywords are extracted the way they are when classifying requests.
+
+namespace {
+
+bool Generate(base::FilePath input_path, base::FilePath output_path) {
+  std::string content;
+  if (!base::ReadFileToString(input_path, &content)) {
+    LOG(ERROR) << "[eyeo] Could not open input file " << input_path;
+    return false;
+  }
+  if (input_path.MatchesFinalExtension(".gz")) {
+    if (!compression::GzipUncompress(content, &content)) {
+      LOG(ERROR) << "[eyeo] Could not decompress input file " << input_path;
+      return false;
+    }
+  }
+
+  adblock::KeywordFrequencyTable table;
+  for (const auto line : base::SplitStringPiece(
+           content, "\n", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+    const GURL url(line);
+    if (!url.is_valid()) {
+      VLOG(1) << "[eyeo] Skipping invalid URL " << line;
+      continue;
+    }
+    const std::string lowercase_spec = base::ToLowerASCII(url.spec());
+    std::set<std::string> keywords;
+    adblock::UrlKeywordExtractor extractor(lowercase_spec);
+    while (const auto keyword = extractor.GetNextKeyword()) {
+      if (!adblock::utils::IsBadKeyword(*keyword)) {
+        keywords.emplace(*keyword);
+      }
+    }
+    table.AddUrl(keywords);
+  }
+
+  if (!base::WriteFile(output_path, table.Serialize())) {
+    LOG(ERROR) << "[eyeo] Could not write output file " << output_path;
+    return false;
+  }
+  LOG(INFO) << "[eyeo] Counted keywords of " << table.url_count() << " URLs";
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  base::AtExitManager exit_manager;
+  base::CommandLine::Init(argc, argv);
+  auto* command_line = base::CommandLine::ForCurrentProcess();
+
+  logging::LoggingSettings logging_settings;
+  logging_settings.logging_dest = logging::LOG_TO_STDERR;
+  logging::InitLogging(logging_settings);
+
+  const auto positional_arguments = command_line->GetArgs();
+  if (positional_arguments.size() != 2u) {
+    LOG(ERROR) << "[eyeo] Usage: " << command_line->GetProgram()
+               << " [URL_LIST_FILE] [OUTPUT_FILE]";
+    return 1;
+  }
+
+  // We need to make the path absolute because base::ReadFileToString() fails
+  // for paths with `..` components.
+  const auto input_path =
+      base::MakeAbsoluteFilePath(base::FilePath(positional_arguments[0]));
+  const auto output_path = base::FilePath(positional_arguments[1]);
+
+  if (!Generate(input_path, output_path)) {
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/converter/serializer/filter_hit_table.h"
+
+#include <sstream>
+
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+
+namespace adblock {
+
+FilterHitTable::FilterHitTable() = default;
+FilterHitTable::FilterHitTable(FilterHitTable&&) = default;
+FilterHitTable& FilterHitTable::operator=(FilterHitTable&&) = default;
+FilterHitTable::~FilterHitTable() = default;
+
+// static
+absl::optional<FilterHitTable> FilterHitTable::Parse(base::StringPiece data) {
+  FilterHitTable table;
+  for (const auto line : base::SplitStringPiece(
+           data, "\n", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+    // The pattern is last, so that it may contain spaces.
+    const size_t first_space = line.find(' ');
+    const size_t second_space = line.find(' ', first_space + 1);
+    if (first_space == base::StringPiece::npos ||
+        second_space == base::StringPiece::npos) {
+      return absl::nullopt;
+    }
+    uint64_t evaluations = 0u;
+    uint64_t matches = 0u;
+    if (!base::StringToUint64(line.substr(0, first_space), &evaluations) ||
+        !base::StringToUint64(
+            line.substr(first_space + 1, second_space - first_space - 1),
+            &matches) ||
+        matches > evaluations) {
+      return absl::nullopt;
+    }
+    table.AddEvaluations(line.substr(second_space + 1), evaluations, matches);
+  }
+  return table;
+}
+
+void FilterHitTable::AddEvaluations(base::StringPiece pattern,
+                                    uint64_t evaluations,
+                                    uint64_t matches) {
+  auto it = counts_.find(pattern);
+  if (it == counts_.end()) {
+    it = counts_.emplace(std::string(pattern), Counts()).first;
+  }
+  it->second.evaluations += evaluations;
+  it->second.matches += matches;
+  total_.evaluations += evaluations;
+  total_.matches += matches;
+}
+
+double FilterHitTable::GetHitProbability(base::StringPiece pattern) const {
+  const auto it = counts_.find(pattern);
+  if (it == counts_.end()) {
+    return (total_.matches + 1.0) / (total_.evaluations + 2.0);
+  }
+  // Laplace smoothing: a filter that never matched in the corpus might still
+  // match eventually.
+  return (it->second.matches + 1.0) / (it->second.evaluations + 2.0);
+}
+
+std::string FilterHitTable::Serialize() const {
+  std::ostringstream output;
+  for (const auto& [pattern, counts] : counts_) {
+    output << counts.evaluations << " " << counts.matches << " " << pattern
+           << "\n";
+  }
+  return output.str();
+}
+
+}  // namespace adblock
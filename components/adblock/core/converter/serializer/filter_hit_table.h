@@ -0,0 +1,75 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CORE_CONVERTER_SERIALIZER_FILTER_HIT_TABLE_H_
+#define COMPONENTS_ADBLOCK_CORE_CONVERTER_SERIALIZER_FILTER_HIT_TABLE_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+#include "absl/types/optional.h"
+#include "base/strings/string_piece.h"
+
+namespace adblock {
+
+// Counts how often each URL filter pattern was evaluated against a corpus of
+// requests, and how often it matched. FlatbufferSerializer can use the table
+// to try the filters of a keyword bucket that are most likely to match first,
+// which shortens lookups that stop at the first matching filter.
+// Patterns are keyed as stored in the flatbuffer, that is lowercased unless
+// the filter is $match-case.
+//
+// The text format produced by Serialize() has one "evaluations matches
+// pattern" line per pattern.
+class FilterHitTable {
+ public:
+  FilterHitTable();
+  FilterHitTable(FilterHitTable&&);
+  FilterHitTable& operator=(FilterHitTable&&);
+  ~FilterHitTable();
+
+  // Returns nullopt if |data| is not in the format produced by Serialize().
+  static absl::optional<FilterHitTable> Parse(base::StringPiece data);
+
+  void AddEvaluations(base::StringPiece pattern,
+                      uint64_t evaluations,
+                      uint64_t matches);
+
+  // Estimated probability that evaluating a filter with |pattern| matches.
+  // Patterns absent from the table are assumed to match as often as the
+  // average filter of the corpus.
+  double GetHitProbability(base::StringPiece pattern) const;
+
+  size_t size() const { return counts_.size(); }
+
+  std::string Serialize() const;
+
+ private:
+  struct Counts {
+    uint64_t evaluations = 0u;
+    uint64_t matches = 0u;
+  };
+
+  Counts total_;
+  std::map<std::string, Counts, std::less<>> counts_;
+};
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CORE_CONVERTER_SERIALIZER_FILTER_HIT_TABLE_H_
@@ -20,11 +20,218 @@
 #include <algorithm>
 #include <cctype>
 
+#include "base/containers/contains.h"
 #include "base/strings/string_util.h"
 #include "components/adblock/core/common/keyword_extractor_utils.h"
 #include "third_party/re2/src/re2/re2.h"
 
 namespace adblock {
+namespace {
+
+// Escapes that stand for a character class or an assertion and span exactly
+// two characters. Other alphanumeric escapes (\x41, \p{L}, \Q...\E) carry
+// arguments that would be misread as literals.
+constexpr base::StringPiece kSimpleEscapes = "dDwWsSbB";
+
+// Must agree with the characters UrlKeywordExtractor builds keywords from.
+bool IsKeywordCharacter(char c) {
+  return base::IsAsciiAlphaNumeric(c) || c == '%';
+}
+
+// Returns the position following the character class opened at |begin|, or
+// npos if the class is not terminated or contains a nested class.
+size_t SkipCharacterClass(base::StringPiece regex, size_t begin) {
+  size_t pos = begin + 1;
+  if (pos < regex.size() && regex[pos] == '^') {
+    ++pos;
+  }
+  // A leading ']' is a member of the class rather than its end.
+  if (pos < regex.size() && regex[pos] == ']') {
+    ++pos;
+  }
+  while (pos < regex.size()) {
+    switch (regex[pos]) {
+      case '\\':
+        pos += 2;
+        continue;
+      case '[':
+        return base::StringPiece::npos;
+      case ']':
+        return pos + 1;
+    }
+    ++pos;
+  }
+  return base::StringPiece::npos;
+}
+
+// Returns the position following the group opened at |begin|, or npos if the
+// group is not terminated or enables free-spacing mode, which would change
+// how the remaining literals are read.
+size_t SkipGroup(base::StringPiece regex, size_t begin) {
+  if (regex.substr(begin, 2) == "(?") {
+    const size_t flags_end = regex.find_first_of(":)", begin);
+    if (flags_end == base::StringPiece::npos ||
+        regex.substr(begin, flags_end - begin).find('x') !=
+            base::StringPiece::npos) {
+      return base::StringPiece::npos;
+    }
+  }
+  int depth = 0;
+  size_t pos = begin;
+  while (pos < regex.size()) {
+    switch (regex[pos]) {
+      case '\\':
+        pos += 2;
+        continue;
+      case '[':
+        pos = SkipCharacterClass(regex, pos);
+        if (pos == base::StringPiece::npos) {
+          return pos;
+        }
+        continue;
+      case '(':
+        ++depth;
+        break;
+      case ')':
+        if (--depth == 0) {
+          return pos + 1;
+        }
+        break;
+    }
+    ++pos;
+  }
+  return base::StringPiece::npos;
+}
+
+// Splits the top-level concatenation of |regex| into runs of literal
+// characters that every match contains verbatim. Groups, classes, anchors and
+// quantified characters end a run. Returns nullopt if the expression has a
+// top-level alternation or cannot be analyzed.
+absl::optional<std::vector<std::string>> FindMandatoryLiterals(
+    base::StringPiece regex) {
+  std::vector<std::string> literals;
+  std::string literal;
+  const auto end_literal = [&]() {
+    if (!literal.empty()) {
+      literals.push_back(std::move(literal));
+    }
+    literal.clear();
+  };
+  size_t pos = 0;
+  while (pos < regex.size()) {
+    const char c = regex[pos];
+    switch (c) {
+      case '|':
+      case ')':
+      case ']':
+        return absl::nullopt;
+      case '(':
+      case '[':
+        end_literal();
+        pos = c == '(' ? SkipGroup(regex, pos) : SkipCharacterClass(regex, pos);
+        if (pos == base::StringPiece::npos) {
+          return absl::nullopt;
+        }
+        continue;
+      case '*':
+      case '+':
+      case '?':
+      case '{': {
+        size_t quantifier_end = pos + 1;
+        if (c == '{') {
+          const size_t close = regex.find('}', pos);
+          if (close == base::StringPiece::npos ||
+              regex.substr(pos + 1, close - pos - 1)
+                      .find_first_not_of("0123456789,") !=
+                  base::StringPiece::npos) {
+            return absl::nullopt;
+          }
+          quantifier_end = close + 1;
+        }
+        // The quantified character may be absent or repeated, so it cannot be
+        // part of a literal. If the quantifier follows a group or a class,
+        // the literal has already ended.
+        if (!literal.empty()) {
+          literal.pop_back();
+        }
+        end_literal();
+        pos = quantifier_end;
+        continue;
+      }
+      case '\\': {
+        if (pos + 1 == regex.size()) {
+          return absl::nullopt;
+        }
+        const char escaped = regex[pos + 1];
+        if (!base::IsAsciiPrintable(escaped)) {
+          return absl::nullopt;
+        }
+        if (base::IsAsciiAlphaNumeric(escaped)) {
+          if (!base::Contains(kSimpleEscapes, escaped)) {
+            return absl::nullopt;
+          }
+          end_literal();
+        } else {
+          literal.push_back(escaped);
+        }
+        pos += 2;
+        continue;
+      }
+      case '.':
+      case '^':
+      case '$':
+        end_literal();
+        break;
+      default:
+        // Whitespace may be insignificant and non-ASCII characters span
+        // several bytes, neither can safely extend a literal.
+        if (base::IsAsciiPrintable(c) && c != ' ') {
+          literal.push_back(c);
+        } else {
+          end_literal();
+        }
+        break;
+    }
+    ++pos;
+  }
+  end_literal();
+  return literals;
+}
+
+}  // namespace
+
+std::vector<std::string> ExtractRegexKeywords(base::StringPiece regex) {
+  const auto literals = FindMandatoryLiterals(regex);
+  if (!literals) {
+    return {};
+  }
+  std::vector<std::string> keywords;
+  for (const auto& literal : *literals) {
+    size_t begin = 0;
+    while (begin < literal.size()) {
+      if (!IsKeywordCharacter(literal[begin])) {
+        ++begin;
+        continue;
+      }
+      size_t end = begin;
+      while (end < literal.size() && IsKeywordCharacter(literal[end])) {
+        ++end;
+      }
+      // A keyword touching either end of the literal could continue into
+      // characters matched by the rest of the expression, e.g. "banner" in
+      // \/banner[0-9]+\/ would not be a keyword of "/banner12/".
+      if (begin > 0 && end < literal.size()) {
+        auto keyword = base::ToLowerASCII(literal.substr(begin, end - begin));
+        if (!utils::IsBadKeyword(keyword) &&
+            !base::Contains(keywords, keyword)) {
+          keywords.push_back(std::move(keyword));
+        }
+      }
+      begin = end;
+    }
+  }
+  return keywords;
+}
 
 absl::optional<std::string> FilterKeywordExtractor::GetNextKeyword() {
   std::string current_keyword;
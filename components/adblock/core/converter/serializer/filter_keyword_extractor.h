@@ -20,6 +20,7 @@
 #define COMPONENTS_ADBLOCK_CORE_CONVERTER_SERIALIZER_FILTER_KEYWORD_EXTRACTOR_H_
 
 #include <string>
+#include <vector>
 
 #include "absl/types/optional.h"
 #include "base/strings/string_piece_forward.h"
@@ -54,6 +55,15 @@ class FilterKeywordExtractor {
   re2::StringPiece::iterator end_of_last_keyword_;
 };
 
+// Returns the keywords that any URL matched by |regex| is guaranteed to
+// contain, lowercased. A keyword qualifies only when it occurs in a mandatory
+// literal part of the expression and is surrounded by literal non-keyword
+// characters, so that extracting keywords from a matching URL yields exactly
+// this keyword. The analysis is conservative: expressions using alternation
+// or unsupported escapes yield no keywords, so their filters stay in the ""
+// bucket.
+std::vector<std::string> ExtractRegexKeywords(base::StringPiece regex);
+
 }  // namespace adblock
 
 #endif  // COMPONENTS_ADBLOCK_CORE_CONVERTER_SERIALIZER_FILTER_KEYWORD_EXTRACTOR_H_
@@ -17,17 +17,68 @@
 
 #include "components/adblock/core/converter/serializer/flatbuffer_serializer.h"
 
+#include "base/bits.h"
+#include "base/check_op.h"
 #include "base/logging.h"
 #include "base/notreached.h"
+#include "base/ranges/algorithm.h"
 #include "base/strings/string_piece.h"
 #include "base/strings/string_util.h"
 #include "components/adblock/core/common/adblock_constants.h"
+#include "components/adblock/core/common/literal_automaton.h"
+#include "components/adblock/core/common/pattern_program.h"
 #include "components/adblock/core/common/regex_filter_pattern.h"
 #include "components/adblock/core/converter/parser/filter_classifier.h"
+#include "components/adblock/core/converter/serializer/filter_hit_table.h"
 #include "components/adblock/core/converter/serializer/filter_keyword_extractor.h"
+#include "components/adblock/core/converter/serializer/keyword_frequency_table.h"
 
 namespace adblock {
 
+namespace {
+
+// Rough relative costs of the steps of evaluating a URL filter, see
+// InstalledSubscriptionImpl::FindFiltersInBucket(). Only their ratios matter.
+constexpr double kOptionCheckCost = 1.0;
+constexpr double kPatternInstructionCost = 1.0;
+constexpr double kWildcardCost = 4.0;
+// Regex filters of a bucket are matched in one batch, but the batch is
+// usually more expensive than any compiled pattern.
+constexpr double kRegexCost = 64.0;
+
+// Estimated share of requests that pass the option checks of a filter with
+// such a restriction, so that its pattern is evaluated at all.
+constexpr double kSitekeyPassRate = 0.01;
+constexpr double kIncludeDomainsPassRate = 0.05;
+constexpr double kThirdPartyPassRate = 0.5;
+
+// Mirrors InstalledSubscriptionImpl::IsGenericFilter(): generic filters have
+// no sitekeys, no exclude domains, and either no include domains or the empty
+// one.
+bool IsGenericUrlFilter(const UrlFilterOptions& options) {
+  const auto& include_domains = options.Domains().GetIncludeDomains();
+  return options.Sitekeys().empty() &&
+         options.Domains().GetExcludeDomains().empty() &&
+         (include_domains.empty() ||
+          base::ranges::any_of(include_domains, &std::string::empty));
+}
+
+// Returns the longest literal of |pattern|, given its compiled |program|.
+std::string FindRequiredLiteral(
+    base::StringPiece pattern,
+    const std::vector<flat::PatternInstruction>& program) {
+  base::StringPiece longest;
+  for (const auto& instruction : program) {
+    if (instruction.opcode() == flat::PatternOpcode_Literal &&
+        instruction.length() > longest.size()) {
+      longest = pattern.substr(instruction.begin(), instruction.length());
+    }
+  }
+  return std::string(longest);
+}
+
+}  // namespace
+
 class Buffer : public FlatbufferData {
  public:
   explicit Buffer(flatbuffers::DetachedBuffer&& buffer)
@@ -41,9 +92,15 @@ class Buffer : public FlatbufferData {
   flatbuffers::DetachedBuffer buffer_;
 };
 
-FlatbufferSerializer::FlatbufferSerializer(GURL subscription_url,
-                                           bool allow_privileged)
-    : subscription_url_(subscription_url), allow_privileged_(allow_privileged) {
+FlatbufferSerializer::FlatbufferSerializer(
+    GURL subscription_url,
+    bool allow_privileged,
+    const KeywordFrequencyTable* keyword_frequencies,
+    const FilterHitTable* filter_hits)
+    : subscription_url_(subscription_url),
+      allow_privileged_(allow_privileged),
+      keyword_frequencies_(keyword_frequencies),
+      filter_hits_(filter_hits) {
   SerializeMetadata(Metadata::Default());
 }
 
@@ -51,6 +108,7 @@ FlatbufferSerializer::~FlatbufferSerializer() = default;
 
 std::unique_ptr<FlatbufferData>
 FlatbufferSerializer::GetSerializedSubscription() {
+  RemoveGenericSelectorsWithGenericExceptions();
   auto subscription = flat::CreateSubscription(
       builder_, metadata_, WriteUrlFilterIndex(url_subresource_block_),
       WriteUrlFilterIndex(url_subresource_allow_),
@@ -61,14 +119,16 @@ FlatbufferSerializer::GetSerializedSubscription() {
       WriteUrlFilterIndex(url_generichide_allow_),
       WriteUrlFilterIndex(url_genericblock_allow_),
       WriteUrlFilterIndex(url_csp_block_), WriteUrlFilterIndex(url_csp_allow_),
-      WriteUrlFilterIndex(url_rewrite_block_),
-      WriteUrlFilterIndex(url_rewrite_allow_),
+      // The first matching rewrite filter determines the rewritten URL.
+      WriteUrlFilterIndex(url_rewrite_block_, UrlFilterOrder::kConversion),
+      WriteUrlFilterIndex(url_rewrite_allow_, UrlFilterOrder::kConversion),
       WriteUrlFilterIndex(url_header_block_),
       WriteUrlFilterIndex(url_header_allow_),
       WriteElemhideFilterIndex(elemhide_index_),
       WriteElemhideFilterIndex(elemhide_emulation_index_),
       WriteElemhideFilterIndex(elemhide_exception_index_),
-      WriteSnippetFilterIndex(snippet_index_));
+      WriteSnippetFilterIndex(snippet_index_),
+      WriteElemhideFilterIndex(elemhide_generic_exclusions_));
 
   builder_.Finish(subscription, flat::SubscriptionIdentifier());
   return std::make_unique<Buffer>(builder_.Release());
@@ -86,30 +146,39 @@ void FlatbufferSerializer::SerializeMetadata(const Metadata metadata) {
 
 void FlatbufferSerializer::SerializeContentFilter(
     const ContentFilter content_filter) {
-  auto offset = flat::CreateElemHideFilter(
-      builder_, {},
+  const std::string selector =
       content_filter.type == FilterType::ElemHideEmulation
-          ? builder_.CreateString(content_filter.selector.data(),
-                                  content_filter.selector.size())
-          : builder_.CreateString(EscapeSelector(content_filter.selector)),
-      CreateVectorOfSharedStrings(content_filter.domains.GetIncludeDomains()),
-      CreateVectorOfSharedStrings(content_filter.domains.GetExcludeDomains()));
+          ? content_filter.selector
+          : EscapeSelector(content_filter.selector);
+  const auto& include_domains = content_filter.domains.GetIncludeDomains();
+  const auto& exclude_domains = content_filter.domains.GetExcludeDomains();
+  const IndexedElemhideFilter filter{
+      flat::CreateElemHideFilter(builder_, {}, builder_.CreateString(selector),
+                                 CreateVectorOfSharedStrings(include_domains),
+                                 CreateVectorOfSharedStrings(exclude_domains)),
+      !exclude_domains.empty()};
 
   // Insert the filter under the correct index.
   switch (content_filter.type) {
     case FilterType::ElemHide:
-      AddElemhideFilterForDomains(
-          elemhide_index_, content_filter.domains.GetIncludeDomains(), offset);
+      AddElemhideFilterForDomains(elemhide_index_, include_domains, filter);
+      if (include_domains.empty()) {
+        generic_elemhide_selectors_.push_back(selector);
+        for (const auto& domain : exclude_domains) {
+          elemhide_generic_exclusions_[domain].push_back(filter);
+        }
+      }
       break;
     case FilterType::ElemHideException:
-      AddElemhideFilterForDomains(elemhide_exception_index_,
-                                  content_filter.domains.GetIncludeDomains(),
-                                  offset);
+      AddElemhideFilterForDomains(elemhide_exception_index_, include_domains,
+                                  filter);
+      if (include_domains.empty() && exclude_domains.empty()) {
+        generic_elemhide_exceptions_.insert(selector);
+      }
       break;
     case FilterType::ElemHideEmulation:
-      AddElemhideFilterForDomains(elemhide_emulation_index_,
-                                  content_filter.domains.GetIncludeDomains(),
-                                  offset);
+      AddElemhideFilterForDomains(elemhide_emulation_index_, include_domains,
+                                  filter);
       break;
     default:
       break;
@@ -147,13 +216,24 @@ void FlatbufferSerializer::SerializeUrlFilter(const UrlFilter url_filter) {
     return;
   }
 
+  const auto regex = ExtractRegexFilterFromPattern(url_filter.pattern);
+  const bool is_regex_pattern = regex.has_value();
+  // Regex patterns are handled by RegexMatcher and have no program.
+  const auto program = is_regex_pattern
+                           ? std::vector<flat::PatternInstruction>()
+                           : CompilePatternProgram(url_filter.pattern);
+  const auto pattern_program =
+      is_regex_pattern
+          ? flatbuffers::Offset<
+                flatbuffers::Vector<const flat::PatternInstruction*>>()
+          : builder_.CreateVectorOfStructs(program);
   auto offset = flat::CreateUrlFilter(
       builder_, {}, builder_.CreateString(url_filter.pattern),
       options.IsMatchCase(), options.ContentTypes(),
       ThirdPartyOptionToFb(options.ThirdParty()),
       CreateVectorOfSharedStringsFromSitekeys(options.Sitekeys()),
-      CreateVectorOfSharedStrings(options.Domains().GetIncludeDomains()),
-      CreateVectorOfSharedStrings(options.Domains().GetExcludeDomains()),
+      CreateSortedVectorOfSharedStrings(options.Domains().GetIncludeDomains()),
+      CreateSortedVectorOfSharedStrings(options.Domains().GetExcludeDomains()),
       options.Rewrite().has_value()
           ? flat::CreateRewrite(builder_,
                                 RewriteOptionToFb(options.Rewrite().value()))
@@ -163,57 +243,78 @@ void FlatbufferSerializer::SerializeUrlFilter(const UrlFilter url_filter) {
           : flatbuffers::Offset<flatbuffers::String>(),
       options.Headers().has_value()
           ? builder_.CreateSharedString(options.Headers().value())
-          : flatbuffers::Offset<flatbuffers::String>());
+          : flatbuffers::Offset<flatbuffers::String>(),
+      flatbuffers::Offset<flat::Header>(), pattern_program);
 
-  const absl::optional<base::StringPiece> keyword_pattern =
-      ExtractRegexFilterFromPattern(url_filter.pattern).has_value()
-          ? absl::optional<base::StringPiece>()
-          : url_filter.pattern;
+  // Regex filters are indexed under a keyword only when the expression
+  // guarantees that every matching URL contains it, otherwise under "".
+  std::vector<std::string> candidate_keywords;
+  if (is_regex_pattern) {
+    candidate_keywords = ExtractRegexKeywords(*regex);
+  } else {
+    FilterKeywordExtractor keyword_extractor(url_filter.pattern);
+    while (auto keyword = keyword_extractor.GetNextKeyword()) {
+      candidate_keywords.push_back(std::move(*keyword));
+    }
+  }
+  // Match-case patterns are compared against the URL as is, so their literals
+  // might not occur in the lowercased URL scanned by the literal automaton.
+  const IndexedUrlFilter indexed_filter{
+      offset,
+      options.IsMatchCase() ? std::string()
+                            : FindRequiredLiteral(url_filter.pattern, program),
+      options.ContentTypes(),
+      UrlFilterCost(url_filter, is_regex_pattern, program),
+      IsGenericUrlFilter(options)};
 
   if (options.Headers().has_value()) {
     AddUrlFilterToIndex(
         url_filter.is_allowing ? url_header_allow_ : url_header_block_,
-        keyword_pattern, offset);
+        candidate_keywords, indexed_filter);
     return;
   }
 
   if (options.IsPopup()) {
     AddUrlFilterToIndex(
         url_filter.is_allowing ? url_popup_allow_ : url_popup_block_,
-        keyword_pattern, offset);
+        candidate_keywords, indexed_filter);
   }
 
   if (options.Csp().has_value()) {
     AddUrlFilterToIndex(
         url_filter.is_allowing ? url_csp_allow_ : url_csp_block_,
-        keyword_pattern, offset);
+        candidate_keywords, indexed_filter);
   }
 
   if (options.Rewrite().has_value()) {
     AddUrlFilterToIndex(
         url_filter.is_allowing ? url_rewrite_allow_ : url_rewrite_block_,
-        keyword_pattern, offset);
+        candidate_keywords, indexed_filter);
   }
 
   if (options.IsSubresource()) {
     AddUrlFilterToIndex(url_filter.is_allowing ? url_subresource_allow_
                                                : url_subresource_block_,
-                        keyword_pattern, offset);
+                        candidate_keywords, indexed_filter);
   }
 
   for (auto exception_type : options.ExceptionTypes()) {
     switch (exception_type) {
       case UrlFilterOptions::ExceptionType::Genericblock:
-        AddUrlFilterToIndex(url_genericblock_allow_, keyword_pattern, offset);
+        AddUrlFilterToIndex(url_genericblock_allow_, candidate_keywords,
+                            indexed_filter);
         break;
       case UrlFilterOptions::ExceptionType::Generichide:
-        AddUrlFilterToIndex(url_generichide_allow_, keyword_pattern, offset);
+        AddUrlFilterToIndex(url_generichide_allow_, candidate_keywords,
+                            indexed_filter);
         break;
       case UrlFilterOptions::ExceptionType::Document:
-        AddUrlFilterToIndex(url_document_allow_, keyword_pattern, offset);
+        AddUrlFilterToIndex(url_document_allow_, candidate_keywords,
+                            indexed_filter);
         break;
       case UrlFilterOptions::ExceptionType::Elemhide:
-        AddUrlFilterToIndex(url_elemhide_allow_, keyword_pattern, offset);
+        AddUrlFilterToIndex(url_elemhide_allow_, candidate_keywords,
+                            indexed_filter);
         break;
       default:
         break;
@@ -223,17 +324,15 @@ void FlatbufferSerializer::SerializeUrlFilter(const UrlFilter url_filter) {
 
 void FlatbufferSerializer::AddUrlFilterToIndex(
     UrlFilterIndex& index,
-    absl::optional<base::StringPiece> pattern_text,
-    flatbuffers::Offset<flat::UrlFilter> filter) {
-  const auto keyword =
-      pattern_text ? FindCandidateKeyword(index, *pattern_text) : "";
-  index[keyword].push_back(filter);
+    const std::vector<std::string>& candidate_keywords,
+    const IndexedUrlFilter& filter) {
+  index[FindCandidateKeyword(index, candidate_keywords)].push_back(filter);
 }
 
 void FlatbufferSerializer::AddElemhideFilterForDomains(
     ElemhideIndex& index,
     const std::vector<std::string>& include_domains,
-    flatbuffers::Offset<flat::ElemHideFilter> filter) const {
+    const IndexedElemhideFilter& filter) const {
   if (include_domains.empty()) {
     // This is a generic filter, we add those under "" index.
     index[""].push_back(filter);
@@ -265,6 +364,15 @@ FlatbufferSerializer::CreateVectorOfSharedStrings(
   return builder_.CreateVector(std::move(shared_strings));
 }
 
+flatbuffers::Offset<
+    flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>>
+FlatbufferSerializer::CreateSortedVectorOfSharedStrings(
+    std::vector<std::string> strings) {
+  base::ranges::sort(strings);
+  strings.erase(base::ranges::unique(strings), strings.end());
+  return CreateVectorOfSharedStrings(strings);
+}
+
 flatbuffers::Offset<
     flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>>
 FlatbufferSerializer::CreateVectorOfSharedStringsFromSitekeys(
@@ -278,19 +386,121 @@ FlatbufferSerializer::CreateVectorOfSharedStringsFromSitekeys(
 
 flatbuffers::Offset<
     flatbuffers::Vector<flatbuffers::Offset<flat::UrlFiltersByKeyword>>>
-FlatbufferSerializer::WriteUrlFilterIndex(const UrlFilterIndex& index) {
+FlatbufferSerializer::WriteUrlFilterIndex(const UrlFilterIndex& index,
+                                          UrlFilterOrder order) {
   std::vector<flatbuffers::Offset<flat::UrlFiltersByKeyword>> offsets;
   offsets.reserve(index.size());
 
   for (const auto& cur : index) {
+    std::vector<const IndexedUrlFilter*> sorted_filters;
+    sorted_filters.reserve(cur.second.size());
+    for (const auto& filter : cur.second) {
+      sorted_filters.push_back(&filter);
+    }
+    // Order-dependent indexes keep the conversion order, in a single slice.
+    // Their lookups pass no content type, and check whether each filter is
+    // generic when $genericblock applies.
+    const bool reorder = order == UrlFilterOrder::kCost;
+    if (reorder) {
+      // Domain-specific filters come first, so that $genericblock lookups can
+      // stop before the generic ones. Within each part, group filters for the
+      // same resource types, so that a request can skip the slices whose
+      // filters don't apply to its content type. Slices for fewer resource
+      // types come first, and within a slice the cheapest filters. The sort
+      // is stable to keep the conversion order otherwise.
+      std::stable_sort(
+          sorted_filters.begin(), sorted_filters.end(),
+          [](const IndexedUrlFilter* lhs, const IndexedUrlFilter* rhs) {
+            if (lhs->generic != rhs->generic) {
+              return rhs->generic;
+            }
+            const int lhs_types =
+                base::bits::CountPopulation(lhs->resource_type);
+            const int rhs_types =
+                base::bits::CountPopulation(rhs->resource_type);
+            if (lhs_types != rhs_types) {
+              return lhs_types < rhs_types;
+            }
+            if (lhs->resource_type != rhs->resource_type) {
+              return lhs->resource_type < rhs->resource_type;
+            }
+            return lhs->cost < rhs->cost;
+          });
+    }
+
+    std::vector<flatbuffers::Offset<flat::UrlFilter>> filters;
+    filters.reserve(sorted_filters.size());
+    std::vector<flat::ContentTypeSlice> slices;
+    uint32_t resource_type_union = 0u;
+    uint32_t domain_specific_resource_type_union = 0u;
+    uint32_t generic_begin = 0u;
+    uint32_t slice_begin = 0u;
+    uint32_t slice_resource_type = 0u;
+    // Filters without a keyword are checked against every URL, the automaton
+    // narrows them down to those whose required literal occurs in the URL.
+    LiteralAutomatonBuilder automaton_builder;
+    for (const auto* filter : sorted_filters) {
+      const uint32_t position = filters.size();
+      if (cur.first.empty()) {
+        automaton_builder.Add(filter->required_literal, position);
+      }
+      slice_resource_type |= filter->resource_type;
+      const bool ends_slice =
+          position + 1 == sorted_filters.size() ||
+          (reorder && (sorted_filters[position + 1]->resource_type !=
+                           filter->resource_type ||
+                       sorted_filters[position + 1]->generic !=
+                           filter->generic));
+      if (ends_slice) {
+        slices.emplace_back(slice_resource_type, slice_begin, position + 1);
+        slice_begin = position + 1;
+        slice_resource_type = 0u;
+      }
+      resource_type_union |= filter->resource_type;
+      if (!filter->generic) {
+        domain_specific_resource_type_union |= filter->resource_type;
+        if (reorder) {
+          generic_begin = position + 1;
+        }
+      }
+      filters.push_back(filter->offset);
+    }
     offsets.push_back(flat::CreateUrlFiltersByKeyword(
         builder_, builder_.CreateSharedString(cur.first),
-        builder_.CreateVector(cur.second)));
+        builder_.CreateVector(filters),
+        automaton_builder.HasLiterals()
+            ? automaton_builder.Build(builder_)
+            : flatbuffers::Offset<flat::LiteralAutomaton>(),
+        resource_type_union, builder_.CreateVectorOfStructs(slices),
+        generic_begin, domain_specific_resource_type_union, !reorder));
   }
 
   return builder_.CreateVector(offsets);
 }
 
+void FlatbufferSerializer::RemoveGenericSelectorsWithGenericExceptions() {
+  if (generic_elemhide_exceptions_.empty()) {
+    return;
+  }
+  auto generic_filters = elemhide_index_.find("");
+  if (generic_filters == elemhide_index_.end()) {
+    return;
+  }
+  auto& filters = generic_filters->second;
+  DCHECK_EQ(filters.size(), generic_elemhide_selectors_.size());
+  size_t kept = 0u;
+  for (size_t i = 0; i < filters.size(); ++i) {
+    if (!generic_elemhide_exceptions_.contains(
+            generic_elemhide_selectors_[i])) {
+      filters[kept++] = filters[i];
+    }
+  }
+  filters.resize(kept);
+  if (filters.empty()) {
+    elemhide_index_.erase(generic_filters);
+  }
+}
+
 flatbuffers::Offset<
     flatbuffers::Vector<flatbuffers::Offset<flat::ElemHideFiltersByDomain>>>
 FlatbufferSerializer::WriteElemhideFilterIndex(const ElemhideIndex& index) {
@@ -298,9 +508,22 @@ FlatbufferSerializer::WriteElemhideFilterIndex(const ElemhideIndex& index) {
   offsets.reserve(index.size());
 
   for (const auto& cur : index) {
+    std::vector<flatbuffers::Offset<flat::ElemHideFilter>> filters;
+    filters.reserve(cur.second.size());
+    for (const auto& filter : cur.second) {
+      if (!filter.has_exclude_domains) {
+        filters.push_back(filter.offset);
+      }
+    }
+    const uint32_t excluding_begin = filters.size();
+    for (const auto& filter : cur.second) {
+      if (filter.has_exclude_domains) {
+        filters.push_back(filter.offset);
+      }
+    }
     offsets.push_back(flat::CreateElemHideFiltersByDomain(
         builder_, builder_.CreateSharedString(cur.first),
-        builder_.CreateVector(cur.second)));
+        builder_.CreateVector(filters), excluding_begin));
   }
   // Filters must be sorted (by domain), in order for LookupByKey() to work
   // correctly. This can be also achieved by making ElemhideIndex an ordered
@@ -325,17 +548,23 @@ FlatbufferSerializer::WriteSnippetFilterIndex(const SnippetIndex& index) {
 
 std::string FlatbufferSerializer::FindCandidateKeyword(
     UrlFilterIndex& index,
-    base::StringPiece value) {
-  FilterKeywordExtractor keyword_extractor(value);
+    const std::vector<std::string>& candidate_keywords) {
+  // Without a frequency table all keywords are considered equally frequent.
+  double last_frequency = std::numeric_limits<double>::max();
   size_t last_size = std::numeric_limits<size_t>::max();
   std::string keyword;
-  while (auto current_keyword = keyword_extractor.GetNextKeyword()) {
-    std::string candidate = *current_keyword;
+  for (const auto& candidate : candidate_keywords) {
+    const double frequency =
+        keyword_frequencies_ ? keyword_frequencies_->GetFrequency(candidate)
+                             : 0.0;
     auto it = index.find(candidate);
     auto size = it != index.end() ? it->second.size() : 0;
 
-    if (size < last_size ||
-        (size == last_size && candidate.size() > keyword.size())) {
+    if (frequency < last_frequency ||
+        (frequency == last_frequency &&
+         (size < last_size ||
+          (size == last_size && candidate.size() > keyword.size())))) {
+      last_frequency = frequency;
       last_size = size;
       keyword = candidate;
     }
@@ -343,6 +572,40 @@ std::string FlatbufferSerializer::FindCandidateKeyword(
   return keyword;
 }
 
+double FlatbufferSerializer::UrlFilterCost(
+    const UrlFilter& url_filter,
+    bool is_regex_pattern,
+    const std::vector<flat::PatternInstruction>& program) const {
+  const auto& options = url_filter.options;
+  double pass_rate = 1.0;
+  if (!options.Sitekeys().empty()) {
+    pass_rate *= kSitekeyPassRate;
+  }
+  if (!options.Domains().GetIncludeDomains().empty()) {
+    pass_rate *= kIncludeDomainsPassRate;
+  }
+  if (options.ThirdParty() != UrlFilterOptions::ThirdPartyOption::Ignore) {
+    pass_rate *= kThirdPartyPassRate;
+  }
+
+  double pattern_cost = kRegexCost;
+  if (!is_regex_pattern) {
+    pattern_cost = 0.0;
+    for (const auto& instruction : program) {
+      pattern_cost += instruction.opcode() == flat::PatternOpcode_Wildcard
+                          ? kWildcardCost
+                          : kPatternInstructionCost;
+    }
+  }
+  const double evaluation_cost = kOptionCheckCost + pass_rate * pattern_cost;
+  if (!filter_hits_) {
+    // Without profile data every filter is assumed equally likely to match,
+    // filters that are cheap to reject go first.
+    return evaluation_cost;
+  }
+  return evaluation_cost / filter_hits_->GetHitProbability(url_filter.pattern);
+}
+
 // static
 std::string FlatbufferSerializer::EscapeSelector(
     const base::StringPiece& value) {
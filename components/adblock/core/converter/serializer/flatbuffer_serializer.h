@@ -33,13 +33,27 @@
 #include "components/adblock/core/converter/parser/url_filter.h"
 #include "components/adblock/core/converter/parser/url_filter_options.h"
 #include "components/adblock/core/schema/filter_list_schema_generated.h"
+#include "third_party/abseil-cpp/absl/container/flat_hash_set.h"
 #include "url/gurl.h"
 
 namespace adblock {
 
+class FilterHitTable;
+class KeywordFrequencyTable;
+
 class FlatbufferSerializer final : public Serializer {
  public:
-  explicit FlatbufferSerializer(GURL subscription_url, bool allow_privileged);
+  // If |keyword_frequencies| is provided, it must outlive this object and URL
+  // filters are indexed under the keyword that requests are least likely to
+  // contain, according to the corpus the table was built from.
+  // If |filter_hits| is provided, it must outlive this object and the filters
+  // of a keyword bucket that are likely to match are tried earlier, see
+  // UrlFilterCost().
+  FlatbufferSerializer(
+      GURL subscription_url,
+      bool allow_privileged,
+      const KeywordFrequencyTable* keyword_frequencies = nullptr,
+      const FilterHitTable* filter_hits = nullptr);
   ~FlatbufferSerializer() override;
 
   std::unique_ptr<FlatbufferData> GetSerializedSubscription();
@@ -50,22 +64,41 @@ class FlatbufferSerializer final : public Serializer {
   void SerializeUrlFilter(const UrlFilter url_filter) override;
 
  private:
-  using UrlFilterIndex =
-      std::map<std::string, std::vector<flatbuffers::Offset<flat::UrlFilter>>>;
-  using ElemhideIndex = std::unordered_map<
-      std::string,
-      std::vector<flatbuffers::Offset<flat::ElemHideFilter>>>;
+  // A filter in a UrlFilterIndex. |required_literal| is text that every URL
+  // matched by the filter contains (after lowercasing), empty if unknown.
+  // |resource_type| is the filter's mask of flat::ResourceType bits.
+  // |cost| estimates the work spent on the filter per request it matches,
+  // filters of a bucket are tried from the cheapest. |generic| filters are
+  // ignored on pages with $genericblock.
+  struct IndexedUrlFilter {
+    flatbuffers::Offset<flat::UrlFilter> offset;
+    std::string required_literal;
+    uint32_t resource_type = 0u;
+    double cost = 0.0;
+    bool generic = true;
+  };
+  // Whether WriteUrlFilterIndex() may reorder filters by domain restriction,
+  // resource types and cost. Lookups that return the first match depend on
+  // the order when several filters match with different payloads.
+  enum class UrlFilterOrder { kConversion, kCost };
+  using UrlFilterIndex = std::map<std::string, std::vector<IndexedUrlFilter>>;
+  struct IndexedElemhideFilter {
+    flatbuffers::Offset<flat::ElemHideFilter> offset;
+    bool has_exclude_domains = false;
+  };
+  using ElemhideIndex =
+      std::unordered_map<std::string, std::vector<IndexedElemhideFilter>>;
   using SnippetIndex =
       std::map<std::string,
                std::vector<flatbuffers::Offset<flat::SnippetFilter>>>;
 
   void AddUrlFilterToIndex(UrlFilterIndex& index,
-                           absl::optional<base::StringPiece> pattern_text,
-                           flatbuffers::Offset<flat::UrlFilter> filter);
+                           const std::vector<std::string>& candidate_keywords,
+                           const IndexedUrlFilter& filter);
   void AddElemhideFilterForDomains(
       ElemhideIndex& index,
       const std::vector<std::string>& include_domains,
-      flatbuffers::Offset<flat::ElemHideFilter> filter) const;
+      const IndexedElemhideFilter& filter) const;
   void AddSnippetFilterForDomains(
       SnippetIndex& index,
       const std::vector<std::string>& domains,
@@ -75,13 +108,25 @@ class FlatbufferSerializer final : public Serializer {
       flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>>
   CreateVectorOfSharedStrings(const std::vector<std::string>& strings);
 
+  // Like CreateVectorOfSharedStrings() but sorts and deduplicates the strings
+  // so the resulting vector can be binary searched.
+  flatbuffers::Offset<
+      flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>>
+  CreateSortedVectorOfSharedStrings(std::vector<std::string> strings);
+
   flatbuffers::Offset<
       flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>>
   CreateVectorOfSharedStringsFromSitekeys(const std::vector<SiteKey>& sitekeys);
 
   flatbuffers::Offset<
       flatbuffers::Vector<flatbuffers::Offset<flat::UrlFiltersByKeyword>>>
-  WriteUrlFilterIndex(const UrlFilterIndex& index);
+  WriteUrlFilterIndex(const UrlFilterIndex& index,
+                      UrlFilterOrder order = UrlFilterOrder::kCost);
+
+  // Drops generic element hiding filters whose selector has an exception on
+  // every domain in this list. They could never hide anything, and frames
+  // would otherwise fetch and discard them over and over.
+  void RemoveGenericSelectorsWithGenericExceptions();
 
   flatbuffers::Offset<
       flatbuffers::Vector<flatbuffers::Offset<flat::ElemHideFiltersByDomain>>>
@@ -91,8 +136,19 @@ class FlatbufferSerializer final : public Serializer {
       flatbuffers::Vector<flatbuffers::Offset<flat::SnippetFiltersByDomain>>>
   WriteSnippetFilterIndex(const SnippetIndex& index);
 
-  std::string FindCandidateKeyword(UrlFilterIndex& index,
-                                   base::StringPiece value);
+  // Picks the candidate keyword that requests are least likely to contain,
+  // then the one with the smallest bucket, then the longest one. Returns ""
+  // if there are no candidates.
+  std::string FindCandidateKeyword(
+      UrlFilterIndex& index,
+      const std::vector<std::string>& candidate_keywords);
+
+  // Expected work spent on |url_filter| before it matches a request: the
+  // estimated cost of evaluating it divided by its hit probability.
+  double UrlFilterCost(
+      const UrlFilter& url_filter,
+      bool is_regex_pattern,
+      const std::vector<flat::PatternInstruction>& program) const;
 
   static std::string EscapeSelector(const base::StringPiece& value);
 
@@ -103,6 +159,8 @@ class FlatbufferSerializer final : public Serializer {
 
   GURL subscription_url_;
   bool allow_privileged_ = false;
+  const KeywordFrequencyTable* keyword_frequencies_ = nullptr;
+  const FilterHitTable* filter_hits_ = nullptr;
   flatbuffers::FlatBufferBuilder builder_;
   flatbuffers::Offset<flat::SubscriptionMetadata> metadata_;
   UrlFilterIndex url_subresource_block_;
@@ -122,6 +180,12 @@ class FlatbufferSerializer final : public Serializer {
   ElemhideIndex elemhide_exception_index_;
   ElemhideIndex elemhide_index_;
   ElemhideIndex elemhide_emulation_index_;
+  // Generic element hiding filters keyed by their exclude domains.
+  ElemhideIndex elemhide_generic_exclusions_;
+  // Selectors of the filters in |elemhide_index_[""]|, in the same order.
+  std::vector<std::string> generic_elemhide_selectors_;
+  // Selectors of exceptions without include or exclude domains.
+  absl::flat_hash_set<std::string> generic_elemhide_exceptions_;
   SnippetIndex snippet_index_;
 };
 
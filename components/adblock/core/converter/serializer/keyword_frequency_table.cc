@@ -0,0 +1,81 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/converter/serializer/keyword_frequency_table.h"
+
+#include <sstream>
+#include <vector>
+
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+
+namespace adblock {
+
+KeywordFrequencyTable::KeywordFrequencyTable() = default;
+KeywordFrequencyTable::KeywordFrequencyTable(KeywordFrequencyTable&&) =
+    default;
+KeywordFrequencyTable& KeywordFrequencyTable::operator=(
+    KeywordFrequencyTable&&) = default;
+KeywordFrequencyTable::~KeywordFrequencyTable() = default;
+
+// static
+absl::optional<KeywordFrequencyTable> KeywordFrequencyTable::Parse(
+    base::StringPiece data) {
+  const auto lines = base::SplitStringPiece(
+      data, "\n", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+  KeywordFrequencyTable table;
+  if (lines.empty() || !base::StringToSizeT(lines[0], &table.url_count_)) {
+    return absl::nullopt;
+  }
+  for (size_t i = 1; i < lines.size(); ++i) {
+    const auto fields = base::SplitStringPiece(
+        lines[i], " ", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+    size_t count = 0u;
+    if (fields.size() != 2u || !base::StringToSizeT(fields[1], &count) ||
+        count > table.url_count_) {
+      return absl::nullopt;
+    }
+    table.keyword_counts_[std::string(fields[0])] = count;
+  }
+  return table;
+}
+
+void KeywordFrequencyTable::AddUrl(const std::set<std::string>& keywords) {
+  ++url_count_;
+  for (const auto& keyword : keywords) {
+    ++keyword_counts_[keyword];
+  }
+}
+
+double KeywordFrequencyTable::GetFrequency(base::StringPiece keyword) const {
+  const auto it = keyword_counts_.find(keyword);
+  const size_t count = it != keyword_counts_.end() ? it->second : 0u;
+  // Laplace smoothing: a keyword that was not seen still gets a small,
+  // non-zero frequency, and all unseen keywords compare equal.
+  return (count + 1.0) / (url_count_ + 2.0);
+}
+
+std::string KeywordFrequencyTable::Serialize() const {
+  std::ostringstream output;
+  output << url_count_ << "\n";
+  for (const auto& [keyword, count] : keyword_counts_) {
+    output << keyword << " " << count << "\n";
+  }
+  return output.str();
+}
+
+}  // namespace adblock
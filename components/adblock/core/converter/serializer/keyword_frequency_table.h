@@ -0,0 +1,68 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CORE_CONVERTER_SERIALIZER_KEYWORD_FREQUENCY_TABLE_H_
+#define COMPONENTS_ADBLOCK_CORE_CONVERTER_SERIALIZER_KEYWORD_FREQUENCY_TABLE_H_
+
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+
+#include "absl/types/optional.h"
+#include "base/strings/string_piece.h"
+
+namespace adblock {
+
+// Counts how many URLs of a corpus, for example a crawl of popular sites,
+// contain each keyword. All filters of a keyword bucket are evaluated for
+// every request containing the keyword, so FlatbufferSerializer can use the
+// table to index filters under the keywords requests are least likely to
+// contain.
+//
+// The text format produced by Serialize() starts with a line holding the
+// number of URLs in the corpus, followed by one "keyword count" line per
+// keyword.
+class KeywordFrequencyTable {
+ public:
+  KeywordFrequencyTable();
+  KeywordFrequencyTable(KeywordFrequencyTable&&);
+  KeywordFrequencyTable& operator=(KeywordFrequencyTable&&);
+  ~KeywordFrequencyTable();
+
+  // Returns nullopt if |data| is not in the format produced by Serialize().
+  static absl::optional<KeywordFrequencyTable> Parse(base::StringPiece data);
+
+  // Records the distinct keywords of one URL of the corpus.
+  void AddUrl(const std::set<std::string>& keywords);
+
+  // Estimated probability that a request contains |keyword|. Keywords absent
+  // from the corpus are assumed rare rather than impossible.
+  double GetFrequency(base::StringPiece keyword) const;
+
+  size_t url_count() const { return url_count_; }
+
+  std::string Serialize() const;
+
+ private:
+  size_t url_count_ = 0u;
+  std::map<std::string, size_t, std::less<>> keyword_counts_;
+};
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CORE_CONVERTER_SERIALIZER_KEYWORD_FREQUENCY_TABLE_H_
@@ -0,0 +1,74 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/converter/serializer/filter_hit_table.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace adblock {
+
+TEST(AdblockFilterHitTableTest, HitProbabilityReflectsCorpus) {
+  FilterHitTable table;
+  table.AddEvaluations("/banner/", 10u, 8u);
+  table.AddEvaluations("/ads/", 10u, 1u);
+  table.AddEvaluations("/ads/", 10u, 1u);
+  table.AddEvaluations("/tracker/", 100u, 0u);
+  EXPECT_EQ(table.size(), 3u);
+  EXPECT_GT(table.GetHitProbability("/banner/"),
+            table.GetHitProbability("/ads/"));
+  EXPECT_GT(table.GetHitProbability("/ads/"),
+            table.GetHitProbability("/tracker/"));
+  // Never matched, but not impossible.
+  EXPECT_GT(table.GetHitProbability("/tracker/"), 0.0);
+}
+
+TEST(AdblockFilterHitTableTest, UnseenPatternsMatchLikeAverageFilter) {
+  FilterHitTable table;
+  table.AddEvaluations("/banner/", 10u, 9u);
+  table.AddEvaluations("/ads/", 30u, 1u);
+  const double unseen = table.GetHitProbability("/pixel/");
+  EXPECT_LT(unseen, table.GetHitProbability("/banner/"));
+  EXPECT_GT(unseen, table.GetHitProbability("/ads/"));
+  EXPECT_EQ(FilterHitTable().GetHitProbability("/pixel/"), 0.5);
+}
+
+TEST(AdblockFilterHitTableTest, SerializedTableParsed) {
+  FilterHitTable table;
+  table.AddEvaluations("/banner/", 10u, 8u);
+  table.AddEvaluations("/ad banner/", 3u, 0u);
+  const std::string serialized = table.Serialize();
+  EXPECT_EQ(serialized, "3 0 /ad banner/\n10 8 /banner/\n");
+
+  const auto parsed = FilterHitTable::Parse(serialized);
+  ASSERT_TRUE(parsed);
+  EXPECT_EQ(parsed->size(), 2u);
+  EXPECT_EQ(parsed->GetHitProbability("/banner/"),
+            table.GetHitProbability("/banner/"));
+  EXPECT_EQ(parsed->GetHitProbability("/ad banner/"),
+            table.GetHitProbability("/ad banner/"));
+  EXPECT_EQ(parsed->Serialize(), serialized);
+}
+
+TEST(AdblockFilterHitTableTest, MalformedTableRejected) {
+  EXPECT_TRUE(FilterHitTable::Parse(""));
+  EXPECT_FALSE(FilterHitTable::Parse("10 /banner/\n"));
+  EXPECT_FALSE(FilterHitTable::Parse("ten 1 /banner/\n"));
+  // A filter cannot match more often than it was evaluated.
+  EXPECT_FALSE(FilterHitTable::Parse("1 2 /banner/\n"));
+}
+
+}  // namespace adblock
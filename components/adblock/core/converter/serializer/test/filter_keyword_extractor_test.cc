@@ -65,4 +65,38 @@ TEST(AdblockKeywordExtractor, DoesNotExtractWildcardKeyword) {
               testing::ElementsAre("path1", "path2", "file"));
 }
 
+TEST(AdblockRegexKeywordExtractor, ExtractsKeywordsBetweenLiterals) {
+  EXPECT_THAT(ExtractRegexKeywords(R"(^https?:\/\/ads\.example\.com\/)"),
+              testing::ElementsAre("ads", "example"));
+  EXPECT_THAT(ExtractRegexKeywords(R"(\/ADS\/\d+\/img\/)"),
+              testing::ElementsAre("ads", "img"));
+}
+
+TEST(AdblockRegexKeywordExtractor, SkipsKeywordsTouchingNonLiterals) {
+  // "banner" may be followed by digits, so it need not be a whole keyword of
+  // a matching URL.
+  EXPECT_THAT(ExtractRegexKeywords(R"(\/ads\/banner[0-9]+\.)"),
+              testing::ElementsAre("ads"));
+  EXPECT_THAT(ExtractRegexKeywords(R"(\/(ads|track)\/pixel\.gif)"),
+              testing::ElementsAre("pixel"));
+  EXPECT_THAT(ExtractRegexKeywords(R"([\/]ads[\/])"), testing::IsEmpty());
+  EXPECT_THAT(ExtractRegexKeywords(R"(\/ads?\/)"), testing::IsEmpty());
+  EXPECT_THAT(ExtractRegexKeywords(R"(\/ads{2}\/)"), testing::IsEmpty());
+}
+
+TEST(AdblockRegexKeywordExtractor, DoesNotExtractCommonKeywords) {
+  EXPECT_THAT(ExtractRegexKeywords(R"(\/\/https\.com\/js\/a\/)"),
+              testing::IsEmpty());
+}
+
+TEST(AdblockRegexKeywordExtractor, GivesUpOnUnsupportedExpressions) {
+  // Top-level alternation.
+  EXPECT_THAT(ExtractRegexKeywords(R"(\/ads\/|\/track\/)"),
+              testing::IsEmpty());
+  // Escapes with arguments.
+  EXPECT_THAT(ExtractRegexKeywords(R"(\x41\/ads\/)"), testing::IsEmpty());
+  // Free-spacing mode.
+  EXPECT_THAT(ExtractRegexKeywords(R"((?x)\/ad s\/)"), testing::IsEmpty());
+}
+
 }  // namespace adblock
@@ -0,0 +1,67 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/converter/serializer/keyword_frequency_table.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace adblock {
+
+TEST(AdblockKeywordFrequencyTableTest, FrequencyReflectsCorpus) {
+  KeywordFrequencyTable table;
+  table.AddUrl({"www", "example", "ads"});
+  table.AddUrl({"www", "example"});
+  table.AddUrl({"www", "tracker"});
+  EXPECT_EQ(table.url_count(), 3u);
+  EXPECT_GT(table.GetFrequency("www"), table.GetFrequency("example"));
+  EXPECT_GT(table.GetFrequency("example"), table.GetFrequency("ads"));
+  EXPECT_EQ(table.GetFrequency("ads"), table.GetFrequency("tracker"));
+}
+
+TEST(AdblockKeywordFrequencyTableTest, UnseenKeywordsAreRareButPossible) {
+  KeywordFrequencyTable table;
+  table.AddUrl({"ads"});
+  EXPECT_GT(table.GetFrequency("banner"), 0.0);
+  EXPECT_LT(table.GetFrequency("banner"), table.GetFrequency("ads"));
+  EXPECT_GT(KeywordFrequencyTable().GetFrequency("banner"), 0.0);
+}
+
+TEST(AdblockKeywordFrequencyTableTest, SerializedTableParsed) {
+  KeywordFrequencyTable table;
+  table.AddUrl({"www", "example"});
+  table.AddUrl({"www"});
+  const std::string serialized = table.Serialize();
+  EXPECT_EQ(serialized, "2\nexample 1\nwww 2\n");
+
+  const auto parsed = KeywordFrequencyTable::Parse(serialized);
+  ASSERT_TRUE(parsed);
+  EXPECT_EQ(parsed->url_count(), 2u);
+  EXPECT_EQ(parsed->GetFrequency("www"), table.GetFrequency("www"));
+  EXPECT_EQ(parsed->GetFrequency("example"), table.GetFrequency("example"));
+  EXPECT_EQ(parsed->Serialize(), serialized);
+}
+
+TEST(AdblockKeywordFrequencyTableTest, MalformedTableRejected) {
+  EXPECT_FALSE(KeywordFrequencyTable::Parse(""));
+  EXPECT_FALSE(KeywordFrequencyTable::Parse("urls\nwww 1\n"));
+  EXPECT_FALSE(KeywordFrequencyTable::Parse("2\nwww\n"));
+  EXPECT_FALSE(KeywordFrequencyTable::Parse("2\nwww two\n"));
+  // A keyword cannot occur in more URLs than the corpus has.
+  EXPECT_FALSE(KeywordFrequencyTable::Parse("2\nwww 3\n"));
+}
+
+}  // namespace adblock
@@ -15,50 +15,275 @@
  * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <map>
+#include <set>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
 #include "base/logging.h"
+#include "base/memory/scoped_refptr.h"
 #include "base/path_service.h"
+#include "base/strings/string_piece.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
 #include "base/time/time.h"
 #include "base/timer/elapsed_timer.h"
 #include "components/adblock/core/common/adblock_constants.h"
+#include "components/adblock/core/common/content_type.h"
+#include "components/adblock/core/common/keyword_extractor_utils.h"
+#include "components/adblock/core/common/regex_filter_pattern.h"
 #include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/converter/serializer/filter_hit_table.h"
+#include "components/adblock/core/converter/serializer/keyword_frequency_table.h"
+#include "components/adblock/core/schema/filter_list_schema_generated.h"
+#include "components/adblock/core/subscription/filter_match_profiler.h"
+#include "components/adblock/core/subscription/installed_subscription_impl.h"
+#include "components/adblock/core/subscription/url_keyword_extractor.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "third_party/zlib/google/compression_utils.h"
+#include "url/gurl.h"
 
 namespace adblock {
 
 class ConverterPerfTest : public testing::Test {
  public:
-  void MeasureConversionTime(std::string filename) {
+  std::string ReadTestFile(std::string filename) {
     base::FilePath source_file;
-    ASSERT_TRUE(base::PathService::Get(base::DIR_SOURCE_ROOT, &source_file));
+    EXPECT_TRUE(base::PathService::Get(base::DIR_SOURCE_ROOT, &source_file));
     source_file = source_file.AppendASCII("components")
                       .AppendASCII("test")
                       .AppendASCII("data")
                       .AppendASCII("adblock")
                       .AppendASCII(filename);
     std::string content;
-    ASSERT_TRUE(base::ReadFileToString(source_file, &content));
-    ASSERT_TRUE(compression::GzipUncompress(content, &content));
-    std::stringstream input(std::move(content));
+    EXPECT_TRUE(base::ReadFileToString(source_file, &content));
+    EXPECT_TRUE(compression::GzipUncompress(content, &content));
+    return content;
+  }
+
+  std::unique_ptr<FlatbufferData> Convert(
+      std::string filename,
+      const KeywordFrequencyTable* keyword_frequencies = nullptr,
+      const FilterHitTable* filter_hits = nullptr) {
+    std::stringstream input(ReadTestFile(filename));
     base::ElapsedTimer timer;
-    auto buffer = FlatbufferConverter::Convert(input, CustomFiltersUrl(), true);
-    ASSERT_TRUE(
-        absl::holds_alternative<std::unique_ptr<FlatbufferData>>(buffer));
+    auto buffer =
+        FlatbufferConverter::Convert(input, CustomFiltersUrl(), true,
+                                     keyword_frequencies, filter_hits);
+    if (!absl::holds_alternative<std::unique_ptr<FlatbufferData>>(buffer)) {
+      ADD_FAILURE() << "Failed to convert " << filename;
+      return nullptr;
+    }
     LOG(INFO) << "[eyeo] Time to convert " << filename << ": "
               << timer.Elapsed();
+    return std::move(absl::get<std::unique_ptr<FlatbufferData>>(buffer));
+  }
+
+  static scoped_refptr<InstalledSubscription> Install(
+      std::unique_ptr<FlatbufferData> buffer) {
+    return base::MakeRefCounted<InstalledSubscriptionImpl>(
+        std::move(buffer), Subscription::InstallationState::Installed,
+        base::Time());
+  }
+
+  // Classifies |urls| as images against |subscription| with
+  // FilterMatchProfiler enabled, and returns what it recorded.
+  static std::map<std::string, FilterMatchProfiler::FilterStats, std::less<>>
+  ProfileFilters(const InstalledSubscription& subscription,
+                 const std::vector<GURL>& urls) {
+    auto* profiler = FilterMatchProfiler::GetInstance();
+    profiler->Reset();
+    profiler->SetEnabled(true);
+    for (const auto& url : urls) {
+      subscription.HasUrlFilter(url, url.host(), ContentType::Image,
+                                SiteKey(), FilterCategory::Blocking);
+    }
+    profiler->SetEnabled(false);
+    auto stats = profiler->GetFilterStats(subscription.GetSourceUrl().spec());
+    profiler->Reset();
+    return stats;
+  }
+
+  // Average number of filters evaluated for each of the |urls| that a filter
+  // of |subscription| blocks, up to and including the first matching one.
+  // Requests that are not blocked evaluate every candidate in any order.
+  static double AverageEvaluationsBeforeHit(
+      const InstalledSubscription& subscription,
+      const std::vector<GURL>& urls) {
+    std::vector<GURL> blocked_urls;
+    for (const auto& url : urls) {
+      if (subscription.HasUrlFilter(url, url.host(), ContentType::Image,
+                                    SiteKey(), FilterCategory::Blocking)) {
+        blocked_urls.push_back(url);
+      }
+    }
+    if (blocked_urls.empty()) {
+      return 0.0;
+    }
+    uint64_t evaluations = 0u;
+    for (const auto& [pattern, stats] :
+         ProfileFilters(subscription, blocked_urls)) {
+      evaluations += stats.evaluations;
+    }
+    return static_cast<double>(evaluations) / blocked_urls.size();
+  }
+
+  // Keywords looked up in the index when classifying a request for |url|.
+  static std::set<std::string> UrlKeywords(base::StringPiece url) {
+    const std::string lowercase_spec = base::ToLowerASCII(GURL(url).spec());
+    std::set<std::string> keywords;
+    UrlKeywordExtractor extractor(lowercase_spec);
+    while (const auto keyword = extractor.GetNextKeyword()) {
+      if (!utils::IsBadKeyword(*keyword)) {
+        keywords.emplace(*keyword);
+      }
+    }
+    return keywords;
+  }
+
+  // Average number of subresource filters found in the keyword buckets of
+  // |urls|, i.e. evaluated in addition to the filters without a keyword.
+  static double AverageKeywordCandidates(
+      const FlatbufferData& buffer,
+      const std::vector<std::set<std::string>>& urls) {
+    const auto* index = flat::GetSubscription(buffer.data());
+    size_t candidates = 0u;
+    for (const auto& keywords : urls) {
+      for (const auto& keyword : keywords) {
+        for (const auto* filters_by_keyword :
+             {index->url_subresource_block(), index->url_subresource_allow()}) {
+          const auto* bucket = filters_by_keyword->LookupByKey(keyword.c_str());
+          if (bucket) {
+            candidates += bucket->filter()->size();
+          }
+        }
+      }
+    }
+    return static_cast<double>(candidates) / urls.size();
+  }
+
+  // Logs how many regex filters were indexed under a keyword extracted from
+  // the expression and how many remain in the "" bucket, which is searched
+  // for every request.
+  void ReportRegexFilterKeywords(std::string filename) {
+    const auto buffer = Convert(filename);
+    ASSERT_TRUE(buffer);
+    const auto* index = flat::GetSubscription(buffer->data());
+    size_t keyworded = 0u;
+    size_t keywordless = 0u;
+    for (const auto* filters_by_keyword :
+         {index->url_subresource_block(), index->url_subresource_allow(),
+          index->url_popup_block(), index->url_popup_allow(),
+          index->url_document_allow(), index->url_elemhide_allow(),
+          index->url_generichide_allow(), index->url_genericblock_allow(),
+          index->url_csp_block(), index->url_csp_allow(),
+          index->url_rewrite_block(), index->url_rewrite_allow(),
+          index->url_header_block(), index->url_header_allow()}) {
+      if (!filters_by_keyword) {
+        continue;
+      }
+      for (const auto* bucket : *filters_by_keyword) {
+        for (const auto* filter : *bucket->filter()) {
+          const base::StringPiece pattern(filter->pattern()->c_str(),
+                                          filter->pattern()->size());
+          if (!ExtractRegexFilterFromPattern(pattern)) {
+            continue;
+          }
+          if (bucket->keyword()->size() == 0u) {
+            ++keywordless;
+          } else {
+            ++keyworded;
+          }
+        }
+      }
+    }
+    LOG(INFO) << "[eyeo] Regex filters in " << filename << " indexed under a "
+              << "keyword: " << keyworded << ", under \"\": " << keywordless;
   }
 };
 
 TEST_F(ConverterPerfTest, ConvertEasylistTime) {
-  MeasureConversionTime("easylist.txt.gz");
+  EXPECT_TRUE(Convert("easylist.txt.gz"));
 }
 
 TEST_F(ConverterPerfTest, ConvertExceptionrulesTime) {
-  MeasureConversionTime("exceptionrules.txt.gz");
+  EXPECT_TRUE(Convert("exceptionrules.txt.gz"));
+}
+
+// Builds a keyword frequency table from half of the URL corpus and compares
+// the number of candidate filters per request for the other half, with and
+// without the table guiding keyword selection.
+TEST_F(ConverterPerfTest, CorpusDrivenKeywordSelection) {
+  const auto lines =
+      base::SplitString(ReadTestFile("5000_urls.txt.gz"), "\n",
+                        base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+  KeywordFrequencyTable keyword_frequencies;
+  std::vector<std::set<std::string>> evaluation_urls;
+  for (size_t i = 0; i < lines.size(); ++i) {
+    if (i % 2 == 0) {
+      keyword_frequencies.AddUrl(UrlKeywords(lines[i]));
+    } else {
+      evaluation_urls.push_back(UrlKeywords(lines[i]));
+    }
+  }
+  ASSERT_FALSE(evaluation_urls.empty());
+
+  const auto default_buffer = Convert("easylist.txt.gz");
+  const auto corpus_buffer = Convert("easylist.txt.gz", &keyword_frequencies);
+  ASSERT_TRUE(default_buffer);
+  ASSERT_TRUE(corpus_buffer);
+  const double default_candidates =
+      AverageKeywordCandidates(*default_buffer, evaluation_urls);
+  const double corpus_candidates =
+      AverageKeywordCandidates(*corpus_buffer, evaluation_urls);
+  LOG(INFO) << "[eyeo] Keyword candidates per request, default: "
+            << default_candidates << ", corpus-driven: " << corpus_candidates;
+  LOG(INFO) << "[eyeo] Flatbuffer size, default: " << default_buffer->size()
+            << ", corpus-driven: " << corpus_buffer->size();
+}
+
+// Compares the number of filters evaluated before the first hit, for URL
+// corpus requests blocked by easylist, between buckets ordered by estimated
+// cost and buckets ordered with a filter hit table built from the other half
+// of the corpus.
+TEST_F(ConverterPerfTest, FilterOrderWithinBuckets) {
+  std::vector<GURL> training_urls;
+  std::vector<GURL> evaluation_urls;
+  const auto lines =
+      base::SplitString(ReadTestFile("5000_urls.txt.gz"), "\n",
+                        base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+  for (size_t i = 0; i < lines.size(); ++i) {
+    GURL url(lines[i]);
+    if (url.is_valid()) {
+      (i % 2 == 0 ? training_urls : evaluation_urls).push_back(std::move(url));
+    }
+  }
+  ASSERT_FALSE(evaluation_urls.empty());
+
+  const auto cost_ordered = Install(Convert("easylist.txt.gz"));
+  FilterHitTable filter_hits;
+  for (const auto& [pattern, stats] :
+       ProfileFilters(*cost_ordered, training_urls)) {
+    filter_hits.AddEvaluations(pattern, stats.evaluations, stats.matches);
+  }
+  const auto profile_ordered =
+      Install(Convert("easylist.txt.gz", nullptr, &filter_hits));
+
+  LOG(INFO) << "[eyeo] Filters evaluated per blocked request, cost-ordered: "
+            << AverageEvaluationsBeforeHit(*cost_ordered, evaluation_urls)
+            << ", profile-ordered: "
+            << AverageEvaluationsBeforeHit(*profile_ordered, evaluation_urls);
+}
+
+TEST_F(ConverterPerfTest, EasylistRegexFilterKeywords) {
+  ReportRegexFilterKeywords("easylist.txt.gz");
+}
+
+TEST_F(ConverterPerfTest, ExceptionrulesRegexFilterKeywords) {
+  ReportRegexFilterKeywords("exceptionrules.txt.gz");
 }
 
 }  // namespace adblock
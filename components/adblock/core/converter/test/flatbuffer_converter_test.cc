@@ -23,6 +23,8 @@
 
 #include "base/memory/scoped_refptr.h"
 #include "base/rand_util.h"
+#include "components/adblock/core/converter/serializer/filter_hit_table.h"
+#include "components/adblock/core/converter/serializer/keyword_frequency_table.h"
 #include "components/adblock/core/subscription/installed_subscription_impl.h"
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -454,6 +456,87 @@ TEST_F(AdblockFlatbufferConverterTest, Elementhide_with_generic_excluded_url) {
   EXPECT_EQ(FilterSelectors(selectors), std::set<base::StringPiece>{"#_AD"});
 }
 
+TEST_F(AdblockFlatbufferConverterTest,
+       Elementhide_generic_selector_with_generic_exception_dropped) {
+  auto subscriptions = ConvertAndLoadRules(R"(
+    ##.ad
+    ~example.org##.ad
+    ##.banner
+    example.org##.ad
+    #@#.ad
+    )");
+  const auto selectors =
+      subscriptions->GetElemhideSelectors(GURL("http://example.org"), false);
+  // Only the domain-specific .ad is still stored, the generic ones could never
+  // hide anything.
+  EXPECT_THAT(selectors.elemhide_selectors,
+              testing::UnorderedElementsAre(".banner", ".ad"));
+  EXPECT_EQ(FilterSelectors(selectors),
+            std::set<base::StringPiece>{".banner"});
+  // With $generichide, neither generic selectors nor generic exceptions apply.
+  const auto domain_specific_selectors =
+      subscriptions->GetElemhideSelectors(GURL("http://example.org"), true);
+  EXPECT_EQ(FilterSelectors(domain_specific_selectors),
+            std::set<base::StringPiece>{".ad"});
+}
+
+TEST_F(AdblockFlatbufferConverterTest,
+       Elementhide_generic_filters_indexed_by_excluded_domain) {
+  auto index = ConvertAndLoadRulesToIndex(R"(
+    ~example.org##.excluded
+    ##.ad
+    ~other.org,~example.com##.both
+    ##.banner
+    )");
+  const auto* generic = index.index_->elemhide()->LookupByKey("");
+  ASSERT_TRUE(generic);
+  ASSERT_EQ(generic->filter()->size(), 4u);
+  // Filters without exclude domains come first.
+  EXPECT_EQ(generic->excluding_begin(), 2u);
+  for (uint32_t i = 0; i < generic->filter()->size(); ++i) {
+    EXPECT_EQ(generic->filter()->Get(i)->exclude_domains()->size() > 0u,
+              i >= generic->excluding_begin())
+        << i;
+  }
+  const auto* exclusions = index.index_->elemhide_generic_exclusions();
+  ASSERT_TRUE(exclusions);
+  ASSERT_EQ(exclusions->size(), 3u);
+  const auto* example_org = exclusions->LookupByKey("example.org");
+  ASSERT_TRUE(example_org);
+  ASSERT_EQ(example_org->filter()->size(), 1u);
+  EXPECT_EQ(example_org->filter()->Get(0)->selector()->str(), ".excluded");
+  const auto* other_org = exclusions->LookupByKey("other.org");
+  ASSERT_TRUE(other_org);
+  ASSERT_EQ(other_org->filter()->size(), 1u);
+  EXPECT_EQ(other_org->filter()->Get(0)->selector()->str(), ".both");
+}
+
+TEST_F(AdblockFlatbufferConverterTest, Elementhide_generic_excluded_subdomain) {
+  auto subscriptions = ConvertAndLoadRules(R"(
+    ~example.org##.excluded
+    ##.ad
+    ~other.org,~example.com##.both
+    )");
+  EXPECT_EQ(FilterSelectors(subscriptions->GetElemhideSelectors(
+                GURL("https://www.example.org/"), false)),
+            std::set<base::StringPiece>({".ad", ".both"}));
+  EXPECT_EQ(FilterSelectors(subscriptions->GetElemhideSelectors(
+                GURL("https://sub.other.org/"), false)),
+            std::set<base::StringPiece>({".ad", ".excluded"}));
+  EXPECT_EQ(FilterSelectors(subscriptions->GetElemhideSelectors(
+                GURL("https://notexample.org/"), false)),
+            std::set<base::StringPiece>({".ad", ".excluded", ".both"}));
+  // Only the generic filters that depend on the domain.
+  EXPECT_THAT(subscriptions
+                  ->GetDomainDependentElemhideSelectors(
+                      GURL("https://www.example.org/"))
+                  .elemhide_selectors,
+              testing::UnorderedElementsAre(".both"));
+  EXPECT_THAT(
+      subscriptions->GetDomainAgnosticElemhideSelectors().elemhide_selectors,
+      testing::UnorderedElementsAre(".ad"));
+}
+
 TEST_F(AdblockFlatbufferConverterTest, Elementhide_top_tier_domain_match) {
   auto subscriptions = ConvertAndLoadRules(R"(
     com###_AD
@@ -1697,6 +1780,293 @@ TEST_F(AdblockFlatbufferConverterTest,
       FilterCategory::Allowing));
 }
 
+TEST_F(AdblockFlatbufferConverterTest, UrlFilterDomainsStoredSorted) {
+  auto index = ConvertAndLoadRulesToIndex(R"(
+    /banner/$domain=zzz.com|~b.aaa.com|aaa.com|mmm.com|zzz.com|~a.aaa.com
+    )");
+  ASSERT_EQ(index.index_->url_subresource_block()->size(), 1u);
+  const auto* filter =
+      index.index_->url_subresource_block()->Get(0)->filter()->Get(0);
+  ASSERT_EQ(filter->include_domains()->size(), 3u);
+  EXPECT_EQ(filter->include_domains()->Get(0)->str(), "aaa.com");
+  EXPECT_EQ(filter->include_domains()->Get(1)->str(), "mmm.com");
+  EXPECT_EQ(filter->include_domains()->Get(2)->str(), "zzz.com");
+  ASSERT_EQ(filter->exclude_domains()->size(), 2u);
+  EXPECT_EQ(filter->exclude_domains()->Get(0)->str(), "a.aaa.com");
+  EXPECT_EQ(filter->exclude_domains()->Get(1)->str(), "b.aaa.com");
+}
+
+TEST_F(AdblockFlatbufferConverterTest, UrlFilterMatchesAnyListedDomain) {
+  auto subscription = ConvertAndLoadRules(R"(
+    /banner/$domain=zzz.com|~b.aaa.com|aaa.com|mmm.com|~a.aaa.com
+    )");
+  const GURL url("https://ads.com/banner/ad.png");
+  for (const auto* domain :
+       {"zzz.com", "aaa.com", "mmm.com", "sub.mmm.com", "c.aaa.com"}) {
+    EXPECT_TRUE(subscription->HasUrlFilter(url, domain, ContentType::Image,
+                                           SiteKey(),
+                                           FilterCategory::Blocking))
+        << domain;
+  }
+  for (const auto* domain :
+       {"b.aaa.com", "sub.a.aaa.com", "bbb.com", "zzz.com.org", "xaaa.com"}) {
+    EXPECT_FALSE(subscription->HasUrlFilter(url, domain, ContentType::Image,
+                                            SiteKey(),
+                                            FilterCategory::Blocking))
+        << domain;
+  }
+}
+
+TEST_F(AdblockFlatbufferConverterTest,
+       KeywordlessFiltersHaveLiteralAutomaton) {
+  auto index = ConvertAndLoadRulesToIndex(R"(
+    banner
+    Tracker$match-case
+    /ad[0-9]+\.js/
+    ||ads.com^
+    )");
+  const auto* bucket = index.index_->url_subresource_block()->LookupByKey("");
+  ASSERT_TRUE(bucket);
+  ASSERT_EQ(bucket->filter()->size(), 3u);
+  ASSERT_TRUE(bucket->literal_automaton());
+  // The match-case and the regex filter have no required literal.
+  EXPECT_EQ(bucket->literal_automaton()->unconditional()->size(), 2u);
+  // Keyword buckets are searched by keyword only.
+  EXPECT_FALSE(index.index_->url_subresource_block()
+                   ->LookupByKey("ads")
+                   ->literal_automaton());
+}
+
+TEST_F(AdblockFlatbufferConverterTest, KeywordlessFiltersMatched) {
+  auto subscription = ConvertAndLoadRules(R"(
+    banner
+    Tracker$match-case
+    /ad[0-9]+\.js/
+    )");
+  const auto matches = [&](const char* url) {
+    return subscription->HasUrlFilter(GURL(url), "domain.com",
+                                      ContentType::Image, SiteKey(),
+                                      FilterCategory::Blocking);
+  };
+  EXPECT_TRUE(matches("https://example.com/BANNER.png"));
+  EXPECT_TRUE(matches("https://example.com/Tracker.png"));
+  EXPECT_TRUE(matches("https://example.com/ad12.js"));
+  EXPECT_FALSE(matches("https://example.com/tracker.png"));
+  EXPECT_FALSE(matches("https://example.com/image.png"));
+}
+
+TEST_F(AdblockFlatbufferConverterTest,
+       RegexFiltersIndexedUnderLiteralKeyword) {
+  auto index = ConvertAndLoadRulesToIndex(R"(
+    /\/ads\/banner[0-9]+\./
+    /\/(ads|track)\/pixel\.gif/
+    /\/ad[0-9]+\/tracker/
+    /a\/ads\/|\/banners\//
+    )");
+  const auto* filters = index.index_->url_subresource_block();
+  ASSERT_TRUE(filters->LookupByKey("ads"));
+  EXPECT_EQ(filters->LookupByKey("ads")->filter()->size(), 1u);
+  ASSERT_TRUE(filters->LookupByKey("pixel"));
+  EXPECT_EQ(filters->LookupByKey("pixel")->filter()->size(), 1u);
+  // No keyword is guaranteed by the remaining filters.
+  ASSERT_TRUE(filters->LookupByKey(""));
+  EXPECT_EQ(filters->LookupByKey("")->filter()->size(), 2u);
+}
+
+TEST_F(AdblockFlatbufferConverterTest, RegexFiltersWithKeywordMatched) {
+  auto subscription = ConvertAndLoadRules(R"(
+    /\/ads\/banner[0-9]+\./
+    /\/(ads|track)\/Pixel\.gif/$match-case
+    )");
+  const auto matches = [&](const char* url) {
+    return subscription->HasUrlFilter(GURL(url), "domain.com",
+                                      ContentType::Image, SiteKey(),
+                                      FilterCategory::Blocking);
+  };
+  EXPECT_TRUE(matches("https://example.com/ads/banner12.png"));
+  EXPECT_TRUE(matches("https://example.com/ADS/Banner1.png"));
+  EXPECT_TRUE(matches("https://example.com/track/Pixel.gif"));
+  EXPECT_FALSE(matches("https://example.com/track/pixel.gif"));
+  EXPECT_FALSE(matches("https://example.com/ads/banner.png"));
+}
+
+TEST_F(AdblockFlatbufferConverterTest, KeywordChosenByCorpusFrequency) {
+  const std::string rules =
+      "[Adblock Plus 2.0]\n! Title: TestingList\n"
+      "||www.example.com/banner/\n";
+  const auto convert = [&](const KeywordFrequencyTable* keyword_frequencies) {
+    std::stringstream input(rules);
+    auto result = FlatbufferConverter::Convert(input, GURL(), false,
+                                               keyword_frequencies);
+    EXPECT_TRUE(
+        absl::holds_alternative<std::unique_ptr<FlatbufferData>>(result));
+    return FlatIndex(
+        std::move(absl::get<std::unique_ptr<FlatbufferData>>(result)));
+  };
+
+  // Without a frequency table, the longest keyword is chosen.
+  const auto default_index = convert(nullptr);
+  EXPECT_TRUE(
+      default_index.index_->url_subresource_block()->LookupByKey("example"));
+
+  // "example" occurs in most requests of the corpus, "banner" in none.
+  KeywordFrequencyTable keyword_frequencies;
+  keyword_frequencies.AddUrl({"www", "example"});
+  keyword_frequencies.AddUrl({"www", "example", "logo"});
+  const auto corpus_index = convert(&keyword_frequencies);
+  EXPECT_FALSE(
+      corpus_index.index_->url_subresource_block()->LookupByKey("example"));
+  EXPECT_TRUE(
+      corpus_index.index_->url_subresource_block()->LookupByKey("banner"));
+}
+
+TEST_F(AdblockFlatbufferConverterTest, BucketsPartitionedByContentType) {
+  auto index = ConvertAndLoadRulesToIndex(R"(
+    /banner/$script
+    /banner/$image
+    /banner/*.gif$image
+    /banner/$script,xmlhttprequest
+    )");
+  const auto* bucket =
+      index.index_->url_subresource_block()->LookupByKey("banner");
+  ASSERT_TRUE(bucket);
+  EXPECT_EQ(bucket->resource_type(), static_cast<uint32_t>(
+                                         ContentType::Script |
+                                         ContentType::Image |
+                                         ContentType::Xmlhttprequest));
+  // Filters for the same resource types are contiguous, in conversion order.
+  ASSERT_EQ(bucket->filter()->size(), 4u);
+  EXPECT_EQ(bucket->filter()->Get(0)->resource_type(), ContentType::Script);
+  EXPECT_EQ(bucket->filter()->Get(1)->resource_type(), ContentType::Image);
+  EXPECT_EQ(bucket->filter()->Get(2)->resource_type(), ContentType::Image);
+  ASSERT_TRUE(bucket->content_type_slices());
+  ASSERT_EQ(bucket->content_type_slices()->size(), 3u);
+  uint32_t expected_begin = 0u;
+  for (const auto* slice : *bucket->content_type_slices()) {
+    EXPECT_EQ(slice->begin(), expected_begin);
+    EXPECT_GT(slice->end(), slice->begin());
+    for (uint32_t i = slice->begin(); i < slice->end(); ++i) {
+      EXPECT_EQ(bucket->filter()->Get(i)->resource_type(),
+                slice->resource_type());
+    }
+    expected_begin = slice->end();
+  }
+  EXPECT_EQ(expected_begin, 4u);
+}
+
+TEST_F(AdblockFlatbufferConverterTest, BucketsOrderedByCost) {
+  const std::string rules =
+      "[Adblock Plus 2.0]\n! Title: TestingList\n"
+      "/banner/*/ad*\n"
+      "/banner/\n"
+      "/banner/$domain=example.com\n"
+      "/banner/$sitekey=abc\n";
+  const auto convert = [&](const FilterHitTable* filter_hits) {
+    std::stringstream input(rules);
+    auto result = FlatbufferConverter::Convert(input, GURL(), false, nullptr,
+                                               filter_hits);
+    EXPECT_TRUE(
+        absl::holds_alternative<std::unique_ptr<FlatbufferData>>(result));
+    return FlatIndex(
+        std::move(absl::get<std::unique_ptr<FlatbufferData>>(result)));
+  };
+
+  // Without profile data, filters that are cheap to reject come first.
+  const auto default_index = convert(nullptr);
+  const auto* bucket =
+      default_index.index_->url_subresource_block()->LookupByKey("banner");
+  ASSERT_TRUE(bucket);
+  ASSERT_EQ(bucket->filter()->size(), 4u);
+  EXPECT_EQ(bucket->filter()->Get(0)->sitekeys()->size(), 1u);
+  EXPECT_EQ(bucket->filter()->Get(1)->include_domains()->size(), 1u);
+  EXPECT_EQ(bucket->filter()->Get(2)->pattern()->str(), "/banner/");
+  EXPECT_EQ(bucket->filter()->Get(2)->include_domains()->size(), 0u);
+  EXPECT_EQ(bucket->filter()->Get(3)->pattern()->str(), "/banner/*/ad*");
+
+  // Among generic filters, one that matched every time in the corpus goes
+  // first despite its cost.
+  FilterHitTable filter_hits;
+  filter_hits.AddEvaluations("/banner/", 100u, 0u);
+  filter_hits.AddEvaluations("/banner/*/ad*", 100u, 100u);
+  const auto profiled_index = convert(&filter_hits);
+  bucket =
+      profiled_index.index_->url_subresource_block()->LookupByKey("banner");
+  ASSERT_TRUE(bucket);
+  ASSERT_EQ(bucket->filter()->size(), 4u);
+  EXPECT_EQ(bucket->filter()->Get(2)->pattern()->str(), "/banner/*/ad*");
+  EXPECT_EQ(bucket->filter()->Get(3)->pattern()->str(), "/banner/");
+}
+
+TEST_F(AdblockFlatbufferConverterTest, DomainSpecificFiltersPrecedeGeneric) {
+  auto index = ConvertAndLoadRulesToIndex(R"(
+    /banner/$image
+    /banner/$image,domain=example.com
+    /banner/$script
+    /banner/$script,domain=~example.com
+    /banner/$image,domain=~example.com|other.com
+    )");
+  const auto* bucket =
+      index.index_->url_subresource_block()->LookupByKey("banner");
+  ASSERT_TRUE(bucket);
+  ASSERT_EQ(bucket->filter()->size(), 5u);
+  EXPECT_EQ(bucket->generic_begin(), 3u);
+  EXPECT_EQ(bucket->domain_specific_resource_type(),
+            static_cast<uint32_t>(ContentType::Script | ContentType::Image));
+  for (uint32_t i = 0; i < bucket->filter()->size(); ++i) {
+    const auto* filter = bucket->filter()->Get(i);
+    const bool generic = filter->include_domains()->size() == 0u &&
+                         filter->exclude_domains()->size() == 0u;
+    EXPECT_EQ(generic, i >= bucket->generic_begin()) << i;
+  }
+  // Slices don't span the boundary.
+  for (const auto* slice : *bucket->content_type_slices()) {
+    EXPECT_TRUE(slice->end() <= bucket->generic_begin() ||
+                slice->begin() >= bucket->generic_begin());
+  }
+}
+
+TEST_F(AdblockFlatbufferConverterTest, GenericblockIgnoresGenericFilters) {
+  auto subscription = ConvertAndLoadRules(R"(
+    /banner/$image
+    /banner/$script,domain=example.com
+    /ads/$image,domain=~example.com
+    )");
+  const auto matches = [&](const char* url, ContentType content_type,
+                           FilterCategory category) {
+    return subscription->HasUrlFilter(GURL(url), "example.com", content_type,
+                                      SiteKey(), category);
+  };
+  EXPECT_TRUE(matches("https://example.com/banner/ad.png", ContentType::Image,
+                      FilterCategory::Blocking));
+  EXPECT_FALSE(matches("https://example.com/banner/ad.png", ContentType::Image,
+                       FilterCategory::DomainSpecificBlocking));
+  EXPECT_TRUE(matches("https://example.com/banner/ad.js", ContentType::Script,
+                      FilterCategory::DomainSpecificBlocking));
+  EXPECT_FALSE(matches("https://example.com/ads/ad.png", ContentType::Image,
+                       FilterCategory::DomainSpecificBlocking));
+}
+
+TEST_F(AdblockFlatbufferConverterTest, PartitionedBucketsMatchContentTypes) {
+  auto subscription = ConvertAndLoadRules(R"(
+    /banner/$script
+    /banner/*.gif$image
+    /banner/$xmlhttprequest
+    )");
+  const auto matches = [&](const char* url, ContentType content_type) {
+    return subscription->HasUrlFilter(GURL(url), "domain.com", content_type,
+                                      SiteKey(), FilterCategory::Blocking);
+  };
+  EXPECT_TRUE(matches("https://example.com/banner/ad.js", ContentType::Script));
+  EXPECT_TRUE(
+      matches("https://example.com/banner/ad.gif", ContentType::Image));
+  EXPECT_TRUE(matches("https://example.com/banner/ad",
+                      ContentType::Xmlhttprequest));
+  EXPECT_FALSE(
+      matches("https://example.com/banner/ad.png", ContentType::Image));
+  EXPECT_FALSE(
+      matches("https://example.com/banner/ad.gif", ContentType::Media));
+}
+
 TEST_F(AdblockFlatbufferConverterTest, UrlFilterWithHashSign) {
   auto subscription = ConvertAndLoadRules(R"(
     @@||search.twcc.com/#web/$elemhide
@@ -1986,6 +2356,65 @@ TEST_F(AdblockFlatbufferConverterTest, RewriteExcludeDomain) {
       GURL("https://test.com/ad.html"), "test.com", FilterCategory::Blocking));
 }
 
+TEST_F(AdblockFlatbufferConverterTest, RewriteIndexNotPartitioned) {
+  // The second filter applies to fewer resource types, partitioning would
+  // move it first.
+  const std::string rules = R"(
+     ||adform.net/adx.js$script,image,domain=delfi.lt,rewrite=abp-resource:blank-js
+     ||adform.net/adx.js$script,domain=delfi.lt,rewrite=abp-resource:blank-text
+    )";
+  auto subscriptions = ConvertAndLoadRules(rules);
+  EXPECT_EQ(subscriptions->FindRewriteFilter(GURL("https://adform.net/adx.js"),
+                                             "delfi.lt",
+                                             FilterCategory::Blocking),
+            "data:application/javascript,");
+
+  auto index = ConvertAndLoadRulesToIndex(rules);
+  ASSERT_TRUE(index.index_->url_rewrite_block());
+  for (const auto* bucket : *index.index_->url_rewrite_block()) {
+    ASSERT_TRUE(bucket->content_type_slices());
+    EXPECT_EQ(bucket->content_type_slices()->size(), 1u);
+  }
+}
+
+TEST_F(AdblockFlatbufferConverterTest, RewriteFirstFilterInListOrderWins) {
+  // Both filters match. The second one is cheaper and narrower in resource
+  // types and domains, but the first one determines the rewritten URL.
+  auto subscriptions = ConvertAndLoadRules(R"(
+     ||adform.net/adx.js$script,image,domain=delfi.lt|example.com,rewrite=abp-resource:blank-js
+     ||adform.net/adx.js$script,domain=delfi.lt,rewrite=abp-resource:blank-text
+    )");
+  EXPECT_EQ(subscriptions->FindRewriteFilter(GURL("https://adform.net/adx.js"),
+                                             "delfi.lt",
+                                             FilterCategory::Blocking),
+            "data:application/javascript,");
+
+  subscriptions = ConvertAndLoadRules(R"(
+     ||adform.net/adx.js$script,domain=delfi.lt,rewrite=abp-resource:blank-text
+     ||adform.net/adx.js$script,image,domain=delfi.lt|example.com,rewrite=abp-resource:blank-js
+    )");
+  EXPECT_EQ(subscriptions->FindRewriteFilter(GURL("https://adform.net/adx.js"),
+                                             "delfi.lt",
+                                             FilterCategory::Blocking),
+            "data:text/plain,");
+}
+
+TEST_F(AdblockFlatbufferConverterTest, RewriteDomainSpecificWithGenericblock) {
+  // With $genericblock, domain-specific rewrite filters still apply, in list
+  // order.
+  auto subscriptions = ConvertAndLoadRules(R"(
+     ||adform.net/adx.js$script,image,domain=delfi.lt|example.com,rewrite=abp-resource:blank-js
+     ||adform.net/adx.js$script,domain=delfi.lt,rewrite=abp-resource:blank-text
+    )");
+  EXPECT_EQ(subscriptions->FindRewriteFilter(
+                GURL("https://adform.net/adx.js"), "delfi.lt",
+                FilterCategory::DomainSpecificBlocking),
+            "data:application/javascript,");
+  EXPECT_FALSE(subscriptions->FindRewriteFilter(
+      GURL("https://adform.net/adx.js"), "other.com",
+      FilterCategory::DomainSpecificBlocking));
+}
+
 TEST_F(AdblockFlatbufferConverterTest, HeaderFilterIgnoredForNonpriviledged) {
   auto subscriptions = ConvertAndLoadRules(R"(
     test.com^$header=X-Frame-Options=sameorigin
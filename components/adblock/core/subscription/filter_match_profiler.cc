@@ -0,0 +1,184 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/filter_match_profiler.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "base/check.h"
+#include "base/json/json_writer.h"
+#include "base/no_destructor.h"
+#include "base/values.h"
+
+namespace adblock {
+namespace {
+
+base::Value::Dict FilterStatsToValue(
+    base::StringPiece pattern,
+    const FilterMatchProfiler::FilterStats& stats) {
+  base::Value::Dict value;
+  value.Set("pattern", pattern);
+  value.Set("evaluations", static_cast<double>(stats.evaluations));
+  value.Set("matches", static_cast<double>(stats.matches));
+  value.Set("total_time_us", stats.total_time.InMicrosecondsF());
+  return value;
+}
+
+}  // namespace
+
+// static
+FilterMatchProfiler* FilterMatchProfiler::GetInstance() {
+  static base::NoDestructor<FilterMatchProfiler> instance;
+  return instance.get();
+}
+
+FilterMatchProfiler::FilterMatchProfiler() = default;
+FilterMatchProfiler::~FilterMatchProfiler() = default;
+
+void FilterMatchProfiler::SetEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+bool FilterMatchProfiler::IsEnabled() const {
+  return enabled_.load(std::memory_order_relaxed);
+}
+
+void FilterMatchProfiler::RecordBucketVisit(base::StringPiece subscription,
+                                            base::StringPiece keyword,
+                                            uint32_t bucket_size) {
+  base::AutoLock lock(lock_);
+  auto& bucket = GetOrCreateBucket(subscription, keyword);
+  ++bucket.visits;
+  bucket.size = bucket_size;
+}
+
+void FilterMatchProfiler::RecordFilterEvaluation(base::StringPiece subscription,
+                                                 base::StringPiece keyword,
+                                                 base::StringPiece pattern,
+                                                 bool matched,
+                                                 base::TimeDelta elapsed) {
+  base::AutoLock lock(lock_);
+  auto& bucket = GetOrCreateBucket(subscription, keyword);
+  bucket.total_time += elapsed;
+  auto it = bucket.filters.find(pattern);
+  if (it == bucket.filters.end()) {
+    it = bucket.filters.emplace(std::string(pattern), FilterStats()).first;
+  }
+  ++it->second.evaluations;
+  if (matched) {
+    ++it->second.matches;
+  }
+  it->second.total_time += elapsed;
+}
+
+void FilterMatchProfiler::Reset() {
+  base::AutoLock lock(lock_);
+  buckets_.clear();
+}
+
+absl::optional<FilterMatchProfiler::BucketStats>
+FilterMatchProfiler::GetBucketStats(base::StringPiece subscription,
+                                    base::StringPiece keyword) const {
+  base::AutoLock lock(lock_);
+  const auto it = buckets_.find(std::make_tuple(subscription, keyword));
+  if (it == buckets_.end()) {
+    return absl::nullopt;
+  }
+  return it->second;
+}
+
+std::map<std::string, FilterMatchProfiler::FilterStats, std::less<>>
+FilterMatchProfiler::GetFilterStats(base::StringPiece subscription) const {
+  base::AutoLock lock(lock_);
+  std::map<std::string, FilterStats, std::less<>> result;
+  for (const auto& [key, stats] : buckets_) {
+    if (std::get<0>(key) != subscription) {
+      continue;
+    }
+    for (const auto& [pattern, filter_stats] : stats.filters) {
+      auto& sum = result[pattern];
+      sum.evaluations += filter_stats.evaluations;
+      sum.matches += filter_stats.matches;
+      sum.total_time += filter_stats.total_time;
+    }
+  }
+  return result;
+}
+
+std::string FilterMatchProfiler::ToJson() const {
+  base::AutoLock lock(lock_);
+  std::vector<std::pair<const BucketKey*, const BucketStats*>> buckets;
+  buckets.reserve(buckets_.size());
+  for (const auto& [key, stats] : buckets_) {
+    buckets.emplace_back(&key, &stats);
+  }
+  std::stable_sort(buckets.begin(), buckets.end(),
+                   [](const auto& lhs, const auto& rhs) {
+                     return lhs.second->total_time > rhs.second->total_time;
+                   });
+
+  base::Value::List bucket_list;
+  for (const auto& [key, stats] : buckets) {
+    std::vector<std::pair<base::StringPiece, const FilterStats*>> filters;
+    filters.reserve(stats->filters.size());
+    for (const auto& [pattern, filter_stats] : stats->filters) {
+      filters.emplace_back(pattern, &filter_stats);
+    }
+    std::stable_sort(filters.begin(), filters.end(),
+                     [](const auto& lhs, const auto& rhs) {
+                       return lhs.second->total_time > rhs.second->total_time;
+                     });
+    base::Value::List filter_list;
+    for (const auto& [pattern, filter_stats] : filters) {
+      filter_list.Append(FilterStatsToValue(pattern, *filter_stats));
+    }
+
+    base::Value::Dict bucket;
+    bucket.Set("subscription", std::get<0>(*key));
+    bucket.Set("keyword", std::get<1>(*key));
+    bucket.Set("size", static_cast<int>(stats->size));
+    bucket.Set("visits", static_cast<double>(stats->visits));
+    bucket.Set("total_time_us", stats->total_time.InMicrosecondsF());
+    bucket.Set("filters", std::move(filter_list));
+    bucket_list.Append(std::move(bucket));
+  }
+
+  base::Value::Dict root;
+  root.Set("enabled", IsEnabled());
+  root.Set("buckets", std::move(bucket_list));
+  std::string serialized;
+  // Writing only fails for values nested deeper than the writer allows, these
+  // are three levels deep.
+  CHECK(base::JSONWriter::WriteWithOptions(
+      root, base::JSONWriter::OPTIONS_PRETTY_PRINT, &serialized));
+  return serialized;
+}
+
+FilterMatchProfiler::BucketStats& FilterMatchProfiler::GetOrCreateBucket(
+    base::StringPiece subscription,
+    base::StringPiece keyword) {
+  auto it = buckets_.find(std::make_tuple(subscription, keyword));
+  if (it == buckets_.end()) {
+    BucketKey key(std::string(subscription), std::string(keyword));
+    it = buckets_.emplace(std::move(key), BucketStats()).first;
+  }
+  return it->second;
+}
+
+}  // namespace adblock
@@ -0,0 +1,111 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_FILTER_MATCH_PROFILER_H_
+#define COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_FILTER_MATCH_PROFILER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+
+#include "absl/types/optional.h"
+#include "base/strings/string_piece.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "base/time/time.h"
+
+namespace adblock {
+
+// Opt-in accounting of what URL filter matching costs, to find pathological
+// filters and oversized keyword buckets in real filter lists. Disabled by
+// default, when it costs InstalledSubscriptionImpl one atomic load per
+// keyword bucket visited.
+// Statistics are kept per keyword bucket of each subscription, and within a
+// bucket per filter pattern. Filters of one bucket that share a pattern but
+// differ in options are accounted together.
+// Thread-safe, a single instance is shared by the whole process.
+class FilterMatchProfiler final {
+ public:
+  struct FilterStats {
+    uint64_t evaluations = 0u;
+    uint64_t matches = 0u;
+    base::TimeDelta total_time;
+  };
+
+  struct BucketStats {
+    uint64_t visits = 0u;
+    uint32_t size = 0u;
+    base::TimeDelta total_time;
+    std::map<std::string, FilterStats, std::less<>> filters;
+  };
+
+  static FilterMatchProfiler* GetInstance();
+
+  FilterMatchProfiler();
+  ~FilterMatchProfiler();
+  FilterMatchProfiler(const FilterMatchProfiler&) = delete;
+  FilterMatchProfiler& operator=(const FilterMatchProfiler&) = delete;
+
+  // Enabling does not clear statistics collected earlier, see Reset().
+  void SetEnabled(bool enabled);
+  bool IsEnabled() const;
+
+  // Records a visit of the |keyword| bucket of |subscription|, which holds
+  // |bucket_size| filters. The keyword-less bucket has an empty |keyword|.
+  void RecordBucketVisit(base::StringPiece subscription,
+                         base::StringPiece keyword,
+                         uint32_t bucket_size);
+  // Records one evaluation of a filter with |pattern| from the |keyword|
+  // bucket of |subscription|. |elapsed| covers every check of the filter,
+  // not only the pattern match.
+  void RecordFilterEvaluation(base::StringPiece subscription,
+                              base::StringPiece keyword,
+                              base::StringPiece pattern,
+                              bool matched,
+                              base::TimeDelta elapsed);
+
+  void Reset();
+
+  absl::optional<BucketStats> GetBucketStats(base::StringPiece subscription,
+                                             base::StringPiece keyword) const;
+  // Statistics of the filters of |subscription| by pattern, summed over all
+  // buckets. |total_time| is only that of the filter evaluations.
+  std::map<std::string, FilterStats, std::less<>> GetFilterStats(
+      base::StringPiece subscription) const;
+
+  // Serializes all statistics as JSON, buckets and the filters within each
+  // bucket ordered from the most to the least expensive. Times are in
+  // microseconds.
+  std::string ToJson() const;
+
+ private:
+  using BucketKey = std::tuple<std::string, std::string>;
+
+  BucketStats& GetOrCreateBucket(base::StringPiece subscription,
+                                 base::StringPiece keyword)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  std::atomic<bool> enabled_{false};
+  mutable base::Lock lock_;
+  std::map<BucketKey, BucketStats, std::less<>> buckets_ GUARDED_BY(lock_);
+};
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_FILTER_MATCH_PROFILER_H_
@@ -19,6 +19,8 @@
 
 #include "base/functional/bind.h"
 #include "base/logging.h"
+#include "base/task/task_traits.h"
+#include "base/task/thread_pool.h"
 #include "base/trace_event/common/trace_event_common.h"
 #include "base/trace_event/trace_event.h"
 #include "components/adblock/core/common/adblock_utils.h"
@@ -63,7 +65,8 @@ FilteringConfigurationMaintainerImpl::FilteringConfigurationMaintainerImpl(
     std::unique_ptr<SubscriptionUpdater> updater,
     ConversionExecutors* conversion_executor,
     SubscriptionPersistentMetadata* persistent_metadata,
-    SubscriptionUpdatedCallback subscription_updated_callback)
+    SubscriptionUpdatedCallback subscription_updated_callback,
+    CollectionChangedCallback collection_changed_callback)
     : configuration_(std::move(configuration)),
       storage_(std::move(storage)),
       downloader_(std::move(downloader)),
@@ -72,7 +75,9 @@ FilteringConfigurationMaintainerImpl::FilteringConfigurationMaintainerImpl(
       updater_(std::move(updater)),
       conversion_executor_(conversion_executor),
       persistent_metadata_(persistent_metadata),
-      subscription_updated_callback_(std::move(subscription_updated_callback)) {
+      subscription_updated_callback_(std::move(subscription_updated_callback)),
+      collection_changed_callback_(std::move(collection_changed_callback)),
+      collection_generation_(SubscriptionCollection::NextGeneration()) {
   DCHECK(configuration_->IsEnabled())
       << "Disabled configurations should not be maintained";
   configuration_->AddObserver(this);
@@ -85,16 +90,23 @@ FilteringConfigurationMaintainerImpl::~FilteringConfigurationMaintainerImpl() {
 std::unique_ptr<SubscriptionCollection>
 FilteringConfigurationMaintainerImpl::GetSubscriptionCollection() const {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
-  std::vector<scoped_refptr<InstalledSubscription>> state = current_state_;
-  if (custom_filters_) {
-    state.push_back(custom_filters_);
-  }
-  base::ranges::move(
-      preloaded_subscription_provider_->GetCurrentPreloadedSubscriptions(),
-      std::back_inserter(state));
+  std::vector<scoped_refptr<InstalledSubscription>> state =
+      GetCollectionState();
   VLOG(2) << "[eyeo] FilteringConfiguration " << configuration_->GetName()
           << " produces " << state.size() << " subscriptions for Snapshot";
-  return std::make_unique<SubscriptionCollectionImpl>(state);
+  // Until the merged index catches up with the latest change, the collection
+  // queries subscriptions one by one.
+  scoped_refptr<const MergedUrlFilterIndex> merged_index;
+  if (merged_index_ && merged_index_->IsBuiltFrom(state)) {
+    merged_index = merged_index_;
+  }
+  scoped_refptr<const GenericElemhideStylesheet> generic_elemhide;
+  if (generic_elemhide_ && generic_elemhide_->IsBuiltFrom(state)) {
+    generic_elemhide = generic_elemhide_;
+  }
+  return std::make_unique<SubscriptionCollectionImpl>(
+      std::move(state), std::move(merged_index), collection_generation_,
+      std::move(generic_elemhide));
 }
 
 std::vector<scoped_refptr<Subscription>>
@@ -450,16 +462,18 @@ void FilteringConfigurationMaintainerImpl::SetCustomFilters() {
   }
   if (filters.empty()) {
     custom_filters_.reset();
-    return;
+  } else {
+    custom_filters_ = conversion_executor_->ConvertCustomFilters(filters);
   }
-
-  custom_filters_ = conversion_executor_->ConvertCustomFilters(filters);
+  OnCollectionStateChanged();
 }
 
 void FilteringConfigurationMaintainerImpl::
     UpdatePreloadedSubscriptionProvider() {
   preloaded_subscription_provider_->UpdateSubscriptions(
       GetReadySubscriptions(), GetPendingSubscriptions());
+  // Called after every change to |current_state_|.
+  OnCollectionStateChanged();
 }
 
 std::vector<GURL> FilteringConfigurationMaintainerImpl::GetReadySubscriptions()
@@ -482,4 +496,87 @@ FilteringConfigurationMaintainerImpl::GetPendingSubscriptions() const {
   return result;
 }
 
+std::vector<scoped_refptr<InstalledSubscription>>
+FilteringConfigurationMaintainerImpl::GetCollectionState() const {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  std::vector<scoped_refptr<InstalledSubscription>> state = current_state_;
+  if (custom_filters_) {
+    state.push_back(custom_filters_);
+  }
+  base::ranges::move(
+      preloaded_subscription_provider_->GetCurrentPreloadedSubscriptions(),
+      std::back_inserter(state));
+  return state;
+}
+
+void FilteringConfigurationMaintainerImpl::OnCollectionStateChanged() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  // Results cached for previous Snapshots no longer apply.
+  collection_generation_ = SubscriptionCollection::NextGeneration();
+  RebuildMergedIndex();
+  RebuildGenericElemhide();
+  collection_changed_callback_.Run();
+}
+
+void FilteringConfigurationMaintainerImpl::RebuildMergedIndex() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  auto state = GetCollectionState();
+  if (merged_index_ && merged_index_->IsBuiltFrom(state)) {
+    return;
+  }
+  // A stale index would not be used anyway, don't let it keep removed
+  // subscriptions alive.
+  merged_index_.reset();
+  base::ThreadPool::PostTaskAndReplyWithResult(
+      FROM_HERE, {base::TaskPriority::USER_VISIBLE},
+      base::BindOnce(&MergedUrlFilterIndex::Build, std::move(state)),
+      base::BindOnce(&FilteringConfigurationMaintainerImpl::OnMergedIndexBuilt,
+                     weak_ptr_factory_.GetWeakPtr()));
+}
+
+void FilteringConfigurationMaintainerImpl::OnMergedIndexBuilt(
+    scoped_refptr<MergedUrlFilterIndex> merged_index) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  if (!merged_index || !merged_index->IsBuiltFrom(GetCollectionState())) {
+    // Either the subscriptions cannot be merged, or the state changed while
+    // this index was being built and a newer one is on its way.
+    return;
+  }
+  VLOG(1) << "[eyeo] Merged URL filter index ready for FilteringConfiguration "
+          << configuration_->GetName();
+  merged_index_ = std::move(merged_index);
+  // Collections made from now on use the index.
+  collection_changed_callback_.Run();
+}
+
+void FilteringConfigurationMaintainerImpl::RebuildGenericElemhide() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  auto state = GetCollectionState();
+  if (generic_elemhide_ && generic_elemhide_->IsBuiltFrom(state)) {
+    return;
+  }
+  generic_elemhide_.reset();
+  base::ThreadPool::PostTaskAndReplyWithResult(
+      FROM_HERE, {base::TaskPriority::USER_VISIBLE},
+      base::BindOnce(&GenericElemhideStylesheet::Build, std::move(state)),
+      base::BindOnce(
+          &FilteringConfigurationMaintainerImpl::OnGenericElemhideBuilt,
+          weak_ptr_factory_.GetWeakPtr()));
+}
+
+void FilteringConfigurationMaintainerImpl::OnGenericElemhideBuilt(
+    scoped_refptr<GenericElemhideStylesheet> generic_elemhide) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  if (!generic_elemhide->IsBuiltFrom(GetCollectionState())) {
+    // A newer stylesheet is on its way.
+    return;
+  }
+  VLOG(1) << "[eyeo] Generic element hiding stylesheet with "
+          << generic_elemhide->selector_count()
+          << " selectors ready for FilteringConfiguration "
+          << configuration_->GetName();
+  generic_elemhide_ = std::move(generic_elemhide);
+  collection_changed_callback_.Run();
+}
+
 }  // namespace adblock
@@ -24,6 +24,8 @@
 #include "components/adblock/core/configuration/filtering_configuration.h"
 #include "components/adblock/core/subscription/conversion_executors.h"
 #include "components/adblock/core/subscription/filtering_configuration_maintainer.h"
+#include "components/adblock/core/subscription/generic_elemhide_stylesheet.h"
+#include "components/adblock/core/subscription/merged_url_filter_index.h"
 #include "components/adblock/core/subscription/preloaded_subscription_provider.h"
 #include "components/adblock/core/subscription/subscription_downloader.h"
 #include "components/adblock/core/subscription/subscription_persistent_metadata.h"
@@ -38,6 +40,8 @@ class FilteringConfigurationMaintainerImpl
  public:
   using SubscriptionUpdatedCallback =
       base::RepeatingCallback<void(const GURL&)>;
+  // Called whenever the result of GetSubscriptionCollection() changes.
+  using CollectionChangedCallback = base::RepeatingClosure;
   FilteringConfigurationMaintainerImpl(
       FilteringConfiguration* configuration,
       std::unique_ptr<SubscriptionPersistentStorage> storage,
@@ -47,7 +51,8 @@ class FilteringConfigurationMaintainerImpl
       std::unique_ptr<SubscriptionUpdater> updater,
       ConversionExecutors* conversion_executor,
       SubscriptionPersistentMetadata* persistent_metadata,
-      SubscriptionUpdatedCallback subscription_updated_callback);
+      SubscriptionUpdatedCallback subscription_updated_callback,
+      CollectionChangedCallback collection_changed_callback);
   ~FilteringConfigurationMaintainerImpl() override;
 
   std::unique_ptr<SubscriptionCollection> GetSubscriptionCollection()
@@ -91,6 +96,14 @@ class FilteringConfigurationMaintainerImpl
   void UpdatePreloadedSubscriptionProvider();
   std::vector<GURL> GetReadySubscriptions() const;
   std::vector<GURL> GetPendingSubscriptions() const;
+  std::vector<scoped_refptr<InstalledSubscription>> GetCollectionState() const;
+  // Must be called after every change to the result of GetCollectionState().
+  void OnCollectionStateChanged();
+  void RebuildMergedIndex();
+  void OnMergedIndexBuilt(scoped_refptr<MergedUrlFilterIndex> merged_index);
+  void RebuildGenericElemhide();
+  void OnGenericElemhideBuilt(
+      scoped_refptr<GenericElemhideStylesheet> generic_elemhide);
 
   SEQUENCE_CHECKER(sequence_checker_);
   StorageStatus status_ = StorageStatus::Uninitialized;
@@ -106,9 +119,19 @@ class FilteringConfigurationMaintainerImpl
   // into SubscriptionPersistentStorage.
   SubscriptionPersistentMetadata* persistent_metadata_;
   SubscriptionUpdatedCallback subscription_updated_callback_;
+  CollectionChangedCallback collection_changed_callback_;
   std::set<scoped_refptr<OngoingInstallation>> ongoing_installations_;
   std::vector<scoped_refptr<InstalledSubscription>> current_state_;
   scoped_refptr<InstalledSubscription> custom_filters_;
+  // Built in background from the result of GetCollectionState(), may lag
+  // behind it for a short while after a change.
+  scoped_refptr<MergedUrlFilterIndex> merged_index_;
+  // Likewise built in background, frames render all their selectors until it
+  // is ready.
+  scoped_refptr<GenericElemhideStylesheet> generic_elemhide_;
+  // Identifies the result of GetCollectionState(), see
+  // SubscriptionCollection::GetGeneration().
+  uint64_t collection_generation_;
   base::WeakPtrFactory<FilteringConfigurationMaintainerImpl> weak_ptr_factory_{
       this};
 };
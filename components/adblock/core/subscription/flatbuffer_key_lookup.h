@@ -0,0 +1,67 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_FLATBUFFER_KEY_LOOKUP_H_
+#define COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_FLATBUFFER_KEY_LOOKUP_H_
+
+#include <algorithm>
+
+#include "base/strings/string_piece.h"
+#include "components/adblock/core/schema/filter_list_schema_generated.h"
+
+namespace adblock {
+
+inline base::StringPiece KeyOf(const flat::UrlFiltersByKeyword* bucket) {
+  return base::StringPiece(bucket->keyword()->c_str(),
+                           bucket->keyword()->size());
+}
+
+inline base::StringPiece KeyOf(const flat::ElemHideFiltersByDomain* bucket) {
+  return base::StringPiece(bucket->domain()->c_str(),
+                           bucket->domain()->size());
+}
+
+inline base::StringPiece KeyOf(const flat::SnippetFiltersByDomain* bucket) {
+  return base::StringPiece(bucket->domain()->c_str(),
+                           bucket->domain()->size());
+}
+
+// Equivalent to |vector|->LookupByKey(), for keys that aren't null-terminated,
+// like keywords and subdomains pointing into a URL. Compares the stored
+// string lengths instead of scanning for terminators, so no copy of |key| is
+// needed. Returns nullptr if |vector| is null or has no element for |key|.
+template <typename T>
+const T* LookupByKey(const flatbuffers::Vector<flatbuffers::Offset<T>>* vector,
+                     base::StringPiece key) {
+  if (!vector) {
+    return nullptr;
+  }
+  // Vectors of tables with a key are sorted by that key.
+  const auto it = std::lower_bound(
+      vector->begin(), vector->end(), key,
+      [](const T* element, base::StringPiece value) {
+        return KeyOf(element) < value;
+      });
+  if (it == vector->end() || KeyOf(*it) != key) {
+    return nullptr;
+  }
+  return *it;
+}
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_FLATBUFFER_KEY_LOOKUP_H_
@@ -0,0 +1,37 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/frame_special_filters.h"
+
+#include "base/check_op.h"
+
+namespace adblock {
+
+FrameSpecialFilters::FrameSpecialFilters(uint64_t generation,
+                                         const Positions& positions)
+    : generation_(generation), positions_(positions) {
+  DCHECK_NE(generation_, 0u);
+}
+
+FrameSpecialFilters::~FrameSpecialFilters() = default;
+
+absl::optional<size_t> FrameSpecialFilters::Find(
+    SpecialFilterType filter_type) const {
+  return positions_[static_cast<size_t>(filter_type)];
+}
+
+}  // namespace adblock
@@ -0,0 +1,75 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_FRAME_SPECIAL_FILTERS_H_
+#define COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_FRAME_SPECIAL_FILTERS_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/types/optional.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
+#include "components/adblock/core/subscription/installed_subscription.h"
+
+namespace adblock {
+
+// Number of SpecialFilterType values.
+constexpr size_t kSpecialFilterTypeCount =
+    static_cast<size_t>(SpecialFilterType::Generichide) + 1;
+
+// Document-level special filters that apply to a frame through its own URL or
+// the URL of one of its ancestors, as found by one SubscriptionCollection.
+// They are the same for every subresource request the frame makes, so they are
+// looked up once per frame and passed to the queries through RequestContext.
+// Only valid for the collection generation they were found with.
+// Immutable and thread-safe.
+class FrameSpecialFilters final
+    : public base::RefCountedThreadSafe<FrameSpecialFilters> {
+ public:
+  // For every SpecialFilterType, position of the earliest subscription of the
+  // collection that has such a filter for the frame, nullopt if none has.
+  using Positions =
+      std::array<absl::optional<size_t>, kSpecialFilterTypeCount>;
+
+  FrameSpecialFilters(uint64_t generation, const Positions& positions);
+  FrameSpecialFilters(const FrameSpecialFilters&) = delete;
+  FrameSpecialFilters& operator=(const FrameSpecialFilters&) = delete;
+
+  // SubscriptionCollection::GetGeneration() of the collection the filters were
+  // found with. Never 0.
+  uint64_t generation() const { return generation_; }
+  absl::optional<size_t> Find(SpecialFilterType filter_type) const;
+
+ private:
+  friend class base::RefCountedThreadSafe<FrameSpecialFilters>;
+  ~FrameSpecialFilters();
+
+  const uint64_t generation_;
+  const Positions positions_;
+};
+
+// Filters of one frame for each collection of a snapshot, in snapshot order.
+// Null for collections that don't track their state.
+using FrameSpecialFiltersList =
+    std::vector<scoped_refptr<const FrameSpecialFilters>>;
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_FRAME_SPECIAL_FILTERS_H_
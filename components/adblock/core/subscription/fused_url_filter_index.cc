@@ -0,0 +1,80 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/fused_url_filter_index.h"
+
+#include <map>
+#include <utility>
+
+#include "base/trace_event/trace_event.h"
+
+namespace adblock {
+
+// static
+scoped_refptr<FusedUrlFilterIndex> FusedUrlFilterIndex::Build(
+    CollectionStates states) {
+  TRACE_EVENT1("eyeo", "FusedUrlFilterIndex::Build", "collections",
+               states.size());
+  if (states.size() > kMaxCollections) {
+    return nullptr;
+  }
+  // Collections may share subscriptions, each is indexed once.
+  std::vector<scoped_refptr<InstalledSubscription>> subscriptions;
+  std::vector<CollectionMask> subscription_collections;
+  std::map<const InstalledSubscription*, size_t> positions;
+  for (size_t collection = 0; collection < states.size(); ++collection) {
+    for (const auto& subscription : states[collection]) {
+      const auto inserted =
+          positions.emplace(subscription.get(), subscriptions.size());
+      if (inserted.second) {
+        subscriptions.push_back(subscription);
+        subscription_collections.emplace_back();
+      }
+      subscription_collections[inserted.first->second].set(collection);
+    }
+  }
+  auto merged_index = MergedUrlFilterIndex::Build(std::move(subscriptions));
+  if (!merged_index) {
+    return nullptr;
+  }
+  return base::WrapRefCounted(new FusedUrlFilterIndex(
+      std::move(states), std::move(merged_index),
+      std::move(subscription_collections)));
+}
+
+FusedUrlFilterIndex::FusedUrlFilterIndex(
+    CollectionStates states,
+    scoped_refptr<const MergedUrlFilterIndex> merged_index,
+    std::vector<CollectionMask> subscription_collections)
+    : states_(std::move(states)),
+      merged_index_(std::move(merged_index)),
+      subscription_collections_(std::move(subscription_collections)) {}
+
+FusedUrlFilterIndex::~FusedUrlFilterIndex() = default;
+
+bool FusedUrlFilterIndex::IsBuiltFrom(const CollectionStates& states) const {
+  return states_ == states;
+}
+
+FusedUrlFilterIndex::CollectionMask
+FusedUrlFilterIndex::FindBlockingCollections(const UrlContext& context,
+                                             ContentType content_type) const {
+  return merged_index_->FindBlockingGroups(context, content_type,
+                                           subscription_collections_);
+}
+
+}  // namespace adblock
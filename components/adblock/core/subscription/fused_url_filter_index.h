@@ -0,0 +1,80 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_FUSED_URL_FILTER_INDEX_H_
+#define COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_FUSED_URL_FILTER_INDEX_H_
+
+#include <vector>
+
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
+#include "components/adblock/core/common/content_type.h"
+#include "components/adblock/core/subscription/installed_subscription.h"
+#include "components/adblock/core/subscription/merged_url_filter_index.h"
+#include "components/adblock/core/subscription/request_context.h"
+
+namespace adblock {
+
+// Merges the subresource blocking filters of the SubscriptionCollections of
+// several FilteringConfigurations into one MergedUrlFilterIndex, so that a
+// request's keywords are looked up once for all of them. Every subscription
+// remembers which collections it belongs to, a match is recorded for all of
+// them at once.
+// Immutable once built, can be shared between sequences.
+class FusedUrlFilterIndex final
+    : public base::RefCountedThreadSafe<FusedUrlFilterIndex> {
+ public:
+  // Bit i stands for the i-th collection this index was built from.
+  using CollectionMask = MergedUrlFilterIndex::GroupMask;
+  // Subscriptions of each collection, in collection order.
+  using CollectionStates =
+      std::vector<std::vector<scoped_refptr<InstalledSubscription>>>;
+  static constexpr size_t kMaxCollections = CollectionMask().size();
+
+  // Builds an index of |states|. Returns nullptr if there are more than
+  // kMaxCollections collections or any subscription is not backed by a
+  // flatbuffer, callers should then query collections individually.
+  // Expensive, should not be called on the UI thread.
+  static scoped_refptr<FusedUrlFilterIndex> Build(CollectionStates states);
+
+  // Returns whether this index was built from exactly |states|.
+  bool IsBuiltFrom(const CollectionStates& states) const;
+
+  // Returns the collections in which a subresource blocking filter matches
+  // the request, as SubscriptionCollection::FindBySubresourceFilter() with
+  // FilterCategory::Blocking would find. Other collections would ignore the
+  // request.
+  CollectionMask FindBlockingCollections(const UrlContext& context,
+                                         ContentType content_type) const;
+
+ private:
+  friend class base::RefCountedThreadSafe<FusedUrlFilterIndex>;
+  FusedUrlFilterIndex(CollectionStates states,
+                      scoped_refptr<const MergedUrlFilterIndex> merged_index,
+                      std::vector<CollectionMask> subscription_collections);
+  ~FusedUrlFilterIndex();
+
+  const CollectionStates states_;
+  // Built from every distinct subscription of |states_|.
+  const scoped_refptr<const MergedUrlFilterIndex> merged_index_;
+  // Indexed like the subscriptions of |merged_index_|.
+  const std::vector<CollectionMask> subscription_collections_;
+};
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_FUSED_URL_FILTER_INDEX_H_
@@ -0,0 +1,105 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/generic_elemhide_stylesheet.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "base/ranges/algorithm.h"
+#include "base/strings/string_util.h"
+#include "base/trace_event/trace_event.h"
+
+namespace adblock {
+
+void AppendElemhideRules(base::span<const base::StringPiece> selectors,
+                         std::string& output) {
+  // Chromium's Blink engine supports only up to 8,192 simple selectors, and
+  // even fewer compound selectors, in a rule. The exact number of selectors
+  // that would work depends on their sizes (e.g. "#foo .bar" has a size of 2).
+  // Since we don't know the sizes of the selectors here, we simply split them
+  // into groups of 1,024, based on the reasonable assumption that the average
+  // selector won't have a size greater than 8. The alternative would be to
+  // calculate the sizes of the selectors and divide them up accordingly, but
+  // this approach is more efficient and has worked well in practice. In theory
+  // this could still lead to some selectors not working on Chromium, but it is
+  // highly unlikely.
+  const size_t max_selector_count = 1024u;
+  for (size_t i = 0; i < selectors.size(); i += max_selector_count) {
+    const size_t batch_size =
+        std::min(max_selector_count, selectors.size() - i);
+    output += base::JoinString(selectors.subspan(i, batch_size), ", ") +
+              " {display: none !important;}\n";
+  }
+}
+
+// static
+scoped_refptr<GenericElemhideStylesheet> GenericElemhideStylesheet::Build(
+    std::vector<scoped_refptr<InstalledSubscription>> subscriptions) {
+  TRACE_EVENT1("eyeo", "GenericElemhideStylesheet::Build", "subscriptions",
+               subscriptions.size());
+  return base::WrapRefCounted(
+      new GenericElemhideStylesheet(std::move(subscriptions)));
+}
+
+GenericElemhideStylesheet::GenericElemhideStylesheet(
+    std::vector<scoped_refptr<InstalledSubscription>> subscriptions)
+    : subscriptions_(std::move(subscriptions)) {
+  // Exceptions from one subscription remove selectors of all others.
+  std::vector<base::StringPiece> selectors;
+  std::vector<base::StringPiece> exceptions;
+  for (const auto& subscription : subscriptions_) {
+    auto domain_agnostic = subscription->GetDomainAgnosticElemhideSelectors();
+    std::move(domain_agnostic.elemhide_selectors.begin(),
+              domain_agnostic.elemhide_selectors.end(),
+              std::back_inserter(selectors));
+    std::move(domain_agnostic.elemhide_exceptions.begin(),
+              domain_agnostic.elemhide_exceptions.end(),
+              std::back_inserter(exceptions));
+  }
+  exceptions_ = base::flat_set<base::StringPiece>(std::move(exceptions));
+  base::ranges::sort(selectors);
+  selectors.erase(base::ranges::unique(selectors), selectors.end());
+  selectors.erase(std::remove_if(selectors.begin(), selectors.end(),
+                                 [&](base::StringPiece selector) {
+                                   return exceptions_.contains(selector);
+                                 }),
+                  selectors.end());
+  AppendElemhideRules(selectors, stylesheet_);
+  selectors_ = base::flat_set<base::StringPiece>(base::sorted_unique,
+                                                 std::move(selectors));
+}
+
+GenericElemhideStylesheet::~GenericElemhideStylesheet() = default;
+
+bool GenericElemhideStylesheet::IsBuiltFrom(
+    const std::vector<scoped_refptr<InstalledSubscription>>& subscriptions)
+    const {
+  return subscriptions_ == subscriptions;
+}
+
+bool GenericElemhideStylesheet::HasSelector(base::StringPiece selector) const {
+  return selectors_.contains(selector);
+}
+
+bool GenericElemhideStylesheet::HasException(
+    base::StringPiece selector) const {
+  return exceptions_.contains(selector);
+}
+
+}  // namespace adblock
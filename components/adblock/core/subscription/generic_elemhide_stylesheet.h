@@ -0,0 +1,79 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_GENERIC_ELEMHIDE_STYLESHEET_H_
+#define COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_GENERIC_ELEMHIDE_STYLESHEET_H_
+
+#include <string>
+#include <vector>
+
+#include "base/containers/flat_set.h"
+#include "base/containers/span.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/string_piece.h"
+#include "components/adblock/core/subscription/installed_subscription.h"
+
+namespace adblock {
+
+// Appends CSS rules that hide elements matching |selectors| to |output|.
+void AppendElemhideRules(base::span<const base::StringPiece> selectors,
+                         std::string& output);
+
+// The part of the element hiding stylesheet of a SubscriptionCollection that
+// is the same for every frame: the domain-agnostic selectors of all its
+// subscriptions, minus their domain-agnostic exceptions. Rendered once per
+// state of the collection, so that frames only need to gather and render the
+// selectors that depend on their domain.
+// Immutable once built, can be shared between sequences.
+class GenericElemhideStylesheet final
+    : public base::RefCountedThreadSafe<GenericElemhideStylesheet> {
+ public:
+  // Expensive, should not be called on the UI thread.
+  static scoped_refptr<GenericElemhideStylesheet> Build(
+      std::vector<scoped_refptr<InstalledSubscription>> subscriptions);
+
+  // Returns whether this stylesheet was built from exactly |subscriptions|,
+  // in the same order.
+  bool IsBuiltFrom(const std::vector<scoped_refptr<InstalledSubscription>>&
+                       subscriptions) const;
+
+  // Whether |selector| is hidden by the stylesheet.
+  bool HasSelector(base::StringPiece selector) const;
+  // Whether |selector| has a domain-agnostic exception, which means it is not
+  // hidden on any frame.
+  bool HasException(base::StringPiece selector) const;
+
+  size_t selector_count() const { return selectors_.size(); }
+  const std::string& stylesheet() const { return stylesheet_; }
+
+ private:
+  friend class base::RefCountedThreadSafe<GenericElemhideStylesheet>;
+  explicit GenericElemhideStylesheet(
+      std::vector<scoped_refptr<InstalledSubscription>> subscriptions);
+  ~GenericElemhideStylesheet();
+
+  // Keeps the flatbuffers referenced by the selectors alive.
+  const std::vector<scoped_refptr<InstalledSubscription>> subscriptions_;
+  base::flat_set<base::StringPiece> selectors_;
+  base::flat_set<base::StringPiece> exceptions_;
+  std::string stylesheet_;
+};
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_GENERIC_ELEMHIDE_STYLESHEET_H_
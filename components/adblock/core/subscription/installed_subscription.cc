@@ -39,4 +39,39 @@ InstalledSubscription::Snippet& InstalledSubscription::Snippet::operator=(
 
 InstalledSubscription::~InstalledSubscription() = default;
 
+bool InstalledSubscription::HasUrlFilter(const UrlContext& context,
+                                         ContentType content_type,
+                                         FilterCategory category) const {
+  return HasUrlFilter(context.url(), context.document_domain(), content_type,
+                      context.sitekey(), category);
+}
+
+bool InstalledSubscription::HasPopupFilter(const UrlContext& context,
+                                           FilterCategory category) const {
+  return HasPopupFilter(context.url(), context.document_domain(),
+                        context.sitekey(), category);
+}
+
+bool InstalledSubscription::HasSpecialFilter(SpecialFilterType type,
+                                             const UrlContext& context) const {
+  return HasSpecialFilter(type, context.url(), context.document_domain(),
+                          context.sitekey());
+}
+
+InstalledSubscription::Selectors
+InstalledSubscription::GetDomainAgnosticElemhideSelectors() const {
+  return {};
+}
+
+InstalledSubscription::Selectors
+InstalledSubscription::GetDomainDependentElemhideSelectors(
+    const GURL& url) const {
+  return GetElemhideSelectors(url, false);
+}
+
+const InstalledSubscriptionImpl*
+InstalledSubscription::AsInstalledSubscriptionImpl() const {
+  return nullptr;
+}
+
 }  // namespace adblock
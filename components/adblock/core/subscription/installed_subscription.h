@@ -30,6 +30,7 @@
 #include "components/adblock/core/common/content_type.h"
 #include "components/adblock/core/common/header_filter_data.h"
 #include "components/adblock/core/common/sitekey.h"
+#include "components/adblock/core/subscription/request_context.h"
 #include "components/adblock/core/subscription/subscription.h"
 #include "url/gurl.h"
 
@@ -50,6 +51,8 @@ enum class SpecialFilterType {
 };
 enum class FilterCategory { Allowing, Blocking, DomainSpecificBlocking };
 
+class InstalledSubscriptionImpl;
+
 // Represents an installed subscription that can be queried for filters.
 class InstalledSubscription : public Subscription {
  public:
@@ -94,6 +97,15 @@ class InstalledSubscription : public Subscription {
                                 const GURL& url,
                                 const std::string& document_domain,
                                 const SiteKey& sitekey) const = 0;
+  // Variants of the above that reuse data precomputed once per request.
+  // Default implementations forward to the variants above.
+  virtual bool HasUrlFilter(const UrlContext& context,
+                            ContentType content_type,
+                            FilterCategory category) const;
+  virtual bool HasPopupFilter(const UrlContext& context,
+                              FilterCategory category) const;
+  virtual bool HasSpecialFilter(SpecialFilterType type,
+                                const UrlContext& context) const;
   // CSP filters have a payload: a string that gets injected to a network
   // response's Content-Security-Policy header. If a filters is found, it will
   // be append to |results|.
@@ -118,6 +130,12 @@ class InstalledSubscription : public Subscription {
 
   virtual Selectors GetElemhideSelectors(const GURL& url,
                                          bool domain_specfic) const = 0;
+  // The generic selectors and exceptions that apply on every domain, i.e.
+  // those with neither include nor exclude domains. Together with
+  // GetDomainDependentElemhideSelectors(url) they make up
+  // GetElemhideSelectors(url, false).
+  virtual Selectors GetDomainAgnosticElemhideSelectors() const;
+  virtual Selectors GetDomainDependentElemhideSelectors(const GURL& url) const;
   // Note there's no "domain_specific". Emulation filters are always
   // domain-specific.
   virtual Selectors GetElemhideEmulationSelectors(const GURL& url) const = 0;
@@ -128,6 +146,11 @@ class InstalledSubscription : public Subscription {
   // Operation is atomic and thread-safe. Consecutive calls are NOPs.
   virtual void MarkForPermanentRemoval() = 0;
 
+  // Returns this subscription as a flatbuffer-backed InstalledSubscriptionImpl
+  // or nullptr if it has a different implementation (ex. in tests).
+  // Allows MergedUrlFilterIndex to access the filters directly.
+  virtual const InstalledSubscriptionImpl* AsInstalledSubscriptionImpl() const;
+
  protected:
   friend class base::RefCountedThreadSafe<InstalledSubscription>;
   ~InstalledSubscription() override;
@@ -22,39 +22,33 @@
 #include <iterator>
 
 #include "absl/types/optional.h"
+#include "base/containers/flat_set.h"
+#include "base/containers/span.h"
 #include "base/logging.h"
 #include "base/ranges/algorithm.h"
 #include "base/strings/string_piece.h"
 #include "base/strings/string_piece_forward.h"
 #include "base/strings/string_util.h"
+#include "base/timer/elapsed_timer.h"
 #include "base/trace_event/trace_event.h"
 #include "components/adblock/core/common/adblock_constants.h"
 #include "components/adblock/core/common/adblock_utils.h"
 #include "components/adblock/core/common/flatbuffer_data.h"
+#include "components/adblock/core/common/literal_automaton.h"
 #include "components/adblock/core/common/regex_filter_pattern.h"
 #include "components/adblock/core/common/sitekey.h"
 #include "components/adblock/core/subscription/domain_splitter.h"
+#include "components/adblock/core/subscription/filter_match_profiler.h"
+#include "components/adblock/core/subscription/flatbuffer_key_lookup.h"
 #include "components/adblock/core/subscription/pattern_matcher.h"
 #include "components/adblock/core/subscription/regex_matcher.h"
+#include "components/adblock/core/subscription/request_context.h"
 #include "components/adblock/core/subscription/subscription.h"
-#include "components/adblock/core/subscription/url_keyword_extractor.h"
-#include "net/base/registry_controlled_domains/registry_controlled_domain.h"
 #include "url/url_constants.h"
 
 namespace adblock {
 namespace {
 
-bool NeedsLowercasing(const std::string& input) {
-  return base::ranges::any_of(
-      input, [](const char c) { return base::IsAsciiUpper(c); });
-}
-
-bool IsThirdParty(const GURL& url, const std::string& domain) {
-  return !net::registry_controlled_domains::SameDomainOrHost(
-      url, GURL(url.scheme() + "://" + domain),
-      net::registry_controlled_domains::INCLUDE_PRIVATE_REGISTRIES);
-}
-
 bool DomainMatches(base::StringPiece filter_domain,
                    base::StringPiece document_domain) {
   // document_domain is same as filter_domain:
@@ -72,6 +66,10 @@ bool DomainMatches(base::StringPiece filter_domain,
                          "."));
 }
 
+uint32_t ExcludingBegin(const flat::ElemHideFiltersByDomain* category) {
+  return std::min(category->excluding_begin(), category->filter()->size());
+}
+
 bool DomainOnList(
     base::StringPiece document_domain,
     const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>* list) {
@@ -82,6 +80,34 @@ bool DomainOnList(
   });
 }
 
+struct DomainLess {
+  bool operator()(const flatbuffers::String* lhs,
+                  base::StringPiece rhs) const {
+    return base::StringPiece(lhs->c_str(), lhs->size()) < rhs;
+  }
+  bool operator()(base::StringPiece lhs,
+                  const flatbuffers::String* rhs) const {
+    return lhs < base::StringPiece(rhs->c_str(), rhs->size());
+  }
+};
+
+// Equivalent to DomainOnList() for the domain whose suffixes are given.
+// |sorted_list| must be sorted, as the converter does for UrlFilter domains.
+// Costs one binary search per label of the document domain rather than a
+// scan of the whole list.
+bool DomainOnSortedList(
+    const std::vector<base::StringPiece>& document_domain_suffixes,
+    const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>*
+        sorted_list) {
+  return std::any_of(document_domain_suffixes.begin(),
+                     document_domain_suffixes.end(),
+                     [&](base::StringPiece suffix) {
+                       return std::binary_search(sorted_list->begin(),
+                                                 sorted_list->end(), suffix,
+                                                 DomainLess());
+                     });
+}
+
 }  // namespace
 
 InstalledSubscriptionImpl::InstalledSubscriptionImpl(
@@ -94,7 +120,6 @@ InstalledSubscriptionImpl::InstalledSubscriptionImpl(
       regex_matcher_(std::make_unique<RegexMatcher>()) {
   DCHECK(buffer_);
   index_ = flat::GetSubscription(buffer_->data());
-  regex_matcher_->PreBuildRegexPatternsWithNoKeyword(index_);
 }
 
 InstalledSubscriptionImpl::~InstalledSubscriptionImpl() = default;
@@ -131,11 +156,18 @@ bool InstalledSubscriptionImpl::HasUrlFilter(const GURL& url,
                                              ContentType content_type,
                                              const SiteKey& sitekey,
                                              FilterCategory category) const {
+  return HasUrlFilter(UrlContext(url, document_domain, sitekey), content_type,
+                      category);
+}
+
+bool InstalledSubscriptionImpl::HasUrlFilter(const UrlContext& context,
+                                             ContentType content_type,
+                                             FilterCategory category) const {
   return !FindInternal(category != FilterCategory::Allowing
                            ? index_->url_subresource_block()
                            : index_->url_subresource_allow(),
-                       url, content_type, document_domain, sitekey.value(),
-                       category, FindStrategy::FindFirst)
+                       context, content_type, category,
+                       FindStrategy::FindFirst)
               .empty();
 }
 
@@ -144,11 +176,16 @@ bool InstalledSubscriptionImpl::HasPopupFilter(
     const std::string& document_domain,
     const SiteKey& sitekey,
     FilterCategory category) const {
+  return HasPopupFilter(UrlContext(url, document_domain, sitekey), category);
+}
+
+bool InstalledSubscriptionImpl::HasPopupFilter(const UrlContext& context,
+                                               FilterCategory category) const {
   return !FindInternal(category != FilterCategory::Allowing
                            ? index_->url_popup_block()
                            : index_->url_popup_allow(),
-                       url, absl::nullopt, document_domain, sitekey.value(),
-                       category, FindStrategy::FindFirst)
+                       context, absl::nullopt, category,
+                       FindStrategy::FindFirst)
               .empty();
 }
 
@@ -160,8 +197,9 @@ void InstalledSubscriptionImpl::FindCspFilters(
   for (auto* filter : FindInternal(category != FilterCategory::Allowing
                                        ? index_->url_csp_block()
                                        : index_->url_csp_allow(),
-                                   url, absl::nullopt, document_domain, "",
-                                   category, FindStrategy::FindAll)) {
+                                   UrlContext(url, document_domain, SiteKey()),
+                                   absl::nullopt, category,
+                                   FindStrategy::FindAll)) {
     DCHECK(category == FilterCategory::Allowing || filter->csp_filter())
         << "Blocking CSP filter must contain payload";
     results.insert(filter->csp_filter()
@@ -178,8 +216,8 @@ absl::optional<base::StringPiece> InstalledSubscriptionImpl::FindRewriteFilter(
   auto filters = FindInternal(category != FilterCategory::Allowing
                                   ? index_->url_rewrite_block()
                                   : index_->url_rewrite_allow(),
-                              url, absl::nullopt, document_domain, "", category,
-                              FindStrategy::FindFirst);
+                              UrlContext(url, document_domain, SiteKey()),
+                              absl::nullopt, category, FindStrategy::FindFirst);
   if (filters.empty()) {
     return absl::nullopt;
   }
@@ -203,8 +241,9 @@ void InstalledSubscriptionImpl::FindHeaderFilters(
   for (auto* filter : FindInternal(category != FilterCategory::Allowing
                                        ? index_->url_header_block()
                                        : index_->url_header_allow(),
-                                   url, content_type, document_domain, "",
-                                   category, FindStrategy::FindAll)) {
+                                   UrlContext(url, document_domain, SiteKey()),
+                                   content_type, category,
+                                   FindStrategy::FindAll)) {
     DCHECK(category == FilterCategory::Allowing || filter->header_filter())
         << "Blocking header filter must contain header_filter() payload";
     results.insert({base::StringPiece(filter->header_filter()->c_str(),
@@ -218,6 +257,12 @@ bool InstalledSubscriptionImpl::HasSpecialFilter(
     const GURL& url,
     const std::string& document_domain,
     const SiteKey& sitekey) const {
+  return HasSpecialFilter(type, UrlContext(url, document_domain, sitekey));
+}
+
+bool InstalledSubscriptionImpl::HasSpecialFilter(
+    SpecialFilterType type,
+    const UrlContext& context) const {
   const UrlFilterIndex* index = nullptr;
   switch (type) {
     case SpecialFilterType::Document:
@@ -233,15 +278,15 @@ bool InstalledSubscriptionImpl::HasSpecialFilter(
       index = index_->url_generichide_allow();
       break;
   }
-  return !FindInternal(index, url, absl::nullopt, document_domain,
-                       sitekey.value(), FilterCategory::Allowing,
+  return !FindInternal(index, context, absl::nullopt, FilterCategory::Allowing,
                        FindStrategy::FindFirst)
               .empty();
 }
 
 std::vector<base::StringPiece> InstalledSubscriptionImpl::GetSelectorsForDomain(
     const flat::ElemHideFiltersByDomain* category,
-    base::StringPiece domain) const {
+    base::StringPiece domain,
+    DomainAgnosticFilters domain_agnostic) const {
   TRACE_EVENT1("eyeo", "InstalledSubscriptionImpl::GetSelectorsForDomain",
                "domain", domain);
 
@@ -251,7 +296,14 @@ std::vector<base::StringPiece> InstalledSubscriptionImpl::GetSelectorsForDomain(
   }
 
   std::vector<base::StringPiece> selectors;
-  for (auto* filter : *category->filter()) {
+  const auto* filters = category->filter();
+  // In the generic bucket, filters before |excluding_begin| have neither
+  // include nor exclude domains.
+  const uint32_t begin = domain_agnostic == DomainAgnosticFilters::kSkip
+                             ? ExcludingBegin(category)
+                             : 0u;
+  for (uint32_t i = begin; i < filters->size(); ++i) {
+    const auto* filter = filters->Get(i);
     const bool filter_allowed_by_includes =
         // No include domains, filter is generic:
         filter->include_domains()->size() == 0 ||
@@ -281,24 +333,105 @@ InstalledSubscriptionImpl::GetElemhideSelectors(const GURL& url,
   const std::string domain(base::ToLowerASCII(url.host()));
   if (!domain_specific) {
     result.elemhide_selectors =
-        GetSelectorsForDomain(index_->elemhide()->LookupByKey(""), domain);
+        GetGenericSelectors(domain, DomainAgnosticFilters::kInclude);
     result.elemhide_exceptions = GetSelectorsForDomain(
-        index_->elemhide_exception()->LookupByKey(""), domain);
+        LookupByKey(index_->elemhide_exception(), ""), domain);
   }
+  AppendDomainSpecificSelectors(domain, result);
+  return result;
+}
+
+InstalledSubscription::Selectors
+InstalledSubscriptionImpl::GetDomainAgnosticElemhideSelectors() const {
+  Selectors result;
+  const auto collect = [](const flat::ElemHideFiltersByDomain* category,
+                          std::vector<base::StringPiece>& out) {
+    if (!category || !category->filter()) {
+      return;
+    }
+    // The "" bucket only holds filters without include domains, those
+    // without exclude domains come first.
+    const uint32_t end = ExcludingBegin(category);
+    out.reserve(out.size() + end);
+    for (uint32_t i = 0; i < end; ++i) {
+      out.push_back(category->filter()->Get(i)->selector()->c_str());
+    }
+  };
+  collect(LookupByKey(index_->elemhide(), ""), result.elemhide_selectors);
+  collect(LookupByKey(index_->elemhide_exception(), ""),
+          result.elemhide_exceptions);
+  return result;
+}
 
+InstalledSubscription::Selectors
+InstalledSubscriptionImpl::GetDomainDependentElemhideSelectors(
+    const GURL& url) const {
+  Selectors result;
+  const std::string domain(base::ToLowerASCII(url.host()));
+  result.elemhide_selectors =
+      GetGenericSelectors(domain, DomainAgnosticFilters::kSkip);
+  result.elemhide_exceptions =
+      GetSelectorsForDomain(LookupByKey(index_->elemhide_exception(), ""),
+                            domain, DomainAgnosticFilters::kSkip);
+  AppendDomainSpecificSelectors(domain, result);
+  return result;
+}
+
+std::vector<base::StringPiece> InstalledSubscriptionImpl::GetGenericSelectors(
+    base::StringPiece domain,
+    DomainAgnosticFilters domain_agnostic) const {
+  TRACE_EVENT1("eyeo", "InstalledSubscriptionImpl::GetGenericSelectors",
+               "domain", domain);
+  const auto* category = LookupByKey(index_->elemhide(), "");
+  if (!category || !category->filter()) {
+    return {};
+  }
+  // Generic filters that exclude |domain| or one of its parent domains,
+  // rather than a check of every generic filter's exclude domains.
+  std::vector<const flat::ElemHideFilter*> excluded_filters;
+  DomainSplitter domain_splitter(domain);
+  while (auto subdomain = domain_splitter.FindNextSubdomain()) {
+    const auto* exclusions =
+        LookupByKey(index_->elemhide_generic_exclusions(), *subdomain);
+    if (exclusions && exclusions->filter()) {
+      excluded_filters.insert(excluded_filters.end(),
+                              exclusions->filter()->begin(),
+                              exclusions->filter()->end());
+    }
+  }
+  const base::flat_set<const flat::ElemHideFilter*> excluded(
+      std::move(excluded_filters));
+
+  const auto* filters = category->filter();
+  const uint32_t excluding_begin = ExcludingBegin(category);
+  const uint32_t begin =
+      domain_agnostic == DomainAgnosticFilters::kSkip ? excluding_begin : 0u;
+  std::vector<base::StringPiece> selectors;
+  selectors.reserve(filters->size() - begin);
+  for (uint32_t i = begin; i < filters->size(); ++i) {
+    const auto* filter = filters->Get(i);
+    if (i >= excluding_begin && excluded.contains(filter)) {
+      continue;
+    }
+    selectors.push_back(filter->selector()->c_str());
+  }
+  return selectors;
+}
+
+void InstalledSubscriptionImpl::AppendDomainSpecificSelectors(
+    const std::string& domain,
+    Selectors& result) const {
   DomainSplitter domain_splitter(domain);
   while (auto subdomain = domain_splitter.FindNextSubdomain()) {
     auto specific_selectors = GetSelectorsForDomain(
-        index_->elemhide()->LookupByKey(subdomain->data()), domain);
+        LookupByKey(index_->elemhide(), *subdomain), domain);
     std::move(specific_selectors.begin(), specific_selectors.end(),
               std::back_inserter(result.elemhide_selectors));
     auto specific_exceptions = GetSelectorsForDomain(
-        index_->elemhide_exception()->LookupByKey(subdomain->data()), domain);
+        LookupByKey(index_->elemhide_exception(), *subdomain), domain);
     std::move(specific_exceptions.begin(), specific_exceptions.end(),
               std::back_inserter(result.elemhide_exceptions));
   }
-
-  return result;
 }
 
 InstalledSubscription::Selectors
@@ -309,11 +442,11 @@ InstalledSubscriptionImpl::GetElemhideEmulationSelectors(
   DomainSplitter domain_splitter(domain);
   while (auto subdomain = domain_splitter.FindNextSubdomain()) {
     auto elemhide_selectors = GetSelectorsForDomain(
-        index_->elemhide_emulation()->LookupByKey(subdomain->data()), domain);
+        LookupByKey(index_->elemhide_emulation(), *subdomain), domain);
     std::move(elemhide_selectors.begin(), elemhide_selectors.end(),
               std::back_inserter(result.elemhide_selectors));
     auto elemhide_exceptions = GetSelectorsForDomain(
-        index_->elemhide_exception()->LookupByKey(subdomain->data()), domain);
+        LookupByKey(index_->elemhide_exception(), *subdomain), domain);
     std::move(elemhide_exceptions.begin(), elemhide_exceptions.end(),
               std::back_inserter(result.elemhide_exceptions));
   }
@@ -322,89 +455,150 @@ InstalledSubscriptionImpl::GetElemhideEmulationSelectors(
 
 std::vector<const flat::UrlFilter*> InstalledSubscriptionImpl::FindInternal(
     const UrlFilterIndex* index,
-    const GURL& url,
+    const UrlContext& context,
     absl::optional<ContentType> content_type,
-    const std::string& document_domain,
-    const std::string& sitekey,
     FilterCategory category,
     FindStrategy strategy) const {
   if (!index) {
     // No filters of this type were parsed.
     return {};
   }
-  const std::string& normalized_domain =
-      NeedsLowercasing(document_domain) ? base::ToLowerASCII(document_domain)
-                                        : document_domain;
-  const std::string normalized_sitekey = base::ToUpperASCII(sitekey);
-  const GURL& lowercase_url =
-      NeedsLowercasing(url.spec()) ? GURL(base::ToLowerASCII(url.spec())) : url;
-  const bool is_third_party_request = IsThirdParty(url, document_domain);
   std::vector<const flat::UrlFilter*> results;
 
-  UrlKeywordExtractor keyword_extractor(lowercase_url.spec());
-  while (auto current_keyword = keyword_extractor.GetNextKeyword()) {
-    FindFiltersForKeyword(index, *current_keyword, url, lowercase_url,
-                          content_type, normalized_domain, normalized_sitekey,
-                          category, is_third_party_request, strategy, results);
+  for (const auto keyword : context.keywords()) {
+    FindFiltersForKeyword(index, keyword, context, content_type, category,
+                          strategy, results);
     if (strategy == FindStrategy::FindFirst && !results.empty()) {
       return results;
     }
   }
 
-  FindFiltersForKeyword(index, "", url, lowercase_url, content_type,
-                        normalized_domain, normalized_sitekey, category,
-                        is_third_party_request, strategy, results);
+  FindFiltersForKeyword(index, "", context, content_type, category, strategy,
+                        results);
   return results;
 }
 
 void InstalledSubscriptionImpl::FindFiltersForKeyword(
     const UrlFilterIndex* index,
     base::StringPiece keyword,
-    const GURL& url,
-    const GURL& lowercase_url,
+    const UrlContext& context,
     absl::optional<ContentType> content_type,
-    const std::string& document_domain,
-    const std::string& sitekey,
     FilterCategory category,
-    bool is_third_party_request,
     FindStrategy strategy,
     std::vector<const flat::UrlFilter*>& out_results) const {
-  const auto* idx = index->LookupByKey(keyword.data());
+  const auto* idx = LookupByKey(index, keyword);
 
   if (!idx) {
     return;
   }
 
-  for (const auto* filter : *(idx->filter())) {
-    if (!CandidateFilterViable(filter, content_type, document_domain, sitekey,
-                               category, is_third_party_request)) {
-      continue;
-    }
+  FindFiltersInBucket(idx, context, content_type, category, strategy,
+                      out_results);
+}
 
-    if (filter->pattern()->size() == 0u) {
-      // This filter applies to all URLs, assuming prior checks passed.
-      out_results.push_back(filter);
-      if (strategy == FindStrategy::FindFirst) {
-        return;
-      }
+void InstalledSubscriptionImpl::FindFiltersInBucket(
+    const flat::UrlFiltersByKeyword* bucket,
+    const UrlContext& context,
+    absl::optional<ContentType> content_type,
+    FilterCategory category,
+    FindStrategy strategy,
+    std::vector<const flat::UrlFilter*>& out_results) const {
+  // With $genericblock, only the domain-specific filters at the start of the
+  // bucket are searched. Buckets in conversion order are not split, their
+  // filters are checked one by one.
+  const bool domain_specific =
+      category == FilterCategory::DomainSpecificBlocking;
+  const bool domain_specific_only =
+      domain_specific && !bucket->conversion_order();
+  const uint32_t resource_type = domain_specific
+                                     ? bucket->domain_specific_resource_type()
+                                     : bucket->resource_type();
+  if (content_type && (resource_type & *content_type) == 0) {
+    // None of the searched filters applies to this content type.
+    return;
+  }
+  if (domain_specific_only && bucket->generic_begin() == 0u) {
+    return;
+  }
+  const auto* filters = bucket->filter();
+  // Regex filters of the bucket are matched together, the first time one of
+  // them passes the cheaper checks.
+  absl::optional<std::vector<uint32_t>> matching_regex_filters;
+  const auto matches = [&](uint32_t position) {
+    const auto* filter = filters->Get(position);
+    // Filters are known to be domain-specific by their position, the generic
+    // check of FilterCategory::DomainSpecificBlocking is redundant.
+    if (!CandidateFilterViable(
+            filter, context, content_type,
+            domain_specific_only ? FilterCategory::Blocking : category)) {
+      return false;
+    }
+    if (!IsRegexFilter(filter)) {
+      return MatchesPattern(filter, context);
     }
-    // During flatbuffer conversion, the pattern is lowercased for
-    // case-insensitive filters, and left in original form for case-sensitive
-    // filters.
-    const base::StringPiece pattern(filter->pattern()->c_str(),
-                                    filter->pattern()->size());
-    if (const auto regex_pattern = ExtractRegexFilterFromPattern(pattern)) {
-      if (regex_matcher_->MatchesRegex(*regex_pattern, url,
-                                       filter->match_case())) {
-        out_results.push_back(filter);
+    if (!matching_regex_filters) {
+      matching_regex_filters =
+          regex_matcher_->FindMatchingRegexFilters(bucket, context.url());
+    }
+    return std::binary_search(matching_regex_filters->begin(),
+                              matching_regex_filters->end(), position);
+  };
+  // With profiling enabled, every filter evaluation is timed and accounted to
+  // this bucket. The first regex filter evaluated is also charged for
+  // matching all regex filters of the bucket in one batch.
+  auto* profiler = FilterMatchProfiler::GetInstance();
+  absl::optional<std::string> profiled_subscription;
+  const base::StringPiece keyword = KeyOf(bucket);
+  if (profiler->IsEnabled()) {
+    profiled_subscription = GetSourceUrl().spec();
+    profiler->RecordBucketVisit(*profiled_subscription, keyword,
+                                filters->size());
+  }
+  const auto evaluate = [&](uint32_t position) {
+    if (!profiled_subscription) {
+      return matches(position);
+    }
+    const auto* pattern = filters->Get(position)->pattern();
+    base::ElapsedTimer timer;
+    const bool matched = matches(position);
+    profiler->RecordFilterEvaluation(
+        *profiled_subscription, keyword,
+        base::StringPiece(pattern->c_str(), pattern->size()), matched,
+        timer.Elapsed());
+    return matched;
+  };
+
+  if (const auto* automaton = bucket->literal_automaton()) {
+    for (const uint32_t position : FindLiteralAutomatonCandidates(
+             *automaton, context.lowercase_url().spec())) {
+      if (domain_specific_only && position >= bucket->generic_begin()) {
+        // Candidates are sorted, only generic filters follow.
+        break;
+      }
+      if (evaluate(position)) {
+        out_results.push_back(filters->Get(position));
         if (strategy == FindStrategy::FindFirst) {
           return;
         }
       }
-    } else {
-      const auto& normalized_url = filter->match_case() ? url : lowercase_url;
-      if (DoesPatternMatchUrl(pattern, normalized_url)) {
-        out_results.push_back(filter);
+    }
+    return;
+  }
+
+  // Filters are partitioned by resource types, slices for other content types
+  // are skipped as a whole.
+  for (const auto* slice : *bucket->content_type_slices()) {
+    if (domain_specific_only && slice->begin() >= bucket->generic_begin()) {
+      // Only generic filters follow.
+      break;
+    }
+    if (content_type && (slice->resource_type() & *content_type) == 0) {
+      continue;
+    }
+    for (uint32_t position = slice->begin(); position < slice->end();
+         ++position) {
+      if (evaluate(position)) {
+        out_results.push_back(filters->Get(position));
         if (strategy == FindStrategy::FindFirst) {
           return;
         }
@@ -413,13 +607,68 @@ void InstalledSubscriptionImpl::FindFiltersForKeyword(
   }
 }
 
+bool InstalledSubscriptionImpl::HasMatchingFilterInBucket(
+    const flat::UrlFiltersByKeyword* bucket,
+    const UrlContext& context,
+    absl::optional<ContentType> content_type,
+    FilterCategory category) const {
+  std::vector<const flat::UrlFilter*> results;
+  FindFiltersInBucket(bucket, context, content_type, category,
+                      FindStrategy::FindFirst, results);
+  return !results.empty();
+}
+
+bool InstalledSubscriptionImpl::MatchesFilter(
+    const flat::UrlFilter* filter,
+    const UrlContext& context,
+    absl::optional<ContentType> content_type,
+    FilterCategory category) const {
+  return CandidateFilterViable(filter, context, content_type, category) &&
+         MatchesPattern(filter, context);
+}
+
+bool InstalledSubscriptionImpl::IsRegexFilter(
+    const flat::UrlFilter* filter) const {
+  const base::StringPiece pattern(filter->pattern()->c_str(),
+                                  filter->pattern()->size());
+  return ExtractRegexFilterFromPattern(pattern).has_value();
+}
+
+bool InstalledSubscriptionImpl::MatchesPattern(
+    const flat::UrlFilter* filter,
+    const UrlContext& context) const {
+  if (filter->pattern()->size() == 0u) {
+    // This filter applies to all URLs, assuming prior checks passed.
+    return true;
+  }
+  // During flatbuffer conversion, the pattern is lowercased for
+  // case-insensitive filters, and left in original form for case-sensitive
+  // filters.
+  const base::StringPiece pattern(filter->pattern()->c_str(),
+                                  filter->pattern()->size());
+  if (const auto regex_pattern = ExtractRegexFilterFromPattern(pattern)) {
+    return regex_matcher_->MatchesRegex(*regex_pattern, context.url(),
+                                        filter->match_case());
+  }
+  const GURL& url =
+      filter->match_case() ? context.url() : context.lowercase_url();
+  if (const auto* program = filter->pattern_program()) {
+    // Vectors of structs are stored inline, the instructions are contiguous.
+    return DoesPatternProgramMatchUrl(
+        pattern,
+        base::make_span(
+            reinterpret_cast<const flat::PatternInstruction*>(program->Data()),
+            program->size()),
+        url);
+  }
+  return DoesPatternMatchUrl(pattern, url);
+}
+
 bool InstalledSubscriptionImpl::CandidateFilterViable(
     const flat::UrlFilter* candidate,
+    const UrlContext& context,
     absl::optional<ContentType> content_type,
-    const std::string& document_domain,
-    const std::string& sitekey,
-    FilterCategory category,
-    bool is_third_party_request) const {
+    FilterCategory category) const {
   if (content_type && (candidate->resource_type() & *content_type) == 0) {
     return false;
   }
@@ -427,10 +676,10 @@ bool InstalledSubscriptionImpl::CandidateFilterViable(
       IsGenericFilter(candidate)) {
     return false;
   }
-  if (!CheckThirdParty(candidate, is_third_party_request)) {
+  if (!CheckThirdParty(candidate, context.is_third_party())) {
     return false;
   }
-  if (!IsActiveOnDomain(candidate, document_domain, sitekey)) {
+  if (!IsActiveOnDomain(candidate, context)) {
     return false;
   }
   return true;
@@ -467,12 +716,12 @@ bool InstalledSubscriptionImpl::IsGenericFilter(
 
 bool InstalledSubscriptionImpl::IsActiveOnDomain(
     const flat::UrlFilter* filter,
-    const std::string& document_domain,
-    const std::string& sitekey) const {
+    const UrlContext& context) const {
   const auto* sitekeys = filter->sitekeys();
   DCHECK(sitekeys);
 
   if (sitekeys->size() != 0u) {
+    const std::string& sitekey = context.normalized_sitekey();
     if (std::none_of(
             sitekeys->begin(), sitekeys->end(),
             [&sitekey](const auto* it) { return it->c_str() == sitekey; })) {
@@ -483,7 +732,19 @@ bool InstalledSubscriptionImpl::IsActiveOnDomain(
 
   const auto* include_domains = filter->include_domains();
   const auto* exclude_domains = filter->exclude_domains();
-  return IsActiveOnDomain(document_domain, include_domains, exclude_domains);
+  if (IsEmptyDomainAllowed(include_domains, exclude_domains)) {
+    return true;
+  }
+  // Same logic as IsActiveOnDomain() for snippets below, with the document
+  // domain's suffixes precomputed once per request.
+  const auto& suffixes = context.document_domain_suffixes();
+  if (exclude_domains && DomainOnSortedList(suffixes, exclude_domains)) {
+    return false;
+  }
+  if (include_domains && include_domains->size()) {
+    return DomainOnSortedList(suffixes, include_domains);
+  }
+  return true;
 }
 
 bool InstalledSubscriptionImpl::IsActiveOnDomain(
@@ -534,7 +795,7 @@ InstalledSubscriptionImpl::MatchSnippets(
 
   DomainSplitter domain_splitter(document_domain);
   while (auto subdomain = domain_splitter.FindNextSubdomain()) {
-    const auto* idx = index_->snippet()->LookupByKey(subdomain->data());
+    const auto* idx = LookupByKey(index_->snippet(), *subdomain);
 
     if (!idx) {
       continue;
@@ -566,4 +827,9 @@ void InstalledSubscriptionImpl::MarkForPermanentRemoval() {
   buffer_->PermanentlyRemoveSourceOnDestruction();
 }
 
+const InstalledSubscriptionImpl*
+InstalledSubscriptionImpl::AsInstalledSubscriptionImpl() const {
+  return this;
+}
+
 }  // namespace adblock
@@ -60,6 +60,13 @@ class InstalledSubscriptionImpl final : public InstalledSubscription {
                         const GURL& url,
                         const std::string& document_domain,
                         const SiteKey& sitekey) const final;
+  bool HasUrlFilter(const UrlContext& context,
+                    ContentType content_type,
+                    FilterCategory category) const final;
+  bool HasPopupFilter(const UrlContext& context,
+                      FilterCategory category) const final;
+  bool HasSpecialFilter(SpecialFilterType type,
+                        const UrlContext& context) const final;
   void FindCspFilters(const GURL& url,
                       const std::string& document_domain,
                       FilterCategory category,
@@ -76,6 +83,8 @@ class InstalledSubscriptionImpl final : public InstalledSubscription {
 
   Selectors GetElemhideSelectors(const GURL& url,
                                  bool domain_specific) const final;
+  Selectors GetDomainAgnosticElemhideSelectors() const final;
+  Selectors GetDomainDependentElemhideSelectors(const GURL& url) const final;
   Selectors GetElemhideEmulationSelectors(const GURL& url) const final;
 
   std::vector<Snippet> MatchSnippets(
@@ -83,6 +92,25 @@ class InstalledSubscriptionImpl final : public InstalledSubscription {
 
   void MarkForPermanentRemoval() final;
 
+  const InstalledSubscriptionImpl* AsInstalledSubscriptionImpl() const final;
+
+  // Direct access to the flatbuffer, valid for the lifetime of this object.
+  const flat::Subscription* GetFlatbuffer() const { return index_; }
+
+  // Returns whether |filter|, which must come from this subscription's
+  // flatbuffer, applies to the URL described by |context|.
+  bool MatchesFilter(const flat::UrlFilter* filter,
+                     const UrlContext& context,
+                     absl::optional<ContentType> content_type,
+                     FilterCategory category) const;
+
+  // Returns whether any filter of |bucket|, which must come from this
+  // subscription's flatbuffer, applies to the URL described by |context|.
+  bool HasMatchingFilterInBucket(const flat::UrlFiltersByKeyword* bucket,
+                                 const UrlContext& context,
+                                 absl::optional<ContentType> content_type,
+                                 FilterCategory category) const;
+
  private:
   friend class base::RefCountedThreadSafe<InstalledSubscriptionImpl>;
   ~InstalledSubscriptionImpl() final;
@@ -98,44 +126,60 @@ class InstalledSubscriptionImpl final : public InstalledSubscription {
   // Finds all filters in category that matchers the remaining parameters.
   std::vector<const flat::UrlFilter*> FindInternal(
       const UrlFilterIndex* index,
-      const GURL& url,
+      const UrlContext& context,
       absl::optional<ContentType> content_type,
-      const std::string& document_domain,
-      const std::string& sitekey,
       FilterCategory category,
       FindStrategy strategy) const;
   void FindFiltersForKeyword(
       const UrlFilterIndex* index,
       base::StringPiece keyword,
-      const GURL& url,
-      const GURL& lowercase_url,
+      const UrlContext& context,
+      absl::optional<ContentType> content_type,
+      FilterCategory category,
+      FindStrategy strategy,
+      std::vector<const flat::UrlFilter*>& out_results) const;
+  // The keyword-less bucket carries a literal automaton, which restricts the
+  // search to filters whose required literal occurs in the URL. Regex filters
+  // are matched in one batch per bucket, see RegexMatcher. Evaluations are
+  // accounted by FilterMatchProfiler when it is enabled.
+  void FindFiltersInBucket(
+      const flat::UrlFiltersByKeyword* bucket,
+      const UrlContext& context,
       absl::optional<ContentType> content_type,
-      const std::string& document_domain,
-      const std::string& sitekey,
       FilterCategory category,
-      bool is_third_party_request,
       FindStrategy strategy,
       std::vector<const flat::UrlFilter*>& out_results) const;
   bool CandidateFilterViable(const flat::UrlFilter* candidate,
+                             const UrlContext& context,
                              absl::optional<ContentType> content_type,
-                             const std::string& document_domain,
-                             const std::string& sitekey,
-                             FilterCategory category,
-                             bool is_third_party_request) const;
+                             FilterCategory category) const;
+  bool IsRegexFilter(const flat::UrlFilter* filter) const;
+  // Matches the URL against the pattern of |filter| only, regex patterns one
+  // at a time.
+  bool MatchesPattern(const flat::UrlFilter* filter,
+                      const UrlContext& context) const;
   bool IsGenericFilter(const flat::UrlFilter* filter) const;
   bool CheckThirdParty(const flat::UrlFilter* filter,
                        bool is_third_party_request) const;
   bool IsActiveOnDomain(const flat::UrlFilter* filter,
-                        const std::string& document_domain,
-                        const std::string& sitekey) const;
+                        const UrlContext& context) const;
   bool IsActiveOnDomain(const std::string& document_domain,
                         const Domains* include_domains,
                         const Domains* exclude_domains) const;
   bool IsEmptyDomainAllowed(const Domains* include_domains,
                             const Domains* exclude_domains) const;
+  enum class DomainAgnosticFilters { kInclude, kSkip };
   std::vector<base::StringPiece> GetSelectorsForDomain(
       const flat::ElemHideFiltersByDomain* category,
-      base::StringPiece domain) const;
+      base::StringPiece domain,
+      DomainAgnosticFilters domain_agnostic =
+          DomainAgnosticFilters::kInclude) const;
+  // Selectors of the generic ("") elemhide bucket that apply on |domain|.
+  std::vector<base::StringPiece> GetGenericSelectors(
+      base::StringPiece domain,
+      DomainAgnosticFilters domain_agnostic) const;
+  void AppendDomainSpecificSelectors(const std::string& domain,
+                                     Selectors& result) const;
 
   const std::unique_ptr<FlatbufferData> buffer_;
   const InstallationState installation_state_;
@@ -0,0 +1,365 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/merged_url_filter_index.h"
+
+#include <iterator>
+#include <map>
+#include <utility>
+
+#include "base/check_op.h"
+#include "base/ranges/algorithm.h"
+#include "base/trace_event/trace_event.h"
+#include "components/adblock/core/subscription/flatbuffer_key_lookup.h"
+
+namespace adblock {
+namespace {
+
+using UrlFilterIndex =
+    flatbuffers::Vector<flatbuffers::Offset<flat::UrlFiltersByKeyword>>;
+
+}  // namespace
+
+// static
+scoped_refptr<MergedUrlFilterIndex> MergedUrlFilterIndex::Build(
+    std::vector<scoped_refptr<InstalledSubscription>> subscriptions) {
+  TRACE_EVENT1("eyeo", "MergedUrlFilterIndex::Build", "subscriptions",
+               subscriptions.size());
+  if (base::ranges::any_of(subscriptions, [](const auto& subscription) {
+        return !subscription->AsInstalledSubscriptionImpl();
+      })) {
+    return nullptr;
+  }
+  return base::WrapRefCounted(
+      new MergedUrlFilterIndex(std::move(subscriptions)));
+}
+
+MergedUrlFilterIndex::MergedUrlFilterIndex(
+    std::vector<scoped_refptr<InstalledSubscription>> subscriptions)
+    : subscriptions_(std::move(subscriptions)) {
+  constexpr size_t kIndexCount = static_cast<size_t>(IndexType::kMaxValue) + 1;
+  std::array<std::map<base::StringPiece, Bucket>, kIndexCount> builders;
+  flatbuffer_subscriptions_.reserve(subscriptions_.size());
+  for (uint32_t i = 0; i < subscriptions_.size(); ++i) {
+    const auto* subscription = subscriptions_[i]->AsInstalledSubscriptionImpl();
+    DCHECK(subscription);
+    flatbuffer_subscriptions_.push_back(subscription);
+    const flat::Subscription* flatbuffer = subscription->GetFlatbuffer();
+    // Order must match IndexType.
+    const std::array<const UrlFilterIndex*, kIndexCount> sources = {
+        flatbuffer->url_subresource_block(),
+        flatbuffer->url_subresource_allow(),
+        flatbuffer->url_popup_block(),
+        flatbuffer->url_popup_allow(),
+        flatbuffer->url_document_allow(),
+        flatbuffer->url_elemhide_allow(),
+        flatbuffer->url_genericblock_allow(),
+        flatbuffer->url_generichide_allow(),
+    };
+    for (size_t type = 0; type < kIndexCount; ++type) {
+      unkeyed_buckets_[type].push_back(LookupByKey(sources[type], ""));
+      if (!sources[type]) {
+        continue;
+      }
+      for (const auto* keyword_bucket : *sources[type]) {
+        if (keyword_bucket->keyword()->size() == 0u) {
+          // Searched per subscription, see |unkeyed_buckets_|.
+          continue;
+        }
+        auto& bucket = builders[type][KeyOf(keyword_bucket)];
+        bucket.resource_type |= keyword_bucket->resource_type();
+        bucket.domain_specific_resource_type |=
+            keyword_bucket->domain_specific_resource_type();
+        const auto* filters = keyword_bucket->filter();
+        for (uint32_t position = 0; position < filters->size(); ++position) {
+          const auto* filter = filters->Get(position);
+          (position < keyword_bucket->generic_begin()
+               ? bucket.domain_specific_entries
+               : bucket.generic_entries)
+              .push_back({i, filter->resource_type(), filter});
+        }
+      }
+    }
+  }
+  for (size_t type = 0; type < kIndexCount; ++type) {
+    // std::map is already sorted by keyword, no need for flat_map to re-sort.
+    indexes_[type] = Index(
+        base::sorted_unique,
+        Index::container_type(std::make_move_iterator(builders[type].begin()),
+                              std::make_move_iterator(builders[type].end())));
+  }
+}
+
+MergedUrlFilterIndex::~MergedUrlFilterIndex() = default;
+
+MergedUrlFilterIndex::Bucket::Bucket() = default;
+MergedUrlFilterIndex::Bucket::Bucket(Bucket&&) = default;
+MergedUrlFilterIndex::Bucket& MergedUrlFilterIndex::Bucket::operator=(
+    Bucket&&) = default;
+MergedUrlFilterIndex::Bucket::~Bucket() = default;
+
+bool MergedUrlFilterIndex::IsBuiltFrom(
+    const std::vector<scoped_refptr<InstalledSubscription>>& subscriptions)
+    const {
+  return subscriptions_ == subscriptions;
+}
+
+absl::optional<size_t> MergedUrlFilterIndex::FindUrlFilter(
+    const UrlContext& context,
+    ContentType content_type,
+    FilterCategory category) const {
+  return FindFirst(category != FilterCategory::Allowing
+                       ? IndexType::SubresourceBlock
+                       : IndexType::SubresourceAllow,
+                   context, content_type, category);
+}
+
+absl::optional<size_t> MergedUrlFilterIndex::FindPopupFilter(
+    const UrlContext& context,
+    FilterCategory category) const {
+  return FindFirst(category != FilterCategory::Allowing
+                       ? IndexType::PopupBlock
+                       : IndexType::PopupAllow,
+                   context, absl::nullopt, category);
+}
+
+absl::optional<size_t> MergedUrlFilterIndex::FindSpecialFilter(
+    SpecialFilterType type,
+    const UrlContext& context) const {
+  IndexType index_type = IndexType::DocumentAllow;
+  switch (type) {
+    case SpecialFilterType::Document:
+      index_type = IndexType::DocumentAllow;
+      break;
+    case SpecialFilterType::Elemhide:
+      index_type = IndexType::ElemhideAllow;
+      break;
+    case SpecialFilterType::Genericblock:
+      index_type = IndexType::GenericblockAllow;
+      break;
+    case SpecialFilterType::Generichide:
+      index_type = IndexType::GenerichideAllow;
+      break;
+  }
+  return FindFirst(index_type, context, absl::nullopt,
+                   FilterCategory::Allowing);
+}
+
+MergedUrlFilterIndex::SubresourceQuery MergedUrlFilterIndex::QuerySubresource(
+    const UrlContext& context,
+    ContentType content_type) const {
+  return SubresourceQuery(*this, context, content_type);
+}
+
+MergedUrlFilterIndex::GroupMask MergedUrlFilterIndex::FindBlockingGroups(
+    const UrlContext& context,
+    ContentType content_type,
+    const std::vector<GroupMask>& subscription_groups) const {
+  DCHECK_EQ(subscription_groups.size(), subscriptions_.size());
+  GroupMask all_groups;
+  for (const auto& groups : subscription_groups) {
+    all_groups |= groups;
+  }
+  GroupMask found;
+  const auto search_entries = [&](const std::vector<Entry>& entries) {
+    for (const Entry& entry : entries) {
+      const GroupMask& groups = subscription_groups[entry.subscription_index];
+      if ((groups & ~found).none()) {
+        // Every group of this subscription already has a verdict.
+        continue;
+      }
+      if ((entry.resource_type & content_type) == 0) {
+        continue;
+      }
+      if (flatbuffer_subscriptions_[entry.subscription_index]->MatchesFilter(
+              entry.filter, context, content_type, FilterCategory::Blocking)) {
+        found |= groups;
+      }
+    }
+  };
+
+  for (const Bucket* bucket :
+       FindBuckets(IndexType::SubresourceBlock, context)) {
+    if ((bucket->resource_type & content_type) == 0) {
+      continue;
+    }
+    search_entries(bucket->domain_specific_entries);
+    search_entries(bucket->generic_entries);
+    if (found == all_groups) {
+      return found;
+    }
+  }
+
+  const auto& unkeyed_buckets =
+      unkeyed_buckets_[static_cast<size_t>(IndexType::SubresourceBlock)];
+  for (size_t i = 0; i < unkeyed_buckets.size(); ++i) {
+    if (unkeyed_buckets[i] && (subscription_groups[i] & ~found).any() &&
+        flatbuffer_subscriptions_[i]->HasMatchingFilterInBucket(
+            unkeyed_buckets[i], context, content_type,
+            FilterCategory::Blocking)) {
+      found |= subscription_groups[i];
+    }
+  }
+  return found;
+}
+
+absl::optional<size_t> MergedUrlFilterIndex::FindFirst(
+    IndexType type,
+    const UrlContext& context,
+    absl::optional<ContentType> content_type,
+    FilterCategory category) const {
+  return FindFirstInBuckets(type, FindBuckets(type, context), context,
+                            content_type, category);
+}
+
+MergedUrlFilterIndex::BucketList MergedUrlFilterIndex::FindBuckets(
+    IndexType type,
+    const UrlContext& context) const {
+  const Index& index = indexes_[static_cast<size_t>(type)];
+  BucketList buckets;
+  if (index.empty()) {
+    return buckets;
+  }
+  for (const auto keyword : context.keywords()) {
+    const auto it = index.find(keyword);
+    if (it != index.end()) {
+      buckets.push_back(&it->second);
+    }
+  }
+  return buckets;
+}
+
+absl::optional<size_t> MergedUrlFilterIndex::FindFirstInBuckets(
+    IndexType type,
+    const BucketList& buckets,
+    const UrlContext& context,
+    absl::optional<ContentType> content_type,
+    FilterCategory category) const {
+  absl::optional<size_t> first_match;
+  const bool domain_specific_only =
+      category == FilterCategory::DomainSpecificBlocking;
+  // Entries come from one part of a bucket, so the generic check of
+  // FilterCategory::DomainSpecificBlocking is never needed.
+  const FilterCategory entry_category =
+      domain_specific_only ? FilterCategory::Blocking : category;
+  const auto search_entries = [&](const std::vector<Entry>& entries) {
+    for (const Entry& entry : entries) {
+      if (first_match && entry.subscription_index >= *first_match) {
+        // Remaining entries come from subscriptions that are no better than
+        // the one already found.
+        return;
+      }
+      if (content_type && (entry.resource_type & *content_type) == 0) {
+        continue;
+      }
+      if (flatbuffer_subscriptions_[entry.subscription_index]->MatchesFilter(
+              entry.filter, context, content_type, entry_category)) {
+        first_match = entry.subscription_index;
+        return;
+      }
+    }
+  };
+
+  for (const Bucket* bucket : buckets) {
+    const uint32_t resource_type = domain_specific_only
+                                       ? bucket->domain_specific_resource_type
+                                       : bucket->resource_type;
+    if (content_type && (resource_type & *content_type) == 0) {
+      continue;
+    }
+    search_entries(bucket->domain_specific_entries);
+    if (!domain_specific_only) {
+      search_entries(bucket->generic_entries);
+    }
+    if (first_match == 0u) {
+      // Nothing can precede the first subscription.
+      return first_match;
+    }
+  }
+
+  // Only subscriptions preceding the current best match are worth searching.
+  const auto& unkeyed_buckets = unkeyed_buckets_[static_cast<size_t>(type)];
+  const size_t end = first_match.value_or(unkeyed_buckets.size());
+  for (size_t i = 0; i < end; ++i) {
+    if (unkeyed_buckets[i] &&
+        flatbuffer_subscriptions_[i]->HasMatchingFilterInBucket(
+            unkeyed_buckets[i], context, content_type, category)) {
+      return i;
+    }
+  }
+  return first_match;
+}
+
+MergedUrlFilterIndex::SubresourceQuery::SubresourceQuery(
+    const MergedUrlFilterIndex& index,
+    const UrlContext& context,
+    ContentType content_type)
+    : index_(index), context_(context), content_type_(content_type) {
+  const Index& block_index =
+      index_.indexes_[static_cast<size_t>(IndexType::SubresourceBlock)];
+  const Index& allow_index =
+      index_.indexes_[static_cast<size_t>(IndexType::SubresourceAllow)];
+  const Index& genericblock_index =
+      index_.indexes_[static_cast<size_t>(IndexType::GenericblockAllow)];
+  // One walk over the keywords for all three indexes.
+  const auto add_bucket = [](const Index& index, base::StringPiece keyword,
+                             BucketList& buckets) {
+    const auto it = index.find(keyword);
+    if (it != index.end()) {
+      buckets.push_back(&it->second);
+    }
+  };
+  for (const auto keyword : context_.keywords()) {
+    add_bucket(block_index, keyword, block_buckets_);
+    add_bucket(allow_index, keyword, allow_buckets_);
+    add_bucket(genericblock_index, keyword, genericblock_buckets_);
+  }
+}
+
+MergedUrlFilterIndex::SubresourceQuery::SubresourceQuery(SubresourceQuery&&) =
+    default;
+MergedUrlFilterIndex::SubresourceQuery::~SubresourceQuery() = default;
+
+absl::optional<size_t> MergedUrlFilterIndex::SubresourceQuery::FindBlocking()
+    const {
+  return index_.FindFirstInBuckets(IndexType::SubresourceBlock, block_buckets_,
+                                   context_, content_type_,
+                                   FilterCategory::Blocking);
+}
+
+absl::optional<size_t>
+MergedUrlFilterIndex::SubresourceQuery::FindDomainSpecificBlocking() const {
+  return index_.FindFirstInBuckets(IndexType::SubresourceBlock, block_buckets_,
+                                   context_, content_type_,
+                                   FilterCategory::DomainSpecificBlocking);
+}
+
+absl::optional<size_t> MergedUrlFilterIndex::SubresourceQuery::FindAllowing()
+    const {
+  return index_.FindFirstInBuckets(IndexType::SubresourceAllow, allow_buckets_,
+                                   context_, content_type_,
+                                   FilterCategory::Allowing);
+}
+
+absl::optional<size_t>
+MergedUrlFilterIndex::SubresourceQuery::FindGenericblock() const {
+  return index_.FindFirstInBuckets(IndexType::GenericblockAllow,
+                                   genericblock_buckets_, context_,
+                                   absl::nullopt, FilterCategory::Allowing);
+}
+
+}  // namespace adblock
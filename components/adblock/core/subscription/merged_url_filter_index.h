@@ -0,0 +1,195 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_MERGED_URL_FILTER_INDEX_H_
+#define COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_MERGED_URL_FILTER_INDEX_H_
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+#include "absl/types/optional.h"
+#include "base/containers/flat_map.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/string_piece.h"
+#include "components/adblock/core/common/content_type.h"
+#include "components/adblock/core/schema/filter_list_schema_generated.h"
+#include "components/adblock/core/subscription/installed_subscription.h"
+#include "components/adblock/core/subscription/installed_subscription_impl.h"
+#include "components/adblock/core/subscription/request_context.h"
+
+namespace adblock {
+
+// Combines the keyword-indexed URL filters of all subscriptions of a
+// SubscriptionCollection into a single index. A request is then tokenized
+// once and each of its keywords is looked up once, instead of once per
+// subscription.
+// Every entry remembers the subscription it came from, so a match can still
+// be attributed to the first matching subscription, in collection order,
+// exactly like a sequential search through the subscriptions would.
+// Only the categories queried on every request are merged: subresource,
+// popup and special (allowlisting) filters.
+// Immutable once built, can be shared between sequences.
+class MergedUrlFilterIndex final
+    : public base::RefCountedThreadSafe<MergedUrlFilterIndex> {
+ public:
+  // Builds an index of |subscriptions|. Returns nullptr if any of them is not
+  // backed by a flatbuffer, callers should then query subscriptions
+  // individually. Expensive, should not be called on the UI thread.
+  static scoped_refptr<MergedUrlFilterIndex> Build(
+      std::vector<scoped_refptr<InstalledSubscription>> subscriptions);
+
+  // Returns whether this index was built from exactly |subscriptions|, in the
+  // same order.
+  bool IsBuiltFrom(const std::vector<scoped_refptr<InstalledSubscription>>&
+                       subscriptions) const;
+
+  // The Find* methods mirror InstalledSubscription::Has*Filter. They return
+  // the position, within the subscriptions this index was built from, of the
+  // first subscription that contains a matching filter.
+  absl::optional<size_t> FindUrlFilter(const UrlContext& context,
+                                       ContentType content_type,
+                                       FilterCategory category) const;
+  absl::optional<size_t> FindPopupFilter(const UrlContext& context,
+                                         FilterCategory category) const;
+  absl::optional<size_t> FindSpecialFilter(SpecialFilterType type,
+                                           const UrlContext& context) const;
+
+  // Bit i stands for the i-th of several groups of subscriptions, see
+  // FindBlockingGroups().
+  using GroupMask = std::bitset<32>;
+  // Searches the subresource blocking filters of all groups in one walk over
+  // the keyword buckets. |subscription_groups| holds, for each subscription
+  // this index was built from, the groups it belongs to. Returns the groups
+  // with at least one subscription that contains a matching filter. Filters
+  // are not matched for subscriptions whose groups already have a match.
+  GroupMask FindBlockingGroups(
+      const UrlContext& context,
+      ContentType content_type,
+      const std::vector<GroupMask>& subscription_groups) const;
+
+  class SubresourceQuery;
+  // Looks up the keywords of |context| once in all indexes needed to classify
+  // a subresource request. The returned query must not outlive this index or
+  // |context|.
+  SubresourceQuery QuerySubresource(const UrlContext& context,
+                                    ContentType content_type) const;
+
+ private:
+  friend class base::RefCountedThreadSafe<MergedUrlFilterIndex>;
+  enum class IndexType {
+    SubresourceBlock,
+    SubresourceAllow,
+    PopupBlock,
+    PopupAllow,
+    DocumentAllow,
+    ElemhideAllow,
+    GenericblockAllow,
+    GenerichideAllow,
+    kMaxValue = GenerichideAllow,
+  };
+  struct Entry {
+    uint32_t subscription_index;
+    // Copy of |filter|'s resource_type, checked without touching the
+    // flatbuffer.
+    uint32_t resource_type;
+    const flat::UrlFilter* filter;
+  };
+  struct Bucket {
+    Bucket();
+    Bucket(Bucket&&);
+    Bucket& operator=(Bucket&&);
+    ~Bucket();
+
+    // Unions of the resource types of all entries and of the domain-specific
+    // ones.
+    uint32_t resource_type = 0u;
+    uint32_t domain_specific_resource_type = 0u;
+    // Both ordered by |subscription_index|. Only the domain-specific entries
+    // are searched on pages with $genericblock.
+    std::vector<Entry> domain_specific_entries;
+    std::vector<Entry> generic_entries;
+  };
+  // Keys point into the flatbuffers of |subscriptions_|.
+  using Index = base::flat_map<base::StringPiece, Bucket>;
+  // Buckets of one index selected by the keywords of a URL, in keyword order.
+  using BucketList = std::vector<const Bucket*>;
+
+  explicit MergedUrlFilterIndex(
+      std::vector<scoped_refptr<InstalledSubscription>> subscriptions);
+  ~MergedUrlFilterIndex();
+
+  absl::optional<size_t> FindFirst(IndexType type,
+                                   const UrlContext& context,
+                                   absl::optional<ContentType> content_type,
+                                   FilterCategory category) const;
+  BucketList FindBuckets(IndexType type, const UrlContext& context) const;
+  // Searches |buckets|, which must come from the index of |type|, then the
+  // keyword-less buckets of that type.
+  absl::optional<size_t> FindFirstInBuckets(
+      IndexType type,
+      const BucketList& buckets,
+      const UrlContext& context,
+      absl::optional<ContentType> content_type,
+      FilterCategory category) const;
+
+  // Keeps the flatbuffers referenced by |indexes_| alive.
+  const std::vector<scoped_refptr<InstalledSubscription>> subscriptions_;
+  std::vector<const InstalledSubscriptionImpl*> flatbuffer_subscriptions_;
+  std::array<Index, static_cast<size_t>(IndexType::kMaxValue) + 1> indexes_;
+  // Keyword-less buckets are not merged, each subscription's bucket has a
+  // literal automaton of its own. Indexed by subscription, null if the
+  // subscription has no such bucket.
+  std::array<std::vector<const flat::UrlFiltersByKeyword*>,
+             static_cast<size_t>(IndexType::kMaxValue) + 1>
+      unkeyed_buckets_;
+};
+
+// Answers the subresource queries of SubscriptionCollection for one request
+// from bucket lookups done up front. Filters are only matched by the Find*
+// methods, so callers pay only for the categories they ask about.
+class MergedUrlFilterIndex::SubresourceQuery final {
+ public:
+  SubresourceQuery(const SubresourceQuery&) = delete;
+  SubresourceQuery& operator=(const SubresourceQuery&) = delete;
+  SubresourceQuery(SubresourceQuery&&);
+  ~SubresourceQuery();
+
+  absl::optional<size_t> FindBlocking() const;
+  absl::optional<size_t> FindDomainSpecificBlocking() const;
+  absl::optional<size_t> FindAllowing() const;
+  absl::optional<size_t> FindGenericblock() const;
+
+ private:
+  friend class MergedUrlFilterIndex;
+  SubresourceQuery(const MergedUrlFilterIndex& index,
+                   const UrlContext& context,
+                   ContentType content_type);
+
+  const MergedUrlFilterIndex& index_;
+  const UrlContext& context_;
+  const ContentType content_type_;
+  BucketList block_buckets_;
+  BucketList allow_buckets_;
+  BucketList genericblock_buckets_;
+};
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_MERGED_URL_FILTER_INDEX_H_
@@ -0,0 +1,92 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/party_info.h"
+
+#include "base/no_destructor.h"
+#include "net/base/registry_controlled_domains/registry_controlled_domain.h"
+
+namespace adblock {
+
+// static
+RegistrableDomainCache* RegistrableDomainCache::GetInstance() {
+  static base::NoDestructor<RegistrableDomainCache> instance;
+  return instance.get();
+}
+
+RegistrableDomainCache::RegistrableDomainCache(size_t capacity)
+    : entries_(capacity) {}
+
+RegistrableDomainCache::~RegistrableDomainCache() = default;
+
+std::string RegistrableDomainCache::Get(base::StringPiece host) {
+  std::string key(host);
+  {
+    base::AutoLock lock(lock_);
+    const auto it = entries_.Get(key);
+    if (it != entries_.end()) {
+      ++hits_;
+      return it->second;
+    }
+    ++misses_;
+  }
+
+  // The registry lookup doesn't need the lock, other hosts can be served
+  // meanwhile.
+  std::string registrable_domain =
+      net::registry_controlled_domains::GetDomainAndRegistry(
+          host, net::registry_controlled_domains::INCLUDE_PRIVATE_REGISTRIES);
+
+  base::AutoLock lock(lock_);
+  entries_.Put(std::move(key), registrable_domain);
+  return registrable_domain;
+}
+
+size_t RegistrableDomainCache::GetEntryCount() const {
+  base::AutoLock lock(lock_);
+  return entries_.size();
+}
+
+size_t RegistrableDomainCache::GetHitCount() const {
+  base::AutoLock lock(lock_);
+  return hits_;
+}
+
+size_t RegistrableDomainCache::GetMissCount() const {
+  base::AutoLock lock(lock_);
+  return misses_;
+}
+
+// static
+PartyInfo PartyInfo::Compute(base::StringPiece host,
+                             base::StringPiece document_domain) {
+  auto* cache = RegistrableDomainCache::GetInstance();
+  PartyInfo info;
+  info.registrable_domain = cache->Get(host);
+  if (host.empty() || document_domain.empty()) {
+    info.is_third_party = true;
+  } else if (host == document_domain) {
+    info.is_third_party = false;
+  } else {
+    info.is_third_party =
+        info.registrable_domain.empty() ||
+        info.registrable_domain != cache->Get(document_domain);
+  }
+  return info;
+}
+
+}  // namespace adblock
@@ -0,0 +1,80 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_PARTY_INFO_H_
+#define COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_PARTY_INFO_H_
+
+#include <cstddef>
+#include <string>
+
+#include "base/containers/lru_cache.h"
+#include "base/strings/string_piece.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+
+namespace adblock {
+
+// Registrable domains (eTLD+1, private registries included) of recently
+// classified hosts. Every classification needs the registrable domain of the
+// request and of the documents in its frame hierarchy, while a page loads
+// most of its resources from a handful of hosts, so registry lookups are
+// mostly repeated. Bounded, the least recently used host is evicted first.
+// Thread-safe.
+class RegistrableDomainCache final {
+ public:
+  static constexpr size_t kDefaultCapacity = 1024u;
+
+  static RegistrableDomainCache* GetInstance();
+
+  explicit RegistrableDomainCache(size_t capacity = kDefaultCapacity);
+  ~RegistrableDomainCache();
+  RegistrableDomainCache(const RegistrableDomainCache&) = delete;
+  RegistrableDomainCache& operator=(const RegistrableDomainCache&) = delete;
+
+  // Returns the registrable domain of |host|, empty if it has none, ex. for
+  // IP addresses.
+  std::string Get(base::StringPiece host);
+
+  size_t GetEntryCount() const;
+  size_t GetHitCount() const;
+  size_t GetMissCount() const;
+
+ private:
+  mutable base::Lock lock_;
+  base::HashingLRUCache<std::string, std::string> entries_ GUARDED_BY(lock_);
+  size_t hits_ GUARDED_BY(lock_) = 0u;
+  size_t misses_ GUARDED_BY(lock_) = 0u;
+};
+
+// Relationship between a URL and the document that loads it, computed once
+// per (host, document domain) pair for all subscriptions and filters.
+struct PartyInfo {
+  // |host| and |document_domain| must be lowercase. Registrable domains are
+  // looked up through RegistrableDomainCache.
+  static PartyInfo Compute(base::StringPiece host,
+                           base::StringPiece document_domain);
+
+  // eTLD+1 of the URL's host, empty if it has none.
+  std::string registrable_domain;
+  // Whether the URL and the document belong to different sites. Equivalent to
+  // !net::registry_controlled_domains::SameDomainOrHost().
+  bool is_third_party = true;
+};
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_PARTY_INFO_H_
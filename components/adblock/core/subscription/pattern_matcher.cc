@@ -17,19 +17,19 @@
 
 #include "components/adblock/core/subscription/pattern_matcher.h"
 
+#include <algorithm>
+
 #include "absl/types/optional.h"
-#include "base/logging.h"
-#include "base/notreached.h"
-#include "base/ranges/algorithm.h"
+#include "base/check.h"
 #include "base/strings/string_piece.h"
-#include "base/strings/string_piece_forward.h"
 #include "base/strings/string_util.h"
+#include "components/adblock/core/common/pattern_program.h"
 #include "components/adblock/core/common/regex_filter_pattern.h"
 
 namespace adblock {
 namespace {
 
-constexpr int kMaxRecursionDepth = 50;
+using Program = base::span<const flat::PatternInstruction>;
 
 bool CharacterIsValidSeparator(char c) {
   // The separator character can be anything but a letter, a digit, or one of
@@ -51,7 +51,6 @@ bool CharacterIsValidSeparator(char c) {
 // - https://sub.domain.com/
 // - https://sub.domain.com/p
 bool IsValidStartOfHost(base::StringPiece candidate, const GURL& url) {
-  const GURL trimmed_url = url.GetWithEmptyPath();
   if (url.has_scheme()) {
     DCHECK(base::StartsWith(candidate, url.scheme_piece()));
     candidate = candidate.substr(url.scheme_piece().size());
@@ -63,159 +62,104 @@ bool IsValidStartOfHost(base::StringPiece candidate, const GURL& url) {
           candidate.find_first_of("/") == base::StringPiece::npos);
 }
 
-class PatternTokenizer {
- public:
-  explicit PatternTokenizer(base::StringPiece filter_pattern)
-      : consumed_filter_pattern_(filter_pattern) {}
-
-  base::StringPiece NextToken() {
-    if (consumed_filter_pattern_.empty()) {
-      return {};
-    }
-    // If the previous call left us on a wildcard character, return it and
-    // and advance to first non-wildcard position.
-    if (consumed_filter_pattern_[0] == '*') {
-      consumed_filter_pattern_ =
-          base::TrimString(consumed_filter_pattern_, "*", base::TRIM_LEADING);
-      return "*";
-    }
-    // If the previous call left us on a ^ separator, return it and advance
-    if (consumed_filter_pattern_[0] == '^') {
-      consumed_filter_pattern_ = consumed_filter_pattern_.substr(1);
-      return "^";
-    }
-    // If the previous call left us on a | anchor (or anchors), return it and
-    // advance to first non-anchor position.
-    if (consumed_filter_pattern_[0] == '|') {
-      const auto token = consumed_filter_pattern_.substr(
-          0, consumed_filter_pattern_.find_first_not_of("|"));
-      consumed_filter_pattern_ = consumed_filter_pattern_.substr(token.size());
-      return token;
-    }
-
-    // The next token is whatever characters are between current position and
-    // the next separator (or EOF)
-    const auto next_token = consumed_filter_pattern_.substr(
-        0, consumed_filter_pattern_.find_first_of(kSeparators));
-    // Advance to next token.
-    consumed_filter_pattern_ =
-        consumed_filter_pattern_.substr(next_token.size());
-    return next_token;
-  }
-
- private:
-  constexpr static base::StringPiece kSeparators{"*^|"};
-  // The tokenizer consumes |consumed_filter_pattern_| from the left as it
-  // advances. This is cheap, just incrementing the begin index.
-  base::StringPiece consumed_filter_pattern_;
-};
-
-absl::optional<base::StringPiece> FindNextTokenInInput(
-    base::StringPiece consumed_input,
-    PatternTokenizer tokenizer,
-    int recursion_depth);
-
-// Check if |consumed_input| starts with next token from |tokenizer| and
-// continues matching subsequent tokens (recursively).
-bool NextTokenBeginsInput(base::StringPiece consumed_input,
-                          PatternTokenizer tokenizer,
-                          int recursion_depth) {
-  if (++recursion_depth > kMaxRecursionDepth) {
-    return false;
-  }
-  const auto token = tokenizer.NextToken();
-  if (token.empty()) {
-    // Matching finished, no more tokens in the filter.
-    return true;
-  }
-  if (token == "^") {
-    // The next character must either be a valid separator, or EOF. "^" matches
-    // either.
-    if (!consumed_input.empty()) {
-      // This is not an EOF, ^ must match a valid separator, followed by
-      // subsequent matching tokens.
-      return CharacterIsValidSeparator(consumed_input[0]) &&
-             NextTokenBeginsInput(consumed_input.substr(1), tokenizer,
-                                  recursion_depth);
-    }
-    // ^ is a valid match for EOF, but only if there aren't any tokens left
-    // that want to match text.
-    return NextTokenBeginsInput({}, tokenizer, recursion_depth);
-  } else if (token == "*") {
-    // The next characters can be anything, as long as subsequent tokens are
-    // matched further in |consumed_input| (recursively).
-    return FindNextTokenInInput(consumed_input, tokenizer, recursion_depth)
-        .has_value();
-  } else if (token == "|") {
-    // "|" is an end-of-URL anchor, verify we indeed reached end of input.
-    // TODO(mpawlowski) A literal "|"" character can occur in a URL, we should
-    // probably check this as well: DPD-1755.
-    return consumed_input.empty();
-  } else {
-    // The next characters should exactly match the token, and then subsequent
-    // tokens must continue matching the input.
-    if (!base::StartsWith(consumed_input, token)) {
-      return false;
-    }
-    return NextTokenBeginsInput(consumed_input.substr(token.size()), tokenizer,
-                                recursion_depth);
+// A segment is a run of Literal and Separator instructions, delimited by
+// wildcards or the ends of the program. Matching a segment at a given position
+// either fails or consumes a fixed amount of input, so segments never need to
+// be backtracked into.
+Program NextSegment(Program program) {
+  size_t size = 0u;
+  while (size < program.size() &&
+         program[size].opcode() != flat::PatternOpcode_Wildcard) {
+    ++size;
   }
+  return program.first(size);
 }
 
-// Returns characters skipped in order to reach next token from |tokenizer|, or
-// nullopt if not found.
-absl::optional<base::StringPiece> FindNextTokenInInput(
-    base::StringPiece consumed_input,
-    PatternTokenizer tokenizer,
-    int recursion_depth) {
-  if (++recursion_depth > kMaxRecursionDepth) {
-    return absl::nullopt;
-  }
-  const auto token = tokenizer.NextToken();
-  // We're searching for |token| anywhere inside |consumed_input|, we may skip
-  // any number of characters while we try to find it.
-  DCHECK(token != "*") << "PatternTokenizer failed to handle multiple "
-                          "consecutive wildcards in the filter pattern";
-  if (token == "^") {
-    // We're looking for input that matches the ^ separator, followed by next
-    // tokens (recursively).
-    // It is possible that the first separator we find won't be followed by the
-    // correct next token. This is ok, this algorithm cannot be greedy. Keep
-    // skipping characters until we match a separator followed by subsequent
-    // tokens.
-    for (size_t i = 0; i < consumed_input.size(); i++) {
-      if (!CharacterIsValidSeparator(consumed_input[i])) {
+// Returns the position right after |segment| if it matches |input| starting
+// at |pos|.
+absl::optional<size_t> MatchSegmentAt(base::StringPiece pattern,
+                                      Program segment,
+                                      base::StringPiece input,
+                                      size_t pos) {
+  for (const auto& instruction : segment) {
+    if (instruction.opcode() == flat::PatternOpcode_Separator) {
+      // ^ matches a single separator character or the end of the input. When
+      // the end is reached, any further Literal fails to match.
+      if (pos == input.size()) {
         continue;
       }
-      if (NextTokenBeginsInput(consumed_input.substr(i + 1), tokenizer,
-                               recursion_depth)) {
-        return consumed_input.substr(0, i + 1);
+      if (!CharacterIsValidSeparator(input[pos])) {
+        return absl::nullopt;
+      }
+      ++pos;
+    } else {
+      DCHECK_EQ(instruction.opcode(), flat::PatternOpcode_Literal);
+      const auto literal =
+          pattern.substr(instruction.begin(), instruction.length());
+      if (input.compare(pos, literal.size(), literal) != 0) {
+        return absl::nullopt;
       }
+      pos += literal.size();
     }
-    // Reached the end of the input without matching a valid separator (that was
-    // followed by the right tokens, recursively).
-    // It is OK as long as there are no further tokens that require matching
-    // input. The "^" symbol matches EOF too.
-    return NextTokenBeginsInput(base::StringPiece(), tokenizer, recursion_depth)
-               ? absl::optional<base::StringPiece>{consumed_input}
-               : absl::nullopt;
-  } else {
-    // The searched token is just ASCII text. Keep searching for occurrences of
-    // it within consumed_input.
-    for (auto match_pos = consumed_input.find(token);
-         match_pos != base::StringPiece::npos;
-         match_pos = consumed_input.find(token, match_pos + 1)) {
-      if (NextTokenBeginsInput(consumed_input.substr(match_pos + token.size()),
-                               tokenizer, recursion_depth)) {
-        return consumed_input.substr(0, match_pos);
+  }
+  return pos;
+}
+
+// Returns the end of the leftmost match of |segment| in |input| that starts
+// at or after |pos|. If |must_reach_end| is set, only matches that end with
+// the input are considered.
+// Since segments consume a fixed amount of input, the leftmost match also ends
+// first, which leaves the most input for subsequent segments. This makes
+// greedy matching of wildcard-separated segments exact.
+absl::optional<size_t> FindSegment(base::StringPiece pattern,
+                                   Program segment,
+                                   base::StringPiece input,
+                                   size_t pos,
+                                   bool must_reach_end) {
+  const bool starts_with_literal =
+      !segment.empty() &&
+      segment.front().opcode() == flat::PatternOpcode_Literal;
+  const auto first_literal =
+      starts_with_literal ? pattern.substr(segment.front().begin(),
+                                           segment.front().length())
+                          : base::StringPiece();
+  while (pos <= input.size()) {
+    if (starts_with_literal) {
+      // Skip ahead to the next occurrence of the segment's first literal.
+      pos = input.find(first_literal, pos);
+      if (pos == base::StringPiece::npos) {
+        return absl::nullopt;
       }
-      // If the first occurrence of token inside consumed_input isn't the right
-      // one, keep looking. Subsequent tokens didn't match, but the algorithm is
-      // not greedy, there might be another match.
     }
+    const auto end = MatchSegmentAt(pattern, segment, input, pos);
+    if (end && (!must_reach_end || *end == input.size())) {
+      return end;
+    }
+    ++pos;
+  }
+  return absl::nullopt;
+}
 
-    return absl::nullopt;
+// Matches the wildcard-separated segments of |program| that follow the first
+// one, which already matched up to |pos|.
+bool MatchRemainingSegments(base::StringPiece pattern,
+                            Program program,
+                            base::StringPiece input,
+                            size_t pos,
+                            bool end_anchored) {
+  while (!program.empty()) {
+    DCHECK_EQ(program.front().opcode(), flat::PatternOpcode_Wildcard);
+    program = program.subspan(1u);
+    const auto segment = NextSegment(program);
+    program = program.subspan(segment.size());
+    const auto end = FindSegment(pattern, segment, input, pos,
+                                 end_anchored && program.empty());
+    if (!end) {
+      return false;
+    }
+    pos = *end;
   }
+  return true;
 }
 
 }  // namespace
@@ -223,35 +167,74 @@ absl::optional<base::StringPiece> FindNextTokenInInput(
 bool DoesPatternMatchUrl(base::StringPiece filter_pattern, const GURL& url) {
   DCHECK(!ExtractRegexFilterFromPattern(filter_pattern))
       << "This function does not support regular expressions filters";
+  const auto program = CompilePatternProgram(filter_pattern);
+  return DoesPatternProgramMatchUrl(filter_pattern, program, url);
+}
+
+bool DoesPatternProgramMatchUrl(base::StringPiece filter_pattern,
+                                Program program,
+                                const GURL& url) {
   const base::StringPiece input(url.spec());
-  PatternTokenizer tokenizer(filter_pattern);
-  const auto first_token = tokenizer.NextToken();
-  if (first_token == "|") {
-    return NextTokenBeginsInput(input, tokenizer, 0);
-  } else if (first_token == "||") {
-    {
-      // If the next token is *, we discard the start-from-host anchor, behave
-      // as if the filter started from *
-      auto wildcard_tokenizer = tokenizer;
-      const auto wildcard_token = wildcard_tokenizer.NextToken();
-      if (wildcard_token == "*") {
-        return FindNextTokenInInput(input, wildcard_tokenizer, 0).has_value();
-      }
-    }
-    const auto skipped_characters = FindNextTokenInInput(input, tokenizer, 0);
-    if (!skipped_characters) {
-      return false;
+  absl::optional<flat::PatternOpcode> anchor;
+  if (!program.empty() &&
+      (program.front().opcode() == flat::PatternOpcode_StartAnchor ||
+       program.front().opcode() == flat::PatternOpcode_HostAnchor)) {
+    anchor = program.front().opcode();
+    program = program.subspan(1u);
+  }
+  const bool end_anchored =
+      !program.empty() &&
+      program.back().opcode() == flat::PatternOpcode_EndAnchor;
+  if (end_anchored) {
+    program = program.first(program.size() - 1u);
+  }
+
+  const auto first_segment = NextSegment(program);
+  const auto rest = program.subspan(first_segment.size());
+  const bool first_must_reach_end = end_anchored && rest.empty();
+  auto match_first_segment_at = [&](size_t pos) -> absl::optional<size_t> {
+    auto end = MatchSegmentAt(filter_pattern, first_segment, input, pos);
+    if (end && first_must_reach_end && *end != input.size()) {
+      return absl::nullopt;
     }
-    return IsValidStartOfHost(*skipped_characters, url);
+    return end;
+  };
+
+  if (!anchor) {
+    const auto end = FindSegment(filter_pattern, first_segment, input, 0u,
+                                 first_must_reach_end);
+    return end && MatchRemainingSegments(filter_pattern, rest, input, *end,
+                                         end_anchored);
+  }
+  if (*anchor == flat::PatternOpcode_StartAnchor) {
+    const auto end = match_first_segment_at(0u);
+    return end && MatchRemainingSegments(filter_pattern, rest, input, *end,
+                                         end_anchored);
+  }
 
-  } else if (first_token == "*") {
-    return FindNextTokenInInput(input, tokenizer, 0).has_value();
-  } else {
-    // Behave as if the first token is a wildcard, recreate tokenizer to restart
-    // from the first token.
-    return FindNextTokenInInput(input, PatternTokenizer(filter_pattern), 0)
-        .has_value();
+  // Host anchor: the pattern must match starting at the beginning of the host
+  // or of one of its subdomain labels. Every such position is tried, the
+  // number of positions is bounded by the number of labels.
+  const size_t scheme_end = url.has_scheme() ? url.scheme_piece().size() : 0u;
+  const size_t host_begin =
+      std::min(input.find_first_not_of(":/", scheme_end), input.size());
+  const size_t host_end = std::min(input.find('/', host_begin), input.size());
+  for (size_t pos = scheme_end; pos <= host_end; ++pos) {
+    // Cheap pre-check of the conditions verified by IsValidStartOfHost().
+    if (pos > host_begin && input[pos - 1] != '.' &&
+        input.substr(host_begin, pos - host_begin) != url.host_piece()) {
+      continue;
+    }
+    if (!IsValidStartOfHost(input.substr(0u, pos), url)) {
+      continue;
+    }
+    const auto end = match_first_segment_at(pos);
+    if (end && MatchRemainingSegments(filter_pattern, rest, input, *end,
+                                      end_anchored)) {
+      return true;
+    }
   }
+  return false;
 }
 
 }  // namespace adblock
@@ -18,7 +18,9 @@
 #ifndef COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_PATTERN_MATCHER_H_
 #define COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_PATTERN_MATCHER_H_
 
+#include "base/containers/span.h"
 #include "base/strings/string_piece_forward.h"
+#include "components/adblock/core/schema/filter_list_schema_generated.h"
 #include "url/gurl.h"
 
 namespace adblock {
@@ -27,8 +29,18 @@ namespace adblock {
 // Example: filter_pattern "||example.com^" will match url
 // "https://subdomain/example.com/path.png"
 // filter_pattern must NOT be a regex filter
+// Compiles the pattern on every call, prefer DoesPatternProgramMatchUrl() with
+// a program compiled ahead of time.
 bool DoesPatternMatchUrl(base::StringPiece filter_pattern, const GURL& url);
 
+// Same as DoesPatternMatchUrl(), with |program| being the result of
+// CompilePatternProgram(filter_pattern). Runs without recursion and in
+// O(pattern length * URL length) time in the worst case.
+bool DoesPatternProgramMatchUrl(
+    base::StringPiece filter_pattern,
+    base::span<const flat::PatternInstruction> program,
+    const GURL& url);
+
 }  // namespace adblock
 
 #endif  // COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_PATTERN_MATCHER_H_
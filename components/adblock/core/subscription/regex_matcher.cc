@@ -20,10 +20,12 @@
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
 #include "base/notreached.h"
+#include "base/ranges/algorithm.h"
 #include "base/strings/string_piece_forward.h"
 #include "base/strings/string_util.h"
 #include "base/timer/elapsed_timer.h"
-#include "components/adblock/core/common/adblock_utils.h"
+#include "base/trace_event/trace_event.h"
+#include "components/adblock/core/common/regex_cache.h"
 #include "components/adblock/core/common/regex_filter_pattern.h"
 #include "re2/re2.h"
 #include "re2/stringpiece.h"
@@ -35,82 +37,80 @@ namespace adblock {
 RegexMatcher::RegexMatcher() = default;
 RegexMatcher::~RegexMatcher() = default;
 
-void RegexMatcher::PreBuildRegexPatternsWithNoKeyword(
-    const flat::Subscription* index) {
-  base::ElapsedTimer timer;
-  PreBuildPatternsFrom(index->url_csp_allow());
-  PreBuildPatternsFrom(index->url_csp_block());
-  PreBuildPatternsFrom(index->url_document_allow());
-  PreBuildPatternsFrom(index->url_genericblock_allow());
-  PreBuildPatternsFrom(index->url_header_allow());
-  PreBuildPatternsFrom(index->url_popup_allow());
-  PreBuildPatternsFrom(index->url_popup_block());
-  PreBuildPatternsFrom(index->url_elemhide_allow());
-  PreBuildPatternsFrom(index->url_rewrite_allow());
-  PreBuildPatternsFrom(index->url_rewrite_block());
-  PreBuildPatternsFrom(index->url_subresource_allow());
-  PreBuildPatternsFrom(index->url_subresource_block());
-  VLOG(1) << "Added " << CacheSize() << " precompiled regular expressions in "
-          << timer.Elapsed();
+RegexMatcher::RegexSet::RegexSet() = default;
+RegexMatcher::RegexSet::~RegexSet() = default;
+
+RegexMatcher::BucketRegexes::BucketRegexes() = default;
+RegexMatcher::BucketRegexes::~BucketRegexes() = default;
+
+std::vector<uint32_t> RegexMatcher::FindMatchingRegexFilters(
+    const flat::UrlFiltersByKeyword* bucket,
+    const GURL& url) const {
+  const BucketRegexes* regexes = nullptr;
+  {
+    base::AutoLock lock(bucket_lock_);
+    const auto it = bucket_cache_.find(bucket);
+    if (it != bucket_cache_.end()) {
+      regexes = it->second.get();
+    }
+  }
+  if (!regexes) {
+    // Compiled without holding the lock, searches of other buckets must not
+    // wait for a large bucket. Threads searching the same bucket concurrently
+    // may compile it more than once, the first one stored is kept.
+    auto built = BuildBucketRegexes(bucket);
+    base::AutoLock lock(bucket_lock_);
+    const auto inserted = bucket_cache_.emplace(bucket, std::move(built));
+    regexes = inserted.first->second.get();
+  }
+
+  const base::StringPiece input = url.spec();
+  std::vector<uint32_t> positions;
+  MatchRegexSet(regexes->case_sensitive, input, positions);
+  MatchRegexSet(regexes->case_insensitive, input, positions);
+  for (const auto& icu_pattern : regexes->icu_patterns) {
+    if (IcuPatternMatches(*icu_pattern.second, input)) {
+      positions.push_back(icu_pattern.first);
+    }
+  }
+  base::ranges::sort(positions);
+  return positions;
 }
 
 void RegexMatcher::PreBuildRegexPattern(base::StringPiece regular_expression,
                                         bool case_sensitive) {
-  auto re2_pattern = BuildRe2Expression(regular_expression, case_sensitive);
-  if (re2_pattern) {
-    re2_cache_[std::make_pair(regular_expression, case_sensitive)] =
-        std::move(re2_pattern);
-  } else {
-    auto icu_pattern = BuildIcuExpression(regular_expression, case_sensitive);
-    if (!icu_pattern) {
-      LOG(ERROR) << "Even ICU cannot parse this regular expression, "
-                    "this should have been caught during parsing. Will "
-                    "ignore this filter: "
-                 << regular_expression;
-      return;
-    }
-    icu_cache_[std::make_pair(regular_expression, case_sensitive)] =
-        std::move(icu_pattern);
+  if (!RegexCache::GetInstance()->Get(regular_expression, case_sensitive)) {
+    LOG(ERROR) << "Even ICU cannot parse this regular expression, "
+                  "this should have been caught during parsing. Will "
+                  "ignore this filter: "
+               << regular_expression;
   }
 }
 
 bool RegexMatcher::MatchesRegex(base::StringPiece regex_pattern,
                                 const GURL& url,
                                 bool case_sensitive) const {
-  const base::StringPiece input = url.spec();
-  const auto cache_key = std::make_pair(regex_pattern, case_sensitive);
-
-  const auto cached_re2_expression = re2_cache_.find(cache_key);
-  if (cached_re2_expression != re2_cache_.end()) {
-    return re2::RE2::PartialMatch(input.data(), *cached_re2_expression->second);
-  }
-
-  const auto cached_icu_expression = icu_cache_.find(cache_key);
-  if (cached_icu_expression != icu_cache_.end()) {
-    const icu::UnicodeString icu_input(input.data(), input.length());
-    UErrorCode status = U_ZERO_ERROR;
-    std::unique_ptr<icu::RegexMatcher> regex_matcher = base::WrapUnique(
-        cached_icu_expression->second->matcher(icu_input, status));
-    bool is_match = regex_matcher->find(0, status);
-    DCHECK(U_SUCCESS(status));
-    return is_match;
-  }
-  VLOG(1) << "Matching a non-prebuilt expression, this will be slow";
-  return utils::RegexMatches(regex_pattern, input, case_sensitive);
+  const auto regex =
+      RegexCache::GetInstance()->Get(regex_pattern, case_sensitive);
+  return regex && regex->Matches(url.spec());
 }
 
-void RegexMatcher::PreBuildPatternsFrom(const UrlFilterIndex* index) {
-  if (!index) {
-    return;
-  }
-  const auto* idx = index->LookupByKey("");
-  if (!idx) {
-    return;
+std::unique_ptr<RegexMatcher::BucketRegexes>
+RegexMatcher::BuildBucketRegexes(
+    const flat::UrlFiltersByKeyword* bucket) const {
+  TRACE_EVENT0("eyeo", "RegexMatcher::BuildBucketRegexes");
+  base::ElapsedTimer timer;
+  auto regexes = std::make_unique<BucketRegexes>();
+  regexes->case_sensitive.case_sensitive = true;
+  for (RegexSet* regex_set :
+       {&regexes->case_sensitive, &regexes->case_insensitive}) {
+    regex_set->set = std::make_unique<re2::RE2::Set>(
+        MakeRe2Options(regex_set->case_sensitive), re2::RE2::UNANCHORED);
   }
-  for (const auto* filter : *(idx->filter())) {
-    if (CacheSize() >= kMaxPrebuiltPatterns) {
-      return;
-    }
+
+  const auto* filters = bucket->filter();
+  for (uint32_t position = 0; position < filters->size(); ++position) {
+    const auto* filter = filters->Get(position);
     if (!filter->pattern()) {
       continue;  // This filter has no keyword because it has an empty pattern.
     }
@@ -120,25 +120,95 @@ void RegexMatcher::PreBuildPatternsFrom(const UrlFilterIndex* index) {
     if (!regex_string) {
       continue;  // This is not a regex filter.
     }
-    PreBuildRegexPattern(*regex_string, filter->match_case());
+    RegexSet& regex_set = filter->match_case() ? regexes->case_sensitive
+                                               : regexes->case_insensitive;
+    if (regex_set.set->Add(
+            re2::StringPiece(regex_string->data(), regex_string->size()),
+            nullptr) >= 0) {
+      regex_set.positions.push_back(position);
+      regex_set.expressions.push_back(*regex_string);
+      continue;
+    }
+    auto icu_pattern = BuildIcuExpression(*regex_string, filter->match_case());
+    if (!icu_pattern) {
+      LOG(ERROR) << "Even ICU cannot parse this regular expression, "
+                    "this should have been caught during parsing. Will "
+                    "ignore this filter: "
+                 << *regex_string;
+      continue;
+    }
+    regexes->icu_patterns.emplace_back(position, std::move(icu_pattern));
+  }
+
+  for (RegexSet* regex_set :
+       {&regexes->case_sensitive, &regexes->case_insensitive}) {
+    if (regex_set->positions.empty() || !regex_set->set->Compile()) {
+      // Nothing to match, or the set is too large for RE2's memory budget,
+      // in which case MatchRegexSet() matches expressions one by one.
+      regex_set->set.reset();
+    }
   }
+  VLOG(1) << "[eyeo] Compiled "
+          << regexes->case_sensitive.positions.size() +
+                 regexes->case_insensitive.positions.size()
+          << " regular expressions into sets and "
+          << regexes->icu_patterns.size() << " ICU expressions in "
+          << timer.Elapsed();
+  return regexes;
 }
 
-std::unique_ptr<re2::RE2> RegexMatcher::BuildRe2Expression(
-    base::StringPiece regular_expression,
-    bool case_sensitive) {
+void RegexMatcher::MatchRegexSet(const RegexSet& regex_set,
+                                 base::StringPiece input,
+                                 std::vector<uint32_t>& out_positions) const {
+  if (regex_set.positions.empty()) {
+    return;
+  }
+  if (regex_set.set) {
+    std::vector<int> matches;
+    re2::RE2::Set::ErrorInfo error_info;
+    if (regex_set.set->Match(re2::StringPiece(input.data(), input.size()),
+                             &matches, &error_info)) {
+      for (const int match : matches) {
+        out_positions.push_back(regex_set.positions[match]);
+      }
+      return;
+    }
+    if (error_info.kind == re2::RE2::Set::kNoError) {
+      return;
+    }
+    // The DFA ran out of memory on this input, fall back to matching
+    // expressions one by one.
+    VLOG(1) << "[eyeo] RE2::Set could not match, error " << error_info.kind;
+  }
+  for (size_t i = 0; i < regex_set.expressions.size(); ++i) {
+    const auto expression = RegexCache::GetInstance()->Get(
+        regex_set.expressions[i], regex_set.case_sensitive);
+    if (expression && expression->Matches(input)) {
+      out_positions.push_back(regex_set.positions[i]);
+    }
+  }
+}
+
+// static
+re2::RE2::Options RegexMatcher::MakeRe2Options(bool case_sensitive) {
   re2::RE2::Options options;
   options.set_case_sensitive(case_sensitive);
   options.set_never_capture(true);
   options.set_log_errors(false);
   options.set_encoding(re2::RE2::Options::EncodingLatin1);
-  auto prebuilt_re2 = std::make_unique<re2::RE2>(
-      re2::StringPiece(regular_expression.data(), regular_expression.size()),
-      options);
-  if (!prebuilt_re2->ok()) {
-    return nullptr;
-  }
-  return prebuilt_re2;
+  return options;
+}
+
+// static
+bool RegexMatcher::IcuPatternMatches(const icu::RegexPattern& pattern,
+                                     base::StringPiece input) {
+  const icu::UnicodeString icu_input(input.data(), input.length());
+  UErrorCode status = U_ZERO_ERROR;
+  std::unique_ptr<icu::RegexMatcher> regex_matcher =
+      base::WrapUnique(pattern.matcher(icu_input, status));
+  bool is_match = regex_matcher->find(0, status);
+  DCHECK(U_SUCCESS(status));
+  return is_match;
 }
 
 std::unique_ptr<icu::RegexPattern> RegexMatcher::BuildIcuExpression(
@@ -156,8 +226,4 @@ std::unique_ptr<icu::RegexPattern> RegexMatcher::BuildIcuExpression(
   return prebuilt_pattern;
 }
 
-int RegexMatcher::CacheSize() const {
-  return re2_cache_.size() + icu_cache_.size();
-}
-
 }  // namespace adblock
@@ -18,11 +18,19 @@
 #ifndef COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_REGEX_MATCHER_H_
 #define COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_REGEX_MATCHER_H_
 
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "base/strings/string_piece_forward.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
 #include "components/adblock/core/schema/filter_list_schema_generated.h"
 #include "third_party/icu/source/i18n/unicode/regex.h"
 #include "third_party/re2/src/re2/re2.h"
+#include "third_party/re2/src/re2/set.h"
 #include "url/gurl.h"
 
 namespace adblock {
@@ -36,15 +44,21 @@ class RegexMatcher {
   RegexMatcher& operator=(const RegexMatcher&) = delete;
   RegexMatcher& operator=(RegexMatcher&&) = delete;
 
-  // Max number of patterns that PreBuildRegexPatternsWithNoKeyword() will
-  // build and store in memory. If there are more regex patterns in |index|,
-  // they will not be pre-built and MatchesRegex() will build them on demand.
-  static constexpr int kMaxPrebuiltPatterns = 500;
+  // Evaluates all regex filters of |bucket| against |url| in one pass and
+  // returns the positions, within |bucket|->filter(), of those that match, in
+  // ascending order.
+  // The regular expressions of a bucket are compiled into RE2::Sets the first
+  // time the bucket is searched, on the sequence that searches it, which is a
+  // classification sequence rather than the UI thread. Only that search waits
+  // for the compilation. Expressions only ICU understands are matched one by
+  // one. Thread-safe.
+  std::vector<uint32_t> FindMatchingRegexFilters(
+      const flat::UrlFiltersByKeyword* bucket,
+      const GURL& url) const;
 
-  // Regex patterns that have no keyword attached must be matched to every URL.
-  // There are typically few of them and they are matched very often, so
-  // pre-build them.
-  void PreBuildRegexPatternsWithNoKeyword(const flat::Subscription* index);
+  // Matches a single expression. Compiled expressions are shared by the
+  // whole process through RegexCache, PreBuildRegexPattern() compiles one
+  // ahead of its first use.
   void PreBuildRegexPattern(base::StringPiece regular_expression,
                             bool case_sensitive);
 
@@ -53,20 +67,43 @@ class RegexMatcher {
                     bool case_sensitive) const;
 
  private:
-  using UrlFilterIndex =
-      flatbuffers::Vector<flatbuffers::Offset<flat::UrlFiltersByKeyword>>;
-  void PreBuildPatternsFrom(const UrlFilterIndex* index);
-  std::unique_ptr<re2::RE2> BuildRe2Expression(
-      base::StringPiece regular_expression,
-      bool case_sensitive);
-  std::unique_ptr<icu::RegexPattern> BuildIcuExpression(
+  // Expressions of one case sensitivity, RE2::Set options apply to all of
+  // them.
+  struct RegexSet {
+    RegexSet();
+    ~RegexSet();
+    std::unique_ptr<re2::RE2::Set> set;
+    // Indexed by the set's own pattern index.
+    std::vector<uint32_t> positions;
+    std::vector<base::StringPiece> expressions;
+    bool case_sensitive = false;
+  };
+  struct BucketRegexes {
+    BucketRegexes();
+    ~BucketRegexes();
+    RegexSet case_sensitive;
+    RegexSet case_insensitive;
+    std::vector<std::pair<uint32_t, std::unique_ptr<icu::RegexPattern>>>
+        icu_patterns;
+  };
+  std::unique_ptr<BucketRegexes> BuildBucketRegexes(
+      const flat::UrlFiltersByKeyword* bucket) const;
+  void MatchRegexSet(const RegexSet& regex_set,
+                     base::StringPiece input,
+                     std::vector<uint32_t>& out_positions) const;
+  static re2::RE2::Options MakeRe2Options(bool case_sensitive);
+  static bool IcuPatternMatches(const icu::RegexPattern& pattern,
+                                base::StringPiece input);
+  static std::unique_ptr<icu::RegexPattern> BuildIcuExpression(
       base::StringPiece regular_expression,
       bool case_sensitive);
-  int CacheSize() const;
 
-  using CacheKey = std::tuple<base::StringPiece, bool>;
-  std::map<CacheKey, std::unique_ptr<re2::RE2>> re2_cache_;
-  std::map<CacheKey, std::unique_ptr<icu::RegexPattern>> icu_cache_;
+  // Buckets point into the flatbuffer of the owning subscription. Entries are
+  // never removed, so they may be read after |bucket_lock_| is released.
+  mutable base::Lock bucket_lock_;
+  mutable std::map<const flat::UrlFiltersByKeyword*,
+                   std::unique_ptr<BucketRegexes>>
+      bucket_cache_ GUARDED_BY(bucket_lock_);
 };
 
 }  // namespace adblock
@@ -0,0 +1,156 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/request_context.h"
+
+#include "base/check_op.h"
+#include "base/ranges/algorithm.h"
+#include "base/strings/string_util.h"
+#include "components/adblock/core/subscription/frame_special_filters.h"
+#include "components/adblock/core/subscription/url_keyword_extractor.h"
+
+namespace adblock {
+namespace {
+
+bool NeedsLowercasing(base::StringPiece input) {
+  return base::ranges::any_of(
+      input, [](const char c) { return base::IsAsciiUpper(c); });
+}
+
+absl::optional<GURL> LowercaseUrl(const GURL& url) {
+  if (!NeedsLowercasing(url.spec())) {
+    return absl::nullopt;
+  }
+  return GURL(base::ToLowerASCII(url.spec()));
+}
+
+// The domain frame_hierarchy[index] is loaded in: that of its parent frame or,
+// for the main frame, its own.
+std::string ParentDomain(const std::vector<GURL>& frame_hierarchy,
+                         size_t index) {
+  return index + 1 < frame_hierarchy.size() ? frame_hierarchy[index + 1].host()
+                                            : frame_hierarchy[index].host();
+}
+
+}  // namespace
+
+UrlContext::UrlContext(const GURL& url,
+                       std::string document_domain,
+                       SiteKey sitekey)
+    : url_(url),
+      document_domain_(std::move(document_domain)),
+      sitekey_(std::move(sitekey)),
+      lowercase_url_(LowercaseUrl(url)),
+      normalized_document_domain_(NeedsLowercasing(document_domain_)
+                                      ? base::ToLowerASCII(document_domain_)
+                                      : document_domain_),
+      party_info_(
+          PartyInfo::Compute(url.host_piece(), normalized_document_domain_)),
+      normalized_sitekey_(base::ToUpperASCII(sitekey_.value())) {
+  UrlKeywordExtractor keyword_extractor(lowercase_url().spec());
+  while (auto keyword = keyword_extractor.GetNextKeyword()) {
+    keywords_.push_back(*keyword);
+  }
+  // Every suffix ends where the domain ends, so it's null-terminated too.
+  const base::StringPiece domain(normalized_document_domain_);
+  document_domain_suffixes_.push_back(domain);
+  for (size_t dot = domain.find('.'); dot != base::StringPiece::npos;
+       dot = domain.find('.', dot + 1)) {
+    document_domain_suffixes_.push_back(domain.substr(dot + 1));
+  }
+}
+
+UrlContext::~UrlContext() = default;
+
+FrameContext::FrameContext(std::vector<GURL> frame_hierarchy, SiteKey sitekey)
+    : frame_hierarchy_(std::move(frame_hierarchy)),
+      sitekey_(std::move(sitekey)),
+      document_domain_(frame_hierarchy_.empty() ? std::string()
+                                                : frame_hierarchy_[0].host()) {
+  // |frame_hierarchy_| never changes, so the contexts may refer to its URLs.
+  frames_.reserve(frame_hierarchy_.size());
+  for (size_t index = 0; index < frame_hierarchy_.size(); ++index) {
+    frames_.push_back(std::make_unique<UrlContext>(
+        frame_hierarchy_[index], ParentDomain(frame_hierarchy_, index),
+        sitekey_));
+  }
+}
+
+FrameContext::~FrameContext() = default;
+
+const UrlContext& FrameContext::frame(size_t index) const {
+  DCHECK_LT(index, frames_.size());
+  return *frames_[index];
+}
+
+RequestContext::RequestContext(
+    const GURL& request_url,
+    const std::vector<GURL>& frame_hierarchy,
+    const SiteKey& sitekey,
+    base::span<const scoped_refptr<const FrameSpecialFilters>>
+        frame_special_filters)
+    : frame_hierarchy_(frame_hierarchy),
+      frame_context_(nullptr),
+      frame_special_filters_(frame_special_filters),
+      request_(request_url,
+               frame_hierarchy.empty() ? request_url.host()
+                                       : frame_hierarchy[0].host(),
+               sitekey),
+      frames_(frame_hierarchy.size()) {}
+
+RequestContext::RequestContext(
+    const GURL& request_url,
+    const FrameContext& frame_context,
+    base::span<const scoped_refptr<const FrameSpecialFilters>>
+        frame_special_filters)
+    : frame_hierarchy_(frame_context.frame_hierarchy()),
+      frame_context_(&frame_context),
+      frame_special_filters_(frame_special_filters),
+      request_(request_url,
+               frame_hierarchy_.empty() ? request_url.host()
+                                        : frame_context.document_domain(),
+               frame_context.sitekey()) {}
+
+RequestContext::~RequestContext() = default;
+
+const UrlContext& RequestContext::frame(size_t index) const {
+  DCHECK_LT(index, frame_hierarchy_.size());
+  if (frame_context_) {
+    return frame_context_->frame(index);
+  }
+  if (!frames_[index]) {
+    frames_[index] = std::make_unique<UrlContext>(
+        frame_hierarchy_[index], ParentDomain(frame_hierarchy_, index),
+        sitekey());
+  }
+  return *frames_[index];
+}
+
+const FrameSpecialFilters* RequestContext::frame_special_filters(
+    uint64_t generation) const {
+  if (generation == 0u) {
+    return nullptr;
+  }
+  for (const auto& filters : frame_special_filters_) {
+    if (filters && filters->generation() == generation) {
+      return filters.get();
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace adblock
@@ -0,0 +1,181 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_REQUEST_CONTEXT_H_
+#define COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_REQUEST_CONTEXT_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/types/optional.h"
+#include "base/containers/span.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/string_piece.h"
+#include "components/adblock/core/common/sitekey.h"
+#include "components/adblock/core/subscription/party_info.h"
+#include "url/gurl.h"
+
+namespace adblock {
+
+class FrameSpecialFilters;
+
+// Everything URL filter matching needs to know about a URL loaded by a
+// document, computed once and reused by every subscription and filter
+// category instead of being recomputed by each query.
+// Holds a reference to |url|, which must outlive this object.
+class UrlContext {
+ public:
+  UrlContext(const GURL& url, std::string document_domain, SiteKey sitekey);
+  ~UrlContext();
+  UrlContext(const UrlContext&) = delete;
+  UrlContext& operator=(const UrlContext&) = delete;
+
+  // As passed to the constructor.
+  const GURL& url() const { return url_; }
+  const std::string& document_domain() const { return document_domain_; }
+  const SiteKey& sitekey() const { return sitekey_; }
+
+  // |url| with the spec lowercased. Same object as url() if it was already
+  // lowercase.
+  const GURL& lowercase_url() const {
+    return lowercase_url_ ? *lowercase_url_ : url_;
+  }
+  // Keywords of lowercase_url(), in order, as yielded by UrlKeywordExtractor.
+  // Point into lowercase_url(), not null-terminated.
+  const std::vector<base::StringPiece>& keywords() const { return keywords_; }
+  // Lowercase document_domain().
+  const std::string& normalized_document_domain() const {
+    return normalized_document_domain_;
+  }
+  // normalized_document_domain() followed by every domain it's a subdomain
+  // of, ex. "a.b.com", "b.com", "com". A filter domain applies to the document
+  // if and only if it's on this list.
+  const std::vector<base::StringPiece>& document_domain_suffixes() const {
+    return document_domain_suffixes_;
+  }
+  // Registrable domain of url() and whether it's third-party to
+  // document_domain().
+  const PartyInfo& party_info() const { return party_info_; }
+  // eTLD+1 of url(), empty if it has none (ex. for IP addresses).
+  const std::string& registrable_domain() const {
+    return party_info_.registrable_domain;
+  }
+  // Whether url() and document_domain() belong to different sites.
+  bool is_third_party() const { return party_info_.is_third_party; }
+  // Uppercase sitekey().
+  const std::string& normalized_sitekey() const { return normalized_sitekey_; }
+
+ private:
+  const GURL& url_;
+  const std::string document_domain_;
+  const SiteKey sitekey_;
+  absl::optional<GURL> lowercase_url_;
+  std::vector<base::StringPiece> keywords_;
+  std::string normalized_document_domain_;
+  std::vector<base::StringPiece> document_domain_suffixes_;
+  const PartyInfo party_info_;
+  std::string normalized_sitekey_;
+};
+
+// The frame hierarchy of a document and everything derived from it that
+// classifying the document's requests needs. Built once per document, ex. when
+// its navigation commits, and shared by the classifications of all its
+// requests instead of walking the frame tree and normalizing the frames' URLs
+// for each of them.
+// Immutable, may be used on any thread.
+class FrameContext final : public base::RefCountedThreadSafe<FrameContext> {
+ public:
+  // |frame_hierarchy| starts with the document's own URL and ends with the
+  // URL of the main frame, |sitekey| is the one found for any of them.
+  FrameContext(std::vector<GURL> frame_hierarchy, SiteKey sitekey);
+  FrameContext(const FrameContext&) = delete;
+  FrameContext& operator=(const FrameContext&) = delete;
+
+  const std::vector<GURL>& frame_hierarchy() const { return frame_hierarchy_; }
+  const SiteKey& sitekey() const { return sitekey_; }
+  // Host of the document's own URL, empty if |frame_hierarchy| is.
+  const std::string& document_domain() const { return document_domain_; }
+  // frame_hierarchy()[index], in the context of its parent frame or, for the
+  // last frame, its own domain.
+  const UrlContext& frame(size_t index) const;
+
+ private:
+  friend class base::RefCountedThreadSafe<FrameContext>;
+  ~FrameContext();
+
+  const std::vector<GURL> frame_hierarchy_;
+  const SiteKey sitekey_;
+  const std::string document_domain_;
+  std::vector<std::unique_ptr<UrlContext>> frames_;
+};
+
+// Created once per classified request and passed down to
+// SubscriptionCollection and InstalledSubscription queries.
+// The UrlContext of the request is computed eagerly. Those of frames in the
+// hierarchy are taken from the FrameContext if there is one, otherwise they
+// are computed on first use, since most requests don't need them.
+// Not thread-safe, meant to live on the stack for the duration of a single
+// classification. |request_url|, |frame_hierarchy|, |frame_context| and
+// |frame_special_filters| must outlive this.
+class RequestContext {
+ public:
+  // |frame_special_filters|, if any, must have been found for
+  // |frame_hierarchy| and |sitekey|, see
+  // SubscriptionCollection::FindFrameSpecialFilters().
+  RequestContext(const GURL& request_url,
+                 const std::vector<GURL>& frame_hierarchy,
+                 const SiteKey& sitekey,
+                 base::span<const scoped_refptr<const FrameSpecialFilters>>
+                     frame_special_filters = {});
+  // For a request made by the document of |frame_context|.
+  RequestContext(const GURL& request_url,
+                 const FrameContext& frame_context,
+                 base::span<const scoped_refptr<const FrameSpecialFilters>>
+                     frame_special_filters = {});
+  ~RequestContext();
+  RequestContext(const RequestContext&) = delete;
+  RequestContext& operator=(const RequestContext&) = delete;
+
+  const GURL& request_url() const { return request_.url(); }
+  const std::vector<GURL>& frame_hierarchy() const { return frame_hierarchy_; }
+  const SiteKey& sitekey() const { return request_.sitekey(); }
+
+  // The request, in the context of the top of |frame_hierarchy| or, if it's
+  // empty, its own domain.
+  const UrlContext& request() const { return request_; }
+  // frame_hierarchy()[index], in the context of its parent frame or, for the
+  // last frame, its own domain.
+  const UrlContext& frame(size_t index) const;
+  // Special filters of the innermost frame found by the collection with
+  // |generation|, null if there are none.
+  const FrameSpecialFilters* frame_special_filters(uint64_t generation) const;
+
+ private:
+  const std::vector<GURL>& frame_hierarchy_;
+  const FrameContext* const frame_context_;
+  const base::span<const scoped_refptr<const FrameSpecialFilters>>
+      frame_special_filters_;
+  const UrlContext request_;
+  mutable std::vector<std::unique_ptr<UrlContext>> frames_;
+};
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_REQUEST_CONTEXT_H_
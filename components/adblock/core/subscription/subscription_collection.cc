@@ -0,0 +1,138 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/subscription_collection.h"
+
+#include <atomic>
+
+namespace adblock {
+namespace {
+
+std::atomic<uint64_t> g_last_generation{0};
+
+}  // namespace
+
+uint64_t SubscriptionCollection::GetGeneration() const {
+  return 0;
+}
+
+// static
+uint64_t SubscriptionCollection::NextGeneration() {
+  return g_last_generation.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+absl::optional<GURL> SubscriptionCollection::FindBySubresourceFilter(
+    const RequestContext& context,
+    ContentType content_type,
+    FilterCategory category) const {
+  return FindBySubresourceFilter(context.request_url(),
+                                 context.frame_hierarchy(), content_type,
+                                 context.sitekey(), category);
+}
+
+absl::optional<GURL> SubscriptionCollection::FindByPopupFilter(
+    const RequestContext& context,
+    FilterCategory category) const {
+  return FindByPopupFilter(context.request_url(), context.frame_hierarchy(),
+                           context.sitekey(), category);
+}
+
+absl::optional<GURL> SubscriptionCollection::FindByAllowFilter(
+    const RequestContext& context,
+    ContentType content_type) const {
+  return FindByAllowFilter(context.request_url(), context.frame_hierarchy(),
+                           content_type, context.sitekey());
+}
+
+absl::optional<GURL> SubscriptionCollection::FindBySpecialFilter(
+    SpecialFilterType filter_type,
+    const RequestContext& context) const {
+  return FindBySpecialFilter(filter_type, context.request_url(),
+                             context.frame_hierarchy(), context.sitekey());
+}
+
+scoped_refptr<const FrameSpecialFilters>
+SubscriptionCollection::FindFrameSpecialFilters(
+    const FrameContext& frame_context) const {
+  return nullptr;
+}
+
+const std::vector<scoped_refptr<InstalledSubscription>>*
+SubscriptionCollection::GetInstalledSubscriptions() const {
+  return nullptr;
+}
+
+SubscriptionCollection::SubresourceMatch::SubresourceMatch() = default;
+SubscriptionCollection::SubresourceMatch::SubresourceMatch(
+    const SubresourceMatch&) = default;
+SubscriptionCollection::SubresourceMatch::SubresourceMatch(
+    SubresourceMatch&&) = default;
+SubscriptionCollection::SubresourceMatch&
+SubscriptionCollection::SubresourceMatch::operator=(const SubresourceMatch&) =
+    default;
+SubscriptionCollection::SubresourceMatch&
+SubscriptionCollection::SubresourceMatch::operator=(SubresourceMatch&&) =
+    default;
+SubscriptionCollection::SubresourceMatch::~SubresourceMatch() = default;
+
+SubscriptionCollection::SubresourceMatch
+SubscriptionCollection::FindSubresourceMatch(const RequestContext& context,
+                                             ContentType content_type) const {
+  SubresourceMatch match;
+  match.blocking =
+      FindBySubresourceFilter(context, content_type, FilterCategory::Blocking);
+  if (!match.blocking) {
+    return match;
+  }
+  match.allowing = FindByAllowFilter(context, content_type);
+  if (match.allowing) {
+    return match;
+  }
+  match.genericblock =
+      FindBySpecialFilter(SpecialFilterType::Genericblock, context);
+  if (!match.genericblock) {
+    return match;
+  }
+  match.domain_specific_blocking = FindBySubresourceFilter(
+      context, content_type, FilterCategory::DomainSpecificBlocking);
+  return match;
+}
+
+SubscriptionCollection::ElementHideData::ElementHideData() = default;
+SubscriptionCollection::ElementHideData::ElementHideData(
+    const ElementHideData&) = default;
+SubscriptionCollection::ElementHideData::ElementHideData(ElementHideData&&) =
+    default;
+SubscriptionCollection::ElementHideData&
+SubscriptionCollection::ElementHideData::operator=(const ElementHideData&) =
+    default;
+SubscriptionCollection::ElementHideData&
+SubscriptionCollection::ElementHideData::operator=(ElementHideData&&) =
+    default;
+SubscriptionCollection::ElementHideData::~ElementHideData() = default;
+
+SubscriptionCollection::ElementHideData
+SubscriptionCollection::GetElementHideData(
+    const GURL& frame_url,
+    const std::vector<GURL>& frame_hierarchy,
+    const SiteKey& sitekey) const {
+  ElementHideData data;
+  data.selectors = GetElementHideSelectors(frame_url, frame_hierarchy, sitekey);
+  return data;
+}
+
+}  // namespace adblock
@@ -18,18 +18,23 @@
 #ifndef COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_SUBSCRIPTION_COLLECTION_H_
 #define COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_SUBSCRIPTION_COLLECTION_H_
 
+#include <cstdint>
 #include <set>
 #include <vector>
 
 #include "absl/types/optional.h"
 #include "base/containers/span.h"
+#include "base/memory/scoped_refptr.h"
 #include "base/strings/string_piece.h"
 #include "base/strings/string_piece_forward.h"
 #include "base/values.h"
 #include "components/adblock/core/common/content_type.h"
 #include "components/adblock/core/common/header_filter_data.h"
 #include "components/adblock/core/common/sitekey.h"
+#include "components/adblock/core/subscription/frame_special_filters.h"
+#include "components/adblock/core/subscription/generic_elemhide_stylesheet.h"
 #include "components/adblock/core/subscription/installed_subscription.h"
+#include "components/adblock/core/subscription/request_context.h"
 #include "url/gurl.h"
 
 namespace adblock {
@@ -42,6 +47,14 @@ class SubscriptionCollection {
  public:
   virtual ~SubscriptionCollection() = default;
 
+  // Identifies the state of subscriptions this collection was created from.
+  // Every new state gets a generation that was never used before in this
+  // process, so results computed for a generation stay valid as long as it is
+  // current. 0 means the state is not tracked and results must not be reused.
+  virtual uint64_t GetGeneration() const;
+  // Returns a generation that was never returned before. Thread-safe.
+  static uint64_t NextGeneration();
+
   virtual absl::optional<GURL> FindBySubresourceFilter(
       const GURL& request_url,
       const std::vector<GURL>& frame_hierarchy,
@@ -64,6 +77,71 @@ class SubscriptionCollection {
       const std::vector<GURL>& frame_hierarchy,
       const SiteKey& sitekey) const = 0;
 
+  // Variants of the above that reuse data precomputed once per request, so
+  // that the request URL is normalized and tokenized only once regardless of
+  // how many queries, collections and subscriptions are involved.
+  // Default implementations forward to the variants above.
+  virtual absl::optional<GURL> FindBySubresourceFilter(
+      const RequestContext& context,
+      ContentType content_type,
+      FilterCategory category) const;
+  virtual absl::optional<GURL> FindByPopupFilter(
+      const RequestContext& context,
+      FilterCategory category) const;
+  virtual absl::optional<GURL> FindByAllowFilter(
+      const RequestContext& context,
+      ContentType content_type) const;
+  virtual absl::optional<GURL> FindBySpecialFilter(
+      SpecialFilterType filter_type,
+      const RequestContext& context) const;
+
+  // Looks up the document-level special filters that apply to the document of
+  // |frame_context| through its frame or its ancestors. Every request that frame
+  // makes can pass the result to its RequestContext, sparing the queries above
+  // from looking them up again. Returns null if the collection does not track
+  // its state, as the result could not be told apart from one found with
+  // another state. Default implementation always returns null.
+  virtual scoped_refptr<const FrameSpecialFilters> FindFrameSpecialFilters(
+      const FrameContext& frame_context) const;
+
+  // What a subresource request matches in the categories that decide whether
+  // it gets blocked. A member is only searched for when the ones before it
+  // leave the decision open:
+  // - |allowing| when there is a |blocking| match,
+  // - |genericblock| when there is no |allowing| match,
+  // - |domain_specific_blocking| when there is a |genericblock| match.
+  struct SubresourceMatch {
+    SubresourceMatch();
+    SubresourceMatch(const SubresourceMatch&);
+    SubresourceMatch(SubresourceMatch&&);
+    SubresourceMatch& operator=(const SubresourceMatch&);
+    SubresourceMatch& operator=(SubresourceMatch&&);
+    ~SubresourceMatch();
+
+    // As FindBySubresourceFilter() with FilterCategory::Blocking.
+    absl::optional<GURL> blocking;
+    // As FindByAllowFilter().
+    absl::optional<GURL> allowing;
+    // As FindBySpecialFilter() with SpecialFilterType::Genericblock.
+    absl::optional<GURL> genericblock;
+    // As FindBySubresourceFilter() with
+    // FilterCategory::DomainSpecificBlocking.
+    absl::optional<GURL> domain_specific_blocking;
+  };
+  // Default implementation runs the queries above one after another.
+  // Implementations may instead look up the request's keywords once for all
+  // categories, the result must be the same.
+  virtual SubresourceMatch FindSubresourceMatch(
+      const RequestContext& context,
+      ContentType content_type) const;
+
+  // Returns the subscriptions this collection searches, in order, or nullptr
+  // if it is not made of InstalledSubscriptions (ex. in tests). Allows
+  // FusedUrlFilterIndex to combine the filters of several collections.
+  // Default implementation returns nullptr.
+  virtual const std::vector<scoped_refptr<InstalledSubscription>>*
+  GetInstalledSubscriptions() const;
+
   virtual std::vector<base::StringPiece> GetElementHideSelectors(
       const GURL& frame_url,
       const std::vector<GURL>& frame_hierarchy,
@@ -71,6 +149,27 @@ class SubscriptionCollection {
   virtual std::vector<base::StringPiece> GetElementHideEmulationSelectors(
       const GURL& frame_url) const = 0;
 
+  // Element hiding for a frame, split into a stylesheet shared with other
+  // frames and the selectors that only apply to this one. Hides the same
+  // elements as GetElementHideSelectors().
+  struct ElementHideData {
+    ElementHideData();
+    ElementHideData(const ElementHideData&);
+    ElementHideData(ElementHideData&&);
+    ElementHideData& operator=(const ElementHideData&);
+    ElementHideData& operator=(ElementHideData&&);
+    ~ElementHideData();
+
+    // May be null, in which case |selectors| holds everything.
+    scoped_refptr<const GenericElemhideStylesheet> generic_stylesheet;
+    std::vector<base::StringPiece> selectors;
+  };
+  // Default implementation returns GetElementHideSelectors() as |selectors|.
+  virtual ElementHideData GetElementHideData(
+      const GURL& frame_url,
+      const std::vector<GURL>& frame_hierarchy,
+      const SiteKey& sitekey) const;
+
   virtual base::Value::List GenerateSnippets(
       const GURL& frame_url,
       const std::vector<GURL>& frame_hierarchy) const = 0;
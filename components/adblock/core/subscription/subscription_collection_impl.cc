@@ -22,6 +22,8 @@
 #include <string>
 #include <vector>
 
+#include "base/check_op.h"
+#include "base/containers/flat_set.h"
 #include "base/ranges/algorithm.h"
 #include "components/adblock/core/common/adblock_utils.h"
 
@@ -34,25 +36,45 @@ std::string DocumentDomain(const GURL& request_url,
                                  : frame_hierarchy[0].host();
 }
 
+absl::optional<size_t> Earliest(absl::optional<size_t> lhs,
+                                absl::optional<size_t> rhs) {
+  if (!lhs || !rhs) {
+    return lhs ? lhs : rhs;
+  }
+  return std::min(*lhs, *rhs);
+}
+
 std::vector<base::StringPiece> ReduceSelectors(
     InstalledSubscription::Selectors& combined_selectors) {
   // Populate result with blocking selectors.
   std::vector<base::StringPiece> final_selectors =
       std::move(combined_selectors.elemhide_selectors);
-  // Remove exceptions.
+  if (combined_selectors.elemhide_exceptions.empty()) {
+    return final_selectors;
+  }
+  // Remove exceptions. Pages may have thousands of both, so exceptions are
+  // sorted once rather than searched linearly for every selector.
+  const base::flat_set<base::StringPiece> exceptions(
+      std::move(combined_selectors.elemhide_exceptions));
   final_selectors.erase(
-      std::remove_if(
-          final_selectors.begin(), final_selectors.end(),
-          [&](const auto& selector) {
-            return std::find(combined_selectors.elemhide_exceptions.begin(),
-                             combined_selectors.elemhide_exceptions.end(),
-                             selector) !=
-                   combined_selectors.elemhide_exceptions.end();
-          }),
+      std::remove_if(final_selectors.begin(), final_selectors.end(),
+                     [&](base::StringPiece selector) {
+                       return exceptions.contains(selector);
+                     }),
       final_selectors.end());
   return final_selectors;
 }
 
+void AppendSelectors(InstalledSubscription::Selectors selectors,
+                     InstalledSubscription::Selectors& combined_selectors) {
+  std::move(selectors.elemhide_selectors.begin(),
+            selectors.elemhide_selectors.end(),
+            std::back_inserter(combined_selectors.elemhide_selectors));
+  std::move(selectors.elemhide_exceptions.begin(),
+            selectors.elemhide_exceptions.end(),
+            std::back_inserter(combined_selectors.elemhide_exceptions));
+}
+
 using GenericGetter = absl::optional<base::StringPiece> (
     InstalledSubscription::*)(const GURL&,
                               const std::string&,
@@ -73,27 +95,21 @@ bool IsFilterOverruled(base::StringPiece blocking,
 
 bool GenericHasAllowingFilter(const InstalledSubscription& subscription,
                               const base::StringPiece blocking,
-                              const GURL& request_url,
-                              const std::vector<GURL>& frame_hierarchy,
+                              const RequestContext& context,
                               GenericGetter getter) {
-  const auto request_domain = DocumentDomain(request_url, frame_hierarchy);
   // There may exist an allowing rule for this request and its immediate
   // parent frame. We also check for document-wide allowing filters.
-  if (IsFilterOverruled(blocking, subscription, request_url, request_domain,
-                        getter) ||
-      subscription.HasSpecialFilter(SpecialFilterType::Document, request_url,
-                                    request_domain, SiteKey())) {
+  if (IsFilterOverruled(blocking, subscription, context.request_url(),
+                        context.request().document_domain(), getter) ||
+      subscription.HasSpecialFilter(SpecialFilterType::Document,
+                                    context.request())) {
     return true;
   }
   // For parent frames, we only match document-wide allowing filters. Parent
   // frames' allowing rules don't propagate to child frames.
-  for (auto it = frame_hierarchy.begin(); it < frame_hierarchy.end(); ++it) {
-    const GURL& current_url = *it;
-    const std::string& current_domain = std::next(it) != frame_hierarchy.end()
-                                            ? std::next(it)->host()
-                                            : current_url.host();
-    if (subscription.HasSpecialFilter(SpecialFilterType::Document, current_url,
-                                      current_domain, SiteKey())) {
+  for (size_t i = 0; i < context.frame_hierarchy().size(); ++i) {
+    if (subscription.HasSpecialFilter(SpecialFilterType::Document,
+                                      context.frame(i))) {
       return true;
     }
   }
@@ -103,65 +119,35 @@ bool GenericHasAllowingFilter(const InstalledSubscription& subscription,
 bool SubscriptionContainsSpecialFilter(
     const scoped_refptr<adblock::InstalledSubscription> subscription,
     SpecialFilterType filter_type,
-    const std::vector<GURL>& frame_hierarchy,
-    const SiteKey& sitekey) {
-  for (auto it = frame_hierarchy.begin(); it < frame_hierarchy.end(); ++it) {
-    const GURL& current_url = *it;
-    const std::string& current_domain = std::next(it) != frame_hierarchy.end()
-                                            ? std::next(it)->host()
-                                            : current_url.host();
-    if (subscription->HasSpecialFilter(filter_type, current_url, current_domain,
-                                       sitekey)) {
+    const RequestContext& context) {
+  for (size_t i = 0; i < context.frame_hierarchy().size(); ++i) {
+    if (subscription->HasSpecialFilter(filter_type, context.frame(i))) {
       return true;
     }
   }
   return false;
 }
 
-bool HasAllowFilter(
-    const scoped_refptr<adblock::InstalledSubscription> subscription,
-    const GURL& request_url,
-    const std::vector<GURL>& frame_hierarchy,
-    ContentType content_type,
-    const SiteKey& sitekey) {
-  if (subscription->HasUrlFilter(
-          request_url, DocumentDomain(request_url, frame_hierarchy),
-          content_type, sitekey, FilterCategory::Allowing)) {
-    return true;
-  }
-  if (SubscriptionContainsSpecialFilter(subscription,
-                                        SpecialFilterType::Document,
-                                        frame_hierarchy, sitekey)) {
-    return true;
-  }
-  return false;
-}
-
 bool HasSpecialFilter(
     const scoped_refptr<adblock::InstalledSubscription> subscription,
     SpecialFilterType filter_type,
-    const GURL& request_url,
-    const std::vector<GURL>& frame_hierarchy,
-    const SiteKey& sitekey) {
-  if (subscription->HasSpecialFilter(
-          filter_type, request_url,
-          DocumentDomain(request_url, frame_hierarchy), sitekey)) {
+    const RequestContext& context) {
+  if (subscription->HasSpecialFilter(filter_type, context.request())) {
     return true;
   }
-  return SubscriptionContainsSpecialFilter(subscription, filter_type,
-                                           frame_hierarchy, sitekey);
+  return SubscriptionContainsSpecialFilter(subscription, filter_type, context);
 }
 
 absl::optional<base::StringPiece> GenericFindFilter(
     const std::vector<scoped_refptr<InstalledSubscription>>& subscriptions,
-    const GURL& request_url,
-    const std::vector<GURL>& frame_hierarchy,
+    const RequestContext& context,
     GenericGetter getter) {
+  const GURL& request_url = context.request_url();
+  const std::string& request_domain = context.request().document_domain();
   for (const auto& subscription : subscriptions) {
     // Is there a blocking filter in this subscription?
-    const auto blocking = (*subscription.*getter)(
-        request_url, DocumentDomain(request_url, frame_hierarchy),
-        FilterCategory::Blocking);
+    const auto blocking = (*subscription.*getter)(request_url, request_domain,
+                                                  FilterCategory::Blocking);
     if (!blocking) {
       // There are no blocking filters in this subscription, check next one.
       continue;
@@ -169,8 +155,7 @@ absl::optional<base::StringPiece> GenericFindFilter(
     // There may be an allowing rule for the entire document or an allowing //
     // filter in one of the subscriptions:
     if (base::ranges::any_of(subscriptions, [&](const auto& sub) {
-          return GenericHasAllowingFilter(*sub, *blocking, request_url,
-                                          frame_hierarchy, getter);
+          return GenericHasAllowingFilter(*sub, *blocking, context, getter);
         })) {
       continue;
     }
@@ -178,13 +163,12 @@ absl::optional<base::StringPiece> GenericFindFilter(
     // we should re-search for domain-specific filters only?
     if (base::ranges::any_of(subscriptions, [&](const auto& sub) {
           return HasSpecialFilter(sub, SpecialFilterType::Genericblock,
-                                  request_url, frame_hierarchy, SiteKey());
+                                  context);
         })) {
       // This is a relatively rare case - we should have searched for
       // domain-specific filters only.
       const auto domain_specific_blocking = (*subscription.*getter)(
-          request_url, DocumentDomain(request_url, frame_hierarchy),
-          FilterCategory::DomainSpecificBlocking);
+          request_url, request_domain, FilterCategory::DomainSpecificBlocking);
       if (domain_specific_blocking) {
         // There is a domain-specific blocking filter. No point in
         // searching for a domain-specific allowing filter, since the
@@ -205,8 +189,17 @@ absl::optional<base::StringPiece> GenericFindFilter(
 }  // namespace
 
 SubscriptionCollectionImpl::SubscriptionCollectionImpl(
-    std::vector<scoped_refptr<InstalledSubscription>> current_state)
-    : subscriptions_(std::move(current_state)) {}
+    std::vector<scoped_refptr<InstalledSubscription>> current_state,
+    scoped_refptr<const MergedUrlFilterIndex> merged_index,
+    uint64_t generation,
+    scoped_refptr<const GenericElemhideStylesheet> generic_elemhide)
+    : subscriptions_(std::move(current_state)),
+      merged_index_(std::move(merged_index)),
+      generation_(generation),
+      generic_elemhide_(std::move(generic_elemhide)) {
+  DCHECK(!merged_index_ || merged_index_->IsBuiltFrom(subscriptions_));
+  DCHECK(!generic_elemhide_ || generic_elemhide_->IsBuiltFrom(subscriptions_));
+}
 SubscriptionCollectionImpl::~SubscriptionCollectionImpl() = default;
 SubscriptionCollectionImpl::SubscriptionCollectionImpl(
     const SubscriptionCollectionImpl&) = default;
@@ -217,18 +210,61 @@ SubscriptionCollectionImpl& SubscriptionCollectionImpl::operator=(
 SubscriptionCollectionImpl& SubscriptionCollectionImpl::operator=(
     SubscriptionCollectionImpl&&) = default;
 
+uint64_t SubscriptionCollectionImpl::GetGeneration() const {
+  return generation_;
+}
+
 absl::optional<GURL> SubscriptionCollectionImpl::FindBySubresourceFilter(
     const GURL& request_url,
     const std::vector<GURL>& frame_hierarchy,
     ContentType content_type,
     const SiteKey& sitekey,
     FilterCategory category) const {
+  return FindBySubresourceFilter(
+      RequestContext(request_url, frame_hierarchy, sitekey), content_type,
+      category);
+}
+
+absl::optional<GURL> SubscriptionCollectionImpl::FindByPopupFilter(
+    const GURL& popup_url,
+    const std::vector<GURL>& frame_hierarchy,
+    const SiteKey& sitekey,
+    FilterCategory category) const {
+  return FindByPopupFilter(RequestContext(popup_url, frame_hierarchy, sitekey),
+                           category);
+}
+
+absl::optional<GURL> SubscriptionCollectionImpl::FindByAllowFilter(
+    const GURL& request_url,
+    const std::vector<GURL>& frame_hierarchy,
+    ContentType content_type,
+    const SiteKey& sitekey) const {
+  return FindByAllowFilter(
+      RequestContext(request_url, frame_hierarchy, sitekey), content_type);
+}
+
+absl::optional<GURL> SubscriptionCollectionImpl::FindBySpecialFilter(
+    SpecialFilterType filter_type,
+    const GURL& request_url,
+    const std::vector<GURL>& frame_hierarchy,
+    const SiteKey& sitekey) const {
+  return FindBySpecialFilter(
+      filter_type, RequestContext(request_url, frame_hierarchy, sitekey));
+}
+
+absl::optional<GURL> SubscriptionCollectionImpl::FindBySubresourceFilter(
+    const RequestContext& context,
+    ContentType content_type,
+    FilterCategory category) const {
+  if (merged_index_) {
+    return GetSourceUrlAt(merged_index_->FindUrlFilter(
+        context.request(), content_type, category));
+  }
   const auto subscription = std::find_if(
       subscriptions_.begin(), subscriptions_.end(),
       [&](const auto& subscription) {
-        return subscription->HasUrlFilter(
-            request_url, DocumentDomain(request_url, frame_hierarchy),
-            content_type, sitekey, category);
+        return subscription->HasUrlFilter(context.request(), content_type,
+                                          category);
       });
   if (subscription != subscriptions_.end()) {
     return (*subscription)->GetSourceUrl();
@@ -237,17 +273,17 @@ absl::optional<GURL> SubscriptionCollectionImpl::FindBySubresourceFilter(
 }
 
 absl::optional<GURL> SubscriptionCollectionImpl::FindByPopupFilter(
-    const GURL& popup_url,
-    const std::vector<GURL>& frame_hierarchy,
-    const SiteKey& sitekey,
+    const RequestContext& context,
     FilterCategory category) const {
-  const auto subscription =
-      std::find_if(subscriptions_.begin(), subscriptions_.end(),
-                   [&](const auto& subscription) {
-                     return subscription->HasPopupFilter(
-                         popup_url, DocumentDomain(popup_url, frame_hierarchy),
-                         sitekey, category);
-                   });
+  if (merged_index_) {
+    return GetSourceUrlAt(
+        merged_index_->FindPopupFilter(context.request(), category));
+  }
+  const auto subscription = std::find_if(
+      subscriptions_.begin(), subscriptions_.end(),
+      [&](const auto& subscription) {
+        return subscription->HasPopupFilter(context.request(), category);
+      });
   if (subscription != subscriptions_.end()) {
     return (*subscription)->GetSourceUrl();
   }
@@ -255,14 +291,19 @@ absl::optional<GURL> SubscriptionCollectionImpl::FindByPopupFilter(
 }
 
 absl::optional<GURL> SubscriptionCollectionImpl::FindByAllowFilter(
-    const GURL& request_url,
-    const std::vector<GURL>& frame_hierarchy,
-    ContentType content_type,
-    const SiteKey& sitekey) const {
-  for (const auto& subscription : subscriptions_) {
-    if (HasAllowFilter(subscription, request_url, frame_hierarchy, content_type,
-                       sitekey)) {
-      return (*subscription).GetSourceUrl();
+    const RequestContext& context,
+    ContentType content_type) const {
+  if (merged_index_) {
+    return GetSourceUrlAt(Earliest(
+        merged_index_->FindUrlFilter(context.request(), content_type,
+                                     FilterCategory::Allowing),
+        FindSpecialFilterInFrames(SpecialFilterType::Document, context)));
+  }
+  for (size_t i = 0; i < subscriptions_.size(); ++i) {
+    if (subscriptions_[i]->HasUrlFilter(context.request(), content_type,
+                                        FilterCategory::Allowing) ||
+        HasSpecialFilterInFrames(i, SpecialFilterType::Document, context)) {
+      return subscriptions_[i]->GetSourceUrl();
     }
   }
   return absl::nullopt;
@@ -270,38 +311,125 @@ absl::optional<GURL> SubscriptionCollectionImpl::FindByAllowFilter(
 
 absl::optional<GURL> SubscriptionCollectionImpl::FindBySpecialFilter(
     SpecialFilterType filter_type,
-    const GURL& request_url,
-    const std::vector<GURL>& frame_hierarchy,
-    const SiteKey& sitekey) const {
-  for (const auto& subscription : subscriptions_) {
-    if (HasSpecialFilter(subscription, filter_type, request_url,
-                         frame_hierarchy, sitekey)) {
-      return (*subscription).GetSourceUrl();
+    const RequestContext& context) const {
+  if (merged_index_) {
+    return GetSourceUrlAt(Earliest(
+        merged_index_->FindSpecialFilter(filter_type, context.request()),
+        FindSpecialFilterInFrames(filter_type, context)));
+  }
+  for (size_t i = 0; i < subscriptions_.size(); ++i) {
+    if (subscriptions_[i]->HasSpecialFilter(filter_type, context.request()) ||
+        HasSpecialFilterInFrames(i, filter_type, context)) {
+      return subscriptions_[i]->GetSourceUrl();
     }
   }
   return absl::nullopt;
 }
 
+scoped_refptr<const FrameSpecialFilters>
+SubscriptionCollectionImpl::FindFrameSpecialFilters(
+    const FrameContext& frame_context) const {
+  if (generation_ == 0u) {
+    return nullptr;
+  }
+  // Only the frames of the context are searched, the request URL is unused.
+  const auto& frame_hierarchy = frame_context.frame_hierarchy();
+  const RequestContext context(
+      frame_hierarchy.empty() ? GURL::EmptyGURL() : frame_hierarchy.front(),
+      frame_context);
+  FrameSpecialFilters::Positions positions;
+  for (size_t type = 0; type < kSpecialFilterTypeCount; ++type) {
+    positions[type] = FindSpecialFilterInFrames(
+        static_cast<SpecialFilterType>(type), context);
+  }
+  return base::MakeRefCounted<FrameSpecialFilters>(generation_, positions);
+}
+
+SubscriptionCollection::SubresourceMatch
+SubscriptionCollectionImpl::FindSubresourceMatch(
+    const RequestContext& context,
+    ContentType content_type) const {
+  if (!merged_index_) {
+    return SubscriptionCollection::FindSubresourceMatch(context, content_type);
+  }
+  // Same sequence of searches as the default implementation, but the request
+  // keywords are looked up once for all of them.
+  const auto query =
+      merged_index_->QuerySubresource(context.request(), content_type);
+  SubresourceMatch match;
+  match.blocking = GetSourceUrlAt(query.FindBlocking());
+  if (!match.blocking) {
+    return match;
+  }
+  match.allowing = GetSourceUrlAt(Earliest(
+      query.FindAllowing(),
+      FindSpecialFilterInFrames(SpecialFilterType::Document, context)));
+  if (match.allowing) {
+    return match;
+  }
+  match.genericblock = GetSourceUrlAt(Earliest(
+      query.FindGenericblock(),
+      FindSpecialFilterInFrames(SpecialFilterType::Genericblock, context)));
+  if (!match.genericblock) {
+    return match;
+  }
+  match.domain_specific_blocking =
+      GetSourceUrlAt(query.FindDomainSpecificBlocking());
+  return match;
+}
+
+const std::vector<scoped_refptr<InstalledSubscription>>*
+SubscriptionCollectionImpl::GetInstalledSubscriptions() const {
+  return &subscriptions_;
+}
+
 std::vector<base::StringPiece>
 SubscriptionCollectionImpl::GetElementHideSelectors(
     const GURL& frame_url,
     const std::vector<GURL>& frame_hierarchy,
     const SiteKey& sitekey) const {
-  const bool domain_specific = !!FindBySpecialFilter(
-      SpecialFilterType::Generichide, frame_url, frame_hierarchy, sitekey);
+  return GetAllElementHideSelectors(
+      frame_url, HasGenerichideFilter(frame_url, frame_hierarchy, sitekey));
+}
 
+SubscriptionCollection::ElementHideData
+SubscriptionCollectionImpl::GetElementHideData(
+    const GURL& frame_url,
+    const std::vector<GURL>& frame_hierarchy,
+    const SiteKey& sitekey) const {
+  ElementHideData data;
+  const bool domain_specific =
+      HasGenerichideFilter(frame_url, frame_hierarchy, sitekey);
+  if (!generic_elemhide_ || domain_specific) {
+    data.selectors = GetAllElementHideSelectors(frame_url, domain_specific);
+    return data;
+  }
   InstalledSubscription::Selectors combined_selectors;
   for (const auto& subscription : subscriptions_) {
-    auto selectors =
-        subscription->GetElemhideSelectors(frame_url, domain_specific);
-    std::move(selectors.elemhide_selectors.begin(),
-              selectors.elemhide_selectors.end(),
-              std::back_inserter(combined_selectors.elemhide_selectors));
-    std::move(selectors.elemhide_exceptions.begin(),
-              selectors.elemhide_exceptions.end(),
-              std::back_inserter(combined_selectors.elemhide_exceptions));
+    AppendSelectors(
+        subscription->GetDomainDependentElemhideSelectors(frame_url),
+        combined_selectors);
   }
-  return ReduceSelectors(combined_selectors);
+  if (base::ranges::any_of(combined_selectors.elemhide_exceptions,
+                           [&](base::StringPiece exception) {
+                             return generic_elemhide_->HasSelector(exception);
+                           })) {
+    // This frame has an exception for a selector of the shared stylesheet,
+    // which cannot be un-hidden by adding more CSS.
+    data.selectors = GetAllElementHideSelectors(frame_url, false);
+    return data;
+  }
+  data.selectors = ReduceSelectors(combined_selectors);
+  // Domain-agnostic exceptions also apply to domain-dependent selectors.
+  const auto has_domain_agnostic_exception = [&](base::StringPiece selector) {
+    return generic_elemhide_->HasException(selector);
+  };
+  data.selectors.erase(
+      std::remove_if(data.selectors.begin(), data.selectors.end(),
+                     has_domain_agnostic_exception),
+      data.selectors.end());
+  data.generic_stylesheet = generic_elemhide_;
+  return data;
 }
 
 std::vector<base::StringPiece>
@@ -356,11 +484,11 @@ std::set<base::StringPiece> SubscriptionCollectionImpl::GetCspInjections(
   }
 
   // If blocking filters found, check if can be overuled by allowing filters.
+  const RequestContext context(request_url, frame_hierarchy, SiteKey());
   for (const auto& subscription : subscriptions_) {
     // There may exist an allowing rule for this request and its immediate
     // parent frame. We also check for document-wide allowing filters.
-    if (HasSpecialFilter(subscription, SpecialFilterType::Document, request_url,
-                         frame_hierarchy, SiteKey())) {
+    if (HasSpecialFilter(subscription, SpecialFilterType::Document, context)) {
       return {};
     }
     subscription->FindCspFilters(request_url,
@@ -382,8 +510,7 @@ std::set<base::StringPiece> SubscriptionCollectionImpl::GetCspInjections(
   // Last chance to avoid blocking: maybe there is a Genericblock filter and
   // we should re-search for domain-specific filters only?
   if (base::ranges::any_of(subscriptions_, [&](const auto& sub) {
-        return HasSpecialFilter(sub, SpecialFilterType::Genericblock,
-                                request_url, frame_hierarchy, SiteKey());
+        return HasSpecialFilter(sub, SpecialFilterType::Genericblock, context);
       })) {
     // This is a relatively rare case - we should have searched for
     // domain-specific filters only.
@@ -415,8 +542,9 @@ std::set<base::StringPiece> SubscriptionCollectionImpl::GetCspInjections(
 absl::optional<GURL> SubscriptionCollectionImpl::GetRewriteUrl(
     const GURL& request_url,
     const std::vector<GURL>& frame_hierarchy) const {
-  auto result = GenericFindFilter(subscriptions_, request_url, frame_hierarchy,
-                                  &InstalledSubscription::FindRewriteFilter);
+  auto result = GenericFindFilter(
+      subscriptions_, RequestContext(request_url, frame_hierarchy, SiteKey()),
+      &InstalledSubscription::FindRewriteFilter);
   return result ? absl::optional<GURL>(GURL(*result)) : absl::nullopt;
 }
 
@@ -434,4 +562,77 @@ std::set<HeaderFilterData> SubscriptionCollectionImpl::GetHeaderFilters(
   return filters;
 }
 
+bool SubscriptionCollectionImpl::HasGenerichideFilter(
+    const GURL& frame_url,
+    const std::vector<GURL>& frame_hierarchy,
+    const SiteKey& sitekey) const {
+  return !!FindBySpecialFilter(SpecialFilterType::Generichide, frame_url,
+                               frame_hierarchy, sitekey);
+}
+
+std::vector<base::StringPiece>
+SubscriptionCollectionImpl::GetAllElementHideSelectors(
+    const GURL& frame_url,
+    bool domain_specific) const {
+  InstalledSubscription::Selectors combined_selectors;
+  for (const auto& subscription : subscriptions_) {
+    AppendSelectors(
+        subscription->GetElemhideSelectors(frame_url, domain_specific),
+        combined_selectors);
+  }
+  return ReduceSelectors(combined_selectors);
+}
+
+absl::optional<GURL> SubscriptionCollectionImpl::GetSourceUrlAt(
+    absl::optional<size_t> position) const {
+  if (!position) {
+    return absl::nullopt;
+  }
+  DCHECK_LT(*position, subscriptions_.size());
+  return subscriptions_[*position]->GetSourceUrl();
+}
+
+absl::optional<size_t> SubscriptionCollectionImpl::FindSpecialFilterInFrames(
+    SpecialFilterType filter_type,
+    const RequestContext& context) const {
+  if (const auto* frame_filters =
+          context.frame_special_filters(generation_)) {
+    return frame_filters->Find(filter_type);
+  }
+  if (!merged_index_) {
+    const auto subscription =
+        base::ranges::find_if(subscriptions_, [&](const auto& subscription) {
+          return SubscriptionContainsSpecialFilter(subscription, filter_type,
+                                                   context);
+        });
+    if (subscription == subscriptions_.end()) {
+      return absl::nullopt;
+    }
+    return static_cast<size_t>(subscription - subscriptions_.begin());
+  }
+  absl::optional<size_t> result;
+  for (size_t i = 0; i < context.frame_hierarchy().size(); ++i) {
+    result = Earliest(result, merged_index_->FindSpecialFilter(
+                                  filter_type, context.frame(i)));
+    if (result == 0u) {
+      break;
+    }
+  }
+  return result;
+}
+
+bool SubscriptionCollectionImpl::HasSpecialFilterInFrames(
+    size_t position,
+    SpecialFilterType filter_type,
+    const RequestContext& context) const {
+  if (const auto* frame_filters =
+          context.frame_special_filters(generation_)) {
+    // The earliest subscription with such a filter is known, none of the ones
+    // after it needs to be checked.
+    return frame_filters->Find(filter_type) == position;
+  }
+  return SubscriptionContainsSpecialFilter(subscriptions_[position],
+                                           filter_type, context);
+}
+
 }  // namespace adblock
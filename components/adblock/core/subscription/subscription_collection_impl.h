@@ -18,24 +18,39 @@
 #ifndef COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_SUBSCRIPTION_COLLECTION_IMPL_H_
 #define COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_SUBSCRIPTION_COLLECTION_IMPL_H_
 
+#include <cstdint>
 #include <vector>
 
 #include "base/containers/span.h"
 #include "base/memory/scoped_refptr.h"
+#include "components/adblock/core/subscription/generic_elemhide_stylesheet.h"
+#include "components/adblock/core/subscription/merged_url_filter_index.h"
 #include "components/adblock/core/subscription/subscription_collection.h"
 
 namespace adblock {
 
 class SubscriptionCollectionImpl final : public SubscriptionCollection {
  public:
+  // If |merged_index| is provided, it must have been built from
+  // |current_state| and will be used to speed up the most common queries.
+  // |generation| identifies |current_state|, see GetGeneration().
+  // If |generic_elemhide| is provided, it must have been built from
+  // |current_state| and frames will only render their domain-dependent
+  // selectors.
   explicit SubscriptionCollectionImpl(
-      std::vector<scoped_refptr<InstalledSubscription>> current_state);
+      std::vector<scoped_refptr<InstalledSubscription>> current_state,
+      scoped_refptr<const MergedUrlFilterIndex> merged_index = nullptr,
+      uint64_t generation = 0,
+      scoped_refptr<const GenericElemhideStylesheet> generic_elemhide =
+          nullptr);
   ~SubscriptionCollectionImpl() final;
   SubscriptionCollectionImpl(const SubscriptionCollectionImpl&);
   SubscriptionCollectionImpl(SubscriptionCollectionImpl&&);
   SubscriptionCollectionImpl& operator=(const SubscriptionCollectionImpl&);
   SubscriptionCollectionImpl& operator=(SubscriptionCollectionImpl&&);
 
+  uint64_t GetGeneration() const final;
+
   absl::optional<GURL> FindBySubresourceFilter(
       const GURL& request_url,
       const std::vector<GURL>& frame_hierarchy,
@@ -61,10 +76,31 @@ class SubscriptionCollectionImpl final : public SubscriptionCollection {
       const std::vector<GURL>& frame_hierarchy,
       const SiteKey& sitekey) const final;
 
+  absl::optional<GURL> FindBySubresourceFilter(
+      const RequestContext& context,
+      ContentType content_type,
+      FilterCategory category) const final;
+  absl::optional<GURL> FindByPopupFilter(const RequestContext& context,
+                                         FilterCategory category) const final;
+  absl::optional<GURL> FindByAllowFilter(const RequestContext& context,
+                                         ContentType content_type) const final;
+  absl::optional<GURL> FindBySpecialFilter(
+      SpecialFilterType filter_type,
+      const RequestContext& context) const final;
+  scoped_refptr<const FrameSpecialFilters> FindFrameSpecialFilters(
+      const FrameContext& frame_context) const final;
+  SubresourceMatch FindSubresourceMatch(const RequestContext& context,
+                                        ContentType content_type) const final;
+  const std::vector<scoped_refptr<InstalledSubscription>>*
+  GetInstalledSubscriptions() const final;
+
   std::vector<base::StringPiece> GetElementHideSelectors(
       const GURL& frame_url,
       const std::vector<GURL>& frame_hierarchy,
       const SiteKey& sitekey) const final;
+  ElementHideData GetElementHideData(const GURL& frame_url,
+                                     const std::vector<GURL>& frame_hierarchy,
+                                     const SiteKey& sitekey) const final;
   std::vector<base::StringPiece> GetElementHideEmulationSelectors(
       const GURL& frame_url) const final;
   base::Value::List GenerateSnippets(
@@ -84,7 +120,29 @@ class SubscriptionCollectionImpl final : public SubscriptionCollection {
       FilterCategory category) const final;
 
  private:
+  absl::optional<GURL> GetSourceUrlAt(absl::optional<size_t> position) const;
+  // Position of the earliest subscription with a |filter_type| filter for any
+  // frame of |context|.
+  absl::optional<size_t> FindSpecialFilterInFrames(
+      SpecialFilterType filter_type,
+      const RequestContext& context) const;
+  // Whether the subscription at |position| has a |filter_type| filter for any
+  // frame of |context|, provided none of the subscriptions before it has.
+  bool HasSpecialFilterInFrames(size_t position,
+                                SpecialFilterType filter_type,
+                                const RequestContext& context) const;
+
+  bool HasGenerichideFilter(const GURL& frame_url,
+                            const std::vector<GURL>& frame_hierarchy,
+                            const SiteKey& sitekey) const;
+  std::vector<base::StringPiece> GetAllElementHideSelectors(
+      const GURL& frame_url,
+      bool domain_specific) const;
+
   std::vector<scoped_refptr<InstalledSubscription>> subscriptions_;
+  scoped_refptr<const MergedUrlFilterIndex> merged_index_;
+  uint64_t generation_;
+  scoped_refptr<const GenericElemhideStylesheet> generic_elemhide_;
 };
 
 }  // namespace adblock
@@ -28,6 +28,7 @@
 #include "components/adblock/core/subscription/subscription.h"
 #include "components/adblock/core/subscription/subscription_collection.h"
 #include "components/adblock/core/subscription/subscription_persistent_metadata.h"
+#include "components/adblock/core/subscription/subscription_snapshot.h"
 #include "components/keyed_service/core/keyed_service.h"
 #include "url/gurl.h"
 
@@ -37,7 +38,7 @@ namespace adblock {
 // FilteringConfigurations.
 class SubscriptionService : public KeyedService {
  public:
-  using Snapshot = std::vector<std::unique_ptr<SubscriptionCollection>>;
+  using Snapshot = SubscriptionSnapshot;
   class SubscriptionObserver : public base::CheckedObserver {
    public:
     // Called only on successful installation or update of a subscription.
@@ -62,7 +63,7 @@ class SubscriptionService : public KeyedService {
   // function that can be used to query filters.
   // The result may be passed between threads, even called
   // concurrently, and future changes to the installed subscriptions will not
-  // impact it.
+  // impact it. May be called from any sequence.
   virtual Snapshot GetCurrentSnapshot() const = 0;
 
   virtual void AddObserver(SubscriptionObserver*) = 0;
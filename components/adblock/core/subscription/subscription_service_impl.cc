@@ -28,6 +28,7 @@
 #include "base/memory/weak_ptr.h"
 #include "base/parameter_pack.h"
 #include "base/ranges/algorithm.h"
+#include "base/task/thread_pool.h"
 #include "base/trace_event/common/trace_event_common.h"
 #include "base/trace_event/trace_event.h"
 #include "components/adblock/core/common/adblock_utils.h"
@@ -37,6 +38,28 @@
 #include "components/adblock/core/subscription/subscription_service.h"
 
 namespace adblock {
+namespace {
+
+// Returns the subscriptions of each collection of |snapshot|, or nothing if
+// the collections cannot or need not be searched together.
+FusedUrlFilterIndex::CollectionStates GetFusableStates(
+    const SubscriptionService::Snapshot& snapshot) {
+  FusedUrlFilterIndex::CollectionStates states;
+  if (snapshot.size() < 2u ||
+      snapshot.size() > FusedUrlFilterIndex::kMaxCollections) {
+    return states;
+  }
+  for (const auto& collection : snapshot) {
+    const auto* subscriptions = collection->GetInstalledSubscriptions();
+    if (!subscriptions) {
+      return {};
+    }
+    states.push_back(*subscriptions);
+  }
+  return states;
+}
+
+}  // namespace
 
 SubscriptionServiceImpl::SubscriptionServiceImpl(
     FilteringConfigurationMaintainerFactory maintainer_factory)
@@ -76,6 +99,7 @@ void SubscriptionServiceImpl::InstallFilteringConfiguration(
   }
   maintainers_.insert(
       std::make_pair(std::move(configuration), std::move(maintainer)));
+  PublishSnapshot();
 }
 
 std::vector<FilteringConfiguration*>
@@ -88,14 +112,9 @@ SubscriptionServiceImpl::GetInstalledFilteringConfigurations() {
 
 SubscriptionService::Snapshot SubscriptionServiceImpl::GetCurrentSnapshot()
     const {
-  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
-  Snapshot snapshot;
-  for (const auto& entry : maintainers_) {
-    if (!entry.second)
-      continue;  // Configuration is disabled
-    snapshot.push_back(entry.second->GetSubscriptionCollection());
-  }
-  return snapshot;
+  // Not bound to |sequence_checker_|, the published Snapshot is immutable.
+  base::AutoLock lock(snapshot_lock_);
+  return current_snapshot_;
 }
 
 void SubscriptionServiceImpl::AddObserver(SubscriptionObserver* o) {
@@ -126,6 +145,7 @@ void SubscriptionServiceImpl::OnEnabledStateChanged(
     // frees all associated memory.
     it->second.reset();
   }
+  PublishSnapshot();
 }
 
 void SubscriptionServiceImpl::OnSubscriptionUpdated(
@@ -140,7 +160,66 @@ SubscriptionServiceImpl::MakeMaintainer(FilteringConfiguration* configuration) {
   return maintainer_factory_.Run(
       configuration,
       base::BindRepeating(&SubscriptionServiceImpl::OnSubscriptionUpdated,
+                          weak_ptr_factory_.GetWeakPtr()),
+      base::BindRepeating(&SubscriptionServiceImpl::PublishSnapshot,
                           weak_ptr_factory_.GetWeakPtr()));
 }
 
+void SubscriptionServiceImpl::PublishSnapshot() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  TRACE_EVENT0("eyeo", "SubscriptionServiceImpl::PublishSnapshot");
+  Snapshot snapshot;
+  for (const auto& entry : maintainers_) {
+    if (!entry.second)
+      continue;  // Configuration is disabled
+    snapshot.push_back(entry.second->GetSubscriptionCollection());
+  }
+  auto states = GetFusableStates(snapshot);
+  if (fused_index_ && !states.empty() && fused_index_->IsBuiltFrom(states)) {
+    // Only the collections changed, not their subscriptions.
+    snapshot = snapshot.WithFusedIndex(fused_index_);
+  } else {
+    // A stale index would not be used anyway, don't let it keep removed
+    // subscriptions alive. Until a new one is built, the collections are
+    // searched one by one.
+    fused_index_.reset();
+    if (states.empty()) {
+      fused_index_states_being_built_.clear();
+    } else if (states != fused_index_states_being_built_) {
+      fused_index_states_being_built_ = states;
+      base::ThreadPool::PostTaskAndReplyWithResult(
+          FROM_HERE, {base::TaskPriority::USER_VISIBLE},
+          base::BindOnce(&FusedUrlFilterIndex::Build, std::move(states)),
+          base::BindOnce(&SubscriptionServiceImpl::OnFusedIndexBuilt,
+                         weak_ptr_factory_.GetWeakPtr()));
+    }
+  }
+  SetCurrentSnapshot(std::move(snapshot));
+}
+
+void SubscriptionServiceImpl::SetCurrentSnapshot(Snapshot snapshot) {
+  {
+    base::AutoLock lock(snapshot_lock_);
+    std::swap(current_snapshot_, snapshot);
+  }
+  // |snapshot| now holds the previous Snapshot. If this was its last
+  // reference, the collections are released outside of the lock.
+}
+
+void SubscriptionServiceImpl::OnFusedIndexBuilt(
+    scoped_refptr<FusedUrlFilterIndex> fused_index) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  const Snapshot snapshot = GetCurrentSnapshot();
+  if (!fused_index || !fused_index->IsBuiltFrom(GetFusableStates(snapshot))) {
+    // Either the collections cannot be fused, or they changed while this
+    // index was being built and a newer one is on its way.
+    return;
+  }
+  VLOG(1) << "[eyeo] Fused URL filter index ready for " << snapshot.size()
+          << " FilteringConfigurations";
+  fused_index_states_being_built_.clear();
+  fused_index_ = std::move(fused_index);
+  SetCurrentSnapshot(snapshot.WithFusedIndex(fused_index_));
+}
+
 }  // namespace adblock
@@ -28,8 +28,11 @@
 #include "base/memory/weak_ptr.h"
 #include "base/observer_list.h"
 #include "base/sequence_checker.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
 #include "components/adblock/core/configuration/filtering_configuration.h"
 #include "components/adblock/core/subscription/filtering_configuration_maintainer.h"
+#include "components/adblock/core/subscription/fused_url_filter_index.h"
 #include "components/adblock/core/subscription/installed_subscription.h"
 #include "components/adblock/core/subscription/preloaded_subscription_provider.h"
 #include "components/adblock/core/subscription/subscription_downloader.h"
@@ -46,12 +49,16 @@ class SubscriptionServiceImpl final : public SubscriptionService,
   // Used to notify this about updates to installed subscriptions.
   using SubscriptionUpdatedCallback =
       base::RepeatingCallback<void(const GURL& subscription_url)>;
+  // Used to notify this that the SubscriptionCollection provided by a
+  // maintainer changed.
+  using CollectionChangedCallback = base::RepeatingClosure;
   // Used to create FilteringConfigurationMaintainers for newly installed
   // FilteringConfigurations.
   using FilteringConfigurationMaintainerFactory =
       base::RepeatingCallback<std::unique_ptr<FilteringConfigurationMaintainer>(
           FilteringConfiguration* configuration,
-          SubscriptionUpdatedCallback observer)>;
+          SubscriptionUpdatedCallback observer,
+          CollectionChangedCallback collection_changed_callback)>;
   explicit SubscriptionServiceImpl(
       FilteringConfigurationMaintainerFactory maintainer_factory);
   ~SubscriptionServiceImpl() final;
@@ -74,6 +81,13 @@ class SubscriptionServiceImpl final : public SubscriptionService,
   void OnSubscriptionUpdated(const GURL& subscription_url);
   std::unique_ptr<FilteringConfigurationMaintainer> MakeMaintainer(
       FilteringConfiguration* configuration);
+  // Builds a new Snapshot from the enabled maintainers and makes it the one
+  // returned by GetCurrentSnapshot(). Must be called after every change to
+  // the set of enabled maintainers or to their SubscriptionCollections.
+  void PublishSnapshot();
+  // Makes |snapshot| the one returned by GetCurrentSnapshot().
+  void SetCurrentSnapshot(Snapshot snapshot);
+  void OnFusedIndexBuilt(scoped_refptr<FusedUrlFilterIndex> fused_index);
 
   SEQUENCE_CHECKER(sequence_checker_);
   FilteringConfigurationMaintainerFactory maintainer_factory_;
@@ -82,6 +96,18 @@ class SubscriptionServiceImpl final : public SubscriptionService,
                std::unique_ptr<FilteringConfigurationMaintainer>>;
   MaintainersCollection maintainers_;
   base::ObserverList<SubscriptionObserver> observers_;
+  // Built on |sequence_checker_| by PublishSnapshot(), read from any sequence
+  // by GetCurrentSnapshot(). The lock is only held to copy or swap the
+  // Snapshot, which amounts to a reference count change.
+  mutable base::Lock snapshot_lock_;
+  Snapshot current_snapshot_ GUARDED_BY(snapshot_lock_);
+  // Built in background from the collections of the current Snapshot, when
+  // there are several of them. May lag behind it for a short while after a
+  // change.
+  scoped_refptr<FusedUrlFilterIndex> fused_index_;
+  // Subscriptions of the fused index currently being built, if any. Spares
+  // building the same index twice when only the collections change.
+  FusedUrlFilterIndex::CollectionStates fused_index_states_being_built_;
   base::WeakPtrFactory<SubscriptionServiceImpl> weak_ptr_factory_{this};
 };
 
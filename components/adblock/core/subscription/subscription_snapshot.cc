@@ -0,0 +1,88 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/subscription_snapshot.h"
+
+#include "base/check.h"
+#include "base/check_op.h"
+#include "components/adblock/core/subscription/fused_url_filter_index.h"
+
+namespace adblock {
+
+SubscriptionSnapshot::SubscriptionSnapshot() = default;
+
+SubscriptionSnapshot::SubscriptionSnapshot(Collections collections) {
+  if (!collections.empty()) {
+    collections_ =
+        base::MakeRefCounted<SharedCollections>(std::move(collections));
+  }
+}
+
+SubscriptionSnapshot::SubscriptionSnapshot(const SubscriptionSnapshot&) =
+    default;
+SubscriptionSnapshot::SubscriptionSnapshot(SubscriptionSnapshot&&) = default;
+SubscriptionSnapshot& SubscriptionSnapshot::operator=(
+    const SubscriptionSnapshot&) = default;
+SubscriptionSnapshot& SubscriptionSnapshot::operator=(SubscriptionSnapshot&&) =
+    default;
+SubscriptionSnapshot::~SubscriptionSnapshot() = default;
+
+void SubscriptionSnapshot::push_back(
+    std::unique_ptr<SubscriptionCollection> collection) {
+  if (!collections_) {
+    collections_ = base::MakeRefCounted<SharedCollections>();
+  }
+  DCHECK(collections_->HasOneRef())
+      << "Snapshot cannot be modified once it is shared";
+  DCHECK(!fused_index_) << "Fused index would no longer match the collections";
+  collections_->data.push_back(std::move(collection));
+}
+
+SubscriptionSnapshot::const_iterator SubscriptionSnapshot::begin() const {
+  return collections_ ? collections_->data.cbegin() : const_iterator();
+}
+
+SubscriptionSnapshot::const_iterator SubscriptionSnapshot::end() const {
+  return collections_ ? collections_->data.cend() : const_iterator();
+}
+
+size_t SubscriptionSnapshot::size() const {
+  return collections_ ? collections_->data.size() : 0u;
+}
+
+bool SubscriptionSnapshot::empty() const {
+  return size() == 0u;
+}
+
+const std::unique_ptr<SubscriptionCollection>&
+SubscriptionSnapshot::operator[](size_t index) const {
+  DCHECK_LT(index, size());
+  return collections_->data[index];
+}
+
+SubscriptionSnapshot SubscriptionSnapshot::WithFusedIndex(
+    scoped_refptr<const FusedUrlFilterIndex> fused_index) const {
+  SubscriptionSnapshot result(*this);
+  result.fused_index_ = std::move(fused_index);
+  return result;
+}
+
+const FusedUrlFilterIndex* SubscriptionSnapshot::fused_index() const {
+  return fused_index_.get();
+}
+
+}  // namespace adblock
@@ -0,0 +1,78 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_SUBSCRIPTION_SNAPSHOT_H_
+#define COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_SUBSCRIPTION_SNAPSHOT_H_
+
+#include <memory>
+#include <vector>
+
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
+#include "components/adblock/core/subscription/subscription_collection.h"
+
+namespace adblock {
+
+class FusedUrlFilterIndex;
+
+// SubscriptionCollections of all enabled FilteringConfigurations, as present
+// at a single point in time. Copies share the same immutable collections, so
+// copying a snapshot costs one reference count increment regardless of how
+// many configurations and subscriptions it spans.
+// A snapshot may only be appended to while it is being built, before it is
+// first copied.
+class SubscriptionSnapshot {
+ public:
+  using Collections = std::vector<std::unique_ptr<SubscriptionCollection>>;
+  using value_type = Collections::value_type;
+  using const_iterator = Collections::const_iterator;
+
+  SubscriptionSnapshot();
+  explicit SubscriptionSnapshot(Collections collections);
+  SubscriptionSnapshot(const SubscriptionSnapshot&);
+  SubscriptionSnapshot(SubscriptionSnapshot&&);
+  SubscriptionSnapshot& operator=(const SubscriptionSnapshot&);
+  SubscriptionSnapshot& operator=(SubscriptionSnapshot&&);
+  ~SubscriptionSnapshot();
+
+  void push_back(std::unique_ptr<SubscriptionCollection> collection);
+
+  const_iterator begin() const;
+  const_iterator end() const;
+  size_t size() const;
+  bool empty() const;
+  const std::unique_ptr<SubscriptionCollection>& operator[](
+      size_t index) const;
+
+  // Returns a snapshot sharing the collections of this one, along with
+  // |fused_index|, which must have been built from their subscriptions.
+  SubscriptionSnapshot WithFusedIndex(
+      scoped_refptr<const FusedUrlFilterIndex> fused_index) const;
+  // Lets the collections be searched together, nullptr if they must be
+  // searched one by one.
+  const FusedUrlFilterIndex* fused_index() const;
+
+ private:
+  using SharedCollections = base::RefCountedData<Collections>;
+  // Null for an empty snapshot, to keep empty snapshots free of allocations.
+  scoped_refptr<SharedCollections> collections_;
+  scoped_refptr<const FusedUrlFilterIndex> fused_index_;
+};
+
+}  // namespace adblock
+
+#endif  // COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_SUBSCRIPTION_SNAPSHOT_H_
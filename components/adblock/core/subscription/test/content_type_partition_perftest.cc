@@ -0,0 +1,161 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "base/timer/elapsed_timer.h"
+#include "components/adblock/core/common/content_type.h"
+#include "components/adblock/core/common/keyword_extractor_utils.h"
+#include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/subscription/flatbuffer_key_lookup.h"
+#include "components/adblock/core/subscription/installed_subscription_impl.h"
+#include "components/adblock/core/subscription/test/load_gzipped_test_file.h"
+#include "components/adblock/core/subscription/url_keyword_extractor.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "url/gurl.h"
+
+namespace adblock {
+namespace {
+
+constexpr char kMetricFindFilters[] = ".find_filters";
+constexpr char kMetricSkippedFilters[] = ".skipped_filters";
+constexpr int kRepetitions = 10;
+
+struct NamedContentType {
+  const char* name;
+  ContentType content_type;
+};
+
+constexpr NamedContentType kContentTypes[] = {
+    {"script", ContentType::Script},
+    {"image", ContentType::Image},
+    {"stylesheet", ContentType::Stylesheet},
+    {"xmlhttprequest", ContentType::Xmlhttprequest},
+    {"subdocument", ContentType::Subdocument},
+    {"media", ContentType::Media},
+    {"font", ContentType::Font},
+    {"other", ContentType::Other},
+};
+
+}  // namespace
+
+class AdblockContentTypePartitionPerfTest : public testing::Test {
+ public:
+  void SetUp() override {
+    const auto easylist = LoadGzippedTestFile("easylist.txt.gz");
+    auto buffer = Convert(easylist);
+    ASSERT_TRUE(buffer);
+    subscription_ = base::MakeRefCounted<InstalledSubscriptionImpl>(
+        std::move(buffer), Subscription::InstallationState::Installed,
+        base::Time());
+    // A second copy, for inspecting the buckets directly.
+    buffer_ = Convert(easylist);
+    ASSERT_TRUE(buffer_);
+
+    const auto url_file_content = LoadGzippedTestFile("5000_urls.txt.gz");
+    for (const auto line :
+         base::SplitStringPiece(url_file_content, "\n", base::TRIM_WHITESPACE,
+                                base::SPLIT_WANT_NONEMPTY)) {
+      GURL url(line);
+      if (url.is_valid()) {
+        urls_.push_back(std::move(url));
+      }
+    }
+  }
+
+  static std::unique_ptr<FlatbufferData> Convert(const std::string& filters) {
+    std::stringstream input(filters);
+    auto result = FlatbufferConverter::Convert(input, GURL(), true);
+    if (!absl::holds_alternative<std::unique_ptr<FlatbufferData>>(result)) {
+      return nullptr;
+    }
+    return std::move(absl::get<std::unique_ptr<FlatbufferData>>(result));
+  }
+
+  // Returns the percentage of filters in the keyword buckets selected by the
+  // URL corpus that a request for |content_type| skips without evaluating
+  // them, either because of the bucket's union mask or of its slices.
+  double SkippedFilterPercentage(ContentType content_type) const {
+    const auto* index =
+        flat::GetSubscription(buffer_->data())->url_subresource_block();
+    size_t total = 0u;
+    size_t skipped = 0u;
+    const auto count_bucket = [&](const flat::UrlFiltersByKeyword* bucket) {
+      if (!bucket) {
+        return;
+      }
+      for (const auto* slice : *bucket->content_type_slices()) {
+        const size_t size = slice->end() - slice->begin();
+        total += size;
+        if ((slice->resource_type() & content_type) == 0) {
+          skipped += size;
+        }
+      }
+    };
+    for (const auto& url : urls_) {
+      const std::string lowercase_url = base::ToLowerASCII(url.spec());
+      UrlKeywordExtractor extractor(lowercase_url);
+      while (const auto keyword = extractor.GetNextKeyword()) {
+        if (!utils::IsBadKeyword(*keyword)) {
+          count_bucket(LookupByKey(index, *keyword));
+        }
+      }
+      count_bucket(LookupByKey(index, ""));
+    }
+    return total ? 100.0 * skipped / total : 0.0;
+  }
+
+  scoped_refptr<InstalledSubscriptionImpl> subscription_;
+  std::unique_ptr<FlatbufferData> buffer_;
+  std::vector<GURL> urls_;
+};
+
+// Matches the URL corpus against easylist once per content type. Content types
+// that few filters apply to benefit the most from skipping whole slices.
+TEST_F(AdblockContentTypePartitionPerfTest, FindFiltersPerContentType) {
+  for (const auto& entry : kContentTypes) {
+    perf_test::PerfResultReporter reporter("content_type_partition",
+                                           entry.name);
+    reporter.RegisterImportantMetric(kMetricFindFilters, "ms");
+    reporter.RegisterImportantMetric(kMetricSkippedFilters, "%");
+
+    size_t blocked = 0u;
+    base::ElapsedTimer timer;
+    for (int i = 0; i < kRepetitions; ++i) {
+      for (const auto& url : urls_) {
+        blocked += subscription_->HasUrlFilter(url, "domain.com",
+                                               entry.content_type, SiteKey(),
+                                               FilterCategory::Blocking);
+      }
+    }
+    reporter.AddResult(kMetricFindFilters, timer.Elapsed());
+    reporter.AddResult(kMetricSkippedFilters,
+                       SkippedFilterPercentage(entry.content_type));
+    // Keeps the matching from being optimized away.
+    EXPECT_GE(blocked, 0u);
+  }
+}
+
+}  // namespace adblock
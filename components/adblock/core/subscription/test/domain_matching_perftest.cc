@@ -0,0 +1,85 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/timer/elapsed_timer.h"
+#include "components/adblock/core/common/content_type.h"
+#include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/subscription/installed_subscription_impl.h"
+#include "components/adblock/core/subscription/request_context.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "url/gurl.h"
+
+namespace adblock {
+namespace {
+
+constexpr char kMetricRuntime[] = ".runtime";
+constexpr int kRepetitions = 10000;
+
+// Converts a single blocking filter restricted to |domain_count| domains and
+// measures how long matching a request against it takes, for a document
+// domain that is a subdomain of the last listed domain and for one that is
+// not listed at all.
+void MeasureDomainMatching(int domain_count) {
+  std::string domains;
+  for (int i = 0; i < domain_count; ++i) {
+    domains += base::StringPrintf("%sdomain%d.com", i ? "|" : "", i);
+  }
+  auto subscription = base::MakeRefCounted<InstalledSubscriptionImpl>(
+      FlatbufferConverter::Convert({"/banner/$domain=" + domains},
+                                   GURL("https://list.com/"), false),
+      Subscription::InstallationState::Installed, base::Time());
+
+  const GURL url("https://ads.com/banner/ad.png");
+  const UrlContext listed(
+      url, base::StringPrintf("www.sub.domain%d.com", domain_count - 1),
+      SiteKey());
+  const UrlContext not_listed(url, "www.sub.unlisted.com", SiteKey());
+
+  perf_test::PerfResultReporter reporter(
+      "domain_matching", base::StringPrintf("%d domains", domain_count));
+  reporter.RegisterImportantMetric(kMetricRuntime, "ms");
+  base::ElapsedTimer timer;
+  for (int i = 0; i < kRepetitions; ++i) {
+    EXPECT_TRUE(subscription->HasUrlFilter(listed, ContentType::Image,
+                                           FilterCategory::Blocking));
+    EXPECT_FALSE(subscription->HasUrlFilter(not_listed, ContentType::Image,
+                                            FilterCategory::Blocking));
+  }
+  reporter.AddResult(kMetricRuntime, timer.Elapsed());
+}
+
+}  // namespace
+
+TEST(AdblockDomainMatchingPerfTest, OneDomain) {
+  MeasureDomainMatching(1);
+}
+
+TEST(AdblockDomainMatchingPerfTest, FiftyDomains) {
+  MeasureDomainMatching(50);
+}
+
+TEST(AdblockDomainMatchingPerfTest, ThousandDomains) {
+  MeasureDomainMatching(1000);
+}
+
+}  // namespace adblock
@@ -0,0 +1,84 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/timer/elapsed_timer.h"
+#include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/subscription/installed_subscription_impl.h"
+#include "components/adblock/core/subscription/subscription_collection_impl.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "url/gurl.h"
+
+namespace adblock {
+namespace {
+
+constexpr char kMetricRuntime[] = ".runtime_per_frame";
+constexpr int kGenericSelectorCount = 20000;
+constexpr int kRepetitions = 50;
+
+// Converts a list of generic selectors, |exception_count| of which have an
+// exception on heavy.com alongside as many domain-specific selectors, and
+// measures gathering the selectors to hide on heavy.com.
+void MeasureElemhideExceptions(int exception_count) {
+  std::vector<std::string> filters;
+  for (int i = 0; i < kGenericSelectorCount; ++i) {
+    filters.push_back(base::StringPrintf("##.ad%d", i));
+  }
+  for (int i = 0; i < exception_count; ++i) {
+    filters.push_back(base::StringPrintf("heavy.com#@#.ad%d", i));
+    filters.push_back(base::StringPrintf("heavy.com##.heavy%d", i));
+  }
+  const SubscriptionCollectionImpl collection(
+      {base::MakeRefCounted<InstalledSubscriptionImpl>(
+          FlatbufferConverter::Convert(filters, GURL("https://list.com/"),
+                                       false),
+          Subscription::InstallationState::Installed, base::Time())});
+  const GURL frame_url("https://www.heavy.com/");
+
+  perf_test::PerfResultReporter reporter(
+      "elemhide_exceptions",
+      base::StringPrintf("%d exceptions", exception_count));
+  reporter.RegisterImportantMetric(kMetricRuntime, "ms");
+  base::ElapsedTimer timer;
+  for (int i = 0; i < kRepetitions; ++i) {
+    EXPECT_EQ(static_cast<size_t>(kGenericSelectorCount),
+              collection.GetElementHideSelectors(frame_url, {}, SiteKey())
+                  .size());
+  }
+  reporter.AddResult(kMetricRuntime, timer.Elapsed() / kRepetitions);
+}
+
+}  // namespace
+
+TEST(AdblockElemhideExceptionsPerfTest, HundredExceptions) {
+  MeasureElemhideExceptions(100);
+}
+
+TEST(AdblockElemhideExceptionsPerfTest, ThousandExceptions) {
+  MeasureElemhideExceptions(1000);
+}
+
+TEST(AdblockElemhideExceptionsPerfTest, TenThousandExceptions) {
+  MeasureElemhideExceptions(10000);
+}
+
+}  // namespace adblock
@@ -0,0 +1,163 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/filter_match_profiler.h"
+
+#include "base/json/json_reader.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/values.h"
+#include "components/adblock/core/common/content_type.h"
+#include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/subscription/installed_subscription_impl.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace adblock {
+
+constexpr char kSubscription[] = "http://data.com/filters.txt";
+
+TEST(AdblockFilterMatchProfilerTest, DisabledByDefault) {
+  FilterMatchProfiler profiler;
+  EXPECT_FALSE(profiler.IsEnabled());
+  EXPECT_FALSE(FilterMatchProfiler::GetInstance()->IsEnabled());
+}
+
+TEST(AdblockFilterMatchProfilerTest, AccountsPerBucketAndFilter) {
+  FilterMatchProfiler profiler;
+  profiler.SetEnabled(true);
+  profiler.RecordBucketVisit(kSubscription, "ads", 2u);
+  profiler.RecordFilterEvaluation(kSubscription, "ads", "/ads/banner", true,
+                                  base::Microseconds(3));
+  profiler.RecordBucketVisit(kSubscription, "ads", 2u);
+  profiler.RecordFilterEvaluation(kSubscription, "ads", "/ads/banner", false,
+                                  base::Microseconds(2));
+  profiler.RecordFilterEvaluation(kSubscription, "ads", "/ads/popup", false,
+                                  base::Microseconds(1));
+
+  const auto stats = profiler.GetBucketStats(kSubscription, "ads");
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(stats->visits, 2u);
+  EXPECT_EQ(stats->size, 2u);
+  EXPECT_EQ(stats->total_time, base::Microseconds(6));
+  ASSERT_EQ(stats->filters.size(), 2u);
+  const auto& banner = stats->filters.at("/ads/banner");
+  EXPECT_EQ(banner.evaluations, 2u);
+  EXPECT_EQ(banner.matches, 1u);
+  EXPECT_EQ(banner.total_time, base::Microseconds(5));
+  const auto& popup = stats->filters.at("/ads/popup");
+  EXPECT_EQ(popup.evaluations, 1u);
+  EXPECT_EQ(popup.matches, 0u);
+
+  EXPECT_FALSE(profiler.GetBucketStats(kSubscription, "banner"));
+  EXPECT_FALSE(profiler.GetBucketStats("http://other.com/list.txt", "ads"));
+
+  profiler.Reset();
+  EXPECT_FALSE(profiler.GetBucketStats(kSubscription, "ads"));
+}
+
+TEST(AdblockFilterMatchProfilerTest, FilterStatsSummedOverBuckets) {
+  FilterMatchProfiler profiler;
+  profiler.RecordFilterEvaluation(kSubscription, "ads", "/ads/", true,
+                                  base::Microseconds(3));
+  profiler.RecordFilterEvaluation(kSubscription, "", "/ads/", false,
+                                  base::Microseconds(2));
+  profiler.RecordFilterEvaluation(kSubscription, "", "/popup/", false,
+                                  base::Microseconds(1));
+  profiler.RecordFilterEvaluation("http://other.com/list.txt", "ads", "/ads/",
+                                  true, base::Microseconds(1));
+
+  const auto stats = profiler.GetFilterStats(kSubscription);
+  ASSERT_EQ(stats.size(), 2u);
+  EXPECT_EQ(stats.at("/ads/").evaluations, 2u);
+  EXPECT_EQ(stats.at("/ads/").matches, 1u);
+  EXPECT_EQ(stats.at("/ads/").total_time, base::Microseconds(5));
+  EXPECT_EQ(stats.at("/popup/").evaluations, 1u);
+  EXPECT_TRUE(profiler.GetFilterStats("http://unknown.com/list.txt").empty());
+}
+
+TEST(AdblockFilterMatchProfilerTest, JsonOrderedByCost) {
+  FilterMatchProfiler profiler;
+  profiler.RecordBucketVisit(kSubscription, "cheap", 1u);
+  profiler.RecordFilterEvaluation(kSubscription, "cheap", "/cheap/", false,
+                                  base::Microseconds(1));
+  profiler.RecordBucketVisit(kSubscription, "", 2u);
+  profiler.RecordFilterEvaluation(kSubscription, "", "fast", false,
+                                  base::Microseconds(2));
+  profiler.RecordFilterEvaluation(kSubscription, "", "slow", true,
+                                  base::Microseconds(8));
+
+  const auto json = base::JSONReader::Read(profiler.ToJson());
+  ASSERT_TRUE(json && json->is_dict());
+  EXPECT_EQ(json->GetDict().FindBool("enabled"), false);
+  const auto* buckets = json->GetDict().FindList("buckets");
+  ASSERT_TRUE(buckets);
+  ASSERT_EQ(buckets->size(), 2u);
+
+  const auto& expensive = (*buckets)[0].GetDict();
+  EXPECT_EQ(*expensive.FindString("subscription"), kSubscription);
+  EXPECT_EQ(*expensive.FindString("keyword"), "");
+  EXPECT_EQ(expensive.FindInt("size"), 2);
+  EXPECT_EQ(expensive.FindDouble("visits"), 1.0);
+  EXPECT_EQ(expensive.FindDouble("total_time_us"), 10.0);
+  const auto* filters = expensive.FindList("filters");
+  ASSERT_TRUE(filters);
+  ASSERT_EQ(filters->size(), 2u);
+  EXPECT_EQ(*(*filters)[0].GetDict().FindString("pattern"), "slow");
+  EXPECT_EQ((*filters)[0].GetDict().FindDouble("matches"), 1.0);
+  EXPECT_EQ(*(*filters)[1].GetDict().FindString("pattern"), "fast");
+
+  EXPECT_EQ(*(*buckets)[1].GetDict().FindString("keyword"), "cheap");
+}
+
+TEST(AdblockFilterMatchProfilerTest, InstalledSubscriptionRecordsWhenEnabled) {
+  auto* profiler = FilterMatchProfiler::GetInstance();
+  profiler->Reset();
+  auto subscription = base::MakeRefCounted<InstalledSubscriptionImpl>(
+      FlatbufferConverter::Convert({"banner"}, GURL(kSubscription), false),
+      Subscription::InstallationState::Installed, base::Time());
+  const GURL url("https://example.com/banner.jpg");
+
+  EXPECT_TRUE(subscription->HasUrlFilter(url, "example.com",
+                                         ContentType::Image, {},
+                                         FilterCategory::Blocking));
+  EXPECT_EQ(profiler->ToJson().find("banner"), std::string::npos);
+
+  profiler->SetEnabled(true);
+  EXPECT_TRUE(subscription->HasUrlFilter(url, "example.com",
+                                         ContentType::Image, {},
+                                         FilterCategory::Blocking));
+  profiler->SetEnabled(false);
+
+  const auto json = base::JSONReader::Read(profiler->ToJson());
+  ASSERT_TRUE(json);
+  const auto* buckets = json->GetDict().FindList("buckets");
+  ASSERT_TRUE(buckets);
+  ASSERT_EQ(buckets->size(), 1u);
+  const auto& bucket = (*buckets)[0].GetDict();
+  EXPECT_EQ(*bucket.FindString("subscription"), kSubscription);
+  EXPECT_EQ(bucket.FindDouble("visits"), 1.0);
+  const auto* filters = bucket.FindList("filters");
+  ASSERT_TRUE(filters);
+  ASSERT_EQ(filters->size(), 1u);
+  EXPECT_EQ(*(*filters)[0].GetDict().FindString("pattern"), "banner");
+  EXPECT_EQ((*filters)[0].GetDict().FindDouble("evaluations"), 1.0);
+  EXPECT_EQ((*filters)[0].GetDict().FindDouble("matches"), 1.0);
+  profiler->Reset();
+}
+
+}  // namespace adblock
@@ -108,6 +108,9 @@ class FakeSubscription final : public InstalledSubscription {
 
   base::TimeDelta GetExpirationInterval() const final { return base::Days(5); }
 
+  using InstalledSubscription::HasPopupFilter;
+  using InstalledSubscription::HasSpecialFilter;
+  using InstalledSubscription::HasUrlFilter;
   bool HasUrlFilter(const GURL& url,
                     const std::string& document_domain,
                     ContentType type,
@@ -205,7 +208,7 @@ class AdblockFilteringConfigurationMaintainerImplTest : public testing::Test {
         filtering_configuration_.get(), std::move(storage),
         std::move(downloader), std::move(preloaded_subscription_provider),
         std::move(updater), &conversion_executor_, &persistent_metadata_,
-        observer_.Get());
+        observer_.Get(), collection_changed_callback_.Get());
     testee_->InitializeStorage();
   }
 
@@ -278,6 +281,9 @@ class AdblockFilteringConfigurationMaintainerImplTest : public testing::Test {
   base::MockCallback<
       FilteringConfigurationMaintainerImpl::SubscriptionUpdatedCallback>
       observer_;
+  NiceMock<base::MockCallback<
+      FilteringConfigurationMaintainerImpl::CollectionChangedCallback>>
+      collection_changed_callback_;
   base::RepeatingClosure run_update_check_callback_;
   std::unique_ptr<FilteringConfigurationMaintainerImpl> testee_;
 };
@@ -669,6 +675,43 @@ TEST_F(AdblockFilteringConfigurationMaintainerImplTest, CustomFilterIsAdded) {
                              CustomFiltersUrl().spec(), "subscription"));
 }
 
+TEST_F(AdblockFilteringConfigurationMaintainerImplTest,
+       CollectionGenerationChangesWithState) {
+  InitializeTesteeWithNoSubscriptions();
+  const uint64_t initial_generation =
+      testee_->GetSubscriptionCollection()->GetGeneration();
+  EXPECT_NE(initial_generation, 0u);
+  // Unchanged state, unchanged generation.
+  EXPECT_EQ(testee_->GetSubscriptionCollection()->GetGeneration(),
+            initial_generation);
+
+  std::vector<std::string> filters = {"test"};
+  EXPECT_CALL(conversion_executor_, ConvertCustomFilters(filters))
+      .WillOnce(testing::Return(
+          base::MakeRefCounted<FakeSubscription>(CustomFiltersUrl().spec())));
+  filtering_configuration_->AddCustomFilter("test");
+  EXPECT_GT(testee_->GetSubscriptionCollection()->GetGeneration(),
+            initial_generation);
+}
+
+TEST_F(AdblockFilteringConfigurationMaintainerImplTest,
+       CollectionChangedCallbackRunOnStateChange) {
+  InitializeTesteeWithNoSubscriptions();
+  // Adding custom filters changes the collection state, the owner of this
+  // maintainer learns that its SubscriptionCollection needs to be fetched
+  // again.
+  EXPECT_CALL(conversion_executor_, ConvertCustomFilters(_))
+      .WillOnce(testing::Return(
+          base::MakeRefCounted<FakeSubscription>(CustomFiltersUrl().spec())));
+  EXPECT_CALL(collection_changed_callback_, Run());
+  filtering_configuration_->AddCustomFilter("test");
+  testing::Mock::VerifyAndClearExpectations(&collection_changed_callback_);
+
+  // Requesting the collection alone does not count as a change.
+  EXPECT_CALL(collection_changed_callback_, Run()).Times(0);
+  testee_->GetSubscriptionCollection();
+}
+
 TEST_F(AdblockFilteringConfigurationMaintainerImplTest,
        PreloadedSubscriptionProviderUpdatedDuringChanges) {
   testing::InSequence sequence;
@@ -0,0 +1,127 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/flatbuffer_key_lookup.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "base/timer/elapsed_timer.h"
+#include "components/adblock/core/common/keyword_extractor_utils.h"
+#include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/subscription/domain_splitter.h"
+#include "components/adblock/core/subscription/test/load_gzipped_test_file.h"
+#include "components/adblock/core/subscription/url_keyword_extractor.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "url/gurl.h"
+
+namespace adblock {
+namespace {
+
+constexpr char kMetricCopyingLookup[] = ".copying_lookup";
+constexpr char kMetricStringPieceLookup[] = ".string_piece_lookup";
+constexpr int kRepetitions = 20;
+
+}  // namespace
+
+class AdblockFlatbufferKeyLookupPerfTest : public testing::Test {
+ public:
+  void SetUp() override {
+    std::stringstream input(LoadGzippedTestFile("easylist.txt.gz"));
+    auto result = FlatbufferConverter::Convert(input, GURL(), true);
+    ASSERT_TRUE(
+        absl::holds_alternative<std::unique_ptr<FlatbufferData>>(result));
+    buffer_ = std::move(absl::get<std::unique_ptr<FlatbufferData>>(result));
+    index_ = flat::GetSubscription(buffer_->data());
+
+    url_file_content_ = LoadGzippedTestFile("5000_urls.txt.gz");
+    for (const auto line :
+         base::SplitStringPiece(url_file_content_, "\n", base::TRIM_WHITESPACE,
+                                base::SPLIT_WANT_NONEMPTY)) {
+      lowercase_urls_.push_back(base::ToLowerASCII(line));
+      hosts_.push_back(GURL(line).host());
+    }
+  }
+
+  // Reports how many lookups per second |lookup| performs for the keywords of
+  // the URL corpus followed by all subdomains of its hosts. |lookup| returns
+  // whether the key was found.
+  template <typename Lookup>
+  size_t Measure(perf_test::PerfResultReporter& reporter,
+                 const std::string& metric,
+                 Lookup lookup) {
+    size_t found = 0u;
+    size_t lookups = 0u;
+    base::ElapsedTimer timer;
+    for (int i = 0; i < kRepetitions; ++i) {
+      for (const auto& url : lowercase_urls_) {
+        UrlKeywordExtractor extractor(url);
+        while (const auto keyword = extractor.GetNextKeyword()) {
+          if (utils::IsBadKeyword(*keyword)) {
+            continue;
+          }
+          found += lookup(index_->url_subresource_block(), *keyword);
+          ++lookups;
+        }
+      }
+      for (const auto& host : hosts_) {
+        DomainSplitter splitter(host);
+        while (const auto subdomain = splitter.FindNextSubdomain()) {
+          found += lookup(index_->elemhide(), *subdomain);
+          ++lookups;
+        }
+      }
+    }
+    reporter.AddResult(metric, lookups / timer.Elapsed().InSecondsF());
+    return found;
+  }
+
+  std::unique_ptr<FlatbufferData> buffer_;
+  const flat::Subscription* index_ = nullptr;
+  std::string url_file_content_;
+  std::vector<std::string> lowercase_urls_;
+  std::vector<std::string> hosts_;
+};
+
+TEST_F(AdblockFlatbufferKeyLookupPerfTest, KeywordAndDomainLookups) {
+  perf_test::PerfResultReporter reporter("flatbuffer_key_lookup", "easylist");
+  reporter.RegisterImportantMetric(kMetricCopyingLookup, "lookups/s");
+  reporter.RegisterImportantMetric(kMetricStringPieceLookup, "lookups/s");
+
+  // The previous approach: copy the key to null-terminate it, then use the
+  // generated LookupByKey().
+  const size_t copying_found =
+      Measure(reporter, kMetricCopyingLookup,
+              [](const auto* vector, base::StringPiece key) {
+                const std::string terminated_key(key);
+                return vector->LookupByKey(terminated_key.c_str()) != nullptr;
+              });
+  const size_t string_piece_found =
+      Measure(reporter, kMetricStringPieceLookup,
+              [](const auto* vector, base::StringPiece key) {
+                return LookupByKey(vector, key) != nullptr;
+              });
+
+  // Both lookups must agree for the comparison to be meaningful.
+  EXPECT_EQ(copying_found, string_piece_found);
+}
+
+}  // namespace adblock
@@ -0,0 +1,82 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/flatbuffer_key_lookup.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace adblock {
+
+class AdblockFlatbufferKeyLookupTest : public testing::Test {
+ public:
+  void SetUp() override {
+    std::vector<std::string> filters = {
+        "||ads.example.com^",  "/banner/*",
+        "*$image",             "example.org##.ad",
+        "example.org#@#.ad",   "sub.example.org#$#log hello",
+    };
+    buffer_ = FlatbufferConverter::Convert(filters, GURL(), true);
+    index_ = flat::GetSubscription(buffer_->data());
+  }
+
+  std::unique_ptr<FlatbufferData> buffer_;
+  const flat::Subscription* index_ = nullptr;
+};
+
+TEST_F(AdblockFlatbufferKeyLookupTest, FindsKeysThatAreNotNullTerminated) {
+  const std::string url = "https://example.com/banner/image.png";
+  // "banner", followed by "/image.png" rather than a null terminator.
+  const base::StringPiece keyword = base::StringPiece(url).substr(20, 6);
+  const auto* bucket = LookupByKey(index_->url_subresource_block(), keyword);
+  ASSERT_TRUE(bucket);
+  EXPECT_EQ(KeyOf(bucket), "banner");
+
+  const std::string domain = "example.org.";
+  const auto* elemhide = LookupByKey(
+      index_->elemhide(), base::StringPiece(domain).substr(0, 11));
+  ASSERT_TRUE(elemhide);
+  EXPECT_EQ(KeyOf(elemhide), "example.org");
+  EXPECT_TRUE(LookupByKey(index_->elemhide_exception(), "example.org"));
+  EXPECT_TRUE(LookupByKey(index_->snippet(), "sub.example.org"));
+}
+
+TEST_F(AdblockFlatbufferKeyLookupTest, FindsEmptyKey) {
+  const auto* bucket = LookupByKey(index_->url_subresource_block(), "");
+  ASSERT_TRUE(bucket);
+  EXPECT_EQ(bucket, index_->url_subresource_block()->LookupByKey(""));
+}
+
+TEST_F(AdblockFlatbufferKeyLookupTest, PrefixesAndExtensionsOfKeysNotFound) {
+  EXPECT_FALSE(LookupByKey(index_->url_subresource_block(), "bann"));
+  EXPECT_FALSE(LookupByKey(index_->url_subresource_block(), "banners"));
+  EXPECT_FALSE(LookupByKey(index_->elemhide(), "org"));
+  EXPECT_FALSE(LookupByKey(index_->snippet(), "example.org"));
+}
+
+TEST_F(AdblockFlatbufferKeyLookupTest, NullVectorHasNoKeys) {
+  const flatbuffers::Vector<flatbuffers::Offset<flat::UrlFiltersByKeyword>>*
+      missing_index = nullptr;
+  EXPECT_FALSE(LookupByKey(missing_index, "banner"));
+}
+
+}  // namespace adblock
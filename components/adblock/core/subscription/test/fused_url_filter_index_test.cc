@@ -0,0 +1,133 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/fused_url_filter_index.h"
+
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_refptr.h"
+#include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/subscription/installed_subscription_impl.h"
+#include "components/adblock/core/subscription/request_context.h"
+#include "components/adblock/core/subscription/test/mock_installed_subscription.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace adblock {
+
+class AdblockFusedUrlFilterIndexTest : public testing::Test {
+ public:
+  scoped_refptr<InstalledSubscription> MakeSubscription(
+      const std::string& url,
+      std::vector<std::string> filters) {
+    return base::MakeRefCounted<InstalledSubscriptionImpl>(
+        FlatbufferConverter::Convert(filters, GURL(url), false),
+        Subscription::InstallationState::Installed, base::Time());
+  }
+
+  static FusedUrlFilterIndex::CollectionMask Mask(const std::string& bits) {
+    return FusedUrlFilterIndex::CollectionMask(bits);
+  }
+
+  const GURL kRequestUrl{"https://ads.com/banner/advert.js"};
+  const std::string kDocumentDomain{"example.com"};
+};
+
+TEST_F(AdblockFusedUrlFilterIndexTest, NotBuiltFromNonFlatbufferSubscription) {
+  EXPECT_FALSE(FusedUrlFilterIndex::Build(
+      {{MakeSubscription("https://list1.com/", {"/banner/"})},
+       {base::MakeRefCounted<MockInstalledSubscription>()}}));
+}
+
+TEST_F(AdblockFusedUrlFilterIndexTest, NotBuiltFromTooManyCollections) {
+  FusedUrlFilterIndex::CollectionStates states(
+      FusedUrlFilterIndex::kMaxCollections + 1);
+  EXPECT_FALSE(FusedUrlFilterIndex::Build(states));
+  states.pop_back();
+  EXPECT_TRUE(FusedUrlFilterIndex::Build(states));
+}
+
+TEST_F(AdblockFusedUrlFilterIndexTest, IsBuiltFromSameStatesOnly) {
+  const FusedUrlFilterIndex::CollectionStates states = {
+      {MakeSubscription("https://list1.com/", {"/banner/"})},
+      {MakeSubscription("https://list2.com/", {"/advert."})}};
+  auto index = FusedUrlFilterIndex::Build(states);
+  ASSERT_TRUE(index);
+  EXPECT_TRUE(index->IsBuiltFrom(states));
+  EXPECT_FALSE(index->IsBuiltFrom({states[1], states[0]}));
+  EXPECT_FALSE(index->IsBuiltFrom({states[0]}));
+}
+
+TEST_F(AdblockFusedUrlFilterIndexTest, BlockingCollectionsReported) {
+  auto index = FusedUrlFilterIndex::Build(
+      {{MakeSubscription("https://list1.com/", {"/banner/"})},
+       {MakeSubscription("https://list2.com/", {"/other.js"})},
+       {MakeSubscription("https://list3.com/", {"/other.js"}),
+        MakeSubscription("https://list4.com/",
+                         {"/advert.js$domain=example.com"})}});
+  ASSERT_TRUE(index);
+  const UrlContext context(kRequestUrl, kDocumentDomain, SiteKey());
+  EXPECT_EQ(Mask("101"),
+            index->FindBlockingCollections(context, ContentType::Script));
+  // Content type and domain restrictions apply.
+  EXPECT_EQ(Mask("001"),
+            index->FindBlockingCollections(
+                UrlContext(kRequestUrl, "other.com", SiteKey()),
+                ContentType::Script));
+  EXPECT_EQ(Mask("000"),
+            index->FindBlockingCollections(
+                UrlContext(GURL("https://ads.com/image.png"), kDocumentDomain,
+                           SiteKey()),
+                ContentType::Image));
+}
+
+TEST_F(AdblockFusedUrlFilterIndexTest, SharedSubscriptionCountsForAll) {
+  auto shared = MakeSubscription("https://list1.com/", {"/banner/"});
+  auto index = FusedUrlFilterIndex::Build(
+      {{shared},
+       {MakeSubscription("https://list2.com/", {"/other.js"}), shared},
+       {MakeSubscription("https://list3.com/", {"/other.js"})}});
+  ASSERT_TRUE(index);
+  const UrlContext context(kRequestUrl, kDocumentDomain, SiteKey());
+  EXPECT_EQ(Mask("011"),
+            index->FindBlockingCollections(context, ContentType::Script));
+}
+
+TEST_F(AdblockFusedUrlFilterIndexTest, AllowingFiltersDoNotCount) {
+  // Allowing filters are left to each collection, only blocking filters
+  // decide which collections need to look further.
+  auto index = FusedUrlFilterIndex::Build(
+      {{MakeSubscription("https://list1.com/", {"@@/banner/"})},
+       {MakeSubscription("https://list2.com/", {"/banner/", "@@/banner/"})}});
+  ASSERT_TRUE(index);
+  const UrlContext context(kRequestUrl, kDocumentDomain, SiteKey());
+  EXPECT_EQ(Mask("10"),
+            index->FindBlockingCollections(context, ContentType::Script));
+}
+
+TEST_F(AdblockFusedUrlFilterIndexTest, KeywordlessFiltersSearched) {
+  auto index = FusedUrlFilterIndex::Build(
+      {{MakeSubscription("https://list1.com/", {"/other.js"})},
+       {MakeSubscription("https://list2.com/", {"advert*js"})}});
+  ASSERT_TRUE(index);
+  const UrlContext context(kRequestUrl, kDocumentDomain, SiteKey());
+  EXPECT_EQ(Mask("10"),
+            index->FindBlockingCollections(context, ContentType::Script));
+}
+
+}  // namespace adblock
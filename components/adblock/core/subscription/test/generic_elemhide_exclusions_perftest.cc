@@ -0,0 +1,104 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/string_split.h"
+#include "base/timer/elapsed_timer.h"
+#include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/subscription/installed_subscription_impl.h"
+#include "components/adblock/core/subscription/test/load_gzipped_test_file.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "url/gurl.h"
+
+namespace adblock {
+namespace {
+
+constexpr char kMetricRuntime[] = ".runtime_per_domain";
+constexpr size_t kDomainCount = 1000u;
+constexpr int kRepetitions = 5;
+
+}  // namespace
+
+// Measures gathering the generic element hiding selectors of easylist for
+// the frames of 1000 distinct domains, where every generic filter with
+// exclude domains is resolved through the index of excluded domains.
+class AdblockGenericElemhideExclusionsPerfTest : public testing::Test {
+ public:
+  void SetUp() override {
+    std::stringstream input(LoadGzippedTestFile("easylist.txt.gz"));
+    auto result = FlatbufferConverter::Convert(input, GURL(), true);
+    ASSERT_TRUE(
+        absl::holds_alternative<std::unique_ptr<FlatbufferData>>(result));
+    subscription_ = base::MakeRefCounted<InstalledSubscriptionImpl>(
+        std::move(absl::get<std::unique_ptr<FlatbufferData>>(result)),
+        Subscription::InstallationState::Installed, base::Time());
+
+    std::set<std::string> hosts;
+    const auto url_file_content = LoadGzippedTestFile("5000_urls.txt.gz");
+    for (const auto line :
+         base::SplitStringPiece(url_file_content, "\n", base::TRIM_WHITESPACE,
+                                base::SPLIT_WANT_NONEMPTY)) {
+      const GURL url(line);
+      if (url.is_valid() && hosts.insert(url.host()).second) {
+        frame_urls_.push_back(url.GetWithEmptyPath());
+        if (frame_urls_.size() == kDomainCount) {
+          break;
+        }
+      }
+    }
+  }
+
+  void Measure(const std::string& story, bool domain_dependent_only) {
+    perf_test::PerfResultReporter reporter("generic_elemhide_exclusions",
+                                           story);
+    reporter.RegisterImportantMetric(kMetricRuntime, "ms");
+    size_t selector_count = 0u;
+    base::ElapsedTimer timer;
+    for (int i = 0; i < kRepetitions; ++i) {
+      for (const auto& frame_url : frame_urls_) {
+        const auto selectors =
+            domain_dependent_only
+                ? subscription_->GetDomainDependentElemhideSelectors(frame_url)
+                : subscription_->GetElemhideSelectors(frame_url, false);
+        selector_count += selectors.elemhide_selectors.size();
+      }
+    }
+    reporter.AddResult(kMetricRuntime,
+                       timer.Elapsed() / (kRepetitions * frame_urls_.size()));
+    EXPECT_GT(selector_count, 0u);
+  }
+
+  scoped_refptr<InstalledSubscription> subscription_;
+  std::vector<GURL> frame_urls_;
+};
+
+TEST_F(AdblockGenericElemhideExclusionsPerfTest, AllGenericSelectors) {
+  Measure("all_generic_selectors", false);
+}
+
+TEST_F(AdblockGenericElemhideExclusionsPerfTest, DomainDependentSelectors) {
+  Measure("domain_dependent_selectors", true);
+}
+
+}  // namespace adblock
@@ -0,0 +1,154 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/memory/scoped_refptr.h"
+#include "base/timer/elapsed_timer.h"
+#include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/subscription/generic_elemhide_stylesheet.h"
+#include "components/adblock/core/subscription/installed_subscription_impl.h"
+#include "components/adblock/core/subscription/subscription_collection_impl.h"
+#include "components/adblock/core/subscription/test/load_gzipped_test_file.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "url/gurl.h"
+
+namespace adblock {
+namespace {
+
+constexpr char kMetricBuild[] = ".build";
+constexpr char kMetricGeneration[] = ".generation_per_frame";
+constexpr char kMetricRenderedSelectors[] = ".rendered_selectors_per_frame";
+constexpr int kRepetitions = 20;
+
+constexpr const char* kTopDomains[] = {
+    "https://www.google.com/",
+    "https://www.youtube.com/",
+    "https://www.facebook.com/",
+    "https://www.wikipedia.org/",
+    "https://www.instagram.com/",
+    "https://www.amazon.com/",
+    "https://www.reddit.com/",
+    "https://www.yahoo.com/",
+    "https://www.bing.com/",
+    "https://www.linkedin.com/",
+    "https://www.twitch.tv/",
+    "https://www.ebay.com/",
+    "https://www.cnn.com/",
+    "https://www.nytimes.com/",
+    "https://www.bbc.co.uk/",
+    "https://www.theguardian.com/",
+    "https://www.imdb.com/",
+    "https://www.spiegel.de/",
+    "https://www.bild.de/",
+    "https://www.lemonde.fr/",
+    "https://www.repubblica.it/",
+    "https://www.elpais.com/",
+    "https://www.dailymail.co.uk/",
+    "https://www.forbes.com/",
+    "https://www.weather.com/",
+    "https://www.espn.com/",
+    "https://www.stackoverflow.com/",
+    "https://www.github.com/",
+    "https://www.msn.com/",
+    "https://www.aol.com/",
+};
+
+}  // namespace
+
+// Measures producing the element hiding stylesheets for the main frames of a
+// list of popular sites, rendering every selector for every frame or only the
+// domain-dependent ones next to a stylesheet shared by all frames.
+class AdblockGenericElemhideStylesheetPerfTest : public testing::Test {
+ public:
+  void SetUp() override {
+    for (const char* filename : {"easylist.txt.gz", "exceptionrules.txt.gz"}) {
+      std::stringstream input(LoadGzippedTestFile(filename));
+      auto result = FlatbufferConverter::Convert(input, GURL(), true);
+      ASSERT_TRUE(
+          absl::holds_alternative<std::unique_ptr<FlatbufferData>>(result));
+      subscriptions_.push_back(base::MakeRefCounted<InstalledSubscriptionImpl>(
+          std::move(absl::get<std::unique_ptr<FlatbufferData>>(result)),
+          Subscription::InstallationState::Installed, base::Time()));
+    }
+  }
+
+  std::vector<scoped_refptr<InstalledSubscription>> subscriptions_;
+};
+
+TEST_F(AdblockGenericElemhideStylesheetPerfTest, AllSelectorsPerFrame) {
+  const SubscriptionCollectionImpl collection(subscriptions_);
+  perf_test::PerfResultReporter reporter("generic_elemhide_stylesheet",
+                                         "all_selectors_per_frame");
+  reporter.RegisterImportantMetric(kMetricGeneration, "ms");
+  reporter.RegisterImportantMetric(kMetricRenderedSelectors, "count");
+  size_t rendered_selectors = 0u;
+  base::ElapsedTimer timer;
+  for (int i = 0; i < kRepetitions; ++i) {
+    for (const char* domain : kTopDomains) {
+      const auto selectors =
+          collection.GetElementHideSelectors(GURL(domain), {}, SiteKey());
+      std::string stylesheet;
+      AppendElemhideRules(selectors, stylesheet);
+      rendered_selectors += selectors.size();
+    }
+  }
+  const size_t frames = kRepetitions * std::size(kTopDomains);
+  reporter.AddResult(kMetricGeneration, timer.Elapsed() / frames);
+  reporter.AddResult(kMetricRenderedSelectors,
+                     static_cast<size_t>(rendered_selectors / frames));
+}
+
+TEST_F(AdblockGenericElemhideStylesheetPerfTest, SharedGenericStylesheet) {
+  perf_test::PerfResultReporter reporter("generic_elemhide_stylesheet",
+                                         "shared_generic_stylesheet");
+  reporter.RegisterImportantMetric(kMetricBuild, "ms");
+  reporter.RegisterImportantMetric(kMetricGeneration, "ms");
+  reporter.RegisterImportantMetric(kMetricRenderedSelectors, "count");
+  base::ElapsedTimer build_timer;
+  auto generic_elemhide = GenericElemhideStylesheet::Build(subscriptions_);
+  reporter.AddResult(kMetricBuild, build_timer.Elapsed());
+
+  const SubscriptionCollectionImpl collection(subscriptions_, nullptr, 1u,
+                                              std::move(generic_elemhide));
+  size_t rendered_selectors = 0u;
+  base::ElapsedTimer timer;
+  for (int i = 0; i < kRepetitions; ++i) {
+    for (const char* domain : kTopDomains) {
+      const auto data =
+          collection.GetElementHideData(GURL(domain), {}, SiteKey());
+      // The shared part is copied, not rendered again.
+      std::string stylesheet;
+      if (data.generic_stylesheet) {
+        stylesheet = data.generic_stylesheet->stylesheet();
+      }
+      AppendElemhideRules(data.selectors, stylesheet);
+      rendered_selectors += data.selectors.size();
+    }
+  }
+  const size_t frames = kRepetitions * std::size(kTopDomains);
+  reporter.AddResult(kMetricGeneration, timer.Elapsed() / frames);
+  reporter.AddResult(kMetricRenderedSelectors,
+                     static_cast<size_t>(rendered_selectors / frames));
+}
+
+}  // namespace adblock
@@ -0,0 +1,182 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/generic_elemhide_stylesheet.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/subscription/installed_subscription_impl.h"
+#include "components/adblock/core/subscription/subscription_collection_impl.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace adblock {
+
+class AdblockGenericElemhideStylesheetTest : public testing::Test {
+ public:
+  scoped_refptr<InstalledSubscription> MakeSubscription(
+      const std::string& url,
+      std::vector<std::string> filters) {
+    return base::MakeRefCounted<InstalledSubscriptionImpl>(
+        FlatbufferConverter::Convert(filters, GURL(url), false),
+        Subscription::InstallationState::Installed, base::Time());
+  }
+
+  // Selectors hidden on |frame_url| by a collection of |subscriptions| that
+  // uses a generic stylesheet. Expects a collection without one to hide
+  // exactly the same.
+  std::set<std::string> HiddenSelectors(
+      const std::vector<scoped_refptr<InstalledSubscription>>& subscriptions,
+      const GURL& frame_url) {
+    const SubscriptionCollectionImpl collection(
+        subscriptions, nullptr, 1u,
+        GenericElemhideStylesheet::Build(subscriptions));
+    const auto data = collection.GetElementHideData(frame_url, {}, SiteKey());
+    std::set<std::string> hidden(data.selectors.begin(),
+                                 data.selectors.end());
+    if (data.generic_stylesheet) {
+      for (const auto& rule : base::SplitStringUsingSubstr(
+               data.generic_stylesheet->stylesheet(), kRuleEnd,
+               base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+        for (const auto& selector : base::SplitStringUsingSubstr(
+                 rule, ", ", base::TRIM_WHITESPACE,
+                 base::SPLIT_WANT_NONEMPTY)) {
+          hidden.insert(selector);
+        }
+      }
+    }
+    const SubscriptionCollectionImpl plain_collection(subscriptions);
+    const auto all_selectors =
+        plain_collection.GetElementHideSelectors(frame_url, {}, SiteKey());
+    EXPECT_EQ(std::set<std::string>(all_selectors.begin(), all_selectors.end()),
+              hidden);
+    return hidden;
+  }
+
+  const std::string kRuleEnd{" {display: none !important;}\n"};
+  const GURL kFrameUrl{"https://www.example.com/page"};
+};
+
+TEST_F(AdblockGenericElemhideStylesheetTest, RendersDomainAgnosticSelectors) {
+  const auto generic_elemhide = GenericElemhideStylesheet::Build(
+      {MakeSubscription("https://list1.com/",
+                        {"##.ad", "##.banner", "example.com##.specific",
+                         "~example.com##.excluded"}),
+       MakeSubscription("https://list2.com/", {"##.ad", "#@#.banner"})});
+  EXPECT_EQ(1u, generic_elemhide->selector_count());
+  EXPECT_EQ(".ad" + kRuleEnd, generic_elemhide->stylesheet());
+  EXPECT_TRUE(generic_elemhide->HasSelector(".ad"));
+  EXPECT_FALSE(generic_elemhide->HasSelector(".banner"));
+  EXPECT_FALSE(generic_elemhide->HasSelector(".specific"));
+  EXPECT_FALSE(generic_elemhide->HasSelector(".excluded"));
+  EXPECT_TRUE(generic_elemhide->HasException(".banner"));
+}
+
+TEST_F(AdblockGenericElemhideStylesheetTest, RulesSplitIntoBatches) {
+  std::vector<std::string> filters;
+  for (int i = 0; i < 1500; ++i) {
+    filters.push_back("##.ad" + base::NumberToString(i));
+  }
+  const auto generic_elemhide = GenericElemhideStylesheet::Build(
+      {MakeSubscription("https://list1.com/", filters)});
+  EXPECT_EQ(1500u, generic_elemhide->selector_count());
+  // Rules of at most 1024 selectors each.
+  const auto rules = base::SplitStringUsingSubstr(
+      generic_elemhide->stylesheet(), kRuleEnd, base::KEEP_WHITESPACE,
+      base::SPLIT_WANT_NONEMPTY);
+  ASSERT_EQ(2u, rules.size());
+  EXPECT_EQ(1024u, base::SplitStringPiece(rules[0], ",", base::TRIM_WHITESPACE,
+                                          base::SPLIT_WANT_ALL)
+                       .size());
+}
+
+TEST_F(AdblockGenericElemhideStylesheetTest, IsBuiltFromSameSubscriptionsOnly) {
+  std::vector<scoped_refptr<InstalledSubscription>> subscriptions = {
+      MakeSubscription("https://list1.com/", {"##.ad"}),
+      MakeSubscription("https://list2.com/", {"##.banner"})};
+  const auto generic_elemhide = GenericElemhideStylesheet::Build(subscriptions);
+  EXPECT_TRUE(generic_elemhide->IsBuiltFrom(subscriptions));
+  subscriptions.pop_back();
+  EXPECT_FALSE(generic_elemhide->IsBuiltFrom(subscriptions));
+}
+
+TEST_F(AdblockGenericElemhideStylesheetTest, FrameGetsDomainDependentDelta) {
+  const std::vector<scoped_refptr<InstalledSubscription>> subscriptions = {
+      MakeSubscription("https://list1.com/",
+                       {"##.ad", "example.com##.specific",
+                        "~example.com##.excluded", "~other.com##.included",
+                        "example.com#@#.included"}),
+      MakeSubscription("https://list2.com/", {"other.com##.other"})};
+  const auto generic_elemhide = GenericElemhideStylesheet::Build(subscriptions);
+  const SubscriptionCollectionImpl collection(subscriptions, nullptr, 1u,
+                                              generic_elemhide);
+  const auto data = collection.GetElementHideData(kFrameUrl, {}, SiteKey());
+  EXPECT_EQ(generic_elemhide, data.generic_stylesheet);
+  EXPECT_THAT(data.selectors, testing::UnorderedElementsAre(".specific"));
+  EXPECT_THAT(HiddenSelectors(subscriptions, kFrameUrl),
+              testing::UnorderedElementsAre(".ad", ".specific"));
+}
+
+TEST_F(AdblockGenericElemhideStylesheetTest,
+       DomainAgnosticExceptionAppliesToDelta) {
+  const std::vector<scoped_refptr<InstalledSubscription>> subscriptions = {
+      MakeSubscription("https://list1.com/",
+                       {"##.ad", "example.com##.specific"}),
+      MakeSubscription("https://list2.com/", {"#@#.specific"})};
+  EXPECT_THAT(HiddenSelectors(subscriptions, kFrameUrl),
+              testing::UnorderedElementsAre(".ad"));
+}
+
+TEST_F(AdblockGenericElemhideStylesheetTest,
+       FrameExceptionForSharedSelectorFallsBackToAllSelectors) {
+  const std::vector<scoped_refptr<InstalledSubscription>> subscriptions = {
+      MakeSubscription("https://list1.com/", {"##.ad", "##.banner"}),
+      MakeSubscription("https://list2.com/", {"example.com#@#.ad"})};
+  const SubscriptionCollectionImpl collection(
+      subscriptions, nullptr, 1u,
+      GenericElemhideStylesheet::Build(subscriptions));
+  const auto data = collection.GetElementHideData(kFrameUrl, {}, SiteKey());
+  EXPECT_FALSE(data.generic_stylesheet);
+  EXPECT_THAT(data.selectors, testing::UnorderedElementsAre(".banner"));
+  // Other domains still get the shared stylesheet.
+  const auto other_data = collection.GetElementHideData(
+      GURL("https://other.com/"), {}, SiteKey());
+  EXPECT_TRUE(other_data.generic_stylesheet);
+  EXPECT_TRUE(other_data.selectors.empty());
+}
+
+TEST_F(AdblockGenericElemhideStylesheetTest, GenerichideSkipsSharedStylesheet) {
+  const std::vector<scoped_refptr<InstalledSubscription>> subscriptions = {
+      MakeSubscription("https://list1.com/",
+                       {"##.ad", "example.com##.specific",
+                        "@@||example.com^$generichide"})};
+  const SubscriptionCollectionImpl collection(
+      subscriptions, nullptr, 1u,
+      GenericElemhideStylesheet::Build(subscriptions));
+  const auto data = collection.GetElementHideData(kFrameUrl, {}, SiteKey());
+  EXPECT_FALSE(data.generic_stylesheet);
+  EXPECT_THAT(data.selectors, testing::UnorderedElementsAre(".specific"));
+}
+
+}  // namespace adblock
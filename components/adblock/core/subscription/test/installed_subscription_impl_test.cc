@@ -26,7 +26,6 @@
 #include "components/adblock/core/common/flatbuffer_data.h"
 #include "components/adblock/core/converter/flatbuffer_converter.h"
 #include "components/adblock/core/subscription/installed_subscription.h"
-#include "components/adblock/core/subscription/regex_matcher.h"
 #include "components/grit/components_resources.h"
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -85,15 +84,14 @@ TEST(AdblockInstalledSubscriptionImplTest, InstallationStateAndDateReported) {
   EXPECT_EQ(subscription->GetInstallationTime(), installation_time);
 }
 
-TEST(AdblockInstalledSubscriptionImplTest,
-     ConvertMoreRegexFiltersThanCacheCapacity) {
+TEST(AdblockInstalledSubscriptionImplTest, ConvertManyRegexFilters) {
   std::vector<std::string> filters;
-  // Create a lot of regex filters
-  for (int i = 0; i < RegexMatcher::kMaxPrebuiltPatterns; i++) {
+  // Create a lot of regex filters, they are all matched as one RE2::Set.
+  for (int i = 0; i < 500; i++) {
     // Match any word followed by the numerical value of i, then another word.
     filters.push_back(base::StringPrintf("/.*word%dword.*/", i));
   }
-  // Add one more, this one will not get prebuilt
+  // Add one more, the last one of the set.
   filters.push_back(base::StringPrintf("/.*word%dword.*/", 1000));
 
   auto buffer = FlatbufferConverter::Convert(
@@ -106,6 +104,31 @@ TEST(AdblockInstalledSubscriptionImplTest,
   EXPECT_TRUE(subscription->HasUrlFilter(
       GURL("https://word1000word.com/ad.jpg"), "example.com",
       ContentType::Image, {}, FilterCategory::Blocking));
+  EXPECT_FALSE(subscription->HasUrlFilter(
+      GURL("https://word1001word.com/ad.jpg"), "example.com",
+      ContentType::Image, {}, FilterCategory::Blocking));
+}
+
+TEST(AdblockInstalledSubscriptionImplTest, RegexFiltersMatchedInBatch) {
+  // Case-sensitive, case-insensitive and ICU-only (lookahead) expressions.
+  auto buffer = FlatbufferConverter::Convert(
+      {"/\\/Banner[0-9]+\\./$match-case", "/\\/popup[0-9]+\\./",
+       "/\\/track(?=er)/"},
+      GURL{"http://data.com/filters.txt"}, false);
+  ASSERT_TRUE(buffer);
+  auto subscription = base::MakeRefCounted<InstalledSubscriptionImpl>(
+      std::move(buffer), Subscription::InstallationState::Installed,
+      base::Time());
+  const auto has_filter = [&](base::StringPiece url) {
+    return subscription->HasUrlFilter(GURL(url), "example.com",
+                                      ContentType::Image, {},
+                                      FilterCategory::Blocking);
+  };
+  EXPECT_TRUE(has_filter("https://ads.com/Banner12.png"));
+  EXPECT_FALSE(has_filter("https://ads.com/banner12.png"));
+  EXPECT_TRUE(has_filter("https://ads.com/POPUP3.png"));
+  EXPECT_TRUE(has_filter("https://ads.com/tracker.gif"));
+  EXPECT_FALSE(has_filter("https://ads.com/tracking.gif"));
 }
 
 }  // namespace adblock
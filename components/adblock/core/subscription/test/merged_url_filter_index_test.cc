@@ -0,0 +1,191 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/merged_url_filter_index.h"
+
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_refptr.h"
+#include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/subscription/installed_subscription_impl.h"
+#include "components/adblock/core/subscription/request_context.h"
+#include "components/adblock/core/subscription/subscription_collection_impl.h"
+#include "components/adblock/core/subscription/test/mock_installed_subscription.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace adblock {
+
+class AdblockMergedUrlFilterIndexTest : public testing::Test {
+ public:
+  scoped_refptr<InstalledSubscription> MakeSubscription(
+      const std::string& url,
+      std::vector<std::string> filters) {
+    return base::MakeRefCounted<InstalledSubscriptionImpl>(
+        FlatbufferConverter::Convert(filters, GURL(url), false),
+        Subscription::InstallationState::Installed, base::Time());
+  }
+
+  const GURL kRequestUrl{"https://ads.com/banner/advert.js"};
+  const GURL kDocumentUrl{"https://example.com/"};
+  const std::string kDocumentDomain{"example.com"};
+};
+
+TEST_F(AdblockMergedUrlFilterIndexTest, NotBuiltFromNonFlatbufferSubscription) {
+  std::vector<scoped_refptr<InstalledSubscription>> subscriptions = {
+      MakeSubscription("https://list1.com/", {"/banner/"}),
+      base::MakeRefCounted<MockInstalledSubscription>()};
+  EXPECT_FALSE(MergedUrlFilterIndex::Build(subscriptions));
+}
+
+TEST_F(AdblockMergedUrlFilterIndexTest, IsBuiltFromSameSubscriptionsOnly) {
+  std::vector<scoped_refptr<InstalledSubscription>> subscriptions = {
+      MakeSubscription("https://list1.com/", {"/banner/"}),
+      MakeSubscription("https://list2.com/", {"/advert."})};
+  auto index = MergedUrlFilterIndex::Build(subscriptions);
+  ASSERT_TRUE(index);
+  EXPECT_TRUE(index->IsBuiltFrom(subscriptions));
+  std::vector<scoped_refptr<InstalledSubscription>> reversed = {
+      subscriptions[1], subscriptions[0]};
+  EXPECT_FALSE(index->IsBuiltFrom(reversed));
+  subscriptions.pop_back();
+  EXPECT_FALSE(index->IsBuiltFrom(subscriptions));
+}
+
+TEST_F(AdblockMergedUrlFilterIndexTest, FirstSubscriptionInOrderIsReported) {
+  // Both subscriptions match, regardless of which keyword is visited first
+  // the first subscription must be reported.
+  auto index = MergedUrlFilterIndex::Build(
+      {MakeSubscription("https://list1.com/", {"/advert.js"}),
+       MakeSubscription("https://list2.com/", {"/banner/"})});
+  ASSERT_TRUE(index);
+  const UrlContext context(kRequestUrl, kDocumentDomain, SiteKey());
+  EXPECT_EQ(0u, index->FindUrlFilter(context, ContentType::Script,
+                                     FilterCategory::Blocking));
+}
+
+TEST_F(AdblockMergedUrlFilterIndexTest, LaterSubscriptionReportedWhenMatching) {
+  auto index = MergedUrlFilterIndex::Build(
+      {MakeSubscription("https://list1.com/", {"/other.js"}),
+       MakeSubscription("https://list2.com/", {"@@/banner/$script"}),
+       MakeSubscription("https://list3.com/", {"/banner/"})});
+  ASSERT_TRUE(index);
+  const UrlContext context(kRequestUrl, kDocumentDomain, SiteKey());
+  EXPECT_EQ(2u, index->FindUrlFilter(context, ContentType::Script,
+                                     FilterCategory::Blocking));
+  EXPECT_EQ(1u, index->FindUrlFilter(context, ContentType::Script,
+                                     FilterCategory::Allowing));
+  EXPECT_FALSE(index->FindUrlFilter(context, ContentType::Image,
+                                    FilterCategory::Allowing));
+}
+
+TEST_F(AdblockMergedUrlFilterIndexTest, DomainSpecificBlockingSkipsGeneric) {
+  auto index = MergedUrlFilterIndex::Build(
+      {MakeSubscription("https://list1.com/", {"/banner/"}),
+       MakeSubscription("https://list2.com/",
+                        {"/advert.js$domain=example.com"})});
+  ASSERT_TRUE(index);
+  const UrlContext context(kRequestUrl, kDocumentDomain, SiteKey());
+  EXPECT_EQ(0u, index->FindUrlFilter(context, ContentType::Script,
+                                     FilterCategory::Blocking));
+  EXPECT_EQ(1u, index->FindUrlFilter(context, ContentType::Script,
+                                     FilterCategory::DomainSpecificBlocking));
+  const UrlContext other_context(kRequestUrl, "other.com", SiteKey());
+  EXPECT_FALSE(index->FindUrlFilter(other_context, ContentType::Script,
+                                    FilterCategory::DomainSpecificBlocking));
+}
+
+TEST_F(AdblockMergedUrlFilterIndexTest,
+       GenericEntryOfEarlierSubscriptionWinsInSharedBucket) {
+  // Both filters land in the "banner" bucket, the domain-specific one of the
+  // later subscription is searched first.
+  auto index = MergedUrlFilterIndex::Build(
+      {MakeSubscription("https://list1.com/", {"/banner/$script"}),
+       MakeSubscription("https://list2.com/",
+                        {"/banner/$script,domain=example.com"})});
+  ASSERT_TRUE(index);
+  const UrlContext context(kRequestUrl, kDocumentDomain, SiteKey());
+  EXPECT_EQ(0u, index->FindUrlFilter(context, ContentType::Script,
+                                     FilterCategory::Blocking));
+  EXPECT_EQ(1u, index->FindUrlFilter(context, ContentType::Script,
+                                     FilterCategory::DomainSpecificBlocking));
+  EXPECT_FALSE(index->FindUrlFilter(context, ContentType::Image,
+                                    FilterCategory::DomainSpecificBlocking));
+}
+
+TEST_F(AdblockMergedUrlFilterIndexTest, PopupAndSpecialFiltersFound) {
+  auto index = MergedUrlFilterIndex::Build(
+      {MakeSubscription("https://list1.com/", {"@@||example.com^$document"}),
+       MakeSubscription(
+           "https://list2.com/",
+           {"||ads.com^$popup", "@@||example.com^$genericblock"})});
+  ASSERT_TRUE(index);
+  const UrlContext popup_context(kRequestUrl, kDocumentDomain, SiteKey());
+  EXPECT_EQ(1u,
+            index->FindPopupFilter(popup_context, FilterCategory::Blocking));
+  const UrlContext document_context(kDocumentUrl, kDocumentDomain, SiteKey());
+  EXPECT_EQ(0u, index->FindSpecialFilter(SpecialFilterType::Document,
+                                         document_context));
+  EXPECT_EQ(1u, index->FindSpecialFilter(SpecialFilterType::Genericblock,
+                                         document_context));
+  EXPECT_FALSE(index->FindSpecialFilter(SpecialFilterType::Elemhide,
+                                        document_context));
+}
+
+TEST_F(AdblockMergedUrlFilterIndexTest,
+       CollectionResultsMatchSequentialSearch) {
+  const std::vector<scoped_refptr<InstalledSubscription>> subscriptions = {
+      MakeSubscription("https://list1.com/", {"/other.js", "@@||frame.com^"}),
+      MakeSubscription("https://list2.com/",
+                       {"/advert.", "@@||parent.com^$document"}),
+      MakeSubscription("https://list3.com/",
+                       {"/banner/", "@@||ads.com^$elemhide"})};
+  const SubscriptionCollectionImpl sequential(subscriptions);
+  const SubscriptionCollectionImpl merged(
+      subscriptions, MergedUrlFilterIndex::Build(subscriptions));
+  const std::vector<std::vector<GURL>> frame_hierarchies = {
+      {},
+      {GURL("https://example.com/")},
+      {GURL("https://frame.com/"), GURL("https://parent.com/")}};
+  for (const auto& frame_hierarchy : frame_hierarchies) {
+    for (const auto category :
+         {FilterCategory::Blocking, FilterCategory::Allowing}) {
+      EXPECT_EQ(
+          sequential.FindBySubresourceFilter(kRequestUrl, frame_hierarchy,
+                                             ContentType::Script, SiteKey(),
+                                             category),
+          merged.FindBySubresourceFilter(kRequestUrl, frame_hierarchy,
+                                         ContentType::Script, SiteKey(),
+                                         category));
+    }
+    EXPECT_EQ(sequential.FindByAllowFilter(kRequestUrl, frame_hierarchy,
+                                           ContentType::Script, SiteKey()),
+              merged.FindByAllowFilter(kRequestUrl, frame_hierarchy,
+                                       ContentType::Script, SiteKey()));
+    for (const auto type :
+         {SpecialFilterType::Document, SpecialFilterType::Elemhide,
+          SpecialFilterType::Genericblock, SpecialFilterType::Generichide}) {
+      EXPECT_EQ(sequential.FindBySpecialFilter(type, kRequestUrl,
+                                               frame_hierarchy, SiteKey()),
+                merged.FindBySpecialFilter(type, kRequestUrl, frame_hierarchy,
+                                           SiteKey()));
+    }
+  }
+}
+
+}  // namespace adblock
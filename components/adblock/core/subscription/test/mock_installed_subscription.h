@@ -30,6 +30,10 @@ namespace adblock {
 class MockInstalledSubscription : public NiceMock<InstalledSubscription> {
  public:
   MockInstalledSubscription();
+  // UrlContext-based variants forward to the mocked methods below.
+  using InstalledSubscription::HasPopupFilter;
+  using InstalledSubscription::HasSpecialFilter;
+  using InstalledSubscription::HasUrlFilter;
   MOCK_METHOD(GURL, GetSourceUrl, (), (override, const));
   MOCK_METHOD(std::string, GetTitle, (), (override, const));
   MOCK_METHOD(std::string, GetCurrentVersion, (), (override, const));
@@ -31,6 +31,12 @@ class MockSubscriptionCollection : public NiceMock<SubscriptionCollection> {
  public:
   MockSubscriptionCollection();
   ~MockSubscriptionCollection() override;
+  // RequestContext-based variants forward to the mocked methods below.
+  using SubscriptionCollection::FindByAllowFilter;
+  using SubscriptionCollection::FindByPopupFilter;
+  using SubscriptionCollection::FindBySpecialFilter;
+  using SubscriptionCollection::FindBySubresourceFilter;
+  MOCK_METHOD(uint64_t, GetGeneration, (), (const, override));
   MOCK_METHOD(absl::optional<GURL>,
               FindBySubresourceFilter,
               (const GURL& frame_url,
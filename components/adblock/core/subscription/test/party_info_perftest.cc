@@ -0,0 +1,142 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/party_info.h"
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/string_split.h"
+#include "base/timer/elapsed_timer.h"
+#include "components/adblock/core/common/content_type.h"
+#include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/subscription/installed_subscription_impl.h"
+#include "components/adblock/core/subscription/test/load_gzipped_test_file.h"
+#include "net/base/registry_controlled_domains/registry_controlled_domain.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "url/gurl.h"
+
+namespace adblock {
+namespace {
+
+constexpr char kMetricUncachedPartyInfo[] = ".uncached_party_info";
+constexpr char kMetricCachedPartyInfo[] = ".cached_party_info";
+constexpr char kMetricThirdPartyFilters[] = ".third_party_filters";
+constexpr int kRepetitions = 10;
+// Consecutive URLs of the corpus are treated as resources of one page, whose
+// document is the host of the first of them.
+constexpr size_t kRequestsPerPage = 50u;
+constexpr size_t kThirdPartyFilterCount = 1000u;
+
+}  // namespace
+
+class AdblockPartyInfoPerfTest : public testing::Test {
+ public:
+  void SetUp() override {
+    const auto url_file_content = LoadGzippedTestFile("5000_urls.txt.gz");
+    for (const auto line :
+         base::SplitStringPiece(url_file_content, "\n", base::TRIM_WHITESPACE,
+                                base::SPLIT_WANT_NONEMPTY)) {
+      GURL url(line);
+      if (url.is_valid()) {
+        urls_.push_back(std::move(url));
+      }
+    }
+    for (size_t i = 0; i < urls_.size(); ++i) {
+      document_domains_.push_back(urls_[i - i % kRequestsPerPage].host());
+    }
+  }
+
+  std::vector<GURL> urls_;
+  std::vector<std::string> document_domains_;
+};
+
+// Registrable domains of the request and of its document, looked up in the
+// registry for every request as opposed to through RegistrableDomainCache.
+TEST_F(AdblockPartyInfoPerfTest, PartyInfoForUrlCorpus) {
+  perf_test::PerfResultReporter reporter("party_info", "5000 urls");
+  reporter.RegisterImportantMetric(kMetricUncachedPartyInfo, "ms");
+  reporter.RegisterImportantMetric(kMetricCachedPartyInfo, "ms");
+
+  size_t uncached_third_party = 0u;
+  base::ElapsedTimer uncached_timer;
+  for (int i = 0; i < kRepetitions; ++i) {
+    for (size_t j = 0; j < urls_.size(); ++j) {
+      uncached_third_party +=
+          !net::registry_controlled_domains::SameDomainOrHost(
+              urls_[j], GURL("https://" + document_domains_[j]),
+              net::registry_controlled_domains::INCLUDE_PRIVATE_REGISTRIES);
+    }
+  }
+  reporter.AddResult(kMetricUncachedPartyInfo, uncached_timer.Elapsed());
+
+  size_t cached_third_party = 0u;
+  base::ElapsedTimer cached_timer;
+  for (int i = 0; i < kRepetitions; ++i) {
+    for (size_t j = 0; j < urls_.size(); ++j) {
+      cached_third_party +=
+          PartyInfo::Compute(urls_[j].host_piece(), document_domains_[j])
+              .is_third_party;
+    }
+  }
+  reporter.AddResult(kMetricCachedPartyInfo, cached_timer.Elapsed());
+
+  // Both must agree for the comparison to be meaningful.
+  EXPECT_EQ(uncached_third_party, cached_third_party);
+}
+
+// Classifies the corpus against a subscription made mostly of $third-party
+// filters, the ones that depend on PartyInfo.
+TEST_F(AdblockPartyInfoPerfTest, ThirdPartyHeavyFilterSet) {
+  std::set<std::string> hosts;
+  for (const auto& url : urls_) {
+    if (hosts.size() == kThirdPartyFilterCount) {
+      break;
+    }
+    hosts.insert(url.host());
+  }
+  std::vector<std::string> filters;
+  for (const auto& host : hosts) {
+    filters.push_back("||" + host + "^$third-party");
+  }
+  filters.push_back("/ads/*$third-party");
+  filters.push_back("/banner/*$~third-party");
+  auto subscription = base::MakeRefCounted<InstalledSubscriptionImpl>(
+      FlatbufferConverter::Convert(filters, GURL("https://list.com/"), false),
+      Subscription::InstallationState::Installed, base::Time());
+
+  perf_test::PerfResultReporter reporter("party_info",
+                                         "third-party filter set");
+  reporter.RegisterImportantMetric(kMetricThirdPartyFilters, "ms");
+  size_t blocked = 0u;
+  base::ElapsedTimer timer;
+  for (int i = 0; i < kRepetitions; ++i) {
+    for (size_t j = 0; j < urls_.size(); ++j) {
+      blocked += subscription->HasUrlFilter(urls_[j], document_domains_[j],
+                                            ContentType::Image, SiteKey(),
+                                            FilterCategory::Blocking);
+    }
+  }
+  reporter.AddResult(kMetricThirdPartyFilters, timer.Elapsed());
+  EXPECT_GT(blocked, 0u);
+}
+
+}  // namespace adblock
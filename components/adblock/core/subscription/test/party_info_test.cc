@@ -0,0 +1,83 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "components/adblock/core/subscription/party_info.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace adblock {
+
+TEST(AdblockRegistrableDomainCacheTest, ReturnsRegistrableDomain) {
+  RegistrableDomainCache cache;
+  EXPECT_EQ(cache.Get("www.example.com"), "example.com");
+  EXPECT_EQ(cache.Get("a.b.example.co.uk"), "example.co.uk");
+  // Private registries are included.
+  EXPECT_EQ(cache.Get("user.github.io"), "user.github.io");
+  EXPECT_EQ(cache.Get("127.0.0.1"), "");
+  EXPECT_EQ(cache.Get(""), "");
+}
+
+TEST(AdblockRegistrableDomainCacheTest, RepeatedHostsServedFromCache) {
+  RegistrableDomainCache cache;
+  EXPECT_EQ(cache.Get("www.example.com"), "example.com");
+  EXPECT_EQ(cache.Get("cdn.example.com"), "example.com");
+  EXPECT_EQ(cache.Get("www.example.com"), "example.com");
+  EXPECT_EQ(cache.GetEntryCount(), 2u);
+  EXPECT_EQ(cache.GetHitCount(), 1u);
+  EXPECT_EQ(cache.GetMissCount(), 2u);
+}
+
+TEST(AdblockRegistrableDomainCacheTest, LeastRecentlyUsedHostEvicted) {
+  RegistrableDomainCache cache(2u);
+  cache.Get("a.example.com");
+  cache.Get("b.example.com");
+  cache.Get("a.example.com");
+  cache.Get("c.example.com");
+  EXPECT_EQ(cache.GetEntryCount(), 2u);
+  EXPECT_EQ(cache.GetMissCount(), 3u);
+  // "b.example.com" was the least recently used.
+  EXPECT_EQ(cache.Get("a.example.com"), "example.com");
+  EXPECT_EQ(cache.GetMissCount(), 3u);
+  EXPECT_EQ(cache.Get("b.example.com"), "example.com");
+  EXPECT_EQ(cache.GetMissCount(), 4u);
+}
+
+TEST(AdblockPartyInfoTest, SameSiteIsFirstParty) {
+  EXPECT_FALSE(PartyInfo::Compute("example.com", "example.com").is_third_party);
+  EXPECT_FALSE(
+      PartyInfo::Compute("cdn.example.com", "www.example.com").is_third_party);
+  EXPECT_FALSE(PartyInfo::Compute("127.0.0.1", "127.0.0.1").is_third_party);
+}
+
+TEST(AdblockPartyInfoTest, DifferentSitesAreThirdParty) {
+  EXPECT_TRUE(
+      PartyInfo::Compute("ads.tracker.com", "www.example.com").is_third_party);
+  EXPECT_TRUE(PartyInfo::Compute("a.github.io", "b.github.io").is_third_party);
+  EXPECT_TRUE(PartyInfo::Compute("127.0.0.1", "127.0.0.2").is_third_party);
+  EXPECT_TRUE(PartyInfo::Compute("example.com", "").is_third_party);
+  EXPECT_TRUE(PartyInfo::Compute("", "example.com").is_third_party);
+}
+
+TEST(AdblockPartyInfoTest, RegistrableDomainOfHost) {
+  EXPECT_EQ(
+      PartyInfo::Compute("ads.tracker.com", "example.com").registrable_domain,
+      "tracker.com");
+  EXPECT_EQ(PartyInfo::Compute("127.0.0.1", "example.com").registrable_domain,
+            "");
+}
+
+}  // namespace adblock
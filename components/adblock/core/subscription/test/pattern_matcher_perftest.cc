@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <iterator>
+#include <string>
 #include <vector>
 
 #include "base/ranges/algorithm.h"
@@ -26,6 +27,7 @@
 #include "base/strings/string_split.h"
 #include "base/time/time.h"
 #include "base/timer/elapsed_timer.h"
+#include "components/adblock/core/common/pattern_program.h"
 #include "components/adblock/core/subscription/test/load_gzipped_test_file.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/perf/perf_result_reporter.h"
@@ -34,6 +36,12 @@
 namespace adblock {
 namespace {
 constexpr char kMetricRuntime[] = ".runtime";
+constexpr char kMetricCompiledRuntime[] = ".compiled_runtime";
+
+struct CompiledPattern {
+  base::StringPiece pattern;
+  std::vector<flat::PatternInstruction> program;
+};
 
 void MatchPatterns(const std::vector<base::StringPiece>& patterns,
                    const GURL& url) {
@@ -42,6 +50,46 @@ void MatchPatterns(const std::vector<base::StringPiece>& patterns,
   }
 }
 
+void MatchCompiledPatterns(const std::vector<CompiledPattern>& patterns,
+                           const GURL& url) {
+  for (const auto& p : patterns) {
+    DoesPatternProgramMatchUrl(p.pattern, p.program, url);
+  }
+}
+
+std::vector<CompiledPattern> CompilePatterns(
+    const std::vector<base::StringPiece>& patterns) {
+  std::vector<CompiledPattern> compiled;
+  base::ranges::transform(patterns, std::back_inserter(compiled),
+                          [](base::StringPiece pattern) {
+                            return CompiledPattern{
+                                pattern, CompilePatternProgram(pattern)};
+                          });
+  return compiled;
+}
+
+// Reports the time to match all |patterns| against all |urls|, compiling
+// the patterns on each match and ahead of time.
+void MeasureMatching(const std::vector<base::StringPiece>& patterns,
+                     const std::vector<GURL>& urls,
+                     const std::string& story) {
+  perf_test::PerfResultReporter reporter("pattern_matcher", story);
+  reporter.RegisterImportantMetric(kMetricRuntime, "ms");
+  reporter.RegisterImportantMetric(kMetricCompiledRuntime, "ms");
+  base::ElapsedTimer timer;
+  for (const auto& url : urls) {
+    MatchPatterns(patterns, url);
+  }
+  reporter.AddResult(kMetricRuntime, timer.Elapsed());
+
+  const auto compiled_patterns = CompilePatterns(patterns);
+  base::ElapsedTimer compiled_timer;
+  for (const auto& url : urls) {
+    MatchCompiledPatterns(compiled_patterns, url);
+  }
+  reporter.AddResult(kMetricCompiledRuntime, compiled_timer.Elapsed());
+}
+
 }  // namespace
 
 TEST(AdblockPatternMatcherPerfTest, FilterMatchingSpeed) {
@@ -56,14 +104,34 @@ TEST(AdblockPatternMatcherPerfTest, FilterMatchingSpeed) {
   const auto patterns =
       base::SplitStringPiece(pattern_file_content, "\n", base::TRIM_WHITESPACE,
                              base::SPLIT_WANT_NONEMPTY);
-  perf_test::PerfResultReporter reporter("pattern_matcher",
-                                         "5000 patterns, 5000 urls");
-  reporter.RegisterImportantMetric(kMetricRuntime, "ms");
-  base::ElapsedTimer timer;
-  for (const auto& url : urls) {
-    MatchPatterns(patterns, url);
+  MeasureMatching(patterns, urls, "5000 patterns, 5000 urls");
+}
+
+TEST(AdblockPatternMatcherPerfTest, AdversarialPatternMatchingSpeed) {
+  // Patterns with many wildcards or separators and URLs that almost, but not
+  // quite, match them. A backtracking matcher explores a number of partial
+  // matches that grows quickly with the number of wildcards.
+  std::vector<std::string> pattern_storage;
+  std::string wildcards;
+  std::string separators;
+  for (int i = 0; i < 20; i++) {
+    wildcards += "a*";
+    separators += "a^";
+    pattern_storage.push_back(wildcards + "b");
+    pattern_storage.push_back(separators + "b");
+    pattern_storage.push_back("||" + separators + "*b|");
   }
-  reporter.AddResult(kMetricRuntime, timer.Elapsed());
+  const std::vector<base::StringPiece> patterns(pattern_storage.begin(),
+                                                pattern_storage.end());
+
+  std::vector<GURL> urls;
+  std::string path;
+  for (int i = 0; i < 50; i++) {
+    path += "a/";
+    urls.emplace_back("https://a.a.a.a.com/" + path);
+    urls.emplace_back("https://example.com/" + std::string(40 * i, 'a'));
+  }
+  MeasureMatching(patterns, urls, "adversarial patterns");
 }
 
 }  // namespace adblock
@@ -21,6 +21,7 @@
 
 #include "base/strings/string_piece.h"
 #include "base/strings/string_piece_forward.h"
+#include "components/adblock/core/common/pattern_program.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace adblock {
@@ -318,7 +319,7 @@ TEST(AdblockPatternMatcherTest, FirstTokenIsWildcard) {
   EXPECT_TRUE(DoesPatternMatchUrl(pattern, GURL("https://start.com/file")));
 }
 
-TEST(AdblockPatternMatcherTest, DeepRecursion) {
+TEST(AdblockPatternMatcherTest, LongPatternMatches) {
   auto recursive_input_maker = [](int depth) -> std::pair<std::string, GURL> {
     std::string pattern;
     GURL url("https://example.com");
@@ -332,9 +333,42 @@ TEST(AdblockPatternMatcherTest, DeepRecursion) {
   const auto [shallow_pattern, short_url] = recursive_input_maker(5);
   EXPECT_TRUE(DoesPatternMatchUrl(shallow_pattern, short_url));
 
-  // Malicious, long filters are never matched.
+  // Matching does not recurse, so long filters are matched too.
   const auto [deep_pattern, long_url] = recursive_input_maker(100);
-  EXPECT_FALSE(DoesPatternMatchUrl(deep_pattern, long_url));
+  EXPECT_TRUE(DoesPatternMatchUrl(deep_pattern, long_url));
+}
+
+TEST(AdblockPatternMatcherTest, HostAnchorTriesEveryLabel) {
+  const auto pattern = base::StringPiece("||b.com^");
+
+  // The first occurrence of "b.com" is not at the start of a label, but the
+  // second one is.
+  EXPECT_TRUE(DoesPatternMatchUrl(pattern, GURL("https://xb.com.b.com/")));
+  EXPECT_FALSE(DoesPatternMatchUrl(pattern, GURL("https://xb.com/b.com/")));
+}
+
+TEST(AdblockPatternMatcherTest, ManyWildcardsDoNotBacktrack) {
+  std::string pattern;
+  for (int i = 0; i < 30; i++) {
+    pattern += "a*";
+  }
+  pattern += "b";
+  const GURL url("https://example.com/" + std::string(2000, 'a'));
+
+  EXPECT_FALSE(DoesPatternMatchUrl(pattern, url));
+  EXPECT_TRUE(DoesPatternMatchUrl(pattern, GURL(url.spec() + "b")));
+}
+
+TEST(AdblockPatternMatcherTest, CompiledProgramMatchesLikePattern) {
+  const auto pattern = base::StringPiece("||example.com^*_*.php|");
+  const auto program = CompilePatternProgram(pattern);
+
+  EXPECT_TRUE(DoesPatternProgramMatchUrl(
+      pattern, program, GURL("https://sub.example.com/data_file.php")));
+  EXPECT_FALSE(DoesPatternProgramMatchUrl(
+      pattern, program, GURL("https://sub.example.com/data_file.php?x")));
+  EXPECT_FALSE(DoesPatternProgramMatchUrl(
+      pattern, program, GURL("https://example.com/datafile.php")));
 }
 
 }  // namespace adblock
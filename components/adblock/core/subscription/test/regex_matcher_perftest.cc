@@ -20,12 +20,20 @@
 #include <iterator>
 #include <vector>
 
+#include "base/memory/scoped_refptr.h"
 #include "base/ranges/algorithm.h"
 #include "base/strings/string_piece.h"
 #include "base/strings/string_piece_forward.h"
 #include "base/strings/string_split.h"
+#include "base/strings/stringprintf.h"
 #include "base/time/time.h"
 #include "base/timer/elapsed_timer.h"
+#include "components/adblock/core/common/content_type.h"
+#include "components/adblock/core/common/regex_cache.h"
+#include "components/adblock/core/common/sitekey.h"
+#include "components/adblock/core/converter/flatbuffer_converter.h"
+#include "components/adblock/core/subscription/installed_subscription_impl.h"
+#include "components/adblock/core/subscription/request_context.h"
 #include "components/adblock/core/subscription/test/load_gzipped_test_file.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/perf/perf_result_reporter.h"
@@ -36,6 +44,129 @@ namespace {
 
 constexpr char kMetricInitialization[] = ".initialization";
 constexpr char kMetricRuntime[] = ".runtime";
+constexpr char kMetricIndividualPerUrl[] = ".individual_per_url";
+constexpr char kMetricBatchPerUrl[] = ".batch_per_url";
+constexpr char kMetricCompiledPerMatch[] = ".compiled_per_match";
+constexpr char kMetricCachedPerMatch[] = ".cached_per_match";
+
+std::vector<GURL> LoadUrls() {
+  const auto url_file_content = LoadGzippedTestFile("5000_urls.txt.gz");
+  std::vector<GURL> urls;
+  base::ranges::transform(
+      base::SplitStringPiece(url_file_content, "\n", base::TRIM_WHITESPACE,
+                             base::SPLIT_WANT_NONEMPTY),
+      std::back_inserter(urls),
+      [](const auto string_piece) { return GURL(string_piece); });
+  return urls;
+}
+
+// Regular expressions shaped like the ones found in popular filter lists.
+std::vector<std::string> GenerateRegularExpressions(int count) {
+  std::vector<std::string> expressions;
+  for (int i = 0; i < count; ++i) {
+    switch (i % 4) {
+      case 0:
+        expressions.push_back(
+            base::StringPrintf("\\/ad[sv]?%d[_-]?banner\\.", i));
+        break;
+      case 1:
+        expressions.push_back(base::StringPrintf(
+            "^https?:\\/\\/[a-z0-9.-]*tracker%d\\.(com|net)\\/", i));
+        break;
+      case 2:
+        expressions.push_back(base::StringPrintf(
+            "\\/img\\/[0-9]{2,4}x[0-9]{2,4}_%d\\.(gif|png)", i));
+        break;
+      default:
+        expressions.push_back(base::StringPrintf("[?&]campaign_id=%d(&|$)", i));
+        break;
+    }
+  }
+  return expressions;
+}
+
+// Compares matching |regex_count| regular expressions one by one against
+// matching them as regex filters of a subscription, where they share one
+// RE2::Set.
+void MeasureRegexFilterMatching(int regex_count) {
+  const auto urls = LoadUrls();
+  const auto expressions = GenerateRegularExpressions(regex_count);
+  std::vector<std::string> filters;
+  for (const auto& expression : expressions) {
+    filters.push_back("/" + expression + "/");
+  }
+
+  perf_test::PerfResultReporter reporter(
+      "regex_match", base::StringPrintf("%d regex filters", regex_count));
+  reporter.RegisterImportantMetric(kMetricIndividualPerUrl, "us");
+  reporter.RegisterImportantMetric(kMetricBatchPerUrl, "us");
+
+  RegexMatcher matcher;
+  for (const auto& expression : expressions) {
+    matcher.PreBuildRegexPattern(expression, false);
+  }
+  base::ElapsedTimer individual_timer;
+  for (const auto& url : urls) {
+    for (const auto& expression : expressions) {
+      matcher.MatchesRegex(expression, url, false);
+    }
+  }
+  reporter.AddResult(kMetricIndividualPerUrl,
+                     individual_timer.Elapsed() / urls.size());
+
+  auto subscription = base::MakeRefCounted<InstalledSubscriptionImpl>(
+      FlatbufferConverter::Convert(filters, GURL("https://list.com/"), false),
+      Subscription::InstallationState::Installed, base::Time());
+  // Builds the RE2::Set, which happens once per subscription.
+  subscription->HasUrlFilter(
+      UrlContext(urls.front(), "example.com", SiteKey()), ContentType::Image,
+      FilterCategory::Blocking);
+  base::ElapsedTimer batch_timer;
+  for (const auto& url : urls) {
+    subscription->HasUrlFilter(UrlContext(url, "example.com", SiteKey()),
+                               ContentType::Image, FilterCategory::Blocking);
+  }
+  reporter.AddResult(kMetricBatchPerUrl, batch_timer.Elapsed() / urls.size());
+}
+
+// Compares the steady-state cost of matching regex filters that are not
+// batched, like keyworded regex filters found through the merged index,
+// when each evaluation compiles its expression against when the compiled
+// expression comes from the shared RegexCache.
+void MeasureUnbatchedRegexMatching(size_t url_count) {
+  auto urls = LoadUrls();
+  urls.resize(std::min(urls.size(), url_count));
+  const auto expressions = GenerateRegularExpressions(100);
+  const size_t match_count = urls.size() * expressions.size();
+
+  perf_test::PerfResultReporter reporter(
+      "regex_match", base::StringPrintf("%zu urls, 100 expressions",
+                                        urls.size()));
+  reporter.RegisterImportantMetric(kMetricCompiledPerMatch, "us");
+  reporter.RegisterImportantMetric(kMetricCachedPerMatch, "us");
+
+  base::ElapsedTimer compiled_timer;
+  for (const auto& url : urls) {
+    for (const auto& expression : expressions) {
+      CompiledRegex::Compile(expression, false)->Matches(url.spec());
+    }
+  }
+  reporter.AddResult(kMetricCompiledPerMatch,
+                     compiled_timer.Elapsed() / match_count);
+
+  RegexMatcher matcher;
+  for (const auto& expression : expressions) {
+    matcher.PreBuildRegexPattern(expression, false);
+  }
+  base::ElapsedTimer cached_timer;
+  for (const auto& url : urls) {
+    for (const auto& expression : expressions) {
+      matcher.MatchesRegex(expression, url, false);
+    }
+  }
+  reporter.AddResult(kMetricCachedPerMatch,
+                     cached_timer.Elapsed() / match_count);
+}
 
 void MatchPatterns(const std::vector<base::StringPiece>& patterns,
                    const GURL& url,
@@ -48,13 +179,7 @@ void MatchPatterns(const std::vector<base::StringPiece>& patterns,
 }  // namespace
 
 TEST(AdblockRegexMatcherPerfTest, FilterMatchingSpeed) {
-  const auto url_file_content = LoadGzippedTestFile("5000_urls.txt.gz");
-  std::vector<GURL> urls;
-  base::ranges::transform(
-      base::SplitStringPiece(url_file_content, "\n", base::TRIM_WHITESPACE,
-                             base::SPLIT_WANT_NONEMPTY),
-      std::back_inserter(urls),
-      [](const auto string_piece) { return GURL(string_piece); });
+  const auto urls = LoadUrls();
   const auto pattern_file_content =
       LoadGzippedTestFile("40_regex_patterns.txt.gz");
   const auto patterns =
@@ -80,4 +205,20 @@ TEST(AdblockRegexMatcherPerfTest, FilterMatchingSpeed) {
   reporter.AddResult(kMetricRuntime, runtime_timer.Elapsed());
 }
 
+TEST(AdblockRegexMatcherPerfTest, HundredRegexFilters) {
+  MeasureRegexFilterMatching(100);
+}
+
+TEST(AdblockRegexMatcherPerfTest, ThousandRegexFilters) {
+  MeasureRegexFilterMatching(1000);
+}
+
+TEST(AdblockRegexMatcherPerfTest, FiveThousandRegexFilters) {
+  MeasureRegexFilterMatching(5000);
+}
+
+TEST(AdblockRegexMatcherPerfTest, UnbatchedRegexFilters) {
+  MeasureUnbatchedRegexMatching(500u);
+}
+
 }  // namespace adblock
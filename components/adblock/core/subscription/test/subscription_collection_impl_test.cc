@@ -22,6 +22,8 @@
 #include "absl/types/optional.h"
 #include "base/memory/scoped_refptr.h"
 #include "base/strings/string_piece_forward.h"
+#include "components/adblock/core/subscription/frame_special_filters.h"
+#include "components/adblock/core/subscription/request_context.h"
 #include "components/adblock/core/subscription/subscription.h"
 #include "components/adblock/core/subscription/test/mock_installed_subscription.h"
 #include "gmock/gmock-actions.h"
@@ -1171,4 +1173,101 @@ TEST_F(AdblockSubscriptionCollectionImplTest, GenericBlockRewriteFilter) {
             absl::nullopt);
 }
 
+TEST_F(AdblockSubscriptionCollectionImplTest,
+       FrameSpecialFiltersSpareFrameLookups) {
+  auto sub1 = base::MakeRefCounted<MockInstalledSubscription>();
+  auto sub2 = base::MakeRefCounted<MockInstalledSubscription>();
+  const auto frame_context = base::MakeRefCounted<FrameContext>(
+      std::vector<GURL>{kParentAddress}, kSitekey);
+
+  // Filters of every type are looked up once for the frame. Only the second
+  // subscription has a Document filter for it.
+  EXPECT_CALL(*sub1, HasSpecialFilter(_, kParentAddress, kParentAddress.host(),
+                                      kSitekey))
+      .Times(static_cast<int>(kSpecialFilterTypeCount))
+      .WillRepeatedly(Return(false));
+  EXPECT_CALL(*sub2, HasSpecialFilter(_, kParentAddress, kParentAddress.host(),
+                                      kSitekey))
+      .Times(static_cast<int>(kSpecialFilterTypeCount) - 1)
+      .WillRepeatedly(Return(false));
+  EXPECT_CALL(*sub2,
+              HasSpecialFilter(SpecialFilterType::Document, kParentAddress,
+                               kParentAddress.host(), kSitekey))
+      .WillOnce(Return(true));
+
+  SubscriptionCollectionImpl collection(
+      std::vector<scoped_refptr<InstalledSubscription>>{sub1, sub2}, nullptr,
+      SubscriptionCollection::NextGeneration());
+  const FrameSpecialFiltersList frame_filters{
+      collection.FindFrameSpecialFilters(*frame_context)};
+  ASSERT_TRUE(frame_filters[0]);
+  EXPECT_EQ(frame_filters[0]->generation(), collection.GetGeneration());
+  EXPECT_EQ(frame_filters[0]->Find(SpecialFilterType::Document), 1u);
+  EXPECT_EQ(frame_filters[0]->Find(SpecialFilterType::Genericblock),
+            absl::nullopt);
+  testing::Mock::VerifyAndClearExpectations(sub1.get());
+  testing::Mock::VerifyAndClearExpectations(sub2.get());
+
+  // Requests made by the frame reuse them instead of looking them up again.
+  EXPECT_CALL(*sub1, HasSpecialFilter(_, kParentAddress, _, _)).Times(0);
+  EXPECT_CALL(*sub2, HasSpecialFilter(_, kParentAddress, _, _)).Times(0);
+  EXPECT_CALL(*sub1, HasUrlFilter(kImageAddress, kParentAddress.host(),
+                                  ContentType::Image, kSitekey,
+                                  FilterCategory::Allowing))
+      .WillOnce(Return(false));
+  EXPECT_CALL(*sub2, HasUrlFilter(kImageAddress, kParentAddress.host(),
+                                  ContentType::Image, kSitekey,
+                                  FilterCategory::Allowing))
+      .WillOnce(Return(false));
+  EXPECT_CALL(*sub2, GetSourceUrl()).WillRepeatedly(Return(kSourceUrl));
+
+  const RequestContext context(kImageAddress, *frame_context, frame_filters);
+  EXPECT_EQ(collection.FindByAllowFilter(context, ContentType::Image),
+            kSourceUrl);
+}
+
+TEST_F(AdblockSubscriptionCollectionImplTest,
+       FrameSpecialFiltersOfOtherGenerationIgnored) {
+  auto sub1 = base::MakeRefCounted<MockInstalledSubscription>();
+  const std::vector<GURL> frame_hierarchy{kParentAddress};
+
+  // Found with a previous state, in which the subscription had a Document
+  // filter for the frame.
+  FrameSpecialFilters::Positions positions;
+  positions[static_cast<size_t>(SpecialFilterType::Document)] = 0u;
+  const FrameSpecialFiltersList frame_filters{
+      base::MakeRefCounted<FrameSpecialFilters>(
+          SubscriptionCollection::NextGeneration(), positions)};
+
+  // The current state is asked again, and has none.
+  EXPECT_CALL(*sub1, HasUrlFilter(kImageAddress, kParentAddress.host(),
+                                  ContentType::Image, kSitekey,
+                                  FilterCategory::Allowing))
+      .WillOnce(Return(false));
+  EXPECT_CALL(*sub1,
+              HasSpecialFilter(SpecialFilterType::Document, kParentAddress,
+                               kParentAddress.host(), kSitekey))
+      .WillOnce(Return(false));
+
+  SubscriptionCollectionImpl collection(
+      std::vector<scoped_refptr<InstalledSubscription>>{sub1}, nullptr,
+      SubscriptionCollection::NextGeneration());
+  const RequestContext context(kImageAddress, frame_hierarchy, kSitekey,
+                               frame_filters);
+  EXPECT_EQ(collection.FindByAllowFilter(context, ContentType::Image),
+            absl::nullopt);
+}
+
+TEST_F(AdblockSubscriptionCollectionImplTest,
+       NoFrameSpecialFiltersForUntrackedState) {
+  auto sub1 = base::MakeRefCounted<MockInstalledSubscription>();
+  EXPECT_CALL(*sub1, HasSpecialFilter(_, _, _, _)).Times(0);
+
+  SubscriptionCollectionImpl collection(
+      std::vector<scoped_refptr<InstalledSubscription>>{sub1});
+  const auto frame_context = base::MakeRefCounted<FrameContext>(
+      std::vector<GURL>{kParentAddress}, kSitekey);
+  EXPECT_FALSE(collection.FindFrameSpecialFilters(*frame_context));
+}
+
 }  // namespace adblock
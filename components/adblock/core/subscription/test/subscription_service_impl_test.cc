@@ -21,10 +21,14 @@
 #include "base/functional/bind.h"
 #include "base/memory/scoped_refptr.h"
 #include "base/ranges/algorithm.h"
+#include "base/test/task_environment.h"
 #include "components/adblock/core/configuration/filtering_configuration.h"
 #include "components/adblock/core/configuration/test/fake_filtering_configuration.h"
+#include "components/adblock/core/converter/flatbuffer_converter.h"
 #include "components/adblock/core/subscription/filtering_configuration_maintainer.h"
+#include "components/adblock/core/subscription/installed_subscription_impl.h"
 #include "components/adblock/core/subscription/subscription_collection.h"
+#include "components/adblock/core/subscription/subscription_collection_impl.h"
 #include "components/adblock/core/subscription/subscription_service.h"
 #include "components/adblock/core/subscription/test/mock_filtering_configuration_mainainer.h"
 #include "components/adblock/core/subscription/test/mock_subscription.h"
@@ -54,6 +58,8 @@ class AdblockSubscriptionServiceImplTest : public testing::Test {
   struct MaintainerFactoryCall {
     FilteringConfiguration* input_configuration;
     SubscriptionServiceImpl::SubscriptionUpdatedCallback input_update_callback;
+    SubscriptionServiceImpl::CollectionChangedCallback
+        input_collection_changed_callback;
     MockFilteringConfigurationMaintainer* output_maintainer;
   };
 
@@ -64,13 +70,21 @@ class AdblockSubscriptionServiceImplTest : public testing::Test {
 
   std::unique_ptr<FilteringConfigurationMaintainer> MockMakeMaintainer(
       FilteringConfiguration* configuration,
-      SubscriptionServiceImpl::SubscriptionUpdatedCallback update_callback) {
+      SubscriptionServiceImpl::SubscriptionUpdatedCallback update_callback,
+      SubscriptionServiceImpl::CollectionChangedCallback
+          collection_changed_callback) {
     auto maintainer = std::make_unique<MockFilteringConfigurationMaintainer>();
-    maintainer_factory_calls_.push_back(
-        {configuration, update_callback, maintainer.get()});
+    ON_CALL(*maintainer, GetSubscriptionCollection()).WillByDefault([]() {
+      return std::unique_ptr<SubscriptionCollection>(
+          std::make_unique<MockSubscriptionCollection>());
+    });
+    maintainer_factory_calls_.push_back({configuration, update_callback,
+                                         collection_changed_callback,
+                                         maintainer.get()});
     return maintainer;
   }
 
+  base::test::TaskEnvironment task_environment_;
   std::vector<MaintainerFactoryCall> maintainer_factory_calls_;
   MockSubscriptionObserver observer_;
   SubscriptionServiceImpl testee_;
@@ -214,6 +228,9 @@ TEST_F(AdblockSubscriptionServiceImplTest,
               GetSubscriptionCollection())
       .WillOnce(Return(testing::ByMove(std::move(collection2))));
 
+  // A maintainer reports a change of its collection, a new Snapshot is built.
+  maintainer_factory_calls_[0].input_collection_changed_callback.Run();
+
   // The SubscriptionCollections that comprise the Snapshot are the ones
   // returned by maintainers.
   const auto snapshot = testee_.GetCurrentSnapshot();
@@ -222,6 +239,90 @@ TEST_F(AdblockSubscriptionServiceImplTest,
       &std::unique_ptr<SubscriptionCollection>::get));
 }
 
+TEST_F(AdblockSubscriptionServiceImplTest,
+       SnapshotSharedUntilCollectionChanges) {
+  testee_.InstallFilteringConfiguration(
+      std::make_unique<FakeFilteringConfiguration>());
+  ASSERT_EQ(maintainer_factory_calls_.size(), 1u);
+  auto* maintainer = maintainer_factory_calls_[0].output_maintainer;
+  auto collection = std::make_unique<MockSubscriptionCollection>();
+  auto* collection_ptr = collection.get();
+  EXPECT_CALL(*maintainer, GetSubscriptionCollection())
+      .WillOnce(Return(testing::ByMove(std::move(collection))));
+  maintainer_factory_calls_[0].input_collection_changed_callback.Run();
+  testing::Mock::VerifyAndClearExpectations(maintainer);
+
+  // Acquiring the Snapshot does not consult the maintainer, every caller
+  // shares the published collections.
+  EXPECT_CALL(*maintainer, GetSubscriptionCollection()).Times(0);
+  const auto first_snapshot = testee_.GetCurrentSnapshot();
+  const auto second_snapshot = testee_.GetCurrentSnapshot();
+  ASSERT_EQ(first_snapshot.size(), 1u);
+  ASSERT_EQ(second_snapshot.size(), 1u);
+  EXPECT_EQ(first_snapshot[0].get(), collection_ptr);
+  EXPECT_EQ(second_snapshot[0].get(), collection_ptr);
+  testing::Mock::VerifyAndClearExpectations(maintainer);
+
+  // Once the collection changes, new Snapshots contain the new collection
+  // while the ones acquired earlier remain intact.
+  auto new_collection = std::make_unique<MockSubscriptionCollection>();
+  auto* new_collection_ptr = new_collection.get();
+  EXPECT_CALL(*maintainer, GetSubscriptionCollection())
+      .WillOnce(Return(testing::ByMove(std::move(new_collection))));
+  maintainer_factory_calls_[0].input_collection_changed_callback.Run();
+  ASSERT_EQ(testee_.GetCurrentSnapshot().size(), 1u);
+  EXPECT_EQ(testee_.GetCurrentSnapshot()[0].get(), new_collection_ptr);
+  EXPECT_EQ(first_snapshot[0].get(), collection_ptr);
+}
+
+TEST_F(AdblockSubscriptionServiceImplTest,
+       DisablingConfigurationRemovesItFromSnapshot) {
+  auto config = std::make_unique<FakeFilteringConfiguration>();
+  auto* config_bare_ptr = config.get();
+  testee_.InstallFilteringConfiguration(std::move(config));
+  ASSERT_EQ(maintainer_factory_calls_.size(), 1u);
+  EXPECT_EQ(testee_.GetCurrentSnapshot().size(), 1u);
+
+  config_bare_ptr->SetEnabled(false);
+  EXPECT_TRUE(testee_.GetCurrentSnapshot().empty());
+}
+
+TEST_F(AdblockSubscriptionServiceImplTest,
+       FusedIndexPublishedForSeveralConfigurations) {
+  testee_.InstallFilteringConfiguration(
+      std::make_unique<FakeFilteringConfiguration>());
+  testee_.InstallFilteringConfiguration(
+      std::make_unique<FakeFilteringConfiguration>());
+  ASSERT_EQ(maintainer_factory_calls_.size(), 2u);
+  std::vector<std::vector<scoped_refptr<InstalledSubscription>>> states;
+  for (const auto& call : maintainer_factory_calls_) {
+    states.push_back({base::MakeRefCounted<InstalledSubscriptionImpl>(
+        FlatbufferConverter::Convert({"/banner/"}, GURL("https://list.com/"),
+                                     false),
+        Subscription::InstallationState::Installed, base::Time())});
+    ON_CALL(*call.output_maintainer, GetSubscriptionCollection())
+        .WillByDefault([state = states.back()]() {
+          return std::unique_ptr<SubscriptionCollection>(
+              std::make_unique<SubscriptionCollectionImpl>(state));
+        });
+  }
+  maintainer_factory_calls_[0].input_collection_changed_callback.Run();
+  // The collections are searched one by one until the fused index is built in
+  // background.
+  EXPECT_FALSE(testee_.GetCurrentSnapshot().fused_index());
+  task_environment_.RunUntilIdle();
+  const auto* fused_index = testee_.GetCurrentSnapshot().fused_index();
+  ASSERT_TRUE(fused_index);
+
+  // A change of collections that keeps their subscriptions keeps the index.
+  maintainer_factory_calls_[1].input_collection_changed_callback.Run();
+  EXPECT_EQ(testee_.GetCurrentSnapshot().fused_index(), fused_index);
+
+  // With a single enabled configuration, there is nothing to fuse.
+  maintainer_factory_calls_[1].input_configuration->SetEnabled(false);
+  EXPECT_FALSE(testee_.GetCurrentSnapshot().fused_index());
+}
+
 TEST_F(AdblockSubscriptionServiceImplTest,
        SubscriptionObserverNotifiedByMaintainerCallbacks) {
   const GURL kUrl("https://test.com");
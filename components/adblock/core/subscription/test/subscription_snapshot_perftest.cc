@@ -0,0 +1,108 @@
+/*
+ * This file is part of eyeo Chromium SDK,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * eyeo Chromium SDK is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * eyeo Chromium SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eyeo Chromium SDK.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <memory>
+#include <vector>
+
+#include "base/functional/bind.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/test/task_environment.h"
+#include "base/timer/elapsed_timer.h"
+#include "components/adblock/core/configuration/test/fake_filtering_configuration.h"
+#include "components/adblock/core/subscription/subscription_collection_impl.h"
+#include "components/adblock/core/subscription/subscription_service_impl.h"
+#include "components/adblock/core/subscription/test/mock_filtering_configuration_mainainer.h"
+#include "components/adblock/core/subscription/test/mock_installed_subscription.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace adblock {
+namespace {
+
+constexpr char kMetricRuntime[] = ".runtime";
+constexpr int kRepetitions = 10000;
+constexpr size_t kConfigurations = 3;
+constexpr size_t kSubscriptionsPerConfiguration = 20;
+constexpr uint64_t kGeneration = 1;
+
+}  // namespace
+
+// Compares the cost of building a Snapshot from all maintainers, which used to
+// be paid by every GetCurrentSnapshot() call and is now paid once per change,
+// with the cost of acquiring the published Snapshot.
+class AdblockSubscriptionSnapshotPerfTest : public testing::Test {
+ public:
+  AdblockSubscriptionSnapshotPerfTest()
+      : service_(base::BindRepeating(
+            &AdblockSubscriptionSnapshotPerfTest::MakeMaintainer,
+            base::Unretained(this))) {
+    for (size_t i = 0; i < kSubscriptionsPerConfiguration; ++i) {
+      state_.push_back(base::MakeRefCounted<MockInstalledSubscription>());
+    }
+    for (size_t i = 0; i < kConfigurations; ++i) {
+      service_.InstallFilteringConfiguration(
+          std::make_unique<FakeFilteringConfiguration>());
+    }
+  }
+
+  std::unique_ptr<FilteringConfigurationMaintainer> MakeMaintainer(
+      FilteringConfiguration* configuration,
+      SubscriptionServiceImpl::SubscriptionUpdatedCallback update_callback,
+      SubscriptionServiceImpl::CollectionChangedCallback
+          collection_changed_callback) {
+    collection_changed_callbacks_.push_back(collection_changed_callback);
+    auto maintainer = std::make_unique<
+        testing::NiceMock<MockFilteringConfigurationMaintainer>>();
+    // Like FilteringConfigurationMaintainerImpl, copies the state into a new
+    // collection on every call.
+    ON_CALL(*maintainer, GetSubscriptionCollection())
+        .WillByDefault([this]() -> std::unique_ptr<SubscriptionCollection> {
+          return std::make_unique<SubscriptionCollectionImpl>(
+              state_, nullptr, kGeneration);
+        });
+    return maintainer;
+  }
+
+  base::test::TaskEnvironment task_environment_;
+  std::vector<scoped_refptr<InstalledSubscription>> state_;
+  std::vector<SubscriptionServiceImpl::CollectionChangedCallback>
+      collection_changed_callbacks_;
+  SubscriptionServiceImpl service_;
+};
+
+TEST_F(AdblockSubscriptionSnapshotPerfTest, BuildSnapshot) {
+  ASSERT_EQ(collection_changed_callbacks_.size(), kConfigurations);
+  perf_test::PerfResultReporter reporter("subscription_snapshot", "build");
+  reporter.RegisterImportantMetric(kMetricRuntime, "ms");
+  base::ElapsedTimer timer;
+  for (int i = 0; i < kRepetitions; ++i) {
+    collection_changed_callbacks_[0].Run();
+  }
+  reporter.AddResult(kMetricRuntime, timer.Elapsed());
+}
+
+TEST_F(AdblockSubscriptionSnapshotPerfTest, AcquireSnapshot) {
+  perf_test::PerfResultReporter reporter("subscription_snapshot", "acquire");
+  reporter.RegisterImportantMetric(kMetricRuntime, "ms");
+  base::ElapsedTimer timer;
+  for (int i = 0; i < kRepetitions; ++i) {
+    EXPECT_EQ(service_.GetCurrentSnapshot().size(), kConfigurations);
+  }
+  reporter.AddResult(kMetricRuntime, timer.Elapsed());
+}
+
+}  // namespace adblock
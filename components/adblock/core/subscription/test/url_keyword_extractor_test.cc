@@ -34,7 +34,7 @@ TEST(AdblockUrlKeywordExtractor, DoesNotExtractCommonKeywords) {
   UrlKeywordExtractor extractor("http://www.base.com/path?query.js");
   std::vector<std::string> extracted_keywords;
   while (auto keyword = extractor.GetNextKeyword()) {
-    extracted_keywords.push_back(keyword->data());
+    extracted_keywords.emplace_back(*keyword);
   }
   EXPECT_THAT(extracted_keywords,
               testing::ElementsAre("www", "base", "path", "query"));
@@ -44,7 +44,7 @@ TEST(AdblockUrlKeywordExtractor, DoesExtractLastKeywordsForRequest) {
   UrlKeywordExtractor extractor("http://domain.cc/in_discovery5");
   std::vector<std::string> extracted_keywords;
   while (auto keyword = extractor.GetNextKeyword()) {
-    extracted_keywords.push_back(keyword->data());
+    extracted_keywords.emplace_back(*keyword);
   }
   EXPECT_THAT(extracted_keywords,
               testing::ElementsAre("domain", "cc", "in", "discovery5"));
@@ -54,7 +54,7 @@ TEST(AdblockUrlKeywordExtractor, SingleLetterKeywordsSkipped) {
   UrlKeywordExtractor extractor("http://a.b/cc");
   std::vector<std::string> extracted_keywords;
   while (auto keyword = extractor.GetNextKeyword()) {
-    extracted_keywords.push_back(keyword->data());
+    extracted_keywords.emplace_back(*keyword);
   }
   EXPECT_THAT(extracted_keywords, testing::ElementsAre("cc"));
 }
@@ -65,10 +65,37 @@ TEST(AdblockUrlKeywordExtractor, KeywordSymbolVsSeparatorSymbols) {
   UrlKeywordExtractor extractor("http://alpha.beta/data123-data2%4?");
   std::vector<std::string> extracted_keywords;
   while (auto keyword = extractor.GetNextKeyword()) {
-    extracted_keywords.push_back(keyword->data());
+    extracted_keywords.emplace_back(*keyword);
   }
   EXPECT_THAT(extracted_keywords,
               testing::ElementsAre("alpha", "beta", "data123", "data2%4"));
 }
 
+TEST(AdblockUrlKeywordExtractor, KeywordsSpanCharacterBlocks) {
+  // Characters are classified in blocks of 16, keywords and separators may
+  // start and end anywhere within or across blocks. Bytes outside ASCII are
+  // separators.
+  const std::string url =
+      "https://averyveryverylongsubdomain.example.org/x/"
+      "path-segment_with%20escapes\x80\xffnonascii?q=1234567890123456789";
+  UrlKeywordExtractor extractor(url);
+  std::vector<std::string> extracted_keywords;
+  while (auto keyword = extractor.GetNextKeyword()) {
+    extracted_keywords.emplace_back(*keyword);
+  }
+  EXPECT_THAT(extracted_keywords,
+              testing::ElementsAre("averyveryverylongsubdomain", "example",
+                                   "org", "path", "segment", "with%20escapes",
+                                   "nonascii", "1234567890123456789"));
+}
+
+TEST(AdblockUrlKeywordExtractor, KeywordsPointIntoInput) {
+  const std::string url = "http://domain.cc/in_discovery5";
+  UrlKeywordExtractor extractor(url);
+  const auto keyword = extractor.GetNextKeyword();
+  ASSERT_TRUE(keyword);
+  EXPECT_EQ(keyword->data(), url.data() + 7);
+  EXPECT_EQ(*keyword, "domain");
+}
+
 }  // namespace adblock
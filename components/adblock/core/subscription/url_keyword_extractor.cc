@@ -17,52 +17,138 @@
 
 #include "components/adblock/core/subscription/url_keyword_extractor.h"
 
-#include <algorithm>
-#include <cctype>
+#include <array>
+#include <cstdint>
 
-#include "base/ranges/algorithm.h"
-#include "base/strings/string_piece_forward.h"
-#include "base/strings/string_util.h"
+#include "base/bits.h"
+#include "build/build_config.h"
 #include "components/adblock/core/common/keyword_extractor_utils.h"
 
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <emmintrin.h>
+#elif defined(ARCH_CPU_ARM_FAMILY) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace adblock {
 namespace {
 
-bool IsSeparatorCharacter(char c) {
-  return !(std::isalnum(c) || c == '%');
+constexpr std::array<bool, 256> MakeKeywordCharacterTable() {
+  std::array<bool, 256> table{};
+  for (int c = '0'; c <= '9'; ++c) {
+    table[c] = true;
+  }
+  for (int c = 'a'; c <= 'z'; ++c) {
+    table[c] = true;
+    table[c - 'a' + 'A'] = true;
+  }
+  table['%'] = true;
+  return table;
 }
 
-}  // namespace
+constexpr std::array<bool, 256> kKeywordCharacterTable =
+    MakeKeywordCharacterTable();
 
-absl::optional<base::StringPiece> UrlKeywordExtractor::GetNextKeyword() {
-  base::StringPiece current_keyword;
-  do {
-    const auto start_of_next_keyword = input_.find_first_not_of('\0');
-    if (start_of_next_keyword == base::StringPiece::npos) {
-      return absl::nullopt;
-    }
-    input_.remove_prefix(start_of_next_keyword);
-    const auto end_of_keyword = input_.find_first_of('\0');
-    current_keyword = input_.substr(0, end_of_keyword);
-    input_.remove_prefix(current_keyword.size());
-  } while (utils::IsBadKeyword(current_keyword));
-  return current_keyword;
+bool IsKeywordCharacter(char c) {
+  return kKeywordCharacterTable[static_cast<uint8_t>(c)];
+}
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#define HAS_KEYWORD_CHARACTER_MASK 1
+constexpr size_t kBlockSize = 16u;
+// One bit per character.
+constexpr size_t kMaskBitsPerCharacter = 1u;
+constexpr uint64_t kFullMask = 0xFFFF;
+
+// Returns a mask of the keyword characters among the |kBlockSize| characters
+// starting at |data|. Bytes above 0x7F compare as negative and never match.
+uint64_t KeywordCharacterMask(const char* data) {
+  const __m128i bytes =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+  // Setting 0x20 lowercases letters and maps no other character to a letter.
+  const __m128i lowercase = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+  const __m128i is_letter =
+      _mm_and_si128(_mm_cmpgt_epi8(lowercase, _mm_set1_epi8('a' - 1)),
+                    _mm_cmplt_epi8(lowercase, _mm_set1_epi8('z' + 1)));
+  const __m128i is_digit =
+      _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('0' - 1)),
+                    _mm_cmplt_epi8(bytes, _mm_set1_epi8('9' + 1)));
+  const __m128i is_percent = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('%'));
+  return static_cast<uint32_t>(_mm_movemask_epi8(
+      _mm_or_si128(_mm_or_si128(is_letter, is_digit), is_percent)));
 }
+#elif defined(ARCH_CPU_ARM_FAMILY) && defined(__ARM_NEON)
+#define HAS_KEYWORD_CHARACTER_MASK 1
+constexpr size_t kBlockSize = 16u;
+// NEON has no movemask, narrowing yields four bits per character.
+constexpr size_t kMaskBitsPerCharacter = 4u;
+constexpr uint64_t kFullMask = ~uint64_t{0};
 
-UrlKeywordExtractor::UrlKeywordExtractor(base::StringPiece url)
-    : url_with_nulls_(url.data(), url.size()) {
-  // The keywords returned by GetNextKeyword() will be passed to
-  // flatbuffers::Vector::LookupByKey(const char* key) which assumes |key| is
-  // null-terminated. In order to avoid allocating a null-terminated
-  // std::string for every extracted keyword, we instead replace separator
-  // characters by nulls, so that a StringPiece referring to a keyword is also
-  // null-terminated.
-  // This isn't elegant, but it's a valid workaround for the limitations of
-  // the flatbuffers generated API.
-  base::ranges::replace_if(url_with_nulls_, &IsSeparatorCharacter, '\0');
-  input_ = url_with_nulls_;
+// Returns a mask of the keyword characters among the |kBlockSize| characters
+// starting at |data|.
+uint64_t KeywordCharacterMask(const char* data) {
+  const uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(data));
+  // Setting 0x20 lowercases letters and maps no other character to a letter.
+  const uint8x16_t lowercase = vorrq_u8(bytes, vdupq_n_u8(0x20));
+  // Unsigned wrap-around turns range checks into a single comparison.
+  const uint8x16_t is_letter = vcleq_u8(vsubq_u8(lowercase, vdupq_n_u8('a')),
+                                        vdupq_n_u8('z' - 'a'));
+  const uint8x16_t is_digit =
+      vcleq_u8(vsubq_u8(bytes, vdupq_n_u8('0')), vdupq_n_u8('9' - '0'));
+  const uint8x16_t is_percent = vceqq_u8(bytes, vdupq_n_u8('%'));
+  const uint8x16_t matches =
+      vorrq_u8(vorrq_u8(is_letter, is_digit), is_percent);
+  return vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
 }
+#endif
+
+// Returns the position of the first character at or after |position| that is
+// a keyword character if |keyword_character| is true, or a separator
+// otherwise. Returns input.size() if there is none.
+size_t FindNext(base::StringPiece input,
+                size_t position,
+                bool keyword_character) {
+#if defined(HAS_KEYWORD_CHARACTER_MASK)
+  for (; position + kBlockSize <= input.size(); position += kBlockSize) {
+    uint64_t mask = KeywordCharacterMask(input.data() + position);
+    if (!keyword_character) {
+      mask = ~mask & kFullMask;
+    }
+    if (mask) {
+      return position +
+             base::bits::CountTrailingZeroBits(mask) / kMaskBitsPerCharacter;
+    }
+  }
+#endif
+  // The tail shorter than a block, or all of the input without SIMD.
+  while (position < input.size() &&
+         IsKeywordCharacter(input[position]) != keyword_character) {
+    ++position;
+  }
+  return position;
+}
+
+}  // namespace
+
+UrlKeywordExtractor::UrlKeywordExtractor(base::StringPiece url) : input_(url) {}
 
 UrlKeywordExtractor::~UrlKeywordExtractor() = default;
 
+absl::optional<base::StringPiece> UrlKeywordExtractor::GetNextKeyword() {
+  while (position_ < input_.size()) {
+    const size_t start = FindNext(input_, position_, true);
+    if (start == input_.size()) {
+      break;
+    }
+    position_ = FindNext(input_, start, false);
+    const base::StringPiece keyword = input_.substr(start, position_ - start);
+    if (!utils::IsBadKeyword(keyword)) {
+      return keyword;
+    }
+  }
+  position_ = input_.size();
+  return absl::nullopt;
+}
+
 }  // namespace adblock
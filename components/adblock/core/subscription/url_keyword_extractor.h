@@ -19,13 +19,10 @@
 #ifndef COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_URL_KEYWORD_EXTRACTOR_H_
 #define COMPONENTS_ADBLOCK_CORE_SUBSCRIPTION_URL_KEYWORD_EXTRACTOR_H_
 
-#include <string>
+#include <cstddef>
 
 #include "absl/types/optional.h"
-
 #include "base/strings/string_piece.h"
-#include "base/strings/string_piece_forward.h"
-#include "url/gurl.h"
 
 namespace adblock {
 
@@ -45,15 +42,22 @@ namespace adblock {
 // 3. If we fail to extract keywords from a filter, we index it under an empty
 // keyword. All filters without a keyword are checked for all URLs, as they
 // could match anything.
+//
+// Keywords are runs of keyword characters: ASCII letters, digits and '%'.
+// Characters are classified with SSE2 or NEON, 16 at a time, where available
+// and with a lookup table otherwise. Keywords are returned as pieces of the
+// input, no copy is made.
 class UrlKeywordExtractor {
  public:
+  // |url| must outlive this object, returned keywords point into it.
   explicit UrlKeywordExtractor(base::StringPiece url);
   ~UrlKeywordExtractor();
+  // Returned keywords are not null-terminated.
   absl::optional<base::StringPiece> GetNextKeyword();
 
  private:
-  std::string url_with_nulls_;
   base::StringPiece input_;
+  size_t position_ = 0u;
 };
 
 }  // namespace adblock
@@ -120,14 +120,15 @@ class FlatbufferAdblockVerifier {
   }
 
   bool FlatbufferUrlFilterImplementation(const test::Request& request) {
-    std::vector<GURL> frame_hierarchy = {GURL("https://" + request.domain)};
+    const auto frame_context = base::MakeRefCounted<FrameContext>(
+        std::vector<GURL>{GURL("https://" + request.domain)}, SiteKey());
     SubscriptionService::Snapshot snapshot;
     snapshot.push_back(
         std::make_unique<SubscriptionCollectionImpl>(*fb_subscriptions_));
 
     auto result = classifier_->ClassifyRequest(
-        std::move(snapshot), request.url, frame_hierarchy,
-        static_cast<adblock::ContentType>(request.content_type), SiteKey());
+        std::move(snapshot), request.url, *frame_context,
+        static_cast<adblock::ContentType>(request.content_type), {});
     return result.decision ==
            ResourceClassifier::ClassificationResult::Decision::Blocked;
   }